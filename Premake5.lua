@@ -342,9 +342,14 @@ function AddProjects(groupName, folders)
 		  		"(IF NOT EXIST \"%{resdir}\" mkdir \"%{resdir}\")",
 		  		"(xcopy /Q /E /Y /I /C \"%{wks.location}shared_assets\\res\" \"%{absdir}\")",
 		  		-- This step copies all the resources to the output directory
-		  		"(xcopy /Q /E /Y /I /C \"%{resdir}\" \"%{absdir}\")"
+		  		"(xcopy /Q /E /Y /I /C \"%{resdir}\" \"%{absdir}\")",
+		  		-- This step converts any changed resources, and packs everything into an asset pack that the runtime prefers over loose files
+		  		"(\"%{wks.location}bin\\%{outputdir}\\AssetCooker\\AssetCooker.exe\" \"%{resdir}\" \"%{absdir}\" --pack \"%{absdir}\\assets.pak\")"
 			} 
 
+			-- The cooker needs to be built before we can pack our resources
+			dependson { "AssetCooker" }
+
 			-- Our source files are everything in the src folder
 			files {
 				"%{prj.location}\\src\\**.h",
@@ -355,7 +360,9 @@ function AddProjects(groupName, folders)
 
 			-- Disable CRT secure warnings
 			defines {
-				"_CRT_SECURE_NO_WARNINGS"
+				"_CRT_SECURE_NO_WARNINGS",
+				-- Lets GUIDs be stored in binary scenes
+				"GUID_CEREAL_ARCHIVES"
 			}
 
 			-- We update the reserved include directory to be the project's source directory
@@ -395,6 +402,64 @@ function AddProjects(groupName, folders)
 
 end
 
+-- The asset cooker converts and packs project resources ahead of time. It uses the game's own loaders to do the
+-- conversion, so it builds all of the game's source (except for it's entry point) with it's own main
+local cookerGameDir = "projects/Assignment 1 Graphics"
+
+group("Tools")
+project "AssetCooker"
+	location "tools/AssetCooker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	targetdir ("%{wks.location}\\bin\\" .. outputdir .. "\\%{prj.name}")
+	objdir ("%{wks.location}\\obj\\" .. outputdir .. "\\%{prj.name}")
+
+	files {
+		"%{prj.location}\\src\\**.h",
+		"%{prj.location}\\src\\**.cpp",
+		cookerGameDir .. "/src/**.h",
+		cookerGameDir .. "/src/**.cpp",
+		cookerGameDir .. "/src/**.c",
+		cookerGameDir .. "/src/**.hpp"
+	}
+	removefiles {
+		cookerGameDir .. "/src/entry_point.cpp"
+	}
+
+	defines {
+		"_CRT_SECURE_NO_WARNINGS",
+		"GUID_CEREAL_ARCHIVES"
+	}
+
+	-- We build the game's source, so we need the same includes and links it does. The per-configuration libraries
+	-- come in through the modules in ProjLinks, same as for the game projects
+	ProjIncludes[1] = path.join(cookerGameDir, "src")
+	includedirs(ProjIncludes)
+	links(ProjLinks)
+
+	buildoptions { "/bigobj" }
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines {
+			"GLFW_INCLUDE_NONE",
+			"WINDOWS"
+		}
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "on"
+
+	filter {}
+
 -- Add the User Projects and Sample Projects
 AddProjects("Projects", projects)
 
@@ -11,6 +11,7 @@ Utility classes for managing OpenGL shaders and shader programs.
 #include <memory>
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "glad/glad.h"
 
@@ -33,6 +34,31 @@ namespace nou
 	//compiling shaders and linking shader programs.
 	void PrintGLInfoLog(const std::string& preamble, GLInfoLogType logType, GLuint objID, GLint buflen);
 
+	//Identifies a uniform by a hash of its name (64-bit FNV-1a), so we can look
+	//up locations without building strings or asking GL every time.
+	//When made from a string literal, the hash can be worked out at compile
+	//time - declare IDs used every frame as constexpr to make sure of this.
+	class UniformID
+	{
+		public:
+
+		constexpr UniformID(const char* name)
+			: hash(Hash(name, 14695981039346656037ull)), name(name) {}
+		UniformID(const std::string& name)
+			: hash(Hash(name.c_str(), 14695981039346656037ull)), name(name.c_str()) {}
+
+		uint64_t hash;
+		//Only valid for as long as the string the ID was made from.
+		const char* name;
+
+		protected:
+
+		static constexpr uint64_t Hash(const char* str, uint64_t h)
+		{
+			return *str ? Hash(str + 1, (h ^ static_cast<uint8_t>(*str)) * 1099511628211ull) : h;
+		}
+	};
+
 	class Shader
 	{
 		public:
@@ -64,19 +90,30 @@ namespace nou
 
 		//Utility functions for managing uniforms - variables
 		//we send to the shader that persist until we change them.
-		GLint GetUniformLoc(const std::string& name) const;
+		GLint GetUniformLoc(const UniformID& id) const;
 
 		template<typename T>
-		void SetUniform(const std::string& name, const T& value) const;
+		void SetUniform(const UniformID& id, const T& value) const;
 
 		template<typename T>
-		void SetUniformArray(const std::string& name, T* data, int len) const;
+		void SetUniformArray(const UniformID& id, T* data, int len) const;
 
 		protected:
 
 		//The OpenGL ID of our shader program.
 		GLuint m_id;
 
+		//Open addressed table of name hashes to uniform locations, filled
+		//in after linking. A hash of 0 marks an empty slot.
+		struct UniformSlot
+		{
+			uint64_t hash = 0;
+			GLint loc = -1;
+		};
+		std::vector<UniformSlot> m_uniforms;
+
+		void BuildUniformTable();
+
 		//The shader program currently in use.
 		static const ShaderProgram* m_current;
 
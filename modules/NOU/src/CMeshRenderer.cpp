@@ -64,9 +64,13 @@ namespace nou
 		//We are assuming the names used by uniform shader variables as a convention here.
 		//In a larger project, we would have a more elegant system for registering
 		//or even automatically detecting uniform names.
-		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
-		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
-		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
+		static constexpr UniformID viewprojID = UniformID("viewproj");
+		static constexpr UniformID modelID = UniformID("model");
+		static constexpr UniformID normalID = UniformID("normal");
+
+		ShaderProgram::Current()->SetUniform(viewprojID, CCamera::current->Get<CCamera>().GetVP());
+		ShaderProgram::Current()->SetUniform(modelID, transform.GetGlobal());
+		ShaderProgram::Current()->SetUniform(normalID, transform.GetNormal());
 		
 		m_vao->Draw();
 	}
@@ -40,7 +40,8 @@ namespace nou
 	{
 		m_program->Bind();
 
-		m_program->SetUniform("matColor", m_color);
+		static constexpr UniformID matColorID = UniformID("matColor");
+		m_program->SetUniform(matColorID, m_color);
 
 		//Bind the textures used by this material.
 		for (auto& t : m_tex)
@@ -164,6 +164,44 @@ namespace nou
 		{
 			glDetachShader(m_id, shader->GetID());
 		}
+
+		BuildUniformTable();
+	}
+
+	void ShaderProgram::BuildUniformTable()
+	{
+		GLint count = 0, maxLen = 0;
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLen);
+
+		//Keep the table at most half full, and a power of 2 in size
+		//so that we can mask instead of taking a modulus.
+		size_t size = 4;
+		while (size < (size_t)count * 2)
+			size <<= 1;
+		m_uniforms.assign(size, UniformSlot());
+
+		std::vector<GLchar> nameBuf(maxLen > 0 ? maxLen : 1);
+		for (GLint i = 0; i < count; ++i)
+		{
+			GLsizei len = 0;
+			glGetActiveUniformName(m_id, (GLuint)i, (GLsizei)nameBuf.size(), &len, nameBuf.data());
+
+			//Arrays are reported as "name[0]" - we want to find them by "name".
+			std::string name(nameBuf.data(), len);
+			name = name.substr(0, name.find('['));
+
+			GLint loc = glGetUniformLocation(m_id, name.c_str());
+			if (loc == -1)
+				continue;
+
+			UniformID id(name);
+			size_t slot = id.hash & (size - 1);
+			while (m_uniforms[slot].hash != 0)
+				slot = (slot + 1) & (size - 1);
+
+			m_uniforms[slot] = { id.hash, loc };
+		}
 	}
 
 	ShaderProgram::~ShaderProgram()
@@ -182,50 +220,60 @@ namespace nou
 		return m_current;
 	}
 
-	GLint ShaderProgram::GetUniformLoc(const std::string& name) const
+	GLint ShaderProgram::GetUniformLoc(const UniformID& id) const
 	{
-		return glGetUniformLocation(m_id, name.c_str());
+		//The table is at least twice as big as the number of uniforms,
+		//so this will almost always be found on the first probe.
+		const size_t mask = m_uniforms.size() - 1;
+		for (size_t slot = id.hash & mask; !m_uniforms.empty() && m_uniforms[slot].hash != 0; slot = (slot + 1) & mask)
+		{
+			if (m_uniforms[slot].hash == id.hash)
+				return m_uniforms[slot].loc;
+		}
+
+		//Names like "lights[2]" aren't in our table, so let GL handle them.
+		return glGetUniformLocation(m_id, id.name);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<int>(const std::string& name, const int& value) const
+	void ShaderProgram::SetUniform<int>(const UniformID& id, const int& value) const
 	{
-		glUniform1i(GetUniformLoc(name), value);
+		glUniform1i(GetUniformLoc(id), value);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<float>(const std::string& name, const float& value) const
+	void ShaderProgram::SetUniform<float>(const UniformID& id, const float& value) const
 	{
-		glUniform1f(GetUniformLoc(name), value);
+		glUniform1f(GetUniformLoc(id), value);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::mat4>(const std::string& name, const glm::mat4& value) const
+	void ShaderProgram::SetUniform<glm::mat4>(const UniformID& id, const glm::mat4& value) const
 	{
-		glUniformMatrix4fv(GetUniformLoc(name), 1, GL_FALSE, &value[0][0]);
+		glUniformMatrix4fv(GetUniformLoc(id), 1, GL_FALSE, &value[0][0]);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::mat3>(const std::string& name, const glm::mat3& value) const
+	void ShaderProgram::SetUniform<glm::mat3>(const UniformID& id, const glm::mat3& value) const
 	{
-		glUniformMatrix3fv(GetUniformLoc(name), 1, GL_FALSE, &value[0][0]);
+		glUniformMatrix3fv(GetUniformLoc(id), 1, GL_FALSE, &value[0][0]);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::vec4>(const std::string& name, const glm::vec4& value) const
+	void ShaderProgram::SetUniform<glm::vec4>(const UniformID& id, const glm::vec4& value) const
 	{
-		glUniform4fv(GetUniformLoc(name), 1, &(value.x));
+		glUniform4fv(GetUniformLoc(id), 1, &(value.x));
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::vec3>(const std::string& name, const glm::vec3& value) const
+	void ShaderProgram::SetUniform<glm::vec3>(const UniformID& id, const glm::vec3& value) const
 	{
-		glUniform3fv(GetUniformLoc(name), 1, &(value.x));
+		glUniform3fv(GetUniformLoc(id), 1, &(value.x));
 	}
 
 	template<>
-	void ShaderProgram::SetUniformArray<glm::mat4>(const std::string& name, glm::mat4* data, int len) const
+	void ShaderProgram::SetUniformArray<glm::mat4>(const UniformID& id, glm::mat4* data, int len) const
 	{
-		glUniformMatrix4fv(GetUniformLoc(name), len, GL_FALSE, (GLfloat*)data);
+		glUniformMatrix4fv(GetUniformLoc(id), len, GL_FALSE, (GLfloat*)data);
 	}
 }
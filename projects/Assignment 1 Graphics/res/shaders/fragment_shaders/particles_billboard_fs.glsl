@@ -0,0 +1,42 @@
+#version 450
+
+layout (location = 0) in vec4  inColor;
+layout (location = 1) in vec2  inUV;
+layout (location = 2) in float inViewDepth;
+
+out vec4 frag_color;
+
+#include "../fragments/frame_uniforms.glsl"
+
+// A copy of the scene's depth buffer, only bound when soft particles are enabled
+uniform layout (binding=13) sampler2D s_SceneDepth;
+
+// The distance over which particles fade out as they approach geometry, 0 to disable
+uniform float u_SoftDistance;
+
+// Converts a value from the depth buffer back into a distance from the camera
+float LinearizeDepth(float depth) {
+    float ndc = depth * 2.0 - 1.0;
+    if (u_Projection[3][3] == 1.0) {
+        // Orthographic
+        return -(ndc - u_Projection[3][2]) / u_Projection[2][2];
+    }
+    return u_Projection[3][2] / (ndc + u_Projection[2][2]);
+}
+
+void main() {
+    // Round sprite with a soft edge
+    float radius = length(inUV * 2.0 - 1.0);
+    float alpha = inColor.a * (1.0 - smoothstep(0.5, 1.0, radius));
+
+    // Fade out where the sprite intersects the scene, to hide the hard edge
+    if (u_SoftDistance > 0) {
+        float sceneDepth = LinearizeDepth(texelFetch(s_SceneDepth, ivec2(gl_FragCoord.xy), 0).r);
+        alpha *= clamp((sceneDepth - inViewDepth) / u_SoftDistance, 0, 1);
+    }
+
+    if (alpha <= 0.0) {
+        discard;
+    }
+    frag_color = vec4(inColor.rgb, alpha);
+}
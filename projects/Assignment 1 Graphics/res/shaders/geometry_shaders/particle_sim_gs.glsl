@@ -11,6 +11,7 @@ layout (location = 2) in vec3 inVelocity[];
 layout (location = 3) in vec4 inColor[];
 layout (location = 4) in float inLifetime[];
 layout (location = 5) in vec4 inMetadata[];
+layout (location = 6) in vec2 inSize[];
 
 // Our per-vertex outputs
 out uint out_Type;
@@ -19,11 +20,16 @@ out vec3 out_Velocity;
 out vec4 out_Color;
 out float out_Lifetime;
 out vec4 out_Metadata;
+out vec2 out_Size;
 
 #include "../fragments/frame_uniforms.glsl"
 
 // Uniforms
 uniform vec3  u_Gravity;
+// The time to simulate, which may cover several frames for distant systems
+uniform float u_StepTime;
+// Multiplier for the spawn rate of emitters, 0 stops all emitters
+uniform float u_EmissionScale;
 
 #define TYPE_EMITTER 0
 #define TYPE_PARTICLE 1
@@ -35,7 +41,7 @@ float rand(vec2 seed) {
 }
 
 void main() {
-    float lifetime = inLifetime[0] - u_DeltaTime;
+    float lifetime = inLifetime[0] - u_StepTime;
     vec4 meta = inMetadata[0];
 
     switch (inType[0]) {
@@ -43,21 +49,29 @@ void main() {
         case TYPE_EMITTER:
             int emitted = 1;
             // If the lifetime is at 0, we emit a particle
-            while ((lifetime < 0) && (emitted < 32)) {
+            while ((lifetime < 0) && (emitted < 32) && (u_EmissionScale > 0)) {
                 out_Type = TYPE_PARTICLE;
                 out_Position = inPosition[0] + inVelocity[0] * (-lifetime);
                 out_Velocity = inVelocity[0];
-                out_Lifetime = meta.z + (meta.w - meta.z) * rand(vec2(inPosition[0].x, u_DeltaTime));
-                out_Metadata = vec4(0, 0, 0, 0);
+                float startLifetime = meta.z + (meta.w - meta.z) * rand(vec2(inPosition[0].x, u_StepTime));
+                out_Lifetime = startLifetime;
+                // Particles remember their starting lifetime so they can be sized by age
+                out_Metadata = vec4(startLifetime, 0, 0, 0);
                 out_Color    = inColor[0];
+                out_Size     = inSize[0];
                 
                 EmitVertex();
                 EndPrimitive();
 
-                lifetime += meta.x;
+                lifetime += meta.x / u_EmissionScale;
                 emitted++;
             }
 
+            // Stopped emitters are held ready to spawn as soon as they're resumed
+            if (u_EmissionScale <= 0) {
+                lifetime = max(lifetime, 0);
+            }
+
             // Push the emitter back into the output stream
             out_Type = TYPE_EMITTER;
             out_Position = inPosition[0];
@@ -65,6 +79,7 @@ void main() {
             out_Color    = inColor[0];
             out_Lifetime = lifetime;
             out_Metadata = inMetadata[0];
+            out_Size     = inSize[0];
             
             EmitVertex();
             EndPrimitive();
@@ -77,8 +92,8 @@ void main() {
                 out_Type = TYPE_PARTICLE;
 
                 // Update position and apply forces
-                out_Position = inPosition[0] + inVelocity[0] * u_DeltaTime;
-                out_Velocity = inVelocity[0] + (u_Gravity * u_DeltaTime);
+                out_Position = inPosition[0] + inVelocity[0] * u_StepTime;
+                out_Velocity = inVelocity[0] + (u_Gravity * u_StepTime);
                 
                 // Update lifetime
                 out_Lifetime = lifetime;
@@ -86,6 +101,7 @@ void main() {
                 // For now, just pass through metadata and color
                 out_Metadata = inMetadata[0];
                 out_Color    = inColor[0];
+                out_Size     = inSize[0];
 
                 // Emit into vertex stream
                 EmitVertex();
@@ -0,0 +1,42 @@
+#version 450
+
+layout (points) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+layout (location = 0) in uint  inType[];
+layout (location = 1) in vec4  inColor[];
+layout (location = 2) in float inSize[];
+
+layout (location = 0) out vec4  outColor;
+layout (location = 1) out vec2  outUV;
+layout (location = 2) out float outViewDepth;
+
+#include "../fragments/frame_uniforms.glsl"
+
+#define TYPE_PARTICLE 1
+
+void main() {
+    // Emitters share the buffer with particles when simulating on the GPU, but aren't drawn
+    if (inType[0] != TYPE_PARTICLE) {
+        return;
+    }
+
+    // The rows of the view matrix are the camera's axes in world space
+    vec3 right = vec3(u_View[0][0], u_View[1][0], u_View[2][0]);
+    vec3 up    = vec3(u_View[0][1], u_View[1][1], u_View[2][1]);
+    vec3 center = gl_in[0].gl_Position.xyz;
+    float halfSize = inSize[0] * 0.5;
+    float viewDepth = -(u_View * vec4(center, 1)).z;
+
+    for (int ix = 0; ix < 4; ix++) {
+        vec2 corner = vec2(ix & 1, ix >> 1);
+        vec3 position = center + (right * (corner.x * 2 - 1) + up * (corner.y * 2 - 1)) * halfSize;
+
+        gl_Position  = u_ViewProjection * vec4(position, 1);
+        outColor     = inColor[0];
+        outUV        = corner;
+        outViewDepth = viewDepth;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
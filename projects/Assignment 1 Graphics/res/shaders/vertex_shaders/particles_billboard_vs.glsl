@@ -0,0 +1,22 @@
+#version 450
+
+layout (location = 0) in uint  inType;
+layout (location = 1) in vec3  inPosition;
+layout (location = 3) in vec4  inColor;
+layout (location = 4) in float inLifetime;
+layout (location = 5) in vec4  inMetadata;
+layout (location = 6) in vec2  inSize;
+
+layout (location = 0) out uint  outType;
+layout (location = 1) out vec4  outColor;
+layout (location = 2) out float outSize;
+
+void main() {
+    // Particles store their starting lifetime in metadata.x, and grow from the start to the end size
+    float age = inMetadata.x > 0 ? clamp(1.0 - inLifetime / inMetadata.x, 0, 1) : 0;
+
+    outType  = inType;
+    outColor = inColor;
+    outSize  = mix(inSize.x, inSize.y, age);
+    gl_Position = vec4(inPosition, 1);
+}
@@ -6,6 +6,7 @@ layout (location = 2) in vec3  inVelocity;
 layout (location = 3) in vec4  inColor;
 layout (location = 4) in float inLifetime;
 layout (location = 5) in vec4  inMetadata;
+layout (location = 6) in vec2  inSize;
 
 layout (location = 0) out uint  outType; 
 layout (location = 1) out vec3  outPosition;
@@ -13,6 +14,7 @@ layout (location = 2) out vec3  outVelocity;
 layout (location = 3) out vec4  outColor;
 layout (location = 4) out float outLifetime;
 layout (location = 5) out vec4  outMetadata;
+layout (location = 6) out vec2  outSize;
 
 // Simple passthrough to the geometry shader
 void main() {
@@ -22,5 +24,6 @@ void main() {
     outColor    = inColor;
     outLifetime = inLifetime;
     outMetadata = inMetadata;
+    outSize     = inSize;
 }
 
@@ -12,6 +12,8 @@
 #include "Utils/FileHelpers.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/CookManifest.h"
 
 // Graphics
 #include "Graphics/Buffers/IndexBuffer.h"
@@ -22,6 +24,7 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Textures/TextureCube.h"
+#include "Graphics/Textures/AsyncTextureLoader.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
 #include "Graphics/GuiBatcher.h"
@@ -85,6 +88,12 @@ Application& Application::Get() {
 void Application::Start(int argCount, char** arguments) {
 	LOG_ASSERT(_singleton == nullptr, "Application has already been started!");
 	_singleton = new Application();
+	for (int ix = 1; ix < argCount; ix++) {
+		if (strcmp(arguments[ix], "--convert-scene") == 0 && ix + 2 < argCount) {
+			_singleton->_convertInput  = arguments[++ix];
+			_singleton->_convertOutput = arguments[++ix];
+		}
+	}
 	_singleton->_Run();
 }
 
@@ -111,15 +120,48 @@ void Application::Quit() {
 }
 
 bool Application::LoadScene(const std::string& path) {
-	if (std::filesystem::exists(path)) { 
+	if (VirtualFileSystem::Exists(path)) { 
+		// If the scene has been converted to binary since it was last edited, load the binary version instead
+		std::string scenePath = path;
+		std::string binaryPath = std::filesystem::path(path).replace_extension(BINARY_FILE_EXTENSION).string();
+		auto isUpToDate = [](const std::string& source, const std::string& converted) {
+			std::filesystem::file_time_type sourceTime, convertedTime;
+			if (!VirtualFileSystem::GetWriteTime(source, sourceTime)) {
+				return true;
+			}
+			return VirtualFileSystem::GetWriteTime(converted, convertedTime) && convertedTime >= sourceTime;
+		};
+		if (binaryPath != path && VirtualFileSystem::Exists(binaryPath) &&
+			isUpToDate(path, binaryPath) &&
+			isUpToDate(Gameplay::Scene::GetManifestPath(path), Gameplay::Scene::GetManifestPath(binaryPath))) {
+			scenePath = binaryPath;
+		}
 
-		std::string manifestPath = std::filesystem::path(path).stem().string() + "-manifest.json";
-		if (std::filesystem::exists(manifestPath)) {
+		// Loads the manifest that goes with a scene, returning false if it exists but could not be read
+		auto loadManifest = [](const std::string& scene) {
+			std::string manifestPath = Gameplay::Scene::GetManifestPath(scene);
+			if (!VirtualFileSystem::Exists(manifestPath)) {
+				return true;
+			}
 			LOG_INFO("Loading manifest from \"{}\"", manifestPath);
-ResourceManager::LoadManifest(manifestPath);
+			return ResourceManager::LoadManifest(manifestPath, true);
+		};
+
+		// Binary files are tied to the version that wrote them, so if either the scene or its manifest can't be
+		// read we fall back to the JSON files they were converted from
+		Gameplay::Scene::Sptr scene = nullptr;
+		if (scenePath != path) {
+			if (loadManifest(scenePath)) {
+				scene = Gameplay::Scene::Load(scenePath);
+			}
+			if (scene == nullptr) {
+				LOG_WARN("Failed to load binary scene \"{}\", falling back to \"{}\"", scenePath, path);
+			}
+		}
+		if (scene == nullptr) {
+			loadManifest(path);
+			scene = Gameplay::Scene::Load(path);
 		}
-
-		Gameplay::Scene::Sptr scene = Gameplay::Scene::Load(path);
 		LoadScene(scene);
 		return scene != nullptr;
 	}
@@ -130,6 +172,26 @@ void Application::LoadScene(const Gameplay::Scene::Sptr& scene) {
 	_targetScene = scene;
 }
 
+bool Application::ConvertScene(const std::string& input, const std::string& output) {
+	if (!VirtualFileSystem::Exists(input)) {
+		LOG_ERROR("Cannot convert \"{}\", the file does not exist", input);
+		return false;
+	}
+
+	std::string manifestPath = Gameplay::Scene::GetManifestPath(input);
+	if (VirtualFileSystem::Exists(manifestPath)) {
+		ResourceManager::LoadManifest(manifestPath, true);
+	}
+
+	Gameplay::Scene::Sptr scene = Gameplay::Scene::Load(input);
+	if (scene == nullptr) {
+		return false;
+	}
+	scene->Save(output);
+	ResourceManager::SaveManifest(Gameplay::Scene::GetManifestPath(output));
+	return true;
+}
+
 void Application::SaveSettings()
 {
 	std::filesystem::path appdata = getenv("APPDATA");
@@ -144,18 +206,23 @@ void Application::SaveSettings()
 
 void Application::_Run()
 {
+	// Converting a scene only needs a GL context, so we skip the rest of the layers
+	bool isConverting = !_convertInput.empty();
+
 	// TODO: Register layers
 	_layers.push_back(std::make_shared<GLAppLayer>());
-	_layers.push_back(std::make_shared<DefaultSceneLayer>());
-	_layers.push_back(std::make_shared<LogicUpdateLayer>());
-	_layers.push_back(std::make_shared<RenderLayer>());
-	_layers.push_back(std::make_shared<ParticleLayer>());
-	//_layers.push_back(std::make_shared<InstancedRenderingTestLayer>());
-	_layers.push_back(std::make_shared<InterfaceLayer>());
-
-	// If we're in editor mode, we add all the editor layers
-	if (_isEditor) {
-		_layers.push_back(std::make_shared<ImGuiDebugLayer>());
+	if (!isConverting) {
+		_layers.push_back(std::make_shared<DefaultSceneLayer>());
+		_layers.push_back(std::make_shared<LogicUpdateLayer>());
+		_layers.push_back(std::make_shared<RenderLayer>());
+		_layers.push_back(std::make_shared<ParticleLayer>());
+		//_layers.push_back(std::make_shared<InstancedRenderingTestLayer>());
+		_layers.push_back(std::make_shared<InterfaceLayer>());
+
+		// If we're in editor mode, we add all the editor layers
+		if (_isEditor) {
+			_layers.push_back(std::make_shared<ImGuiDebugLayer>());
+		}
 	}
 
 	// Either load the settings, or use the defaults
@@ -165,6 +232,26 @@ void Application::_Run()
 	_windowSize.x = JsonGet(_appSettings, "window_width", DEFAULT_WINDOW_WIDTH);
 	_windowSize.y = JsonGet(_appSettings, "window_height", DEFAULT_WINDOW_HEIGHT);
 
+	// A budget of 0 disables eviction of unused resources
+	ResourceManager::MemoryBudget = JsonGet(_appSettings, "resource_memory_budget_mb", (size_t)0) * 1024 * 1024;
+
+	// If we have an asset pack, mount it so that loaders read from it instead of from loose files
+	VirtualFileSystem::PreferLooseFiles = JsonGet(_appSettings, "prefer_loose_files", false);
+	std::string assetPack = JsonGet<std::string>(_appSettings, "asset_pack", "assets.pak");
+	if (!assetPack.empty() && std::filesystem::exists(assetPack)) {
+		VirtualFileSystem::Mount(assetPack);
+	}
+
+	// If the asset cooker has been run, make sure what it produced still matches our sources
+	if (CookManifest::Load(CookManifest::DefaultPath)) {
+		size_t numStale = CookManifest::ValidateAll();
+		if (numStale > 0) {
+			LOG_WARN("{} of {} cooked assets are out of date, they will be converted when loaded. Re-run the AssetCooker to update them", numStale, CookManifest::GetEntryCount());
+		} else {
+			LOG_INFO("Validated {} cooked assets", CookManifest::GetEntryCount());
+		}
+	}
+
 	// By default, we want our viewport to be the whole screen
 	_primaryViewport = { 0, 0, _windowSize.x, _windowSize.y };
 
@@ -175,6 +262,14 @@ void Application::_Run()
 	// Load all layers
 	_Load();
 
+	if (isConverting) {
+		bool success = ConvertScene(_convertInput, _convertOutput);
+		LOG_INFO("{} \"{}\" to \"{}\"", success ? "Converted" : "Failed to convert", _convertInput, _convertOutput);
+		_Unload();
+		VirtualFileSystem::UnmountAll();
+		return;
+	}
+
 	// Grab current time as the previous frame
 	double lastFrame = glfwGetTime();
 
@@ -193,6 +288,15 @@ void Application::_Run()
 		// Receive events like input and window position/size changes from GLFW
 		glfwPollEvents();
 
+		// Upload any textures that have finished decoding in the background
+		AsyncTextureLoader::Update();
+
+		// Load queued resources and evict unused ones if we're over our memory budget
+		ResourceManager::Update();
+
+		// Rebuild any shaders whose source files have been modified
+		ShaderProgram::ReloadChangedShaders();
+
 		// Handle closing the app via the close button
 		if (glfwWindowShouldClose(_window)) {
 			_isRunning = false;
@@ -239,6 +343,9 @@ void Application::_Run()
 
 	// Unload all our layers
 	_Unload();
+
+	// Nothing should be holding views into our packs anymore
+	VirtualFileSystem::UnmountAll();
 }
 
 void Application::_RegisterClasses()
@@ -466,6 +573,7 @@ nlohmann::json Application::_GetDefaultAppSettings()
 
 	result["window_width"]  = DEFAULT_WINDOW_WIDTH;
 	result["window_height"] = DEFAULT_WINDOW_HEIGHT;
+	result["resource_memory_budget_mb"] = 0;
 	return result;
 }
 
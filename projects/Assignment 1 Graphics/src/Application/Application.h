@@ -79,6 +79,15 @@ public:
 	 * @param scene The scene to switch to
 	 */
 	void LoadScene(const Gameplay::Scene::Sptr& scene);
+	/**
+	 * Converts a scene and it's resource manifest between the JSON and binary formats. The format of each
+	 * output is picked from it's extension (see Scene::Save), so this works in either direction
+	 * 
+	 * @param input The path to the scene file to convert
+	 * @param output The path to write the converted scene to, the manifest is written next to it
+	 * @returns True if the scene was loaded and converted, false if otherwise
+	 */
+	bool ConvertScene(const std::string& input, const std::string& output);
 
 	/**
 	 * Gets the currently loaded scene that the application is working from
@@ -129,6 +138,11 @@ protected:
 	// The primary viewport that the game will render into, in client window bounds
 	glm::uvec4  _primaryViewport;
 
+	// When set from the command line (--convert-scene <input> <output>), the application converts the
+	// scene and exits instead of running
+	std::string _convertInput;
+	std::string _convertOutput;
+
 	// Stores the current application settings
 	nlohmann::json _appSettings;
 
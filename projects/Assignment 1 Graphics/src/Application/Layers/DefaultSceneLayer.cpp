@@ -30,6 +30,7 @@
 #include "Utils/FileHelpers.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 #include "Utils/GlmDefines.h"
 
 // Gameplay
@@ -92,7 +93,7 @@ void DefaultSceneLayer::_CreateScene()
 
 	bool loadScene = false;
 	// For now we can use a toggle to generate our scene vs load from file
-	if (loadScene && std::filesystem::exists("scene.json")) {
+	if (loadScene && VirtualFileSystem::Exists("scene.json")) {
 		app.LoadScene("scene.json");
 	}
 	else {
@@ -160,16 +161,17 @@ void DefaultSceneLayer::_CreateScene()
 		MeshResource::Sptr buildingMesh1 = ResourceManager::CreateAsset<MeshResource>("building1.obj");
 		MeshResource::Sptr monkeyMesh = ResourceManager::CreateAsset<MeshResource>("TrafficL.obj");
 
-		// Load in some textures
-		Texture2D::Sptr    boxTexture = ResourceManager::CreateAsset<Texture2D>("textures/asphalt.png");
-		Texture2D::Sptr    boxSpec = ResourceManager::CreateAsset<Texture2D>("textures/box-specular.png");
-		Texture2D::Sptr    LightTex = ResourceManager::CreateAsset<Texture2D>("textures/light.png");
-		Texture2D::Sptr    carTex = ResourceManager::CreateAsset<Texture2D>("textures/car.png");
-		Texture2D::Sptr    car2Tex = ResourceManager::CreateAsset<Texture2D>("textures/car2.png");
-		Texture2D::Sptr    buildTex = ResourceManager::CreateAsset<Texture2D>("textures/2build texture.png");
-		Texture2D::Sptr    buildTex2 = ResourceManager::CreateAsset<Texture2D>("textures/2build.png");
-		Texture2D::Sptr    buildTex3 = ResourceManager::CreateAsset<Texture2D>("textures/build.png");
-		Texture2D::Sptr    leafTex = ResourceManager::CreateAsset<Texture2D>("textures/leaves.png");
+		// Load in some textures, these decode in the background and bind a placeholder until they are ready. Maps that
+		// hold linear data rather than color opt out of gamma correct mip generation
+		Texture2D::Sptr    boxTexture = ResourceManager::CreateAsset<Texture2D>("textures/asphalt.png", true);
+		Texture2D::Sptr    boxSpec = ResourceManager::CreateAsset<Texture2D>("textures/box-specular.png", true, false);
+		Texture2D::Sptr    LightTex = ResourceManager::CreateAsset<Texture2D>("textures/light.png", true);
+		Texture2D::Sptr    carTex = ResourceManager::CreateAsset<Texture2D>("textures/car.png", true);
+		Texture2D::Sptr    car2Tex = ResourceManager::CreateAsset<Texture2D>("textures/car2.png", true);
+		Texture2D::Sptr    buildTex = ResourceManager::CreateAsset<Texture2D>("textures/2build texture.png", true);
+		Texture2D::Sptr    buildTex2 = ResourceManager::CreateAsset<Texture2D>("textures/2build.png", true);
+		Texture2D::Sptr    buildTex3 = ResourceManager::CreateAsset<Texture2D>("textures/build.png", true);
+		Texture2D::Sptr    leafTex = ResourceManager::CreateAsset<Texture2D>("textures/leaves.png", true);
 		leafTex->SetMinFilter(MinFilter::Nearest);
 		leafTex->SetMagFilter(MagFilter::Nearest);
 
@@ -294,9 +296,9 @@ void DefaultSceneLayer::_CreateScene()
 
 		Material::Sptr displacementTest = ResourceManager::CreateAsset<Material>(displacementShader);
 		{
-			Texture2D::Sptr displacementMap = ResourceManager::CreateAsset<Texture2D>("textures/displacement_map.png");
-			Texture2D::Sptr normalMap = ResourceManager::CreateAsset<Texture2D>("textures/normal_map.png");
-			Texture2D::Sptr diffuseMap = ResourceManager::CreateAsset<Texture2D>("textures/bricks_diffuse.png");
+			Texture2D::Sptr displacementMap = ResourceManager::CreateAsset<Texture2D>("textures/displacement_map.png", true, false);
+			Texture2D::Sptr normalMap = ResourceManager::CreateAsset<Texture2D>("textures/normal_map.png", true, false);
+			Texture2D::Sptr diffuseMap = ResourceManager::CreateAsset<Texture2D>("textures/bricks_diffuse.png", true);
 
 			displacementTest->Name = "Displacement Map";
 			displacementTest->Set("u_Material.Diffuse", diffuseMap);
@@ -308,8 +310,8 @@ void DefaultSceneLayer::_CreateScene()
 
 		Material::Sptr normalmapMat = ResourceManager::CreateAsset<Material>(tangentSpaceMapping);
 		{
-			Texture2D::Sptr normalMap = ResourceManager::CreateAsset<Texture2D>("textures/normal_map.png");
-			Texture2D::Sptr diffuseMap = ResourceManager::CreateAsset<Texture2D>("textures/bricks_diffuse.png");
+			Texture2D::Sptr normalMap = ResourceManager::CreateAsset<Texture2D>("textures/normal_map.png", true, false);
+			Texture2D::Sptr diffuseMap = ResourceManager::CreateAsset<Texture2D>("textures/bricks_diffuse.png", true);
 
 			normalmapMat->Name = "Tangent Space Normal Map";
 			normalmapMat->Set("u_Material.Diffuse", diffuseMap);
@@ -320,8 +322,8 @@ void DefaultSceneLayer::_CreateScene()
 
 		Material::Sptr multiTextureMat = ResourceManager::CreateAsset<Material>(multiTextureShader);
 		{
-			Texture2D::Sptr sand = ResourceManager::CreateAsset<Texture2D>("textures/terrain/sand.png");
-			Texture2D::Sptr grass = ResourceManager::CreateAsset<Texture2D>("textures/terrain/grass.png");
+			Texture2D::Sptr sand = ResourceManager::CreateAsset<Texture2D>("textures/terrain/sand.png", true);
+			Texture2D::Sptr grass = ResourceManager::CreateAsset<Texture2D>("textures/terrain/grass.png", true);
 
 			multiTextureMat->Name = "Multitexturing";
 			multiTextureMat->Set("u_Material.DiffuseA", sand);
@@ -2,6 +2,7 @@
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 #include "Application/Application.h"
+#include "Graphics/Textures/AsyncTextureLoader.h"
 
 GLAppLayer::GLAppLayer() :
 	ApplicationLayer() {
@@ -27,11 +28,18 @@ void GLAppLayer::OnAppLoad(const nlohmann::json& config) {
 	LOG_ASSERT(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) != 0, "Failed to initialize glad");
 
 	glEnable(GL_PROGRAM_POINT_SIZE);
+
+	// Start decoding threads for textures that are loaded in the background
+	AsyncTextureLoader::Init();
 }
 
 void GLAppLayer::OnAppUnload()
 {
 	Application& app = Application::Get();
+
+	// Stop our texture workers while we still have a GL context
+	AsyncTextureLoader::Shutdown();
+
 	glfwDestroyWindow(app._window);
 	app._window = nullptr;
 	app._windowSize = glm::ivec2(0, 0);
@@ -158,7 +158,7 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Load scene item
 				if (ImGui::MenuItem("Load Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json\0\0");
+					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json;*.scnb\0\0");
 					if (path.has_value()) {
 						app.LoadScene(path.value());
 					}
@@ -166,12 +166,11 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Save scene item
 				if (ImGui::MenuItem("Save Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::SaveFile("Scene File\0*.json\0\0");
+					// Saving with a .scnb extension writes the scene and it's manifest in the binary formats
+					std::optional<std::string> path = FileDialogs::SaveFile("JSON Scene\0*.json\0Binary Scene\0*.scnb\0\0");
 					if (path.has_value()) {
 						app.CurrentScene()->Save(path.value());
-
-						std::string newFilename = std::filesystem::path(path.value()).stem().string() + "-manifest.json";
-						ResourceManager::SaveManifest(newFilename);
+						ResourceManager::SaveManifest(Gameplay::Scene::GetManifestPath(path.value()));
 					}
 				}
 
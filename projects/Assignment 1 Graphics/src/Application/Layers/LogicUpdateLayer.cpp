@@ -1,6 +1,7 @@
 #include "LogicUpdateLayer.h"
 #include "../Application.h"
 #include "../Timing.h"
+#include "Graphics/DebugDraw.h"
 
 LogicUpdateLayer::LogicUpdateLayer() :
 	ApplicationLayer()
@@ -20,4 +21,7 @@ void LogicUpdateLayer::OnUpdate()
 
 	// Update our worlds physics!
 	app.CurrentScene()->DoPhysics(Timing::Current().DeltaTime());
+
+	// Debug primitives should still expire while the game is paused
+	DebugDrawer::Get().Update(Timing::Current().UnscaledDeltaTime());
 }
@@ -1,9 +1,12 @@
 #include "ParticleLayer.h"
 #include "Gameplay/Components/ParticleSystem.h"
+#include "Gameplay/Particles/ParticleBudget.h"
 #include "Application/Application.h"
+#include "Application/Layers/RenderLayer.h"
 
 ParticleLayer::ParticleLayer() :
-	ApplicationLayer()
+	ApplicationLayer(),
+	_depthCopy(nullptr)
 {
 	Name = "Particles";
 	Overrides = AppLayerFunctions::OnUpdate | AppLayerFunctions::OnRender;
@@ -16,6 +19,9 @@ void ParticleLayer::OnUpdate()
 {
 	Application& app = Application::Get();
 
+	// Culling and LOD also apply while editing, so that rendering matches what we'd see in game
+	ParticleBudget::Update(app.CurrentScene());
+
 	// Only update the particle systems when the game is playing, so we can edit them in
 	// the inspector
 	if (app.CurrentScene()->IsPlaying) {
@@ -29,9 +35,45 @@ void ParticleLayer::OnUpdate()
 
 void ParticleLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 {
-	Application::Get().CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
+	Application& app = Application::Get();
+
+	// Only pay for the depth copy if something is going to read it
+	bool needsDepth = false;
+	app.CurrentScene()->Components().Each<ParticleSystem>([&](const ParticleSystem::Sptr& system) {
+		needsDepth |= system->NeedsSceneDepth();
+	});
+	if (needsDepth) {
+		_CopySceneDepth();
+	}
+
+	app.CurrentScene()->Components().Each<ParticleSystem>([](const ParticleSystem::Sptr& system) {
 		if (system->IsEnabled) {
 			system->Render();
 		}
 	});
 }
+
+void ParticleLayer::_CopySceneDepth()
+{
+	RenderLayer::Sptr renderLayer = Application::Get().GetLayer<RenderLayer>();
+	if (renderLayer == nullptr) {
+		return;
+	}
+	const Framebuffer::Sptr& primary = renderLayer->GetPrimaryFBO();
+
+	// Create the copy the first time it's needed, and keep it the same size as the primary framebuffer
+	if (_depthCopy == nullptr) {
+		FramebufferDescriptor descriptor;
+		descriptor.Width = primary->GetWidth();
+		descriptor.Height = primary->GetHeight();
+		descriptor.RenderTargets[RenderTargetAttachment::DepthStencil] = { true, RenderTargetType::DepthStencil };
+		_depthCopy = std::make_shared<Framebuffer>(descriptor);
+	} else if (_depthCopy->GetSize() != primary->GetSize()) {
+		_depthCopy->Resize(primary->GetSize());
+	}
+
+	// Blitting unbinds both framebuffers, so we need to rebind the primary to keep drawing into it
+	Framebuffer::Blit(primary, _depthCopy, BufferFlags::Depth, MagFilter::Nearest);
+	primary->Bind();
+	_depthCopy->BindAttachment(RenderTargetAttachment::DepthStencil, ParticleSystem::SCENE_DEPTH_SLOT);
+}
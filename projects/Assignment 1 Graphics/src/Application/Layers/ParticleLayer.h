@@ -11,4 +11,12 @@ public:
 	void OnUpdate() override;
 	void OnRender(const Framebuffer::Sptr& prevLayer) override;
 
-};
\ No newline at end of file
+protected:
+	// A copy of the scene's depth for soft particles, since they can't sample the depth buffer they're being tested against
+	Framebuffer::Sptr _depthCopy;
+
+	/// <summary>
+	/// Copies the depth from the primary framebuffer into _depthCopy and binds it for the particle shaders
+	/// </summary>
+	void _CopySceneDepth();
+};
@@ -52,6 +52,10 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 	// Cache the camera's viewprojection
 	glm::mat4 viewProj = camera->GetViewProjection();
+	// We'll need the view and projection seperately for selecting LODs
+	const glm::mat4& view = camera->GetView();
+	const glm::mat4& projection = camera->GetProjection();
+	bool isOrtho = camera->GetOrthoEnabled();
 	DebugDrawer::Get().SetViewProjection(viewProj);
 
 	// Make sure depth testing and culling are re-enabled
@@ -139,16 +143,23 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 		// Grab the game object so we can do some stuff with it
 		GameObject* object = renderable->GetGameObject();
+		const glm::mat4& transform = object->GetTransform();
+
+		// Estimate how large the object's bounds appear on screen (as a fraction of the screen height) so we can select a LOD
+		float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		float depth = isOrtho ? 1.0f : glm::max(-(view * transform[3]).z, 0.0001f);
+		float screenSize = renderable->GetMeshResource()->BoundingRadius * scale * projection[1][1] / depth;
+		VertexArrayObject::Sptr mesh = renderable->GetMeshForScreenSize(screenSize);
 
 		// Use our uniform buffer for our instance level uniforms
 		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
+		instanceData.u_Model = transform;
+		instanceData.u_ModelViewProjection = viewProj * transform;
+		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(transform)));
 		_instanceUniforms->Update();
 
 		// Draw the object
-		renderable->GetMesh()->Draw();
+		mesh->Draw();
 	});
 
 	// Use our cubemap to draw our skybox
@@ -2,6 +2,8 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Graphics/DebugDraw.h"
+#include "Gameplay/Particles/ParticleBudget.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -26,6 +28,29 @@ void DebugWindow::RenderMenuBar()
 
 	ImGui::Separator();
 
+	DebugDrawer& drawer = DebugDrawer::Get();
+	if (ImGui::BeginCombo("Debug Draw", "categories")) {
+		for (DebugDrawCategory category : { DebugDrawCategory::General, DebugDrawCategory::Physics, DebugDrawCategory::Lighting, DebugDrawCategory::Gameplay }) {
+			bool enabled = drawer.IsCategoryEnabled(category);
+			if (ImGui::Checkbox((~category).c_str(), &enabled)) {
+				drawer.SetCategoryEnabled(category, enabled);
+			}
+		}
+		ImGui::Checkbox("Frustum Culling", &DebugDrawer::EnableCulling);
+		ImGui::EndCombo();
+	}
+
+	ImGui::Separator();
+
+	const ParticleBudget::Stats& particleStats = ParticleBudget::GetStats();
+	std::string particleLabel = std::to_string(particleStats.Allocated) + " / " + std::to_string(ParticleBudget::MaxParticles);
+	if (ImGui::BeginCombo("Particles", particleLabel.c_str())) {
+		ParticleBudget::RenderImGui();
+		ImGui::EndCombo();
+	}
+
+	ImGui::Separator();
+
 	RenderFlags flags = renderLayer->GetRenderFlags();
 	bool changed = false;
 	bool temp = *(flags & RenderFlags::EnableColorCorrection);
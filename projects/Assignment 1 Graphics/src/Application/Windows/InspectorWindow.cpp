@@ -77,6 +77,7 @@ void InspectorWindow::Render()
 
 			if (_RenderComponent(component)) {
 				selection->_components.erase(selection->_components.begin() + ix);
+				selection->MarkGuiDirty();
 				ix--;
 			}
 		}
@@ -119,7 +120,11 @@ bool InspectorWindow::_RenderComponent(Gameplay::IComponent::Sptr component)
 
 	ImGuiID id = ImGui::GetID(component->ComponentTypeName().c_str());
 	bool isOpen = ImGui::CollapsingHeader(component->ComponentTypeName().c_str(), ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_ClipLabelForTrailingButton);
+	bool wasEnabled = component->IsEnabled;
 	ImGuiHelper::HeaderCheckbox(id, &component->IsEnabled);
+	if (component->IsEnabled != wasEnabled) {
+		component->GetGameObject()->MarkGuiDirty();
+	}
 	
 	if (ImGui::BeginPopupContextItem()) {
 		if (ImGui::MenuItem("Copy Values")) {
@@ -50,6 +50,17 @@ namespace Gameplay {
 		return result;
 	}
 
+	void Camera::save(BinaryOutputArchive& archive) const
+	{
+		archive(_nearPlane, _farPlane, _fovRadians, _orthoVerticalScale, _isOrtho, _clearColor);
+	}
+
+	void Camera::load(BinaryInputArchive& archive)
+	{
+		archive(_nearPlane, _farPlane, _fovRadians, _orthoVerticalScale, _isOrtho, _clearColor);
+		_isProjectionDirty = true;
+	}
+
 	Camera::Camera() :
 		_nearPlane(0.1f),
 		_farPlane(1000.0f),
@@ -25,6 +25,8 @@ namespace Gameplay {
 
 		virtual nlohmann::json ToJson() const override;
 		static Camera::Sptr FromJson(const nlohmann::json& data);
+		void save(BinaryOutputArchive& archive) const;
+		void load(BinaryInputArchive& archive);
 
 
 	public:
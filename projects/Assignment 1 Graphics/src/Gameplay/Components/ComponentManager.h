@@ -15,6 +15,8 @@ namespace Gameplay {
 	public:
 		typedef std::function<IComponent::Sptr(const nlohmann::json&)> LoadComponentFunc;
 		typedef std::function<IComponent::Sptr()> CreateComponentFunc;
+		typedef std::function<IComponent::Sptr(BinaryInputArchive&)> LoadBinaryComponentFunc;
+		typedef std::function<void(const IComponent::Sptr&, BinaryOutputArchive&)> SaveBinaryComponentFunc;
 
 		/// <summary>
 		/// Loads a component with the given type name from a JSON blob
@@ -49,6 +51,48 @@ namespace Gameplay {
 			return nullptr;
 		}
 
+		/// <summary>
+		/// Loads a component with the given type name from a binary archive, the inverse of SaveBinary
+		/// If the type name does not correspond to a registered type, will
+		/// return nullptr and the archive will be left part way through the component
+		/// </summary>
+		/// <param name="typeName">The name of the type to load (taken from GetComponentTypeName of component)</param>
+		/// <param name="archive">The archive to read the component from</param>
+		/// <returns>The component as decoded from the archive, or nullptr</returns>
+		inline IComponent::Sptr LoadBinary(const std::string& typeName, BinaryInputArchive& archive) {
+			std::optional<std::type_index> typeIndex = _TypeNameMap[typeName];
+			if (typeIndex.has_value()) {
+				LoadBinaryComponentFunc callback = _TypeLoadBinaryRegistry[typeIndex.value()];
+				if (callback) {
+					// Invoke the loader, also load additional component data
+					IComponent::Sptr result = callback(archive);
+					IComponent::LoadBaseBinary(result, archive);
+
+					// Make sure the component knows it's own type
+					result->_realType = typeIndex.value();
+					result->_weakSelfPtr = result;
+
+					// Add the component to the global pools
+					_Components[result->_realType].push_back(result);
+					return result;
+				}
+			}
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Writes a component's data to a binary archive, using the component's save function if it has
+		/// one, or it's JSON representation if not. Note that the type name is not stored
+		/// </summary>
+		/// <param name="component">The component to store</param>
+		/// <param name="archive">The archive to write to</param>
+		static void SaveBinary(const IComponent::Sptr& component, BinaryOutputArchive& archive) {
+			SaveBinaryComponentFunc callback = _TypeSaveBinaryRegistry[component->_realType];
+			LOG_ASSERT(callback != nullptr, "You must register component types before saving them!");
+			callback(component, archive);
+			IComponent::SaveBaseBinary(component, archive);
+		}
+
 		/// <summary>
 		/// Creates a component with the given type name
 		/// If the type name does not correspond to a registered type, will
@@ -226,6 +270,8 @@ namespace Gameplay {
 				// name to type index mapping
 				_TypeLoadRegistry[type] = &ComponentManager::ParseTypeFromBlob<T>;
 				_TypeCreateRegistry[type] = &ComponentManager::_InternalCreate<T>;
+				_TypeLoadBinaryRegistry[type] = &ComponentManager::ParseTypeFromBinary<T>;
+				_TypeSaveBinaryRegistry[type] = &ComponentManager::WriteTypeToBinary<T>;
 				_TypeNameMap[StringTools::SanitizeClassName(typeid(T).name())] = type;
 			}
 		}
@@ -249,6 +295,9 @@ namespace Gameplay {
 		inline static std::unordered_map<std::type_index, LoadComponentFunc> _TypeLoadRegistry;
 		// Stores functions to load components from JSON, indexed on the type that they load
 		inline static std::unordered_map<std::type_index, CreateComponentFunc> _TypeCreateRegistry;
+		// Stores functions to load and save components in binary scenes, indexed on the type that they handle
+		inline static std::unordered_map<std::type_index, LoadBinaryComponentFunc> _TypeLoadBinaryRegistry;
+		inline static std::unordered_map<std::type_index, SaveBinaryComponentFunc> _TypeSaveBinaryRegistry;
 
 		// Weak pointers let us store a reference to an object stored by a shared pointer, without
 		// actually increasing the reference count. Thus components will be destroyed at the correct
@@ -260,6 +309,29 @@ namespace Gameplay {
 			return T::FromJson(blob);
 		}
 
+		template <typename T>
+		static IComponent::Sptr ParseTypeFromBinary(BinaryInputArchive& archive) {
+			if constexpr (cereal::traits::is_input_serializable<T, BinaryInputArchive>::value) {
+				std::shared_ptr<T> result = std::make_shared<T>();
+				archive(*result);
+				return result;
+			} else {
+				// Types without binary support are stored as CBOR encoded JSON
+				std::vector<uint8_t> data;
+				archive(data);
+				return T::FromJson(nlohmann::json::from_cbor(data));
+			}
+		}
+
+		template <typename T>
+		static void WriteTypeToBinary(const IComponent::Sptr& component, BinaryOutputArchive& archive) {
+			if constexpr (cereal::traits::is_output_serializable<T, BinaryOutputArchive>::value) {
+				archive(*std::static_pointer_cast<T>(component));
+			} else {
+				archive(nlohmann::json::to_cbor(component->ToJson()));
+			}
+		}
+
 		template <typename ComponentType>
 		static IComponent::Sptr _InternalCreate() {
 			// We can use typeid and type_index to get a unique ID for our types
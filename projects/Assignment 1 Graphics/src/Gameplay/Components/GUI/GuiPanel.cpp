@@ -15,6 +15,7 @@ GuiPanel::~GuiPanel() = default;
 
 void GuiPanel::SetColor(const glm::vec4& color) {
 	_color = color;
+	MarkGuiDirty();
 }
 
 const glm::vec4& GuiPanel::GetColor() const {
@@ -27,6 +28,7 @@ int GuiPanel::GetBorderRadius() const {
 
 void GuiPanel::SetBorderRadius(int value) {
 	_borderRadius = value;
+	MarkGuiDirty();
 }
 
 Texture2D::Sptr GuiPanel::GetTexture() const {
@@ -35,6 +37,8 @@ Texture2D::Sptr GuiPanel::GetTexture() const {
 
 void GuiPanel::SetTexture(const Texture2D::Sptr& value) {
 	_texture = value;
+	GuiBatcher::AddToAtlas(_texture);
+	MarkGuiDirty();
 }
 
 void GuiPanel::Awake() {
@@ -43,6 +47,7 @@ void GuiPanel::Awake() {
 		IsEnabled = false;
 		LOG_WARN("Failed to find a rect transform for a GUI panel, disabling");
 	}
+	GuiBatcher::AddToAtlas(_texture);
 }
 
 void GuiPanel::StartGUI() {
@@ -57,8 +62,12 @@ void GuiPanel::FinishGUI() {
 
 void GuiPanel::RenderImGui()
 {
-	LABEL_LEFT(ImGui::ColorEdit4, "Color ", &_color.x);
-	LABEL_LEFT(ImGui::DragInt,    "Radius", &_borderRadius, 1, 0, 128);
+	bool changed = false;
+	changed |= LABEL_LEFT(ImGui::ColorEdit4, "Color ", &_color.x);
+	changed |= LABEL_LEFT(ImGui::DragInt,    "Radius", &_borderRadius, 1, 0, 128);
+	if (changed) {
+		MarkGuiDirty();
+	}
 }
 
 nlohmann::json GuiPanel::ToJson() const {
@@ -78,3 +87,13 @@ GuiPanel::Sptr GuiPanel::FromJson(const nlohmann::json& blob) {
 
 	return result;
 }
+
+void GuiPanel::save(BinaryOutputArchive& archive) const {
+	archive(_color, _borderRadius, GuidOrNull(_texture));
+}
+
+void GuiPanel::load(BinaryInputArchive& archive) {
+	Guid texture;
+	archive(_color, _borderRadius, texture);
+	_texture = ResourceManager::Get<Texture2D>(texture);
+}
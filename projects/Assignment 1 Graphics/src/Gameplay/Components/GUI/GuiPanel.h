@@ -52,6 +52,8 @@ public:
 	MAKE_TYPENAME(GuiPanel);
 	virtual nlohmann::json ToJson() const override;
 	static GuiPanel::Sptr FromJson(const nlohmann::json& blob);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 
 protected:
 	int             _borderRadius;
@@ -13,14 +13,16 @@ GuiText::GuiText() :
 	_text(LR"()"), // The LR and parenthesis tell us it's a unicode string (wide string)
 	_color(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)),
 	_font(nullptr),
-	_textSize(glm::vec2(0.0f)),
-	_textScale(1.0f)
+	_textScale(1.0f),
+	_alignment(TextAlignment::Center),
+	_wordWrap(false)
 { }
 
 GuiText::~GuiText() = default;
 
 void GuiText::SetColor(const glm::vec4& color) {
 	_color = color;
+	MarkGuiDirty();
 }
 
 const glm::vec4& GuiText::GetColor() const {
@@ -40,11 +42,12 @@ const std::wstring& GuiText::GetTextUnicode() const {
 }
 
 void GuiText::SetTextUnicode(const std::wstring& value) {
-	_text = value;
-	
-	if (_font != nullptr) {
-		_textSize = _font->MeausureString(_text, _textScale);
+	// Avoid rebuilding the GUI when the text is set to the same value every frame
+	if (value == _text) {
+		return;
 	}
+	_text = value;
+	MarkGuiDirty();
 }
 
 const float GuiText::GetTextScale() const {
@@ -53,6 +56,7 @@ const float GuiText::GetTextScale() const {
 
 void GuiText::SetTextScale(float value) {
 	_textScale = value;
+	MarkGuiDirty();
 }
 
 const Font::Sptr& GuiText::GetFont() const {
@@ -61,9 +65,25 @@ const Font::Sptr& GuiText::GetFont() const {
 
 void GuiText::SetFont(const Font::Sptr& font) {
 	_font = font;
-	if (_font != nullptr) {
-		_textSize = _font->MeausureString(_text, _textScale);
-	}
+	MarkGuiDirty();
+}
+
+TextAlignment GuiText::GetAlignment() const {
+	return _alignment;
+}
+
+void GuiText::SetAlignment(TextAlignment value) {
+	_alignment = value;
+	MarkGuiDirty();
+}
+
+bool GuiText::GetWordWrap() const {
+	return _wordWrap;
+}
+
+void GuiText::SetWordWrap(bool value) {
+	_wordWrap = value;
+	MarkGuiDirty();
 }
 
 void GuiText::Awake() {
@@ -77,9 +97,17 @@ void GuiText::Awake() {
 void GuiText::RenderGUI()
 {
 	if (_font != nullptr && !_text.empty()) {
-		glm::vec2 position = _transform->GetSize() / 2.0f;
-		position -= _textSize / 2.0f;
-		GuiBatcher::RenderText(_text, _font, position, _color, _textScale);
+		glm::vec2 size = _transform->GetSize();
+		const TextLayoutCache::Layout& layout = TextLayoutCache::Get(_text, _font, _textScale, _color, _alignment, _wordWrap ? size.x : 0.0f);
+
+		// Lines are aligned within the text block, so we only need to place the block itself
+		glm::vec2 position = glm::vec2(0.0f, (size.y - layout.Size.y) / 2.0f);
+		switch (_alignment) {
+			case TextAlignment::Center: position.x = (size.x - layout.Size.x) / 2.0f; break;
+			case TextAlignment::Right:  position.x = size.x - layout.Size.x; break;
+			default: break;
+		}
+		GuiBatcher::RenderText(layout, position);
 	}
 }
 
@@ -90,16 +118,20 @@ void GuiText::RenderImGui()
 	memcpy(buffer, ascii.data(), ascii.size());
 
 	if (LABEL_LEFT(ImGui::InputTextMultiline, "Text", buffer, 4096)) {
-		_text = StringConvert.from_bytes(buffer);
-		if (_font != nullptr) {
-			_textSize = _font->MeausureString(_text, _textScale);
-		}
+		SetTextUnicode(StringConvert.from_bytes(buffer));
+	}
+	if (LABEL_LEFT(ImGui::ColorEdit4, "Color", &_color.x)) {
+		MarkGuiDirty();
 	}
-	LABEL_LEFT(ImGui::ColorEdit4, "Color", &_color.x);
 	if (LABEL_LEFT(ImGui::DragFloat, "Scale", &_textScale, 0.01f)) {
-		if (_font != nullptr) {
-			_textSize = _font->MeausureString(_text, _textScale);
-		}
+		SetTextScale(_textScale);
+	}
+	int alignment = (int)_alignment;
+	if (LABEL_LEFT(ImGui::Combo, "Alignment", &alignment, "Left\0Center\0Right\0")) {
+		SetAlignment((TextAlignment)alignment);
+	}
+	if (LABEL_LEFT(ImGui::Checkbox, "Word Wrap", &_wordWrap)) {
+		MarkGuiDirty();
 	}
 }
 
@@ -108,7 +140,9 @@ nlohmann::json GuiText::ToJson() const {
 		{ "color", _color },
 		{ "text",  _text },
 		{ "scale", _textScale },
-		{ "font",  _font  ? _font->GetGUID().str() : "null" }
+		{ "font",  _font  ? _font->GetGUID().str() : "null" },
+		{ "alignment", ~_alignment },
+		{ "word_wrap", _wordWrap }
 	};
 }
 
@@ -118,5 +152,17 @@ GuiText::Sptr GuiText::FromJson(const nlohmann::json& blob) {
 	result->_textScale = JsonGet(blob, "scale", 1.0f);
 	result->_text      = JsonGet<std::wstring>(blob, "text", LR"()");
 	result->_font      = ResourceManager::Get<Font>(Guid(JsonGet<std::string>(blob, "font", "null")));
+	result->_alignment = JsonParseEnum(TextAlignment, blob, "alignment", TextAlignment::Center);
+	result->_wordWrap  = JsonGet(blob, "word_wrap", false);
 	return result;
 }
+
+void GuiText::save(BinaryOutputArchive& archive) const {
+	archive(_color, _text, _textScale, GuidOrNull(_font), _alignment, _wordWrap);
+}
+
+void GuiText::load(BinaryInputArchive& archive) {
+	Guid font;
+	archive(_color, _text, _textScale, font, _alignment, _wordWrap);
+	_font = ResourceManager::Get<Font>(font);
+}
@@ -2,6 +2,7 @@
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/GUI/RectTransform.h"
 #include "Graphics/Font.h"
+#include "Graphics/TextLayoutCache.h"
 
 /// <summary>
 /// Renders text for UI components
@@ -63,6 +64,24 @@ public:
 	/// </summary>
 	void SetFont(const Font::Sptr& font);
 
+	/// <summary>
+	/// Gets how lines of text are aligned horizontally within the element
+	/// </summary>
+	TextAlignment GetAlignment() const;
+	/// <summary>
+	/// Sets how lines of text are aligned horizontally within the element
+	/// </summary>
+	void SetAlignment(TextAlignment value);
+
+	/// <summary>
+	/// Gets whether lines are broken between words to fit within the width of the element
+	/// </summary>
+	bool GetWordWrap() const;
+	/// <summary>
+	/// Sets whether lines are broken between words to fit within the width of the element
+	/// </summary>
+	void SetWordWrap(bool value);
+
 
 public:
 	// Inherited from IComponent
@@ -73,13 +92,16 @@ public:
 	MAKE_TYPENAME(GuiText);
 	virtual nlohmann::json ToJson() const override;
 	static GuiText::Sptr FromJson(const nlohmann::json& blob);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 
 protected:
 	std::wstring    _text;
 	glm::vec4       _color;
 	Font::Sptr      _font;
-	glm::vec2       _textSize;
 	float           _textScale;
+	TextAlignment   _alignment;
+	bool            _wordWrap;
 
 	RectTransform::Sptr _transform;
 };
\ No newline at end of file
@@ -24,6 +24,7 @@ const glm::vec2& RectTransform::GetPosition() const {
 void RectTransform::SetPosition(const glm::vec2& pos) {
 	_position = pos;
 	_transformDirty = true;
+	MarkGuiDirty();
 }
 
 glm::vec2 RectTransform::GetMin() const {
@@ -36,6 +37,7 @@ void RectTransform::SetMin(const glm::vec2& value)
 	_halfSize = newSize / 2.0f;
 	_position = value + _halfSize;
 	_transformDirty = true;
+	MarkGuiDirty();
 }
 
 glm::vec2 RectTransform::GetMax() const {
@@ -46,17 +48,22 @@ void RectTransform::SetMax(const glm::vec2& value) {
 	_halfSize = newSize / 2.0f;
 	_position = value - _halfSize;
 	_transformDirty = true;
+	MarkGuiDirty();
 }
 
 glm::vec2 RectTransform::GetSize() const {
 	return _halfSize * 2.0f;
 }
 void RectTransform::SetSize(const glm::vec2& value) {
-	_halfSize = value * 2.0f;
+	_halfSize = value / 2.0f;
+	_transformDirty = true;
+	MarkGuiDirty();
 }
 
 void RectTransform::SetRotationDeg(float value) {
 	_rotation = glm::radians(value);
+	_transformDirty = true;
+	MarkGuiDirty();
 }
 
 float RectTransform::GetRotationDeg() const {
@@ -70,11 +77,13 @@ const glm::mat3& RectTransform::GetLocalTransform() const {
 
 void RectTransform::RenderImGui()
 {
-	_transformDirty |= LABEL_LEFT(ImGui::DragFloat2, "Position", &_position.x, 0.01f);
+	if (LABEL_LEFT(ImGui::DragFloat2, "Position", &_position.x, 0.01f)) {
+		_transformDirty = true;
+		MarkGuiDirty();
+	}
 	float degrees = glm::degrees(_rotation);
 	if (LABEL_LEFT(ImGui::DragFloat, "Rotation", &degrees, 0.1f)) {
-		_transformDirty = true;
-		_rotation = glm::radians(degrees);
+		SetRotationDeg(degrees);
 	}
 	glm::vec2 temp = GetSize();
 	if (LABEL_LEFT(ImGui::DragFloat2, "Size    ", &temp.x, 0.1f)) {
@@ -118,6 +127,15 @@ RectTransform::Sptr RectTransform::FromJson(const nlohmann::json& blob)
 	return result;
 }
 
+void RectTransform::save(BinaryOutputArchive& archive) const {
+	archive(_position, _halfSize, _rotation);
+}
+
+void RectTransform::load(BinaryInputArchive& archive) {
+	archive(_position, _halfSize, _rotation);
+	_transformDirty = true;
+}
+
 void RectTransform::__RecalcTransforms() const {
 	if (_transformDirty) {
 		_transform = glm::translate(MAT3_IDENTITY, _position) * glm::rotate(MAT3_IDENTITY, _rotation) * glm::translate(MAT3_IDENTITY, -_halfSize);
@@ -75,6 +75,8 @@ public:
 	virtual void StartGUI() override;
 	virtual void FinishGUI() override;
 	static RectTransform::Sptr FromJson(const nlohmann::json& blob);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 	MAKE_TYPENAME(RectTransform);
 
 protected:
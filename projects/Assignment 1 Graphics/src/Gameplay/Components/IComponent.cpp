@@ -12,6 +12,13 @@ namespace Gameplay {
 		return _weakSelfPtr;
 	}
 
+	void IComponent::MarkGuiDirty() {
+		// Components loaded from files won't be attached to an object yet
+		if (_context != nullptr) {
+			_context->MarkGuiDirty();
+		}
+	}
+
 	void IComponent::LoadBaseJson(const Sptr& result, const nlohmann::json& blob)
 	{
 		result->OverrideGUID(Guid(blob["guid"]));
@@ -24,6 +31,18 @@ namespace Gameplay {
 		data["enabled"] = instance->IsEnabled;
 	}
 
+	void IComponent::LoadBaseBinary(const Sptr& result, BinaryInputArchive& archive)
+	{
+		Guid guid;
+		archive(guid, result->IsEnabled);
+		result->OverrideGUID(guid);
+	}
+
+	void IComponent::SaveBaseBinary(const Sptr& instance, BinaryOutputArchive& archive)
+	{
+		archive(instance->GetGUID(), instance->IsEnabled);
+	}
+
 	IComponent::IComponent() :
 		IResource(),
 		IsEnabled(true),
@@ -5,6 +5,7 @@
 #include <GLM/glm.hpp>
 
 #include "Utils/StringUtils.h"
+#include "Utils/BinarySerialization.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/TypeHelpers.h"
@@ -27,6 +28,14 @@ namespace Gameplay {
 	/// static std::shared_ptr<Type> FromJson(const nlohmann::json&);
 	/// 
 	/// where Type is the Type of component
+	/// 
+	/// Components may also define member functions for storing them in binary scenes:
+	/// 
+	/// void save(BinaryOutputArchive&) const;
+	/// void load(BinaryInputArchive&);
+	/// 
+	/// (or a single serialize member that does both). Components without them are stored in binary
+	/// scenes using their JSON representation
 	/// </summary>
 	class IComponent : public IResource {
 	public:
@@ -156,6 +165,12 @@ namespace Gameplay {
 	protected:
 		IComponent();
 
+		/// <summary>
+		/// Marks the GUI geometry of the gameobject this component is attached to as out of date, should be
+		/// invoked whenever something this component draws in the GUI changes (see GameObject::MarkGuiDirty)
+		/// </summary>
+		void MarkGuiDirty();
+
 	private:
 		friend class ComponentManager;
 		friend class GameObject;
@@ -169,6 +184,8 @@ namespace Gameplay {
 
 		static void LoadBaseJson(const IComponent::Sptr& result, const nlohmann::json& blob);
 		static void SaveBaseJson(const IComponent::Sptr& instance, nlohmann::json& data);
+		static void LoadBaseBinary(const IComponent::Sptr& result, BinaryInputArchive& archive);
+		static void SaveBaseBinary(const IComponent::Sptr& instance, BinaryOutputArchive& archive);
 	};
 
 	/// <summary>
@@ -36,6 +36,14 @@ JumpBehaviour::Sptr JumpBehaviour::FromJson(const nlohmann::json& blob) {
 	return result;
 }
 
+void JumpBehaviour::save(BinaryOutputArchive& archive) const {
+	archive(_impulse);
+}
+
+void JumpBehaviour::load(BinaryInputArchive& archive) {
+	archive(_impulse);
+}
+
 void JumpBehaviour::Update(float deltaTime) {
 	if (InputEngine::GetKeyState(GLFW_KEY_SPACE) == ButtonState::Pressed) {
 		_body->ApplyImpulse(glm::vec3(0.0f, 0.0f, _impulse));
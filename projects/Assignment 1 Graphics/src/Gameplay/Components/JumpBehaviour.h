@@ -23,6 +23,8 @@ public:
 	MAKE_TYPENAME(JumpBehaviour);
 	virtual nlohmann::json ToJson() const override;
 	static JumpBehaviour::Sptr FromJson(const nlohmann::json& blob);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 
 protected:
 	float _impulse;
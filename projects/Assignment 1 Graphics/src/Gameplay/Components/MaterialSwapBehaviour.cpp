@@ -43,3 +43,14 @@ MaterialSwapBehaviour::Sptr MaterialSwapBehaviour::FromJson(const nlohmann::json
 	result->ExitMaterial  = ResourceManager::Get<Gameplay::Material>(Guid(blob["exit_material"]));
 	return result;
 }
+
+void MaterialSwapBehaviour::save(BinaryOutputArchive& archive) const {
+	archive(GuidOrNull(EnterMaterial), GuidOrNull(ExitMaterial));
+}
+
+void MaterialSwapBehaviour::load(BinaryInputArchive& archive) {
+	Guid enterMaterial, exitMaterial;
+	archive(enterMaterial, exitMaterial);
+	EnterMaterial = ResourceManager::Get<Gameplay::Material>(enterMaterial);
+	ExitMaterial  = ResourceManager::Get<Gameplay::Material>(exitMaterial);
+}
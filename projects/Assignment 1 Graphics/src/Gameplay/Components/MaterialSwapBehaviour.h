@@ -27,6 +27,8 @@ public:
 	virtual void RenderImGui() override;
 	virtual nlohmann::json ToJson() const override;
 	static MaterialSwapBehaviour::Sptr FromJson(const nlohmann::json& blob);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 	MAKE_TYPENAME(MaterialSwapBehaviour);
 
 protected:
@@ -1,21 +1,41 @@
 #include "ParticleSystem.h"
+#include <chrono>
 #include "Utils/JsonGlmHelpers.h"
 #include "Application/Timing.h"
 #include "Application/Application.h"
 #include "Utils/ImGuiHelper.h"
+#include "Gameplay/Components/Camera.h"
 
 ParticleSystem::ParticleSystem() :
 	IComponent(),
 	_hasInit(false),
+	_simulationMode(ParticleSimulationMode::Gpu),
+	_cpuSimulator(CpuParticleSimulator()),
+	_simulationTime(0.0f),
+	_renderMode(ParticleRenderMode::Points),
+	_softParticles(false),
+	_softDistance(0.5f),
+	_drawOrder(),
+	_priority(1.0f),
+	_isCulled(false),
+	_emissionScale(1.0f),
+	_updateInterval(1),
+	_framesSinceStep(0),
+	_pendingTime(0.0f),
 	_maxParticles(1000),
 	_numParticles(0),
 	_particleBuffers(),
 	_feedbackBuffers(),
-	_query(0),
+	_queries(),
+	_timerQueries(),
+	_queryHead(0),
+	_queriesInFlight(0),
+	_statsReadback(true),
 	_currentVertexBuffer(0),
 	_currentFeedbackBuffer(1),
 	_updateShader(nullptr),
 	_renderShader(nullptr),
+	_billboardShader(nullptr),
 	_gravity({ 0, 0, -9.81f }),
 	_emitters()
 { }
@@ -25,13 +45,51 @@ ParticleSystem::~ParticleSystem()
 	if (_hasInit) {
 		glDeleteBuffers(2, _particleBuffers);
 		glDeleteTransformFeedbacks(2, _feedbackBuffers);
-		glDeleteQueries(1, &_query);
+		glDeleteQueries(QUERY_RING_SIZE, _queries);
+		glDeleteQueries(QUERY_RING_SIZE, _timerQueries);
 		_updateShader = nullptr;
 		_renderShader = nullptr;
+		_billboardShader = nullptr;
 	}
 }
 
 void ParticleSystem::Update()
+{
+	// Culled systems are frozen until they come back into view
+	if (_isCulled) {
+		_pendingTime = 0.0f;
+		_framesSinceStep = 0;
+		return;
+	}
+
+	// Distant systems are stepped less often, by all the time they've missed
+	_pendingTime += Timing::Current().DeltaTime();
+	_framesSinceStep++;
+	if (_hasInit && _framesSinceStep < _updateInterval) {
+		return;
+	}
+	float dt = _pendingTime;
+	_pendingTime = 0.0f;
+	_framesSinceStep = 0;
+
+	if (_simulationMode == ParticleSimulationMode::Cpu) {
+		auto startTime = std::chrono::high_resolution_clock::now();
+		_UpdateCpu(dt);
+		_RecordSimulationTime(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count());
+	} else {
+		// Timing the GPU pass on the CPU would only measure how long it takes to submit the commands, the
+		// actual simulation time comes back from the timer queries
+		_UpdateGpu(dt);
+	}
+}
+
+void ParticleSystem::_RecordSimulationTime(float milliseconds)
+{
+	// Smooth the timing out a bit so it's readable in the inspector
+	_simulationTime = _simulationTime == 0.0f ? milliseconds : glm::mix(_simulationTime, milliseconds, 0.05f);
+}
+
+void ParticleSystem::_UpdateGpu(float dt)
 {
 	// If we haven't previously initialized our data, initialize it now
 	if (!_hasInit) {
@@ -61,8 +119,10 @@ void ParticleSystem::Update()
 		glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_DYNAMIC_DRAW);
 		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _particleBuffers[1]);
 
-		// We create a query object to track the number of particles we're simulating
-		glGenQueries(1, &_query);
+		// We create a ring of query objects to track the number of particles we're simulating and how long
+		// the GPU spends on them, so we can read older results while newer ones are still being processed
+		glGenQueries(QUERY_RING_SIZE, _queries);
+		glGenQueries(QUERY_RING_SIZE, _timerQueries);
 
 		// We no longer need the CPU copy
 		delete[] data;
@@ -86,6 +146,7 @@ void ParticleSystem::Update()
 	glEnableVertexAttribArray(3);
 	glEnableVertexAttribArray(4);
 	glEnableVertexAttribArray(5);
+	glEnableVertexAttribArray(6);
 
 	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ParticleData), 0); // type
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Position)); // position
@@ -93,13 +154,29 @@ void ParticleSystem::Update()
 	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Color)); // color 
 	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Lifetime)); // metadata 
 	glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Metadata)); // metadata 
+	glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Size)); // size
 
 	// Bind the update shader and send our relevant uniforms
 	_updateShader->Bind();
-	_updateShader->SetUniform("u_Gravity", _gravity);
+	static constexpr UniformId U_GRAVITY = UniformId("u_Gravity");
+	static constexpr UniformId U_STEP_TIME = UniformId("u_StepTime");
+	static constexpr UniformId U_EMISSION_SCALE = UniformId("u_EmissionScale");
+	_updateShader->SetUniform(U_GRAVITY, _gravity);
+	_updateShader->SetUniform(U_STEP_TIME, dt);
+	_updateShader->SetUniform(U_EMISSION_SCALE, _emissionScale);
+
+	// Only count and time particles if we have a free query slot, otherwise we'd need to wait on the oldest one
+	bool issueQuery = false;
+	if (_statsReadback) {
+		_PollQueries();
+		issueQuery = _queriesInFlight < QUERY_RING_SIZE;
+	}
 
 	// Our particles are points that we're simulating
-	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _query);
+	if (issueQuery) {
+		glBeginQuery(GL_TIME_ELAPSED, _timerQueries[_queryHead]);
+		glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, _queries[_queryHead]);
+	}
 	glBeginTransformFeedback(GL_POINTS);
 
 	// If this is our first pass, we use drawArrays to get the initial state, otherwise we use transform feedback for rendering
@@ -112,15 +189,11 @@ void ParticleSystem::Update()
 
 	// End of transform feedback
 	glEndTransformFeedback();
-	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
-
-	// Use our query to get the number of particles
-	glGetQueryObjectuiv(_query, GL_QUERY_RESULT, &_numParticles);
-	if (_numParticles >= _emitters.size()) {
-		_numParticles -= _emitters.size();
-	}
-	else {
-		_numParticles = 0;
+	if (issueQuery) {
+		glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+		glEndQuery(GL_TIME_ELAPSED);
+		_queryHead = (_queryHead + 1) % QUERY_RING_SIZE;
+		_queriesInFlight++;
 	}
 
 	// Clean up our state
@@ -132,6 +205,7 @@ void ParticleSystem::Update()
 	glDisableVertexAttribArray(3);
 	glDisableVertexAttribArray(4);
 	glDisableVertexAttribArray(5);
+	glDisableVertexAttribArray(6);
 
 	// Re-enable rasterization for later OpenGL calls
 	glDisable(GL_RASTERIZER_DISCARD);
@@ -143,13 +217,121 @@ void ParticleSystem::Update()
 	_currentFeedbackBuffer = (_currentFeedbackBuffer + 1) & 0x01;
 }
 
+void ParticleSystem::_PollQueries()
+{
+	while (_queriesInFlight > 0) {
+		uint32_t oldest = (_queryHead + QUERY_RING_SIZE - _queriesInFlight) % QUERY_RING_SIZE;
+
+		// Queries finish in order, so if the oldest isn't ready none of the others are either. The timer ends
+		// after the count, so once it's available both are
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(_timerQueries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			break;
+		}
+
+		GLuint written = 0;
+		GLuint64 elapsed = 0;
+		glGetQueryObjectuiv(_queries[oldest], GL_QUERY_RESULT, &written);
+		glGetQueryObjectui64v(_timerQueries[oldest], GL_QUERY_RESULT, &elapsed);
+		_queriesInFlight--;
+
+		_RecordSimulationTime(static_cast<float>(elapsed / 1000000.0));
+
+		// Emitters are written back to the buffer as well, so we don't count them
+		_numParticles = written >= _emitters.size() ? written - (GLuint)_emitters.size() : 0;
+	}
+}
+
+void ParticleSystem::_UpdateCpu(float dt)
+{
+	if (!_hasInit) {
+		_cpuSimulator.SetMaxParticles(_maxParticles);
+		_cpuSimulator.SetGravity(_gravity);
+		for (const auto& emitter : _emitters) {
+			_cpuSimulator.AddEmitter({
+				emitter.Position,
+				emitter.Velocity,
+				emitter.Color,
+				emitter.Metadata.x,
+				emitter.Lifetime,
+				glm::vec2(emitter.Metadata.z, emitter.Metadata.w),
+				emitter.Size
+			});
+		}
+
+		// We only need a single buffer to stream the results into, since the CPU has the real copy
+		glCreateBuffers(1, _particleBuffers);
+		glNamedBufferData(_particleBuffers[0], _maxParticles * sizeof(ParticleData), nullptr, GL_STREAM_DRAW);
+		_currentVertexBuffer = 0;
+		_hasInit = true;
+	}
+
+	_cpuSimulator.SetEmissionScale(_emissionScale);
+	_cpuSimulator.Update(dt);
+	_numParticles = _cpuSimulator.GetCount();
+
+	// Sorted systems upload when they're rendered, since the camera can move without the system updating
+	if (_renderMode != ParticleRenderMode::SortedBillboards) {
+		_UploadCpu();
+	}
+}
+
+void ParticleSystem::_UploadCpu()
+{
+	_numParticles = _cpuSimulator.GetCount();
+	if (_numParticles == 0) {
+		return;
+	}
+
+	Gameplay::Camera::Sptr camera = Application::Get().CurrentScene()->MainCamera;
+	bool sorted = _renderMode == ParticleRenderMode::SortedBillboards && camera != nullptr;
+	if (sorted) {
+		_cpuSimulator.SortBackToFront(camera->GetView(), _drawOrder);
+	}
+
+	// Invalidating lets the driver hand us fresh memory instead of waiting for last frame's draw to finish
+	ParticleData* data = reinterpret_cast<ParticleData*>(glMapNamedBufferRange(_particleBuffers[0], 0, _numParticles * sizeof(ParticleData), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (data != nullptr) {
+		// Velocity isn't needed for rendering, so we skip it
+		const CpuParticleSimulator::Streams& streams = _cpuSimulator.GetStreams();
+		for (uint32_t ix = 0; ix < _numParticles; ix++) {
+			uint32_t source = sorted ? _drawOrder[ix] : ix;
+			data[ix].Type     = ParticleType::Particle;
+			data[ix].Position = glm::vec3(streams.PositionX[source], streams.PositionY[source], streams.PositionZ[source]);
+			data[ix].Color    = streams.Color[source];
+			data[ix].Lifetime = streams.Lifetime[source];
+			data[ix].Metadata = glm::vec4(streams.StartLifetime[source], 0.0f, 0.0f, 0.0f);
+			data[ix].Size     = streams.Size[source];
+		}
+		glUnmapNamedBuffer(_particleBuffers[0]);
+	} else {
+		_numParticles = 0;
+	}
+}
+
 void ParticleSystem::Render()
 {
 	// Make sure that we've actually initialized our stuff
-	if (_hasInit) {
+	if (_hasInit && !_isCulled) {
+		bool billboards = _renderMode != ParticleRenderMode::Points;
+		if (_renderMode == ParticleRenderMode::SortedBillboards && _simulationMode == ParticleSimulationMode::Cpu) {
+			_UploadCpu();
+		}
 
 		// We're using our particle rendering shader
-		_renderShader->Bind();
+		if (billboards) {
+			_billboardShader->Bind();
+			static constexpr UniformId U_SOFT_DISTANCE = UniformId("u_SoftDistance");
+			_billboardShader->SetUniform(U_SOFT_DISTANCE, NeedsSceneDepth() ? _softDistance : 0.0f);
+
+			// Billboards are blended, so they shouldn't hide each other
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			glDepthMask(GL_FALSE);
+		} else {
+			_renderShader->Bind();
+		}
 
 		// Make sure no VAOs are bound
 		glBindVertexArray(0);
@@ -163,16 +345,42 @@ void ParticleSystem::Render()
 		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Position)); // position
 		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Color)); // color 
 
-		// Draw our particles using whatever data we have in transform feedback buffer
-		glDrawTransformFeedback(GL_POINTS, _feedbackBuffers[_currentVertexBuffer]);
+		// Billboards also need the type to skip emitters, and the age and size to scale the quads
+		if (billboards) {
+			glEnableVertexAttribArray(0);
+			glEnableVertexAttribArray(4);
+			glEnableVertexAttribArray(5);
+			glEnableVertexAttribArray(6);
+			glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ParticleData), 0); // type
+			glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Lifetime)); // lifetime
+			glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Metadata)); // metadata
+			glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleData), (const GLvoid*)offsetof(ParticleData, Size)); // size
+		}
+
+		// Draw our particles using whatever data we have in transform feedback buffer, CPU particles
+		// are written as a tightly packed list
+		if (_simulationMode == ParticleSimulationMode::Cpu) {
+			glDrawArrays(GL_POINTS, 0, _numParticles);
+		} else {
+			glDrawTransformFeedback(GL_POINTS, _feedbackBuffers[_currentVertexBuffer]);
+		}
 
 		// Clean up after ourselves
 		glDisableVertexAttribArray(1);
 		glDisableVertexAttribArray(3);
+		if (billboards) {
+			glDisableVertexAttribArray(0);
+			glDisableVertexAttribArray(4);
+			glDisableVertexAttribArray(5);
+			glDisableVertexAttribArray(6);
+
+			glDisable(GL_BLEND);
+			glDepthMask(GL_TRUE);
+		}
 	}
 }
 
-void ParticleSystem::AddEmitter(const glm::vec3& position, const glm::vec3& direction, float emitRate /*= 1.0f*/, const glm::vec4& color /*= glm::vec4(1.0f)*/)
+void ParticleSystem::AddEmitter(const glm::vec3& position, const glm::vec3& direction, float emitRate /*= 1.0f*/, const glm::vec4& color /*= glm::vec4(1.0f)*/, const glm::vec2& size /*= glm::vec2(0.25f)*/)
 {
 	LOG_ASSERT(!_hasInit, "Cannot add an emitter after the particle system has been initialized");
 
@@ -183,16 +391,164 @@ void ParticleSystem::AddEmitter(const glm::vec3& position, const glm::vec3& dire
 	emitter.Lifetime = 1.0f / emitRate; 
 	emitter.Color    = color;
 	emitter.Metadata = { 1.0f / emitRate, 0.0f, 2.0f, 4.0f };
+	emitter.Size     = size;
 
 	_emitters.push_back(emitter); 
 }
 
+void ParticleSystem::SetRenderMode(ParticleRenderMode mode) {
+	_renderMode = mode;
+}
+
+ParticleRenderMode ParticleSystem::GetRenderMode() const {
+	return _renderMode;
+}
+
+void ParticleSystem::SetSoftParticles(bool value) {
+	_softParticles = value;
+}
+
+bool ParticleSystem::GetSoftParticles() const {
+	return _softParticles;
+}
+
+void ParticleSystem::SetSoftDistance(float value) {
+	_softDistance = value;
+}
+
+float ParticleSystem::GetSoftDistance() const {
+	return _softDistance;
+}
+
+bool ParticleSystem::NeedsSceneDepth() const {
+	return _softParticles && _softDistance > 0.0f && _renderMode != ParticleRenderMode::Points && _hasInit && !_isCulled;
+}
+
+void ParticleSystem::SetPriority(float value) {
+	_priority = value;
+}
+
+float ParticleSystem::GetPriority() const {
+	return _priority;
+}
+
+bool ParticleSystem::GetBounds(glm::vec3& min, glm::vec3& max) const {
+	if (_emitters.empty()) {
+		return false;
+	}
+
+	min = glm::vec3(std::numeric_limits<float>::max());
+	max = glm::vec3(std::numeric_limits<float>::lowest());
+	for (const auto& emitter : _emitters) {
+		// Particles follow p + vt + gt^2/2, so along each axis they are furthest out either at the start,
+		// the end of their life, or where gravity turns them around
+		float maxLife = glm::max(emitter.Metadata.z, emitter.Metadata.w);
+		for (int axis = 0; axis < 3; axis++) {
+			float p = emitter.Position[axis];
+			float v = emitter.Velocity[axis];
+			float g = _gravity[axis];
+			float end = p + v * maxLife + 0.5f * g * maxLife * maxLife;
+			min[axis] = glm::min(min[axis], glm::min(p, end));
+			max[axis] = glm::max(max[axis], glm::max(p, end));
+
+			float turn = g != 0.0f ? -v / g : 0.0f;
+			if (turn > 0.0f && turn < maxLife) {
+				float apex = p + v * turn + 0.5f * g * turn * turn;
+				min[axis] = glm::min(min[axis], apex);
+				max[axis] = glm::max(max[axis], apex);
+			}
+		}
+	}
+	return true;
+}
+
+float ParticleSystem::GetParticleDemand() const {
+	// Each emitter keeps (spawn rate * average lifetime) particles alive
+	float result = 0.0f;
+	for (const auto& emitter : _emitters) {
+		result += (emitter.Metadata.z + emitter.Metadata.w) * 0.5f / glm::max(emitter.Metadata.x, 0.0001f);
+	}
+	return glm::min(result, (float)_maxParticles);
+}
+
+bool ParticleSystem::IsCulled() const {
+	return _isCulled;
+}
+
+void ParticleSystem::SetStatsReadback(bool value) {
+	_statsReadback = value;
+}
+
+bool ParticleSystem::GetStatsReadback() const {
+	return _statsReadback;
+}
+
+void ParticleSystem::SetSimulationMode(ParticleSimulationMode mode)
+{
+	LOG_ASSERT(!_hasInit, "Cannot change the simulation mode after the particle system has been initialized");
+	_simulationMode = mode;
+}
+
+ParticleSimulationMode ParticleSystem::GetSimulationMode() const {
+	return _simulationMode;
+}
+
+const CpuParticleSimulator& ParticleSystem::GetCpuSimulator() const {
+	return _cpuSimulator;
+}
+
+float ParticleSystem::GetSimulationTime() const {
+	return _simulationTime;
+}
+
 void ParticleSystem::RenderImGui()
 {
-	LABEL_LEFT(ImGui::LabelText, "Particle Count", "%u", _numParticles);
+	if (_statsReadback || _simulationMode == ParticleSimulationMode::Cpu) {
+		LABEL_LEFT(ImGui::LabelText, "Particle Count", "%u", _numParticles);
+	} else {
+		LABEL_LEFT(ImGui::LabelText, "Particle Count", "Readback disabled");
+	}
+	LABEL_LEFT(ImGui::Checkbox, "Stats Readback", &_statsReadback);
+	LABEL_LEFT(ImGui::DragFloat, "Priority", &_priority, 0.1f, 0.0f, 100.0f);
+	if (_isCulled) {
+		LABEL_LEFT(ImGui::LabelText, "LOD", "Culled");
+	} else {
+		LABEL_LEFT(ImGui::LabelText, "LOD", "%.0f%% emission, every %u frame(s)", _emissionScale * 100.0f, _updateInterval);
+	}
+	if (_simulationMode == ParticleSimulationMode::Cpu) {
+		LABEL_LEFT(ImGui::LabelText, "CPU Time (ms)", "%.3f", _simulationTime);
+	} else if (_statsReadback) {
+		LABEL_LEFT(ImGui::LabelText, "GPU Time (ms)", "%.3f", _simulationTime);
+	} else {
+		LABEL_LEFT(ImGui::LabelText, "GPU Time (ms)", "Readback disabled");
+	}
 
 	Application& app = Application::Get();
 
+	// The backend can only be changed before the buffers are created
+	if (!_hasInit) {
+		int mode = (int)_simulationMode;
+		if (LABEL_LEFT(ImGui::Combo, "Simulation", &mode, "GPU\0CPU\0")) {
+			SetSimulationMode((ParticleSimulationMode)mode);
+		}
+	} else {
+		LABEL_LEFT(ImGui::LabelText, "Simulation", "%s", _simulationMode == ParticleSimulationMode::Cpu ? "CPU" : "GPU");
+	}
+
+	int renderMode = (int)_renderMode;
+	if (LABEL_LEFT(ImGui::Combo, "Rendering", &renderMode, "Points\0Billboards\0Sorted Billboards\0")) {
+		SetRenderMode((ParticleRenderMode)renderMode);
+	}
+	if (_renderMode == ParticleRenderMode::SortedBillboards && _simulationMode == ParticleSimulationMode::Gpu) {
+		ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Sorting requires CPU simulation");
+	}
+	if (_renderMode != ParticleRenderMode::Points) {
+		LABEL_LEFT(ImGui::Checkbox, "Soft Particles", &_softParticles);
+		if (_softParticles) {
+			LABEL_LEFT(ImGui::DragFloat, "Soft Distance", &_softDistance, 0.01f, 0.0f, 100.0f);
+		}
+	}
+
 	ImGui::Separator();
 	ImGui::Text("Emitters:");
 
@@ -216,6 +572,7 @@ void ParticleSystem::RenderImGui()
 					emitter.Metadata.z = lifeRange.x;
 					emitter.Metadata.w = lifeRange.y;
 				}
+				LABEL_LEFT(ImGui::DragFloat2, "Size      ", &emitter.Size.x, 0.01f, 0.0f);
 
 				if (ImGuiHelper::WarningButton("Delete")) {
 					_emitters.erase(_emitters.begin() + ix);
@@ -235,6 +592,7 @@ void ParticleSystem::RenderImGui()
 			emitter.Color    = glm::vec4(1.0f);
 			emitter.Lifetime = 1.0f; 
 			emitter.Metadata = { 1.0f, 0.0f, 1.0f, 1.0f };
+			emitter.Size     = glm::vec2(0.25f);
 			_emitters.push_back(emitter);
 		}
 	}
@@ -243,20 +601,21 @@ void ParticleSystem::RenderImGui()
 void ParticleSystem::Awake()
 {
 	// There are the things we want the feedback buffers to track
-	const char const* varyings[6] = {
+	const char const* varyings[7] = {
 		"out_Type",  
 		"out_Position",
 		"out_Velocity",
 		"out_Color", 
 		"out_Lifetime",
-		"out_Metadata" 
+		"out_Metadata",
+		"out_Size"
 	}; 
 
 	// This is our transform feedback shader
 	_updateShader = ShaderProgram::Create();
 	_updateShader->LoadShaderPartFromFile("shaders/vertex_shaders/particles_sim_vs.glsl", ShaderPartType::Vertex);
  	_updateShader->LoadShaderPartFromFile("shaders/geometry_shaders/particle_sim_gs.glsl", ShaderPartType::Geometry);
-	_updateShader->RegisterVaryings(varyings, 6, true); // Here we call glTransformFeedbackVaryings, and let it know we want interleaved data
+	_updateShader->RegisterVaryings(varyings, 7, true); // Here we call glTransformFeedbackVaryings, and let it know we want interleaved data
 	_updateShader->Link(); 
 
 	// This shader will render the particles
@@ -264,12 +623,25 @@ void ParticleSystem::Awake()
 	_renderShader->LoadShaderPartFromFile("shaders/vertex_shaders/particles_render_vs.glsl", ShaderPartType::Vertex);
 	_renderShader->LoadShaderPartFromFile("shaders/fragment_shaders/particles_render_fs.glsl", ShaderPartType::Fragment);
 	_renderShader->Link(); 
+
+	// This shader expands particles into camera facing quads
+	_billboardShader = ShaderProgram::Create();
+	_billboardShader->LoadShaderPartFromFile("shaders/vertex_shaders/particles_billboard_vs.glsl", ShaderPartType::Vertex);
+	_billboardShader->LoadShaderPartFromFile("shaders/geometry_shaders/particles_billboard_gs.glsl", ShaderPartType::Geometry);
+	_billboardShader->LoadShaderPartFromFile("shaders/fragment_shaders/particles_billboard_fs.glsl", ShaderPartType::Fragment);
+	_billboardShader->Link();
 }
 
 nlohmann::json ParticleSystem::ToJson() const {
 	nlohmann::json result = {
 		{ "gravity", _gravity },
-		{ "max_particles", _maxParticles }
+		{ "max_particles", _maxParticles },
+		{ "simulation", ~_simulationMode },
+		{ "stats_readback", _statsReadback },
+		{ "priority", _priority },
+		{ "render_mode", ~_renderMode },
+		{ "soft_particles", _softParticles },
+		{ "soft_distance", _softDistance }
 	};
 
 	// Add emitters to the JSON data
@@ -281,7 +653,8 @@ nlohmann::json ParticleSystem::ToJson() const {
 			{ "spawn_rate", emitter.Lifetime },
 			{ "color", emitter.Color },
 			{ "cone_angle", emitter.Metadata.y },
-			{ "lifetime_range", glm::vec2(emitter.Metadata.z, emitter.Metadata.w) }
+			{ "lifetime_range", glm::vec2(emitter.Metadata.z, emitter.Metadata.w) },
+			{ "size_range", emitter.Size }
 		};
 		result["emitters"].push_back(blob);
 	}
@@ -293,7 +666,14 @@ ParticleSystem::Sptr ParticleSystem::FromJson(const nlohmann::json& blob) {
 	ParticleSystem::Sptr result = std::make_shared<ParticleSystem>();
 
 	result->_gravity = JsonGet(blob, "gravity", result->_gravity);
-	result->_maxParticles = JsonGet(blob, "max_particled", result->_maxParticles);
+	// Older scenes were read with a misspelled key, so we still accept it
+	result->_maxParticles = JsonGet(blob, "max_particles", JsonGet(blob, "max_particled", result->_maxParticles));
+	result->_simulationMode = JsonParseEnum(ParticleSimulationMode, blob, "simulation", ParticleSimulationMode::Gpu);
+	result->_statsReadback = JsonGet(blob, "stats_readback", result->_statsReadback);
+	result->_priority = JsonGet(blob, "priority", result->_priority);
+	result->_renderMode = JsonParseEnum(ParticleRenderMode, blob, "render_mode", ParticleRenderMode::Points);
+	result->_softParticles = JsonGet(blob, "soft_particles", result->_softParticles);
+	result->_softDistance = JsonGet(blob, "soft_distance", result->_softDistance);
 
 	if (blob.contains("emitters") && blob["emitters"].is_array()) {
 		for (const auto& data : blob["emitters"]) {
@@ -305,6 +685,7 @@ ParticleSystem::Sptr ParticleSystem::FromJson(const nlohmann::json& blob) {
 			emitter.Color    = JsonGet(data, "color", glm::vec4(1.0f));
 			glm::vec2 lifeRange = JsonGet(data, "lifetime_range", glm::vec2(1.0f));
 			emitter.Metadata = { emitter.Lifetime, JsonGet(data, "cone_angle", 0.0f), lifeRange.x, lifeRange.y };
+			emitter.Size     = JsonGet(data, "size_range", glm::vec2(0.25f));
 
 			result->_emitters.push_back(emitter);
 		}
@@ -312,3 +693,22 @@ ParticleSystem::Sptr ParticleSystem::FromJson(const nlohmann::json& blob) {
 
 	return result;
 }
+
+void ParticleSystem::save(BinaryOutputArchive& archive) const {
+	archive(_gravity, _maxParticles, _simulationMode, _statsReadback, _priority, _renderMode, _softParticles, _softDistance);
+	archive(static_cast<uint32_t>(_emitters.size()));
+	for (const auto& emitter : _emitters) {
+		archive(emitter.Position, emitter.Velocity, emitter.Color, emitter.Lifetime, emitter.Metadata, emitter.Size);
+	}
+}
+
+void ParticleSystem::load(BinaryInputArchive& archive) {
+	archive(_gravity, _maxParticles, _simulationMode, _statsReadback, _priority, _renderMode, _softParticles, _softDistance);
+	uint32_t numEmitters = 0;
+	archive(numEmitters);
+	_emitters.resize(numEmitters);
+	for (auto& emitter : _emitters) {
+		emitter.Type = ParticleType::Emitter;
+		archive(emitter.Position, emitter.Velocity, emitter.Color, emitter.Lifetime, emitter.Metadata, emitter.Size);
+	}
+}
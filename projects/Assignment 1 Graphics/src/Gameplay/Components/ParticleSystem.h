@@ -1,23 +1,119 @@
 #pragma once
 #include "Gameplay/Components/IComponent.h"
 #include "Graphics/ShaderProgram.h"
+#include "Gameplay/Particles/CpuParticleSimulator.h"
 
 ENUM(ParticleType, uint32_t,
 	Emitter       = 0,
 	Particle      = 1
 );
 
+/// <summary>
+/// Where a particle system runs it's simulation
+/// </summary>
+ENUM(ParticleSimulationMode, uint32_t,
+	Gpu           = 0, // Simulated with transform feedback, particles never leave the GPU
+	Cpu           = 1  // Simulated by CpuParticleSimulator and streamed to the GPU for rendering
+);
+
+/// <summary>
+/// How a particle system draws it's particles
+/// </summary>
+ENUM(ParticleRenderMode, uint32_t,
+	Points           = 0, // Fixed size opaque points in simulation order
+	Billboards       = 1, // Camera facing quads sized by age, alpha blended in simulation order
+	SortedBillboards = 2  // Billboards drawn back to front, requires the Cpu simulation mode
+);
+
 class ParticleSystem : public Gameplay::IComponent{
 public:
 	MAKE_PTRS(ParticleSystem);
 
+	// The number of particle count and timer queries that can be in flight at once, results are read this many frames late at most
+	static constexpr uint32_t QUERY_RING_SIZE = 4;
+	// The texture slot that ParticleLayer binds the scene depth to for soft particles
+	static constexpr int SCENE_DEPTH_SLOT = 13;
+
 	ParticleSystem();
 	~ParticleSystem();
 
 	void Update();
 	void Render();
 
-	void AddEmitter(const glm::vec3& position, const glm::vec3& direction, float emitRate = 1.0f, const glm::vec4& color = glm::vec4(1.0f));
+	void AddEmitter(const glm::vec3& position, const glm::vec3& direction, float emitRate = 1.0f, const glm::vec4& color = glm::vec4(1.0f), const glm::vec2& size = glm::vec2(0.25f));
+
+	/// <summary>
+	/// Selects whether this system is simulated on the GPU or the CPU, must be set before the first update
+	/// </summary>
+	void SetSimulationMode(ParticleSimulationMode mode);
+	ParticleSimulationMode GetSimulationMode() const;
+
+	/// <summary>
+	/// Gets the CPU simulation, which can be used to read particle state back for gameplay. Only contains
+	/// particles when the simulation mode is Cpu
+	/// </summary>
+	const CpuParticleSimulator& GetCpuSimulator() const;
+
+	/// <summary>
+	/// Enables or disables reading the particle count and simulation time back from the GPU. Reads never stall,
+	/// but the values shown lag a few frames behind the simulation. When disabled, no queries are issued at all
+	/// </summary>
+	void SetStatsReadback(bool value);
+	bool GetStatsReadback() const;
+
+	/// <summary>
+	/// Sets how the particles are drawn, can be changed at any time. Sorting needs the particles on the CPU,
+	/// so systems simulated on the GPU draw SortedBillboards as unsorted Billboards
+	/// </summary>
+	void SetRenderMode(ParticleRenderMode mode);
+	ParticleRenderMode GetRenderMode() const;
+
+	/// <summary>
+	/// Enables or disables fading billboards out as they get close to the scene geometry behind them, which
+	/// hides the hard line where they intersect
+	/// </summary>
+	void SetSoftParticles(bool value);
+	bool GetSoftParticles() const;
+	/// <summary>
+	/// Sets the distance in front of the scene geometry over which soft particles fade out, in world units
+	/// </summary>
+	void SetSoftDistance(float value);
+	float GetSoftDistance() const;
+	/// <summary>
+	/// Returns true if this system will sample the scene depth (at SCENE_DEPTH_SLOT) when it's next rendered
+	/// </summary>
+	bool NeedsSceneDepth() const;
+
+	/// <summary>
+	/// Sets how important this system is when the scene is over it's particle budget, systems with a higher
+	/// priority get a proportionally larger share of the budget (see ParticleBudget)
+	/// </summary>
+	void SetPriority(float value);
+	float GetPriority() const;
+
+	/// <summary>
+	/// Gets a world space box containing every point particles can reach during their lifetime
+	/// </summary>
+	/// <param name="min">Receives the minimum corner of the bounds</param>
+	/// <param name="max">Receives the maximum corner of the bounds</param>
+	/// <returns>False if the system has no emitters</returns>
+	bool GetBounds(glm::vec3& min, glm::vec3& max) const;
+	/// <summary>
+	/// Estimates how many particles this system will have alive once it's emitters have been running for
+	/// a while, at full emission rate
+	/// </summary>
+	float GetParticleDemand() const;
+	/// <summary>
+	/// Gets whether the system was outside of the camera's view this frame, culled systems are not updated
+	/// or rendered
+	/// </summary>
+	bool IsCulled() const;
+
+	/// <summary>
+	/// Gets the average time spent simulating, in milliseconds, for comparing simulation modes. This is CPU
+	/// time in the Cpu mode, and GPU time (measured with timer queries, a few frames late) in the Gpu mode
+	/// </summary>
+	float GetSimulationTime() const;
 
 	// Inherited from IComponent
 
@@ -25,9 +121,13 @@ public:
 	virtual void Awake() override;
 	virtual nlohmann::json ToJson() const override;
 	static ParticleSystem::Sptr FromJson(const nlohmann::json& blob);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 	MAKE_TYPENAME(ParticleSystem);
 
 protected:
+	friend class ParticleBudget;
+
 	struct ParticleData {
 		ParticleType Type;     // uint32_t, 0 for emitters, 1 for particles
 		glm::vec3    Position;
@@ -36,24 +136,66 @@ protected:
 		float        Lifetime; // For emitters, this is the time to next particle spawn
 
 		// For emitters, x is time to next particle, y is max deviation from direction in radians, z-w is lifetime range
+		// For particles, x is the lifetime the particle started with
 		glm::vec4    Metadata;
+		glm::vec2    Size;     // The size of particles at the start and end of their lifetime
 	};
 
 	bool _hasInit;
 
+	ParticleSimulationMode _simulationMode;
+	CpuParticleSimulator   _cpuSimulator;
+	float                  _simulationTime;
+
+	ParticleRenderMode     _renderMode;
+	bool                   _softParticles;
+	float                  _softDistance;
+	// Particle indices from back to front, for sorted rendering
+	std::vector<uint32_t>  _drawOrder;
+
+	// Level of detail, assigned by ParticleBudget every frame
+	float    _priority;
+	bool     _isCulled;
+	float    _emissionScale;
+	uint32_t _updateInterval;
+	uint32_t _framesSinceStep;
+	float    _pendingTime;
+
 	uint32_t _maxParticles;
 	GLuint _numParticles;
 
 	uint32_t _particleBuffers[2];
 	uint32_t _feedbackBuffers[2];
-	uint32_t _query;
+	// Ring of queries counting the primitives written by transform feedback, and timing the update pass on
+	// the GPU. _queryHead is the next slot to issue, and the _queriesInFlight slots before it are waiting on results
+	uint32_t _queries[QUERY_RING_SIZE];
+	uint32_t _timerQueries[QUERY_RING_SIZE];
+	uint32_t _queryHead;
+	uint32_t _queriesInFlight;
+	bool     _statsReadback;
 
 	uint32_t _currentVertexBuffer;
 	uint32_t _currentFeedbackBuffer;
 
 	ShaderProgram::Sptr _updateShader;
 	ShaderProgram::Sptr _renderShader;
+	ShaderProgram::Sptr _billboardShader;
 	glm::vec3           _gravity;
 
 	std::vector<ParticleData> _emitters;
+
+	void _UpdateGpu(float dt);
+	void _UpdateCpu(float dt);
+	/// <summary>
+	/// Writes the CPU simulation into the render buffer, in back to front order if sorting
+	/// </summary>
+	void _UploadCpu();
+	/// <summary>
+	/// Reads the results of any particle count queries that have finished, oldest first, without blocking
+	/// </summary>
+	void _PollQueries();
+	/// <summary>
+	/// Adds a timing sample to the smoothed simulation time
+	/// </summary>
+	void _RecordSimulationTime(float milliseconds);
 };
\ No newline at end of file
@@ -7,17 +7,20 @@
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
 	_mesh(mesh), 
 	_material(material), 
-	_meshBuilderParams(std::vector<MeshBuilderParam>()) 
+	_meshBuilderParams(std::vector<MeshBuilderParam>()),
+	_lodLevel(0)
 { }
 
 RenderComponent::RenderComponent() : 
 	_mesh(nullptr), 
 	_material(nullptr), 
-	_meshBuilderParams(std::vector<MeshBuilderParam>())
+	_meshBuilderParams(std::vector<MeshBuilderParam>()),
+	_lodLevel(0)
 { }
 
 void RenderComponent::SetMesh(const Gameplay::MeshResource::Sptr& mesh) {
 	_mesh = mesh;
+	_lodLevel = 0;
 }
 
 const Gameplay::MeshResource::Sptr& RenderComponent::GetMeshResource() const {
@@ -28,6 +31,18 @@ VertexArrayObject::Sptr RenderComponent::GetMesh() const {
 	return _mesh ? _mesh->Mesh : nullptr;
 }
 
+VertexArrayObject::Sptr RenderComponent::GetMeshForScreenSize(float screenSize) {
+	if (_mesh == nullptr) {
+		return nullptr;
+	}
+	_lodLevel = _mesh->SelectLOD(screenSize, _lodLevel);
+	return _mesh->GetLOD(_lodLevel);
+}
+
+int RenderComponent::GetLODLevel() const {
+	return _lodLevel;
+}
+
 void RenderComponent::SetMaterial(const Gameplay::Material::Sptr& mat) {
 	_material = mat;
 }
@@ -51,9 +66,21 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 	return result;
 }
 
+void RenderComponent::save(BinaryOutputArchive& archive) const {
+	archive(GuidOrNull(_mesh), GuidOrNull(_material));
+}
+
+void RenderComponent::load(BinaryInputArchive& archive) {
+	Guid mesh, material;
+	archive(mesh, material);
+	_mesh     = ResourceManager::Get<Gameplay::MeshResource>(mesh);
+	_material = ResourceManager::Get<Gameplay::Material>(material);
+}
+
 void RenderComponent::RenderImGui() {
 	ImGui::Text("Indexed:   %s", GetMesh() != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
 	ImGui::Text("Triangles: %d", GetMesh() != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
+	ImGui::Text("LOD:       %d / %d", _lodLevel, _mesh != nullptr ? _mesh->GetLODCount() : 0);
 	ImGui::Text("Source:    %s", (_mesh == nullptr || _mesh->Filename.empty()) ? "Generated" : _mesh->Filename.c_str());
 	ImGui::Separator();
 	ImGui::Text("Material:  %s", _material != nullptr ? _material->Name.c_str() : "NULL");
@@ -26,6 +26,16 @@ public:
 	/// </summary>
 	VertexArrayObject::Sptr GetMesh() const;
 	/// <summary>
+	/// Selects and returns the VAO for the level of detail matching the given screen size,
+	/// remembering the selected level so that we can apply hysteresis next frame
+	/// </summary>
+	/// <param name="screenSize">The projected diameter of the mesh's bounds, as a fraction of the screen height</param>
+	VertexArrayObject::Sptr GetMeshForScreenSize(float screenSize);
+	/// <summary>
+	/// Gets the level of detail that was last selected for rendering
+	/// </summary>
+	int GetLODLevel() const;
+	/// <summary>
 	/// Gets the material that this renderer is using
 	/// </summary>
 	const Gameplay::Material::Sptr& GetMaterial() const;
@@ -47,6 +57,8 @@ public:
 	virtual void RenderImGui() override;
 	virtual nlohmann::json ToJson() const override;
 	static RenderComponent::Sptr FromJson(const nlohmann::json& data);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 	MAKE_TYPENAME(RenderComponent);
 
 protected:
@@ -57,4 +69,7 @@ protected:
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
+
+	// The level of detail selected for the last frame
+	int                           _lodLevel;
 };
\ No newline at end of file
@@ -24,3 +24,11 @@ RotatingBehaviour::Sptr RotatingBehaviour::FromJson(const nlohmann::json& data)
 	result->RotationSpeed = JsonGet(data, "speed", result->RotationSpeed);
 	return result;
 }
+
+void RotatingBehaviour::save(BinaryOutputArchive& archive) const {
+	archive(RotationSpeed);
+}
+
+void RotatingBehaviour::load(BinaryInputArchive& archive) {
+	archive(RotationSpeed);
+}
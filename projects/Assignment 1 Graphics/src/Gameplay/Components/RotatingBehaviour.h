@@ -17,6 +17,8 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static RotatingBehaviour::Sptr FromJson(const nlohmann::json& data);
+	void save(BinaryOutputArchive& archive) const;
+	void load(BinaryInputArchive& archive);
 
 	MAKE_TYPENAME(RotatingBehaviour);
 };
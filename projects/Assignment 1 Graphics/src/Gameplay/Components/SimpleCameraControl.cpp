@@ -97,3 +97,11 @@ SimpleCameraControl::Sptr SimpleCameraControl::FromJson(const nlohmann::json& bl
 	result->_shiftMultipler   = JsonGet(blob, "shift_mult", 2.0f);
 	return result;
 }
+
+void SimpleCameraControl::save(BinaryOutputArchive& archive) const {
+	archive(_mouseSensitivity, _moveSpeeds, _shiftMultipler);
+}
+
+void SimpleCameraControl::load(BinaryInputArchive& archive) {
+	archive(_mouseSensitivity, _moveSpeeds, _shiftMultipler);
+}
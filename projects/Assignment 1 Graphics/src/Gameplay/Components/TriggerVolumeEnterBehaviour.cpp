@@ -29,3 +29,7 @@ TriggerVolumeEnterBehaviour::Sptr TriggerVolumeEnterBehaviour::FromJson(const nl
 	TriggerVolumeEnterBehaviour::Sptr result = std::make_shared<TriggerVolumeEnterBehaviour>();
 	return result;
 }
+
+void TriggerVolumeEnterBehaviour::save(BinaryOutputArchive& archive) const { }
+
+void TriggerVolumeEnterBehaviour::load(BinaryInputArchive& archive) { }
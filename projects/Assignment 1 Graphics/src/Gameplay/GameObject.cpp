@@ -12,6 +12,7 @@
 #include "Utils/ImGuiHelper.h"
 
 #include "Gameplay/Scene.h"
+#include "Graphics/GuiBatcher.h"
 
 namespace Gameplay {
 	GameObject::GameObject() :
@@ -30,7 +31,9 @@ namespace Gameplay {
 		_inverseWorldTransform(MAT4_IDENTITY),
 		_isWorldTransformDirty(true),
 		_parent(WeakRef()),
-		_children(std::vector<WeakRef>())
+		_children(std::vector<WeakRef>()),
+		_guiCache(nullptr),
+		_isGuiDirty(true)
 	{ }
 
 	void GameObject::_RecalcLocalTransform() const
@@ -169,28 +172,52 @@ namespace Gameplay {
 	}
 
 	void GameObject::RenderGUI() {
-		// Prune children
-		auto it = std::remove_if(_children.begin(), _children.end(), [](const WeakRef& child) { return !child.IsAlive(); });
-		if (it != _children.end()) {
-			_children.erase(it);
+		if (_guiCache == nullptr) {
+			_guiCache = std::make_shared<GuiGeometryCache>();
 		}
 
-		for (auto& component : _components) {
-			if (component->IsEnabled) {
-				component->StartGUI();
+		// Only regenerate our geometry when something has changed, otherwise we can re-use the last results
+		if (_isGuiDirty || !_guiCache->IsValid()) {
+			// Prune children
+			auto it = std::remove_if(_children.begin(), _children.end(), [](const WeakRef& child) { return !child.IsAlive(); });
+			if (it != _children.end()) {
+				_children.erase(it, _children.end());
 			}
-		}
-		for (auto& component : _components) {
-			if (component->IsEnabled) {
-				component->RenderGUI();
+
+			GuiBatcher::BeginCache(*_guiCache);
+			for (auto& component : _components) {
+				if (component->IsEnabled) {
+					component->StartGUI();
+				}
 			}
+			for (auto& component : _components) {
+				if (component->IsEnabled) {
+					component->RenderGUI();
+				}
+			}
+			for (auto& child : _children) {
+				child->RenderGUI();
+			}
+			for (auto& component : _components) {
+				if (component->IsEnabled) {
+					component->FinishGUI();
+				}
+			}
+			GuiBatcher::EndCache();
+
+			_isGuiDirty = false;
 		}
-		for (auto& child : _children) {
-			child->RenderGUI();
-		}
-		for (auto& component : _components) {
-			if (component->IsEnabled) {
-				component->FinishGUI();
+
+		GuiBatcher::SubmitCache(_guiCache);
+	}
+
+	void GameObject::MarkGuiDirty() {
+		// If we're already dirty, our parents will be as well
+		if (!_isGuiDirty) {
+			_isGuiDirty = true;
+			GameObject::Sptr parent = _parent;
+			if (parent != nullptr) {
+				parent->MarkGuiDirty();
 			}
 		}
 	}
@@ -252,6 +279,7 @@ namespace Gameplay {
 		// Append it to the binding component's storage, and invoke the OnLoad
 		_components.push_back(component);
 		component->OnLoad();
+		MarkGuiDirty();
 
 		if (_scene->GetIsAwake()) {
 			component->Awake();
@@ -276,6 +304,7 @@ namespace Gameplay {
 			_children.push_back(child);
 			child->_parent = _selfRef.lock();
 			child->_isWorldTransformDirty = true;
+			MarkGuiDirty();
 		} else {
 			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->Name);
 		}
@@ -289,6 +318,7 @@ namespace Gameplay {
 			// Clear the object's parent and remove from our list of children
 			child->_parent.Reset();
 			_children.erase(it);
+			MarkGuiDirty();
 			return true;
 		} else {
 			return false;
@@ -391,6 +421,7 @@ namespace Gameplay {
 					// Render a delete button for the component
 					if (ImGuiHelper::WarningButton("Delete")) {
 						_components.erase(_components.begin() + ix);
+						MarkGuiDirty();
 						ix--;
 					}
 					ImGui::PopID();
@@ -480,6 +511,52 @@ namespace Gameplay {
 		return result;
 	}
 
+	GameObject::Sptr GameObject::FromBinary(Scene* scene, BinaryInputArchive& archive)
+	{
+		GameObject::Sptr result(new GameObject());
+		result->_scene = scene;
+
+		// Load in basic info, in the same order as ToBinary
+		Guid parent;
+		archive(result->Name, result->_guid, parent, result->_position, result->_rotation, result->_scale, result->HideInHierarchy);
+		result->_parent = WeakRef(parent, nullptr);
+		result->_isLocalTransformDirty = true;
+		result->_isWorldTransformDirty = true;
+
+		uint32_t numComponents = 0;
+		archive(numComponents);
+		result->_components.reserve(numComponents);
+		for (uint32_t ix = 0; ix < numComponents; ix++) {
+			std::string typeName;
+			archive(typeName);
+
+			// Components aren't length prefixed, so we can't skip over a type we don't know about
+			IComponent::Sptr component = scene->Components().LoadBinary(typeName, archive);
+			if (component == nullptr) {
+				throw std::runtime_error("Unknown component type \"" + typeName + "\" in binary scene");
+			}
+			component->_context = result.get();
+
+			// Add component to object and allow it to perform self initialization
+			result->_components.push_back(component);
+			component->OnLoad();
+		}
+
+		return result;
+	}
+
+	void GameObject::ToBinary(BinaryOutputArchive& archive) const
+	{
+		GameObject::Sptr parent = _parent;
+		archive(Name, _guid, parent == nullptr ? Guid() : parent->_guid, _position, _rotation, _scale, HideInHierarchy);
+
+		archive(static_cast<uint32_t>(_components.size()));
+		for (auto& component : _components) {
+			archive(component->ComponentTypeName());
+			ComponentManager::SaveBinary(component, archive);
+		}
+	}
+
 	nlohmann::json GameObject::ToJson() const {
 		GameObject::Sptr parent = _parent;
 		nlohmann::json result = {
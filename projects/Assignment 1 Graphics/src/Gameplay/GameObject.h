@@ -15,6 +15,7 @@
 
 class InspectorWindow;
 class HierarchyWindow;
+class GuiGeometryCache;
 
 namespace Gameplay {
 // Predeclaration for Scene
@@ -225,9 +226,16 @@ namespace Gameplay {
 		const glm::mat4& GetInverseLocalTransform() const;
 
 		/// <summary>
-		/// Allows components to render GUI elements to the screen
+		/// Allows components to render GUI elements to the screen. The geometry for this object and it's
+		/// children is cached, and only regenerated after MarkGuiDirty has been called
 		/// </summary>
 		void RenderGUI(); 
+		/// <summary>
+		/// Marks the GUI geometry for this object as out of date, along with all of it's parents, so that it
+		/// will be rebuilt on the next call to RenderGUI. Components should call this whenever something
+		/// that affects what they draw in StartGUI, RenderGUI or FinishGUI changes
+		/// </summary>
+		void MarkGuiDirty();
 
 		/// <summary>
 		/// Returns a pointer to the scene that this GameObject belongs to
@@ -300,6 +308,7 @@ namespace Gameplay {
 			// Append it to the binding component's storage, and invoke the OnLoad
 			_components.push_back(component);
 			component->OnLoad();
+			MarkGuiDirty();
 
 			if (_scene->GetIsAwake()) {
 				component->Awake();
@@ -331,6 +340,15 @@ namespace Gameplay {
 		/// Converts this object into it's JSON representation for storage
 		/// </summary>
 		nlohmann::json ToJson() const;
+		/// <summary>
+		/// Loads a render object from a binary archive
+		/// </summary>
+		static GameObject::Sptr FromBinary(Scene* scene, BinaryInputArchive& archive);
+		/// <summary>
+		/// Writes this object to a binary archive for storage, note that unlike ToJson children are not
+		/// included, since the scene stores every object
+		/// </summary>
+		void ToBinary(BinaryOutputArchive& archive) const;
 
 	private:
 		friend class Scene;
@@ -359,6 +377,10 @@ namespace Gameplay {
 
 		// The components that this game object has attached to it
 		std::vector<IComponent::Sptr> _components;
+
+		// The GUI geometry for this object and it's children, see RenderGUI
+		std::shared_ptr<GuiGeometryCache> _guiCache;
+		bool _isGuiDirty;
 		std::weak_ptr<GameObject> _selfRef;
 
 		// Pointer to the scene, we use raw pointers since 
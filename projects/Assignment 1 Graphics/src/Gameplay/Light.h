@@ -1,6 +1,7 @@
 #pragma once
 #include "json.hpp"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/BinarySerialization.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -42,5 +43,13 @@ namespace Gameplay {
 			};
 		}
 
+		/// <summary>
+		/// Reads or writes this light in a binary archive
+		/// </summary>
+		template <class Archive>
+		void serialize(Archive& archive) {
+			archive(Position, Color, Range);
+		}
+
 	};
 }
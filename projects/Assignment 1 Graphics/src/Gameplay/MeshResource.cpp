@@ -1,7 +1,13 @@
 #include "MeshResource.h"
 #include <filesystem>
+#include <unordered_set>
+#include <BulletCollision/CollisionShapes/btTriangleMesh.h>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/CookManifest.h"
 
 namespace Gameplay {
 	MeshResource::MeshResource() :
@@ -9,7 +15,10 @@ namespace Gameplay {
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		LODs(std::vector<VertexArrayObject::Sptr>()),
+		BoundingRadius(0.0f),
+		BulletTriMesh(nullptr),
+		_sharedGeometry(nullptr)
 	{ }
 
 	MeshResource::MeshResource(const std::string& filename) :
@@ -17,9 +26,12 @@ namespace Gameplay {
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		LODs(std::vector<VertexArrayObject::Sptr>()),
+		BoundingRadius(0.0f),
+		BulletTriMesh(nullptr),
+		_sharedGeometry(nullptr)
 	{
-		Mesh = ObjLoader::LoadFromFile(filename);
+		_LoadFromFile();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -44,38 +56,181 @@ namespace Gameplay {
 		MeshResource::Sptr result = std::make_shared<MeshResource>();
 		if (blob.contains("params") && blob["params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexColTangents> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
-			MeshFactory::CalculateTBN(mesh);
-			result->Mesh = mesh.Bake();
+			result->GenerateMesh();
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
-				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
-				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
-				#endif
-
+			if (result->Filename != "null" && VirtualFileSystem::Exists(result->Filename)) {
+				result->_LoadFromFile();
 			}
 		}
 		return result;
 	}
 
-	void MeshResource::GenerateMesh() {
-		MeshBuilder<VertexPosNormTexColTangents> mesh;
-		for (auto& param : MeshBuilderParams) {
-			MeshFactory::AddParameterized(mesh, param);
+	void MeshResource::Prefetch(const nlohmann::json& blob) {
+		// Generated meshes are built and uploaded together, so there's nothing to do ahead of time
+		if (blob.contains("params")) {
+			return;
+		}
+		std::string filename = JsonGet<std::string>(blob, "filename", "null");
+		if (filename == "null" || !VirtualFileSystem::Exists(filename)) {
+			return;
 		}
-		MeshFactory::CalculateTBN(mesh);
-		Mesh = mesh.Bake();
+		#ifdef OPTIMIZED_OBJ_LOADER
+		std::string extension = std::filesystem::path(filename).extension().string();
+		StringTools::ToLower(extension);
+		if (extension == ".obj") {
+			OptimizedObjLoader::PrepareFile(filename);
+		}
+		#else
+		// If the cooker has already converted the mesh, loading the binary file is cheap enough to leave for later
+		if (!CookManifest::GetCookedOutput(filename, ".bin").empty()) {
+			return;
+		}
+		// Parse and simplify the mesh now, _LoadFromFile will pick it up and only has to bake it
+		std::shared_ptr<CookedMesh> cooked = _CookFile(filename);
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+		_prefetched[filename] = cooked;
+		#endif
+	}
+
+	void MeshResource::GenerateMesh() {
+		// Identical parameter lists will share the same geometry, so we only generate it once
+		_sharedGeometry = ProceduralMeshCache::Get(MeshBuilderParams, LOD_MIN_TRIANGLES);
+		LODs = _sharedGeometry->LODs;
+		BoundingRadius = _sharedGeometry->BoundingRadius;
+		Mesh = LODs.empty() ? nullptr : LODs[0];
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
-}
\ No newline at end of file
+
+	int MeshResource::SelectLOD(float screenSize, int currentLod) const {
+		const int numLods = GetLODCount();
+		if (numLods <= 1) {
+			return 0;
+		}
+
+		// LOD n is used when the mesh is smaller than base / 2^(n-1) of the screen
+		auto threshold = [](int level) {
+			return LOD_BASE_SCREEN_SIZE / static_cast<float>(1 << (level - 1));
+		};
+
+		int result = glm::clamp(currentLod, 0, numLods - 1);
+		// Step to coarser levels while we are comfortably below their threshold
+		while (result < numLods - 1 && screenSize < threshold(result + 1) * (1.0f - LOD_HYSTERESIS)) {
+			result++;
+		}
+		// Step to finer levels while we are comfortably above the current level's threshold
+		while (result > 0 && screenSize > threshold(result) * (1.0f + LOD_HYSTERESIS)) {
+			result--;
+		}
+		return result;
+	}
+
+	VertexArrayObject::Sptr MeshResource::GetLOD(int level) const {
+		if (LODs.empty()) {
+			return Mesh;
+		}
+		return LODs[glm::clamp(level, 0, static_cast<int>(LODs.size()) - 1)];
+	}
+
+	int MeshResource::GetLODCount() const {
+		return LODs.empty() ? (Mesh != nullptr ? 1 : 0) : static_cast<int>(LODs.size());
+	}
+
+	void MeshResource::ClearPrefetched() {
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+		_prefetched.clear();
+	}
+
+	size_t MeshResource::GetGpuMemoryUsage() const {
+		// Our LODs share a vertex buffer, so we collect the unique buffers before adding them up
+		std::unordered_set<const IBuffer*> buffers;
+		auto collect = [&](const VertexArrayObject::Sptr& vao) {
+			if (vao == nullptr) {
+				return;
+			}
+			if (vao->GetIndexBuffer() != nullptr) {
+				buffers.insert(vao->GetIndexBuffer().get());
+			}
+			for (const auto* binding : vao->GetVertexBuffers()) {
+				buffers.insert(binding->GetBuffer().get());
+			}
+		};
+		collect(Mesh);
+		for (const auto& lod : LODs) {
+			collect(lod);
+		}
+
+		size_t result = 0;
+		for (const IBuffer* buffer : buffers) {
+			result += buffer->GetTotalSize();
+		}
+		return result;
+	}
+
+	size_t MeshResource::GetCpuMemoryUsage() const {
+		size_t result = Filename.capacity() + MeshBuilderParams.capacity() * sizeof(MeshBuilderParam);
+		// Colliders keep a copy of the triangles in bullet's format for as long as the mesh is around
+		if (BulletTriMesh != nullptr) {
+			const IndexedMeshArray& parts = BulletTriMesh->getIndexedMeshArray();
+			for (int ix = 0; ix < parts.size(); ix++) {
+				result += static_cast<size_t>(parts[ix].m_numVertices) * parts[ix].m_vertexStride;
+				result += static_cast<size_t>(parts[ix].m_numTriangles) * parts[ix].m_triangleIndexStride;
+			}
+		}
+		return result;
+	}
+
+	void MeshResource::_LoadFromFile() {
+		_sharedGeometry = nullptr;
+		#ifdef OPTIMIZED_OBJ_LOADER
+		// The optimized loader generates our LODs once and stores them in the binary file
+		OptimizedObjLoader::LodChain chain = OptimizedObjLoader::LoadLODsFromFile(Filename);
+		LODs = chain.Levels;
+		BoundingRadius = chain.BoundingRadius;
+		Mesh = LODs.empty() ? nullptr : LODs[0];
+		#else
+		// If the cooker produced an up to date binary mesh, we can load that (and it's LODs) directly
+		std::string cookedFile = CookManifest::GetCookedOutput(Filename, ".bin");
+		if (!cookedFile.empty()) {
+			OptimizedObjLoader::LodChain chain = OptimizedObjLoader::LoadLODsFromFile(cookedFile);
+			if (!chain.Levels.empty()) {
+				LODs = chain.Levels;
+				BoundingRadius = chain.BoundingRadius;
+				Mesh = LODs[0];
+				return;
+			}
+		}
+
+		// Use the prefetched data if we have it, otherwise we do the CPU side work now
+		std::shared_ptr<CookedMesh> cooked = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(_prefetchMutex);
+			auto it = _prefetched.find(Filename);
+			if (it != _prefetched.end()) {
+				cooked = it->second;
+				_prefetched.erase(it);
+			}
+		}
+		if (cooked == nullptr) {
+			cooked = _CookFile(Filename);
+		}
+		BoundingRadius = cooked->BoundingRadius;
+		LODs = cooked->Mesh.BakeLODs(cooked->LODs);
+		Mesh = LODs[0];
+		#endif
+	}
+
+	std::shared_ptr<MeshResource::CookedMesh> MeshResource::_CookFile(const std::string& filename) {
+		std::shared_ptr<CookedMesh> result = std::make_shared<CookedMesh>();
+		result->Mesh = ObjLoader::LoadMeshBuilder(filename);
+		result->BoundingRadius = MeshSimplifier::CalculateBoundingRadius(MeshSimplifier::ExtractPositions(result->Mesh));
+		result->LODs = MeshSimplifier::GenerateLODs(result->Mesh, 3, LOD_MIN_TRIANGLES);
+		return result;
+	}
+}
@@ -1,7 +1,10 @@
 #pragma once
+#include <mutex>
+#include <unordered_map>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
+#include "Gameplay/ProceduralMeshCache.h"
 
 // bullet triangle mesh pre-declaration
 class btTriangleMesh;
@@ -40,6 +43,31 @@ namespace Gameplay {
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
+		/// <summary>
+		/// The VAOs for each level of detail of this mesh, where element 0 is the same as Mesh.
+		/// All levels share one vertex buffer, and each has roughly half the triangles of the last
+		/// </summary>
+		std::vector<VertexArrayObject::Sptr> LODs;
+		/// <summary>
+		/// The radius of the sphere around the mesh's origin that contains all of it's vertices,
+		/// used to estimate how large the mesh appears on screen
+		/// </summary>
+		float                           BoundingRadius;
+
+		/// <summary>
+		/// The size on screen (as a fraction of the screen height) below which we will switch to LOD 1,
+		/// each level after that switches at half the size of the previous level
+		/// </summary>
+		static constexpr float LOD_BASE_SCREEN_SIZE = 0.4f;
+		/// <summary>
+		/// How far past a threshold (as a fraction of the threshold) the screen size must go before we
+		/// switch levels, this prevents objects from flickering between LODs near a threshold
+		/// </summary>
+		static constexpr float LOD_HYSTERESIS = 0.15f;
+		/// <summary>
+		/// Generated meshes with fewer triangles than this will not get simplified LODs
+		/// </summary>
+		static constexpr size_t LOD_MIN_TRIANGLES = 64;
 
 
 		/// <summary>
@@ -52,7 +80,8 @@ namespace Gameplay {
 		std::shared_ptr<btTriangleMesh> BulletTriMesh;
 
 		/// <summary>
-		/// Generates a new mesh from the mesh builder parameters
+		/// Generates a new mesh from the mesh builder parameters, sharing geometry with any
+		/// other resources that have identical parameters
 		/// </summary>
 		void GenerateMesh();
 		/// <summary>
@@ -61,9 +90,71 @@ namespace Gameplay {
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Selects the level of detail to render based on how large the mesh appears on screen
+		/// </summary>
+		/// <param name="screenSize">The projected diameter of the mesh's bounds, as a fraction of the screen height</param>
+		/// <param name="currentLod">The level that was selected last frame, used for hysteresis</param>
+		/// <returns>The index of the LOD to render</returns>
+		int SelectLOD(float screenSize, int currentLod) const;
+		/// <summary>
+		/// Gets the VAO for the given level of detail, clamped to the available levels
+		/// </summary>
+		/// <param name="level">The index of the level to get</param>
+		VertexArrayObject::Sptr GetLOD(int level) const;
+		/// <summary>
+		/// Gets the number of levels of detail in this mesh, including the full detail mesh
+		/// </summary>
+		int GetLODCount() const;
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+		/// <summary>
+		/// Converts the mesh's OBJ file to our binary format ahead of time if needed, so that FromJson only
+		/// has to read the binary file. Safe to call from worker threads
+		/// </summary>
+		static void Prefetch(const nlohmann::json& blob);
+		/// <summary>
+		/// Drops any prefetched meshes that were never loaded, called by the resource manager once it's
+		/// done preloading
+		/// </summary>
+		static void ClearPrefetched();
+		/// <summary>
+		/// Gets the size of all the buffers used by this mesh's LODs, buffers shared between LODs are only counted once
+		/// </summary>
+		virtual size_t GetGpuMemoryUsage() const override;
+		/// <summary>
+		/// Gets the size of the CPU side geometry kept by this mesh, which is mostly the bullet triangle mesh
+		/// used by mesh colliders
+		/// </summary>
+		virtual size_t GetCpuMemoryUsage() const override;
+
+	protected:
+		/// <summary>
+		/// Loads the mesh and it's LODs from Filename
+		/// </summary>
+		void _LoadFromFile();
+		// Mesh data that has been loaded and simplified, but not uploaded to OpenGL yet
+		struct CookedMesh {
+			MeshBuilder<VertexPosNormTexColTangents> Mesh;
+			// The index lists for LOD 1 through N
+			std::vector<std::vector<uint32_t>>       LODs;
+			float                                    BoundingRadius = 0.0f;
+		};
+
+		// Meshes that were cooked by Prefetch, keyed by filename, waiting to be baked by _LoadFromFile
+		inline static std::mutex                                                  _prefetchMutex;
+		inline static std::unordered_map<std::string, std::shared_ptr<CookedMesh>> _prefetched;
+
+		/// <summary>
+		/// Loads a mesh from an OBJ file and generates it's LODs, only touches CPU memory
+		/// </summary>
+		/// <param name="filename">The path of the OBJ file to load</param>
+		static std::shared_ptr<CookedMesh> _CookFile(const std::string& filename);
+
+		// Keeps our generated geometry alive in the procedural mesh cache, null for meshes loaded from files
+		ProceduralMeshCache::CachedMesh::Sptr _sharedGeometry;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "Gameplay/Particles/CpuParticleSimulator.h"
+#include <future>
+#include <cstring>
+
+// SSE2 is always available on x64, other platforms fall back to the scalar loops
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define PARTICLES_USE_SSE 0
+#endif
+
+CpuParticleSimulator::CpuParticleSimulator(uint32_t maxParticles) :
+	_maxParticles(0),
+	_count(0),
+	_gravity(glm::vec3(0.0f, 0.0f, -9.81f)),
+	_emissionScale(1.0f),
+	_streams(Streams()),
+	_emitters(std::vector<Emitter>()),
+	_random(std::minstd_rand(std::random_device()()))
+{
+	SetMaxParticles(maxParticles);
+}
+
+void CpuParticleSimulator::SetMaxParticles(uint32_t value) {
+	_maxParticles = value;
+	_count = 0;
+	for (std::vector<float>* stream : { &_streams.PositionX, &_streams.PositionY, &_streams.PositionZ,
+		 &_streams.VelocityX, &_streams.VelocityY, &_streams.VelocityZ, &_streams.Lifetime, &_streams.StartLifetime }) {
+		stream->assign(value, 0.0f);
+	}
+	_streams.Color.assign(value, glm::vec4(0.0f));
+	_streams.Size.assign(value, glm::vec2(0.0f));
+}
+
+void CpuParticleSimulator::AddEmitter(const Emitter& emitter) {
+	_emitters.push_back(emitter);
+}
+
+void CpuParticleSimulator::Update(float dt) {
+	// Integrating and aging touch each particle independently, so large systems can be split across threads
+	uint32_t chunkSize = glm::max(ParallelChunkSize, 4u);
+	uint32_t numChunks = (_count + chunkSize - 1) / chunkSize;
+	if (numChunks <= 1) {
+		_Integrate(_streams, 0, _count, dt, _gravity);
+		_Age(_streams, 0, _count, dt);
+	} else {
+		std::vector<std::future<void>> jobs;
+		jobs.reserve(numChunks - 1);
+		for (uint32_t chunk = 1; chunk < numChunks; chunk++) {
+			uint32_t begin = chunk * chunkSize;
+			uint32_t end = glm::min(begin + chunkSize, _count);
+			jobs.push_back(std::async(std::launch::async, [this, begin, end, dt]() {
+				_Integrate(_streams, begin, end, dt, _gravity);
+				_Age(_streams, begin, end, dt);
+			}));
+		}
+		// This thread takes the first chunk instead of waiting
+		_Integrate(_streams, 0, chunkSize, dt, _gravity);
+		_Age(_streams, 0, chunkSize, dt);
+		for (auto& job : jobs) {
+			job.wait();
+		}
+	}
+
+	// Removing and spawning change the particle count, so they happen on this thread
+	_Kill();
+	_Emit(dt);
+}
+
+void CpuParticleSimulator::Clear() {
+	_count = 0;
+}
+
+void CpuParticleSimulator::SortBackToFront(const glm::mat4& view, std::vector<uint32_t>& order) {
+	order.resize(_count);
+	_sortKeys.resize(_count);
+	_sortKeysTemp.resize(_count);
+	_sortIndicesTemp.resize(_count);
+	for (uint32_t ix = 0; ix < _count; ix++) {
+		order[ix] = ix;
+	}
+
+	// Keys are independent, so they can be calculated in parallel the same way as the update
+	uint32_t chunkSize = glm::max(ParallelChunkSize, 4u);
+	uint32_t numChunks = (_count + chunkSize - 1) / chunkSize;
+	if (numChunks <= 1) {
+		_DepthKeys(_streams, 0, _count, view, _sortKeys.data());
+	} else {
+		std::vector<std::future<void>> jobs;
+		jobs.reserve(numChunks - 1);
+		for (uint32_t chunk = 1; chunk < numChunks; chunk++) {
+			uint32_t begin = chunk * chunkSize;
+			uint32_t end = glm::min(begin + chunkSize, _count);
+			jobs.push_back(std::async(std::launch::async, [this, begin, end, &view]() {
+				_DepthKeys(_streams, begin, end, view, _sortKeys.data());
+			}));
+		}
+		_DepthKeys(_streams, 0, chunkSize, view, _sortKeys.data());
+		for (auto& job : jobs) {
+			job.wait();
+		}
+	}
+
+	// LSD radix sort, 8 bits at a time. Each pass is stable, so the order from earlier passes is kept
+	uint32_t* keys = _sortKeys.data();
+	uint32_t* indices = order.data();
+	uint32_t* keysOut = _sortKeysTemp.data();
+	uint32_t* indicesOut = _sortIndicesTemp.data();
+	for (uint32_t shift = 0; shift < 32; shift += 8) {
+		uint32_t offsets[256] = { 0 };
+		for (uint32_t ix = 0; ix < _count; ix++) {
+			offsets[(keys[ix] >> shift) & 0xFF]++;
+		}
+
+		// All keys have the same value in this byte, nothing would move
+		if (_count > 0 && offsets[(keys[0] >> shift) & 0xFF] == _count) {
+			continue;
+		}
+
+		uint32_t total = 0;
+		for (uint32_t bucket = 0; bucket < 256; bucket++) {
+			uint32_t count = offsets[bucket];
+			offsets[bucket] = total;
+			total += count;
+		}
+		for (uint32_t ix = 0; ix < _count; ix++) {
+			uint32_t target = offsets[(keys[ix] >> shift) & 0xFF]++;
+			keysOut[target] = keys[ix];
+			indicesOut[target] = indices[ix];
+		}
+		std::swap(keys, keysOut);
+		std::swap(indices, indicesOut);
+	}
+
+	// After an odd number of passes the results are in the scratch buffer
+	if (indices != order.data()) {
+		memcpy(order.data(), indices, _count * sizeof(uint32_t));
+	}
+}
+
+void CpuParticleSimulator::_Integrate(Streams& streams, uint32_t begin, uint32_t end, float dt, const glm::vec3& gravity) {
+	float* px = streams.PositionX.data();
+	float* py = streams.PositionY.data();
+	float* pz = streams.PositionZ.data();
+	float* vx = streams.VelocityX.data();
+	float* vy = streams.VelocityY.data();
+	float* vz = streams.VelocityZ.data();
+	glm::vec3 dv = gravity * dt;
+
+	uint32_t ix = begin;
+#if PARTICLES_USE_SSE
+	const __m128 delta = _mm_set1_ps(dt);
+	const __m128 dvx = _mm_set1_ps(dv.x);
+	const __m128 dvy = _mm_set1_ps(dv.y);
+	const __m128 dvz = _mm_set1_ps(dv.z);
+	for (; ix + 4 <= end; ix += 4) {
+		// Position is moved by the velocity from before gravity is applied, same as the shader
+		__m128 velX = _mm_loadu_ps(vx + ix);
+		__m128 velY = _mm_loadu_ps(vy + ix);
+		__m128 velZ = _mm_loadu_ps(vz + ix);
+		_mm_storeu_ps(px + ix, _mm_add_ps(_mm_loadu_ps(px + ix), _mm_mul_ps(velX, delta)));
+		_mm_storeu_ps(py + ix, _mm_add_ps(_mm_loadu_ps(py + ix), _mm_mul_ps(velY, delta)));
+		_mm_storeu_ps(pz + ix, _mm_add_ps(_mm_loadu_ps(pz + ix), _mm_mul_ps(velZ, delta)));
+		_mm_storeu_ps(vx + ix, _mm_add_ps(velX, dvx));
+		_mm_storeu_ps(vy + ix, _mm_add_ps(velY, dvy));
+		_mm_storeu_ps(vz + ix, _mm_add_ps(velZ, dvz));
+	}
+#endif
+	for (; ix < end; ix++) {
+		px[ix] += vx[ix] * dt;
+		py[ix] += vy[ix] * dt;
+		pz[ix] += vz[ix] * dt;
+		vx[ix] += dv.x;
+		vy[ix] += dv.y;
+		vz[ix] += dv.z;
+	}
+}
+
+void CpuParticleSimulator::_Age(Streams& streams, uint32_t begin, uint32_t end, float dt) {
+	float* life = streams.Lifetime.data();
+
+	uint32_t ix = begin;
+#if PARTICLES_USE_SSE
+	const __m128 delta = _mm_set1_ps(dt);
+	for (; ix + 4 <= end; ix += 4) {
+		_mm_storeu_ps(life + ix, _mm_sub_ps(_mm_loadu_ps(life + ix), delta));
+	}
+#endif
+	for (; ix < end; ix++) {
+		life[ix] -= dt;
+	}
+}
+
+void CpuParticleSimulator::_DepthKeys(const Streams& streams, uint32_t begin, uint32_t end, const glm::mat4& view, uint32_t* keys) {
+	// The distance in front of the camera is -(view * p).z, we use +z so that keys sort furthest first
+	for (uint32_t ix = begin; ix < end; ix++) {
+		float z = view[0][2] * streams.PositionX[ix] + view[1][2] * streams.PositionY[ix] + view[2][2] * streams.PositionZ[ix] + view[3][2];
+
+		// Flip the bits of the float so that it sorts correctly as an unsigned integer (negatives reversed,
+		// positives above negatives)
+		uint32_t bits;
+		memcpy(&bits, &z, sizeof(float));
+		keys[ix] = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+}
+
+void CpuParticleSimulator::_Kill() {
+	const float* life = _streams.Lifetime.data();
+
+	uint32_t ix = 0;
+	while (ix < _count) {
+#if PARTICLES_USE_SSE
+		// Most particles are alive, so we skip over blocks of 4 that have no dead particles
+		if (ix + 4 <= _count && _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(life + ix), _mm_setzero_ps())) == 0) {
+			ix += 4;
+			continue;
+		}
+#endif
+		// The particle we move in may also be dead, so we check the same index again
+		if (life[ix] <= 0.0f) {
+			_count--;
+			_Move(_count, ix);
+		} else {
+			ix++;
+		}
+	}
+}
+
+void CpuParticleSimulator::_Emit(float dt) {
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	for (Emitter& emitter : _emitters) {
+		emitter.SpawnTimer -= dt;
+
+		// Stopped emitters are held ready to spawn as soon as they're resumed
+		if (_emissionScale <= 0.0f) {
+			emitter.SpawnTimer = glm::max(emitter.SpawnTimer, 0.0f);
+			continue;
+		}
+		float interval = glm::max(emitter.SpawnInterval, 0.0001f) / _emissionScale;
+
+		uint32_t emitted = 0;
+		while (emitter.SpawnTimer < 0.0f && emitted < MAX_EMIT_PER_UPDATE) {
+			// Particles that don't fit are dropped, but the emitter still keeps it's rhythm
+			if (_count < _maxParticles) {
+				uint32_t ix = _count++;
+				// Particles spawned partway through the update are moved forward by the time they've existed
+				glm::vec3 position = emitter.Position + emitter.Velocity * (-emitter.SpawnTimer);
+				_streams.PositionX[ix] = position.x;
+				_streams.PositionY[ix] = position.y;
+				_streams.PositionZ[ix] = position.z;
+				_streams.VelocityX[ix] = emitter.Velocity.x;
+				_streams.VelocityY[ix] = emitter.Velocity.y;
+				_streams.VelocityZ[ix] = emitter.Velocity.z;
+				_streams.Lifetime[ix]  = glm::mix(emitter.LifetimeRange.x, emitter.LifetimeRange.y, unit(_random));
+				_streams.StartLifetime[ix] = _streams.Lifetime[ix];
+				_streams.Color[ix]     = emitter.Color;
+				_streams.Size[ix]      = emitter.SizeRange;
+			}
+
+			emitter.SpawnTimer += interval;
+			emitted++;
+		}
+	}
+}
+
+void CpuParticleSimulator::_Move(uint32_t from, uint32_t to) {
+	_streams.PositionX[to] = _streams.PositionX[from];
+	_streams.PositionY[to] = _streams.PositionY[from];
+	_streams.PositionZ[to] = _streams.PositionZ[from];
+	_streams.VelocityX[to] = _streams.VelocityX[from];
+	_streams.VelocityY[to] = _streams.VelocityY[from];
+	_streams.VelocityZ[to] = _streams.VelocityZ[from];
+	_streams.Lifetime[to]  = _streams.Lifetime[from];
+	_streams.StartLifetime[to] = _streams.StartLifetime[from];
+	_streams.Color[to]     = _streams.Color[from];
+	_streams.Size[to]      = _streams.Size[from];
+}
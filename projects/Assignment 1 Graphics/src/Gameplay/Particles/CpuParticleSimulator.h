@@ -0,0 +1,146 @@
+#pragma once
+#include <vector>
+#include <random>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Simulates particles on the CPU with the same rules as particle_sim_gs.glsl. Each particle attribute is
+/// stored in it's own array, so that integration and aging can be vectorized, and large systems are split
+/// into chunks that are updated in parallel. Does not depend on OpenGL, so particle logic can run without
+/// a renderer (ex: on a headless server), and gameplay code can read the particle state back
+/// </summary>
+class CpuParticleSimulator {
+public:
+	/// <summary>
+	/// A point that spawns particles at a fixed rate
+	/// </summary>
+	struct Emitter {
+		glm::vec3 Position;
+		// The initial velocity of particles spawned by this emitter
+		glm::vec3 Velocity;
+		glm::vec4 Color;
+		// The time between particle spawns, in seconds
+		float     SpawnInterval;
+		// The time until the next particle spawns, in seconds
+		float     SpawnTimer;
+		// The minimum and maximum lifetime of spawned particles, in seconds
+		glm::vec2 LifetimeRange;
+		// The size of spawned particles at the start and end of their lifetime
+		glm::vec2 SizeRange;
+	};
+
+	/// <summary>
+	/// The state of all live particles, index N of each array belongs to the same particle
+	/// </summary>
+	struct Streams {
+		std::vector<float>     PositionX, PositionY, PositionZ;
+		std::vector<float>     VelocityX, VelocityY, VelocityZ;
+		std::vector<float>     Lifetime;
+		std::vector<float>     StartLifetime;
+		std::vector<glm::vec4> Color;
+		std::vector<glm::vec2> Size;
+	};
+
+	// Systems with more particles than this are split into chunks of this size that are updated in parallel
+	inline static uint32_t ParallelChunkSize = 16384;
+	// The most particles a single emitter can spawn in one update, matches the limit in particle_sim_gs.glsl
+	static constexpr uint32_t MAX_EMIT_PER_UPDATE = 31;
+
+	CpuParticleSimulator(uint32_t maxParticles = 0);
+	~CpuParticleSimulator() = default;
+
+	/// <summary>
+	/// Sets the maximum number of live particles, removing all existing particles
+	/// </summary>
+	void SetMaxParticles(uint32_t value);
+	uint32_t GetMaxParticles() const { return _maxParticles; }
+
+	void SetGravity(const glm::vec3& value) { _gravity = value; }
+	const glm::vec3& GetGravity() const { return _gravity; }
+
+	/// <summary>
+	/// Sets a multiplier for the spawn rate of all emitters, 0 stops all emitters
+	/// </summary>
+	void SetEmissionScale(float value) { _emissionScale = value; }
+	float GetEmissionScale() const { return _emissionScale; }
+
+	/// <summary>
+	/// Adds an emitter to the simulation, emitters can be edited at any time with GetEmitters
+	/// </summary>
+	void AddEmitter(const Emitter& emitter);
+	std::vector<Emitter>& GetEmitters() { return _emitters; }
+
+	/// <summary>
+	/// Advances the simulation. Moves and ages all particles, removes particles that have expired, then
+	/// spawns new particles from the emitters
+	/// </summary>
+	/// <param name="dt">The time since the last update, in seconds</param>
+	void Update(float dt);
+	/// <summary>
+	/// Removes all live particles, leaving the emitters
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Gets the number of live particles
+	/// </summary>
+	uint32_t GetCount() const { return _count; }
+	/// <summary>
+	/// Gets the particle state, only the first GetCount() elements of each array are valid. Note that
+	/// particles are re-ordered when others are removed, so indices are only valid until the next update
+	/// </summary>
+	const Streams& GetStreams() const { return _streams; }
+	glm::vec3 GetPosition(uint32_t index) const {
+		return glm::vec3(_streams.PositionX[index], _streams.PositionY[index], _streams.PositionZ[index]);
+	}
+	glm::vec3 GetVelocity(uint32_t index) const {
+		return glm::vec3(_streams.VelocityX[index], _streams.VelocityY[index], _streams.VelocityZ[index]);
+	}
+
+	/// <summary>
+	/// Sorts the live particles by their distance along the camera's view direction, furthest first, so they
+	/// can be drawn with alpha blending. Particles are not moved, instead their indices are written in order
+	/// </summary>
+	/// <param name="view">The camera's view matrix</param>
+	/// <param name="order">Receives GetCount() particle indices, from back to front</param>
+	void SortBackToFront(const glm::mat4& view, std::vector<uint32_t>& order);
+
+protected:
+	uint32_t             _maxParticles;
+	uint32_t             _count;
+	glm::vec3            _gravity;
+	float                _emissionScale;
+	Streams              _streams;
+	std::vector<Emitter> _emitters;
+	std::minstd_rand     _random;
+
+	// Scratch space for sorting, kept around so we don't allocate every frame
+	std::vector<uint32_t> _sortKeys;
+	std::vector<uint32_t> _sortKeysTemp;
+	std::vector<uint32_t> _sortIndicesTemp;
+
+	/// <summary>
+	/// Moves the particles in [begin, end) by their velocity, and applies gravity to their velocity
+	/// </summary>
+	static void _Integrate(Streams& streams, uint32_t begin, uint32_t end, float dt, const glm::vec3& gravity);
+	/// <summary>
+	/// Counts down the lifetime of the particles in [begin, end)
+	/// </summary>
+	static void _Age(Streams& streams, uint32_t begin, uint32_t end, float dt);
+	/// <summary>
+	/// Calculates the sort keys for the particles in [begin, end), keys increase towards the camera
+	/// </summary>
+	static void _DepthKeys(const Streams& streams, uint32_t begin, uint32_t end, const glm::mat4& view, uint32_t* keys);
+	/// <summary>
+	/// Removes all particles that have no lifetime left, by moving the last particle into their place
+	/// </summary>
+	void _Kill();
+	/// <summary>
+	/// Spawns particles from all emitters that are due to spawn
+	/// </summary>
+	void _Emit(float dt);
+	/// <summary>
+	/// Copies the particle at one index to another
+	/// </summary>
+	void _Move(uint32_t from, uint32_t to);
+};
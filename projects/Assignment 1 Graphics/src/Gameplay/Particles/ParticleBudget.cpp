@@ -0,0 +1,160 @@
+#include "Gameplay/Particles/ParticleBudget.h"
+#include "Gameplay/Components/ParticleSystem.h"
+#include "Gameplay/GameObject.h"
+#include "Utils/ImGuiHelper.h"
+#include "Utils/GlmDefines.h"
+
+ParticleBudget::Stats ParticleBudget::_stats;
+
+/// <summary>
+/// Returns true if a box is entirely on the outside of one of the frustum planes
+/// </summary>
+inline bool IsBoxCulled(const glm::vec4 planes[6], const glm::vec3& min, const glm::vec3& max) {
+	for (int ix = 0; ix < 6; ix++) {
+		// Test the corner that is furthest along the plane's normal
+		glm::vec3 normal = glm::vec3(planes[ix]);
+		glm::vec3 corner = glm::vec3(
+			normal.x >= 0.0f ? max.x : min.x,
+			normal.y >= 0.0f ? max.y : min.y,
+			normal.z >= 0.0f ? max.z : min.z
+		);
+		if (glm::dot(normal, corner) + planes[ix].w < 0.0f) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ParticleBudget::Update(const Gameplay::Scene::Sptr& scene) {
+	_stats = Stats();
+
+	struct Entry {
+		ParticleSystem* System;
+		float           Demand;
+		float           Allowance;
+		bool            Settled;
+	};
+	std::vector<Entry> visible;
+
+	bool hasCamera = scene->MainCamera != nullptr;
+	glm::vec4 planes[6];
+	glm::vec3 cameraPos = glm::vec3(0.0f);
+	if (hasCamera) {
+		ExtractFrustumPlanes(scene->MainCamera->GetViewProjection(), planes);
+		cameraPos = glm::vec3(scene->MainCamera->GetGameObject()->GetTransform()[3]);
+	}
+
+	scene->Components().Each<ParticleSystem>([&](const ParticleSystem::Sptr& system) {
+		// Disabled systems don't simulate or draw, so they don't count against the budget
+		if (!system->IsEnabled) {
+			return;
+		}
+		_stats.Systems++;
+		_stats.Live += system->_numParticles;
+
+		if (!Enabled || !hasCamera) {
+			system->_isCulled = false;
+			system->_emissionScale = 1.0f;
+			system->_updateInterval = 1;
+			return;
+		}
+
+		// Systems with no emitters have nothing to draw
+		glm::vec3 min, max;
+		if (!system->GetBounds(min, max) || IsBoxCulled(planes, min - BoundsPadding, max + BoundsPadding)) {
+			system->_isCulled = true;
+			_stats.Culled++;
+			return;
+		}
+		system->_isCulled = false;
+
+		// Measure to the closest point on the bounds, so we get full detail when we're inside of a system
+		float distance = glm::length(glm::clamp(cameraPos, min, max) - cameraPos);
+		float lod = glm::clamp((distance - LodNearDistance) / glm::max(LodFarDistance - LodNearDistance, 0.001f), 0.0f, 1.0f);
+		system->_emissionScale = glm::mix(1.0f, MinEmissionScale, lod);
+		system->_updateInterval = 1 + (uint32_t)glm::round(lod * (glm::max(MaxUpdateInterval, 1u) - 1));
+
+		float demand = system->GetParticleDemand() * system->_emissionScale;
+		_stats.Requested += (uint32_t)demand;
+		visible.push_back({ system.get(), demand, 0.0f, false });
+	});
+
+	if (!Enabled || !hasCamera) {
+		return;
+	}
+
+	// Split the budget by priority, systems that need less than their share give the remainder back to
+	// the others (weighted max-min fairness)
+	float remaining = (float)MaxParticles;
+	size_t unsettled = visible.size();
+	while (unsettled > 0) {
+		float totalWeight = 0.0f;
+		for (const Entry& entry : visible) {
+			if (!entry.Settled) {
+				totalWeight += glm::max(entry.System->_priority, 0.001f);
+			}
+		}
+
+		bool anySettled = false;
+		for (Entry& entry : visible) {
+			if (!entry.Settled && entry.Demand <= remaining * glm::max(entry.System->_priority, 0.001f) / totalWeight) {
+				entry.Allowance = entry.Demand;
+				entry.Settled = true;
+				anySettled = true;
+			}
+		}
+		if (!anySettled) {
+			// Everybody left wants more than their share, so they get exactly their share
+			for (Entry& entry : visible) {
+				if (!entry.Settled) {
+					entry.Allowance = remaining * glm::max(entry.System->_priority, 0.001f) / totalWeight;
+					entry.Settled = true;
+				}
+			}
+			unsettled = 0;
+		} else {
+			remaining = (float)MaxParticles;
+			unsettled = 0;
+			for (const Entry& entry : visible) {
+				if (entry.Settled) {
+					remaining -= entry.Allowance;
+				} else {
+					unsettled++;
+				}
+			}
+		}
+	}
+
+	// Systems that were cut back emit proportionally slower, so they settle at their allowance
+	for (const Entry& entry : visible) {
+		if (entry.Demand > 0.0f && entry.Allowance < entry.Demand) {
+			entry.System->_emissionScale *= entry.Allowance / entry.Demand;
+		}
+		_stats.Allocated += (uint32_t)entry.Allowance;
+	}
+}
+
+const ParticleBudget::Stats& ParticleBudget::GetStats() {
+	return _stats;
+}
+
+void ParticleBudget::RenderImGui() {
+	ImGui::Text("Systems: %u (%u culled)", _stats.Systems, _stats.Culled);
+	ImGui::Text("Particles: %u live, %u / %u allocated", _stats.Live, _stats.Allocated, MaxParticles);
+	if (_stats.Requested > _stats.Allocated) {
+		ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Over budget, %u requested", _stats.Requested);
+	}
+	ImGui::ProgressBar(MaxParticles > 0 ? (float)_stats.Allocated / MaxParticles : 0.0f);
+
+	ImGui::Checkbox("Enable Budget", &Enabled);
+	int maxParticles = (int)MaxParticles;
+	if (ImGui::DragInt("Max Particles", &maxParticles, 100.0f, 0, 10000000)) {
+		MaxParticles = (uint32_t)maxParticles;
+	}
+	ImGui::DragFloatRange2("LOD Distance", &LodNearDistance, &LodFarDistance, 0.5f, 0.0f, 10000.0f);
+	ImGui::SliderFloat("Min Emission", &MinEmissionScale, 0.0f, 1.0f);
+	int interval = (int)MaxUpdateInterval;
+	if (ImGui::SliderInt("Max Update Interval", &interval, 1, 16)) {
+		MaxUpdateInterval = (uint32_t)interval;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <GLM/glm.hpp>
+#include "Gameplay/Scene.h"
+
+/// <summary>
+/// Decides how much work each particle system in a scene gets every frame. Systems outside of the main
+/// camera's frustum are frozen and not drawn, distant systems emit fewer particles and update less often,
+/// and the particles that visible systems expect to have alive are kept under a scene-wide cap, with
+/// higher priority systems getting a larger share when there isn't enough to go around
+/// </summary>
+class ParticleBudget {
+public:
+	/// <summary>
+	/// What the budget decided for the most recent frame
+	/// </summary>
+	struct Stats {
+		// The number of enabled particle systems in the scene
+		uint32_t Systems   = 0;
+		// The number of systems outside of the camera's frustum
+		uint32_t Culled    = 0;
+		// The number of particles the visible systems would have alive at their distance based emission rate
+		uint32_t Requested = 0;
+		// The number of particles the visible systems are allowed to have alive, at most MaxParticles
+		uint32_t Allocated = 0;
+		// The sum of the particle counts reported by each system, which may lag behind for GPU systems
+		uint32_t Live      = 0;
+	};
+
+	// If false, all systems update and draw every frame at full rate
+	inline static bool     Enabled = true;
+	// The total number of live particles to allow across all visible systems
+	inline static uint32_t MaxParticles = 50000;
+	// Systems closer to the camera than this get full detail
+	inline static float    LodNearDistance = 15.0f;
+	// Systems further from the camera than this get the lowest detail
+	inline static float    LodFarDistance = 80.0f;
+	// The emission rate scale for systems at LodFarDistance
+	inline static float    MinEmissionScale = 0.25f;
+	// The number of frames between updates for systems at LodFarDistance
+	inline static uint32_t MaxUpdateInterval = 4;
+	// Added to the bounds of each system when culling, to cover the size of the particle sprites
+	inline static float    BoundsPadding = 0.5f;
+
+	/// <summary>
+	/// Assigns the LOD and particle allowance for every particle system in the scene, should be called
+	/// once per frame before the systems are updated
+	/// </summary>
+	/// <param name="scene">The scene containing the particle systems</param>
+	static void Update(const Gameplay::Scene::Sptr& scene);
+
+	/// <summary>
+	/// Gets the budget usage from the last call to Update
+	/// </summary>
+	static const Stats& GetStats();
+
+	/// <summary>
+	/// Renders the budget usage and settings with ImGui
+	/// </summary>
+	static void RenderImGui();
+
+protected:
+	ParticleBudget() = default;
+
+	static Stats _stats;
+};
@@ -29,6 +29,14 @@ namespace Gameplay::Physics {
 		blob["extents"] = _extents;
 	}
 
+	void BoxCollider::ToBinary(BinaryOutputArchive& archive) const {
+		archive(_extents);
+	}
+
+	void BoxCollider::FromBinary(BinaryInputArchive& archive) {
+		archive(_extents);
+	}
+
 	void BoxCollider::DrawImGui() {
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat3, "Extents  ", &_extents.x, 0.01f, 0.01f);
 	}
@@ -31,6 +31,14 @@ namespace Gameplay::Physics {
 		_height = data["height"];
 	}
 
+	void CapsuleCollider::ToBinary(BinaryOutputArchive& archive) const {
+		archive(_radius, _height);
+	}
+
+	void CapsuleCollider::FromBinary(BinaryInputArchive& archive) {
+		archive(_radius, _height);
+	}
+
 	btCollisionShape* CapsuleCollider::CreateShape() const {
 		return new btCapsuleShapeZ(_radius, _height);
 	}
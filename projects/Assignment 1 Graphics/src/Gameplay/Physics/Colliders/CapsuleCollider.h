@@ -22,6 +22,8 @@ namespace Gameplay::Physics {
 		virtual void DrawImGui() override;
 		virtual void ToJson(nlohmann::json& blob) const override;
 		virtual void FromJson(const nlohmann::json& data) override;
+		virtual void ToBinary(BinaryOutputArchive& archive) const override;
+		virtual void FromBinary(BinaryInputArchive& archive) override;
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
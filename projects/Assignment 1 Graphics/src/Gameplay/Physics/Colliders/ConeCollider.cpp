@@ -31,6 +31,14 @@ namespace Gameplay::Physics {
 		_height = data["height"];
 	}
 
+	void ConeCollider::ToBinary(BinaryOutputArchive& archive) const {
+		archive(_radius, _height);
+	}
+
+	void ConeCollider::FromBinary(BinaryInputArchive& archive) {
+		archive(_radius, _height);
+	}
+
 	btCollisionShape* ConeCollider::CreateShape() const {
 		return new btConeShapeZ(_radius, _height);
 	}
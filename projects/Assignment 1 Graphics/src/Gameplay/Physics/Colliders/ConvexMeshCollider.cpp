@@ -168,6 +168,12 @@ namespace Gameplay::Physics {
 	void ConvexMeshCollider::ToJson(nlohmann::json& blob) const {
 	}
 
+	void ConvexMeshCollider::ToBinary(BinaryOutputArchive& archive) const {
+	}
+
+	void ConvexMeshCollider::FromBinary(BinaryInputArchive& archive) {
+	}
+
 	void ConvexMeshCollider::DrawImGui() {
 	}
 }
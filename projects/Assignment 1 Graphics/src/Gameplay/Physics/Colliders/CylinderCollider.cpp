@@ -29,6 +29,14 @@ namespace Gameplay::Physics {
 		_extents = (data["half_extents"]);
 	}
 
+	void CylinderCollider::ToBinary(BinaryOutputArchive& archive) const {
+		archive(_extents);
+	}
+
+	void CylinderCollider::FromBinary(BinaryInputArchive& archive) {
+		archive(_extents);
+	}
+
 	btCollisionShape* CylinderCollider::CreateShape() const {
 		return new btCylinderShapeZ(ToBt(_extents));
 	}
@@ -27,6 +27,14 @@ namespace Gameplay::Physics {
 		_normal = (data["normal"]);
 	}
 
+	void PlaneCollider::ToBinary(BinaryOutputArchive& archive) const {
+		archive(_normal);
+	}
+
+	void PlaneCollider::FromBinary(BinaryInputArchive& archive) {
+		archive(_normal);
+	}
+
 	btCollisionShape* PlaneCollider::CreateShape() const {
 		return new btStaticPlaneShape(btVector3(_normal.x, _normal.y, _normal.z), 0.0f);
 	}
@@ -36,6 +36,14 @@ namespace Gameplay::Physics {
 		blob["radius"] = _radius;
 	}
 
+	void SphereCollider::ToBinary(BinaryOutputArchive& archive) const {
+		archive(_radius);
+	}
+
+	void SphereCollider::FromBinary(BinaryInputArchive& archive) {
+		archive(_radius);
+	}
+
 	void SphereCollider::DrawImGui() {
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat, "Radius", &_radius, 0.01f);
 	}
@@ -7,6 +7,7 @@
 #include <btBulletCollisionCommon.h>
 
 #include "Utils/GUID.hpp"
+#include "Utils/BinarySerialization.h"
 
 /// <summary>
 /// Represents the shape of a collider
@@ -76,6 +77,18 @@ namespace Gameplay::Physics {
 		/// </summary>
 		/// <param name="data">The JSON data to unpack into this instance</param>
 		virtual void FromJson(const nlohmann::json& data) = 0;
+		/// <summary>
+		/// Writes information about this collider to a binary archive, the binary
+		/// equivalent of ToJson
+		/// </summary>
+		/// <param name="archive">The archive to write to</param>
+		virtual void ToBinary(BinaryOutputArchive& archive) const = 0;
+		/// <summary>
+		/// Reads information about this collider from a binary archive, the binary
+		/// equivalent of FromJson
+		/// </summary>
+		/// <param name="archive">The archive to read from</param>
+		virtual void FromBinary(BinaryInputArchive& archive) = 0;
 
 		/// <summary>
 		/// Allows colliders to perform initialization on object awake, 
@@ -114,6 +114,36 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 	}
 
 
+	void PhysicsBase::SaveBinaryBase(BinaryOutputArchive& archive) const {
+		archive(_collisionGroup, _collisionMask);
+		archive(static_cast<uint32_t>(_colliders.size()));
+		for (auto& collider : _colliders) {
+			archive(collider->_guid, *collider->_type, collider->_position, collider->_rotation, collider->_scale);
+			collider->ToBinary(archive);
+		}
+	}
+
+	void PhysicsBase::LoadBinaryBase(BinaryInputArchive& archive) {
+		archive(_collisionGroup, _collisionMask);
+		uint32_t numColliders = 0;
+		archive(numColliders);
+		for (uint32_t ix = 0; ix < numColliders; ix++) {
+			Guid guid;
+			int type = 0;
+			archive(guid, type);
+			// Unlike JSON, we can't skip over colliders we can't create, since we don't know their size
+			ICollider::Sptr collider = ICollider::Create(static_cast<ColliderType>(type));
+			if (collider == nullptr) {
+				throw std::runtime_error("Unknown collider type in binary scene");
+			}
+			collider->_guid = guid;
+			archive(collider->_position, collider->_rotation, collider->_scale);
+			collider->FromBinary(archive);
+			collider->_isDirty = true;
+			_colliders.push_back(collider);
+		}
+	}
+
 	void PhysicsBase::SetCollisionGroup(int value) {
 		_collisionGroup = 1 << value;
 		_isGroupMaskDirty = true;
@@ -109,6 +109,8 @@ namespace Gameplay {
 
 			void ToJsonBase(nlohmann::json& output) const;
 			void FromJsonBase(const nlohmann::json& input);
+			void SaveBinaryBase(BinaryOutputArchive& archive) const;
+			void LoadBinaryBase(BinaryInputArchive& archive);
 
 			// Handles adding a collider to our compound shape
 			void _AddColliderToShape(ICollider* collider);
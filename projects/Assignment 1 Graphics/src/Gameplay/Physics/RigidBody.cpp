@@ -268,6 +268,18 @@ namespace Gameplay::Physics {
 		return result;
 	}
 
+	void RigidBody::save(BinaryOutputArchive& archive) const {
+		archive(static_cast<int>(_type), _mass, _linearDamping, _angularDamping);
+		SaveBinaryBase(archive);
+	}
+
+	void RigidBody::load(BinaryInputArchive& archive) {
+		int type = 0;
+		archive(type, _mass, _linearDamping, _angularDamping);
+		_type = static_cast<RigidBodyType>(type);
+		LoadBinaryBase(archive);
+	}
+
 	void RigidBody::_HandleStateDirty() {
 		// Only dynamic bodies have velocities
 		if (_type == RigidBodyType::Dynamic) {
@@ -170,6 +170,8 @@ namespace Gameplay::Physics {
 		virtual void RenderImGui() override;
 		virtual nlohmann::json ToJson() const override;
 		static RigidBody::Sptr FromJson(const nlohmann::json& data);
+		void save(BinaryOutputArchive& archive) const;
+		void load(BinaryInputArchive& archive);
 		MAKE_TYPENAME(RigidBody)
 
 
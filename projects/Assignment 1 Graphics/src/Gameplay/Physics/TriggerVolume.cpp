@@ -188,6 +188,14 @@ namespace Gameplay::Physics {
 		return result;
 	}
 
+	void TriggerVolume::save(BinaryOutputArchive& archive) const {
+		SaveBinaryBase(archive);
+	}
+
+	void TriggerVolume::load(BinaryInputArchive& archive) {
+		LoadBinaryBase(archive);
+	}
+
 	btBroadphaseProxy* TriggerVolume::_GetBroadphaseHandle() {
 		return _ghost != nullptr ? _ghost->getBroadphaseHandle() : nullptr;
 	}
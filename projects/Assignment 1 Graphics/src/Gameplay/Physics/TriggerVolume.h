@@ -48,6 +48,8 @@ namespace Gameplay::Physics {
 		virtual void RenderImGui() override;
 		virtual nlohmann::json ToJson() const override;
 		static TriggerVolume::Sptr FromJson(const nlohmann::json& data);
+		void save(BinaryOutputArchive& archive) const;
+		void load(BinaryInputArchive& archive);
 		MAKE_TYPENAME(TriggerVolume);
 
 	protected:
@@ -0,0 +1,86 @@
+#include "Gameplay/ProceduralMeshCache.h"
+
+#include <filesystem>
+
+#include "Utils/MeshSimplifier.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+namespace Gameplay {
+	ProceduralMeshCache::CachedMesh::Sptr ProceduralMeshCache::Get(const std::vector<MeshBuilderParam>& params, size_t minLodTriangles) {
+		// The vertex layout and LOD settings change the output, so they need to be part of the key as well
+		uint64_t hash = MeshBuilderParam::HashList(params);
+		hash = HashHelpers::Combine(hash, static_cast<uint32_t>(sizeof(VertexPosNormTexColTangents)));
+		hash = HashHelpers::Combine(hash, static_cast<uint64_t>(minLodTriangles));
+		hash = HashHelpers::Combine(hash, GENERATOR_VERSION);
+
+		// If someone is still holding onto this mesh, we can just share it
+		auto it = _cache.find(hash);
+		if (it != _cache.end()) {
+			if (CachedMesh::Sptr result = it->second.lock()) {
+				return result;
+			}
+		}
+
+		CachedMesh::Sptr result = _Generate(params, hash, minLodTriangles);
+		_cache[hash] = result;
+		return result;
+	}
+
+	size_t ProceduralMeshCache::GetLiveCount() {
+		// Take this opportunity to clean out any expired entries
+		for (auto it = _cache.begin(); it != _cache.end();) {
+			it = it->second.expired() ? _cache.erase(it) : std::next(it);
+		}
+		return _cache.size();
+	}
+
+	void ProceduralMeshCache::Clear() {
+		_cache.clear();
+	}
+
+	ProceduralMeshCache::CachedMesh::Sptr ProceduralMeshCache::_Generate(const std::vector<MeshBuilderParam>& params, uint64_t hash, size_t minLodTriangles) {
+		CachedMesh::Sptr result = std::make_shared<CachedMesh>();
+		result->Hash = hash;
+
+		// Try and load the pre-generated mesh from disk, the binary mesh format already stores our LODs
+		std::string diskPath = _GetDiskPath(hash);
+		if (DiskCacheEnabled && fs::exists(diskPath)) {
+			OptimizedObjLoader::LodChain chain = OptimizedObjLoader::LoadLODsFromFile(diskPath);
+			if (!chain.Levels.empty()) {
+				result->LODs = chain.Levels;
+				result->BoundingRadius = chain.BoundingRadius;
+				return result;
+			}
+			LOG_WARN("Failed to load cached mesh \"{}\", regenerating", diskPath);
+		}
+
+		MeshBuilder<VertexPosNormTexColTangents> mesh;
+		for (const auto& param : params) {
+			MeshFactory::AddParameterized(mesh, param);
+		}
+		MeshFactory::CalculateTBN(mesh);
+
+		std::vector<std::vector<uint32_t>> lods = MeshSimplifier::GenerateLODs(mesh, 3, minLodTriangles);
+		result->BoundingRadius = MeshSimplifier::CalculateBoundingRadius(MeshSimplifier::ExtractPositions(mesh));
+
+		if (DiskCacheEnabled) {
+			// Failing to write the cache is not fatal, we'll just generate the mesh again next time
+			try {
+				fs::create_directories(fs::path(diskPath).parent_path());
+				OptimizedObjLoader::SaveBinaryFile(mesh, diskPath, lods);
+			} catch (const std::exception& e) {
+				LOG_WARN("Failed to write mesh cache \"{}\": {}", diskPath, e.what());
+			}
+		}
+
+		result->LODs = mesh.BakeLODs(lods);
+		return result;
+	}
+
+	std::string ProceduralMeshCache::_GetDiskPath(uint64_t hash) {
+		return (fs::path(DiskCachePath) / (HashHelpers::ToHex(hash) + ".bin")).string();
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/MeshFactory.h"
+#include "Utils/Macros.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// A content addressed cache for meshes generated from MeshBuilderParams. Parameter lists are
+	/// hashed, and any resources with identical parameters will share the same VAOs (and GPU buffers)
+	/// instead of generating and uploading their own copy
+	///
+	/// The cache only holds weak references, so geometry is freed once no resources are using it.
+	/// Optionally, generated geometry (including tangents and LODs) can also be written to disk so
+	/// that subsequent runs can skip generation entirely
+	/// </summary>
+	class ProceduralMeshCache {
+	public:
+		/// <summary>
+		/// The baked geometry for a parameter list, shared between all resources with that list
+		/// </summary>
+		struct CachedMesh {
+			MAKE_PTRS(CachedMesh);
+
+			/// <summary>
+			/// The hash of the parameter list that generated this mesh
+			/// </summary>
+			uint64_t                             Hash = 0;
+			/// <summary>
+			/// The VAOs for each level of detail, where element 0 is the full detail mesh
+			/// </summary>
+			std::vector<VertexArrayObject::Sptr> LODs;
+			/// <summary>
+			/// The radius of the sphere around the mesh's origin that contains all vertices
+			/// </summary>
+			float                                BoundingRadius = 0.0f;
+		};
+
+		/// <summary>
+		/// True if generated meshes should be stored in and loaded from DiskCachePath
+		/// </summary>
+		inline static bool        DiskCacheEnabled = false;
+		/// <summary>
+		/// The directory that generated meshes will be cached to when DiskCacheEnabled is set
+		/// </summary>
+		inline static std::string DiskCachePath = "cache/meshes/";
+
+		/// <summary>
+		/// Gets the geometry for a list of mesh builder parameters, generating it if there
+		/// is not already a live copy in the cache
+		/// </summary>
+		/// <param name="params">The parameters to build the mesh from</param>
+		/// <param name="minLodTriangles">Meshes with fewer triangles than this will not have LODs generated</param>
+		/// <returns>The shared geometry, keep a reference to this to keep it in the cache</returns>
+		static CachedMesh::Sptr Get(const std::vector<MeshBuilderParam>& params, size_t minLodTriangles);
+
+		/// <summary>
+		/// Gets the number of meshes that are currently alive in the cache
+		/// </summary>
+		static size_t GetLiveCount();
+
+		/// <summary>
+		/// Drops all entries from the in memory cache, meshes that are in use will remain
+		/// alive, but will no longer be shared with new resources
+		/// </summary>
+		static void Clear();
+
+	protected:
+		ProceduralMeshCache() = default;
+		~ProceduralMeshCache() = default;
+
+		// Bump this whenever mesh generation changes, so that stale disk caches are ignored
+		static const uint32_t GENERATOR_VERSION = 1;
+
+		inline static std::unordered_map<uint64_t, CachedMesh::Wptr> _cache;
+
+		static CachedMesh::Sptr _Generate(const std::vector<MeshBuilderParam>& params, uint64_t hash, size_t minLodTriangles);
+		static std::string _GetDiskPath(uint64_t hash);
+	};
+}
@@ -4,8 +4,12 @@
 #include <locale>
 #include <codecvt>
 
+#include <fstream>
+#include <filesystem>
+
 #include "Utils/FileHelpers.h"
 #include "Utils/GlmBulletConversions.h"
+#include "Utils/VirtualFileSystem.h"
 
 #include "Gameplay/Physics/RigidBody.h"
 #include "Gameplay/Physics/TriggerVolume.h"
@@ -205,10 +209,14 @@ namespace Gameplay {
 	}
 
 	void Scene::DrawPhysicsDebug() {
-		if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
+		DebugDrawer& drawer = DebugDrawer::Get();
+		if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug && drawer.IsCategoryEnabled(DebugDrawCategory::Physics)) {
+			drawer.PushCategory(DebugDrawCategory::Physics);
 			_physicsWorld->debugDrawWorld();
-			DebugDrawer::Get().FlushAll();
+			drawer.PopCategory();
 		}
+		// Also draws anything else that was submitted this frame, and any timed primitives
+		drawer.FlushAll();
 	}
 
 	void Scene::Update(float dt) {
@@ -356,23 +364,125 @@ namespace Gameplay {
 		return blob;
 	}
 
+	Scene::Sptr Scene::FromBinary(BinaryInputArchive& archive)
+	{
+		uint32_t magic = 0, version = 0;
+		archive(magic, version);
+		if (magic != BINARY_MAGIC || version != BINARY_VERSION) {
+			throw std::runtime_error("Not a binary scene, or the scene is from another version");
+		}
+
+		Scene::Sptr result = std::make_shared<Scene>();
+		result->MainCamera = nullptr;
+		result->_objects.clear();
+
+		Guid defaultMaterial, skyboxMesh, skyboxShader, skyboxTexture;
+		glm::vec3 ambient;
+		glm::quat skyboxRotation;
+		archive(defaultMaterial, ambient, skyboxMesh, skyboxShader, skyboxTexture, skyboxRotation);
+		result->DefaultMaterial = ResourceManager::Get<Material>(defaultMaterial);
+		result->SetAmbientLight(ambient);
+		result->_skyboxMesh = ResourceManager::Get<MeshResource>(skyboxMesh);
+		result->SetSkyboxShader(ResourceManager::Get<ShaderProgram>(skyboxShader));
+		result->SetSkyboxTexture(ResourceManager::Get<TextureCube>(skyboxTexture));
+		result->SetSkyboxRotation(glm::mat3_cast(skyboxRotation));
+
+		uint32_t numObjects = 0;
+		archive(numObjects);
+		result->_objects.reserve(numObjects);
+		for (uint32_t ix = 0; ix < numObjects; ix++) {
+			GameObject::Sptr obj = GameObject::FromBinary(result.get(), archive);
+			obj->_scene = result.get();
+			obj->_parent.SceneContext = result.get();
+			obj->_selfRef = obj;
+			result->_objects.push_back(obj);
+		}
+
+		// Re-build the parent hierarchy 
+		for (const auto& object : result->_objects) {
+			if (object->GetParent() != nullptr) {
+				object->GetParent()->AddChild(object);
+			}
+		}
+
+		Guid mainCamera;
+		archive(result->Lights, mainCamera);
+		result->MainCamera = result->_components.GetComponentByGUID<Camera>(mainCamera);
+
+		return result;
+	}
+
+	void Scene::ToBinary(BinaryOutputArchive& archive) const
+	{
+		archive(BINARY_MAGIC, BINARY_VERSION);
+
+		archive(GuidOrNull(DefaultMaterial), GetAmbientLight());
+		archive(GuidOrNull(_skyboxMesh), GuidOrNull(_skyboxShader), GuidOrNull(_skyboxTexture), (glm::quat)_skyboxRotation);
+
+		archive(static_cast<uint32_t>(_objects.size()));
+		for (const auto& object : _objects) {
+			object->ToBinary(archive);
+		}
+
+		archive(Lights, GuidOrNull(MainCamera));
+	}
+
 	void Scene::Save(const std::string& path) {
 		_filePath = path;
 		// Save data to file
-		FileHelpers::WriteContentsToFile(path, ToJson().dump(1, '\t'));
+		if (std::filesystem::path(path).extension() == BINARY_FILE_EXTENSION) {
+			std::ofstream file(path, std::ios::binary);
+			BinaryOutputArchive archive(file);
+			ToBinary(archive);
+		} else {
+			FileHelpers::WriteContentsToFile(path, ToJson().dump(1, '\t'));
+		}
 		LOG_INFO("Saved scene to \"{}\"", path);
 	}
 
 	Scene::Sptr Scene::Load(const std::string& path)
 	{
 		LOG_INFO("Loading scene from \"{}\"", path);
-		std::string content = FileHelpers::ReadFile(path);
-		nlohmann::json blob = nlohmann::json::parse(content);
-		Scene::Sptr result = FromJson(blob);
+		FileView file = VirtualFileSystem::Open(path);
+
+		// Binary scenes start with our magic number, anything else we treat as JSON
+		Scene::Sptr result = nullptr;
+		uint32_t magic = 0;
+		if (file.Size() >= sizeof(uint32_t)) {
+			memcpy(&magic, file.Data(), sizeof(uint32_t));
+		}
+		if (magic == BINARY_MAGIC) {
+			try {
+				FileViewStream stream(file);
+				BinaryInputArchive archive(stream);
+				result = FromBinary(archive);
+			}
+			catch (const std::exception& e) {
+				// Components are pooled per-scene, so anything loaded before the failure was released along with
+				// the partially loaded scene
+				LOG_ERROR("Failed to load binary scene \"{}\": {}", path, e.what());
+				return nullptr;
+			}
+		} else {
+			nlohmann::json blob = nlohmann::json::parse(file.Data(), file.Data() + file.Size());
+			result = FromJson(blob);
+		}
 		result->_filePath = path;
 		return result;
 	}
 
+	std::string Scene::GetManifestPath(const std::string& scenePath) {
+		std::filesystem::path path(scenePath);
+		std::string filename = path.stem().string() + "-manifest" + path.extension().string();
+		std::filesystem::path result = path.parent_path() / filename;
+
+		// Older scenes keep their manifest in the working directory rather than beside the scene file
+		if (!VirtualFileSystem::Exists(result.string()) && VirtualFileSystem::Exists(filename)) {
+			return filename;
+		}
+		return result.string();
+	}
+
 	int Scene::NumObjects() const {
 		return static_cast<int>(_objects.size());
 	}
@@ -416,6 +526,11 @@ namespace Gameplay {
 			if (weakPtr.expired()) continue;
 			auto& it = std::find(_objects.begin(), _objects.end(), weakPtr.lock());
 			if (it != _objects.end()) {
+				// The parent's GUI geometry includes the object, so it needs to be rebuilt
+				GameObject::Sptr parent = (*it)->GetParent();
+				if (parent != nullptr) {
+					parent->MarkGuiDirty();
+				}
 				_objects.erase(it);
 			}
 		}
@@ -450,8 +565,10 @@ namespace Gameplay {
 			glDepthFunc(GL_LEQUAL); 
 
 			_skyboxShader->Bind();
-			_skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
-			_skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation);
+			static constexpr UniformId U_CLIPPED_VIEW = UniformId("u_ClippedView");
+			static constexpr UniformId U_ENVIRONMENT_ROTATION = UniformId("u_EnvironmentRotation");
+			_skyboxShader->SetUniformMatrix(U_CLIPPED_VIEW, MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
+			_skyboxShader->SetUniformMatrix(U_ENVIRONMENT_ROTATION, _skyboxRotation);
 			_skyboxTexture->Bind(0);
 			_skyboxMesh->Mesh->Draw();
 
@@ -41,6 +41,10 @@ namespace Gameplay {
 		static const int MAX_LIGHTS = 8;
 		static const int LIGHT_UBO_BINDING = 2;
 
+		// Identifies binary scene files, and the version of the binary format
+		static constexpr uint32_t BINARY_MAGIC   = MakeFourCC('S', 'C', 'N', 'B');
+		static constexpr uint32_t BINARY_VERSION = 6;
+
 		// Stores all the lights in our scene
 		std::vector<Light>         Lights;
 		// The camera for our scene
@@ -191,21 +195,38 @@ namespace Gameplay {
 		/// Converts this object into it's JSON representation for storage
 		/// </summary>
 		nlohmann::json ToJson() const;
+		/// <summary>
+		/// Loads a scene from a binary archive, throws if the archive is not a valid binary scene
+		/// </summary>
+		static Scene::Sptr FromBinary(BinaryInputArchive& archive);
+		/// <summary>
+		/// Writes this scene to a binary archive. Binary scenes load much faster than JSON, but
+		/// can't be edited by hand
+		/// </summary>
+		void ToBinary(BinaryOutputArchive& archive) const;
 
 		ComponentManager& Components() { return _components; }
 		const ComponentManager& Components() const { return _components; }
 
 		/// <summary>
-		/// Saves this scene to an output JSON file
+		/// Saves this scene to an output file, in the binary format if the path ends with
+		/// BINARY_FILE_EXTENSION, or as JSON otherwise
 		/// </summary>
 		/// <param name="path">The path of the file to write to</param>
 		void Save(const std::string& path);
 		/// <summary>
-		/// Loads a scene from an input JSON file
+		/// Loads a scene from an input JSON or binary file
 		/// </summary>
 		/// <param name="path">The path of the file to read from</param>
-		/// <returns>A new scene loaded from the file</returns>
+		/// <returns>A new scene loaded from the file, or nullptr if a binary scene could not be loaded</returns>
 		static Scene::Sptr Load(const std::string& path);
+		/// <summary>
+		/// Gets the path of the resource manifest that goes with a scene file
+		/// (ex: scenes/scene.json uses scenes/scene-manifest.json). If that file does not exist but
+		/// scene-manifest.json does in the working directory, where older scenes keep it, that is used instead
+		/// </summary>
+		/// <param name="scenePath">The path of the scene file</param>
+		static std::string GetManifestPath(const std::string& scenePath);
 
 
 		int NumObjects() const;
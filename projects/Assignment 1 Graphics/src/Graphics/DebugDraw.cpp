@@ -1,12 +1,26 @@
 #include "Graphics/DebugDraw.h"
+#include <algorithm>
+#include <limits>
+#include "Utils/GlmDefines.h"
+
+namespace {
+	constexpr UniformId U_MVP = UniformId("u_MVP");
+}
 
 DebugDrawer::DebugDrawer() :
 	_colorStack(std::stack<glm::vec3>()),
 	_transformStack(std::stack<glm::mat4>()),
+	_categoryStack(std::stack<DebugDrawCategory>()),
+	_enabledCategories((DebugDrawCategory)0xFFFFFFFFu),
 	_viewProjection(glm::mat4(1.0f)),
-	_lineOffset(0),
-	_triangleOffset(0)
+	_isWorldIdentity(true),
+	_lineBuffer(std::vector<VertexPosCol>()),
+	_triBuffer(std::vector<VertexPosCol>()),
+	_timed(std::vector<TimedPrimitive>())
 {
+	_lineBuffer.reserve(LINE_BATCH_SIZE * 2);
+	_triBuffer.reserve(TRI_BATCH_SIZE * 3);
+
 	_linesVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
 	_linesVBO->LoadData<VertexPosCol>(nullptr, LINE_BATCH_SIZE * 2);
 	_linesVAO = VertexArrayObject::Create();
@@ -19,6 +33,9 @@ DebugDrawer::DebugDrawer() :
 
 	_colorStack.push(glm::vec3(1.0f));
 	_transformStack.push(glm::mat4(1.0f));
+	_categoryStack.push(DebugDrawCategory::General);
+
+	SetViewProjection(glm::mat4(1.0f));
 }
 
 void DebugDrawer::PushColor(const glm::vec3& color) {
@@ -33,15 +50,31 @@ glm::vec3 DebugDrawer::PopColor() {
 }
 
 void DebugDrawer::PushWorldMatrix(const glm::mat4& value) {
-	FlushAll();
 	_transformStack.push(value);
+	_isWorldIdentity = value == glm::mat4(1.0f);
 }
 
 void DebugDrawer::PopWorldMatrix() {
 	LOG_ASSERT(_transformStack.size() > 1, "Attempting to pop more transforms than you are pushing! Check your code!");
-	FlushAll();
 	_transformStack.pop();
+	_isWorldIdentity = _transformStack.top() == glm::mat4(1.0f);
+}
+
+void DebugDrawer::PushCategory(DebugDrawCategory category) {
+	_categoryStack.push(category);
+}
 
+void DebugDrawer::PopCategory() {
+	LOG_ASSERT(_categoryStack.size() > 1, "Attempting to pop more categories than you are pushing! Check your code!");
+	_categoryStack.pop();
+}
+
+void DebugDrawer::SetCategoryEnabled(DebugDrawCategory category, bool enabled) {
+	_enabledCategories = enabled ? (_enabledCategories | category) : (_enabledCategories & ~*category);
+}
+
+bool DebugDrawer::IsCategoryEnabled(DebugDrawCategory category) const {
+	return *(_enabledCategories & category) != 0;
 }
 
 void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2) {
@@ -54,34 +87,22 @@ void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::
 
 void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& color1, const glm::vec3& color2)
 {
-	_lineBuffer[_lineOffset + 0].Color = glm::vec4(color1, 1.0f);
-	_lineBuffer[_lineOffset + 0].Position = p1;
-	_lineBuffer[_lineOffset + 1].Color = glm::vec4(color2, 1.0f);
-	_lineBuffer[_lineOffset + 1].Position = p2;
-
-	_lineOffset += 2;
-	if (_lineOffset >= LINE_BATCH_SIZE) {
-		FlushLines();
+	if (!IsCategoryEnabled(_categoryStack.top())) {
+		return;
+	}
+
+	VertexPosCol verts[2] = {
+		VertexPosCol(_ToWorld(p1), glm::vec4(color1, 1.0f)),
+		VertexPosCol(_ToWorld(p2), glm::vec4(color2, 1.0f))
+	};
+	if (!_IsCulled(verts, 2)) {
+		_lineBuffer.insert(_lineBuffer.end(), verts, verts + 2);
 	}
 }
 
 void DebugDrawer::FlushLines()
 {
-	if (_lineOffset > 0) {
-		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_linesVBO->LoadData<VertexPosCol>(_lineBuffer, LINE_BATCH_SIZE * 2);
-		_linesVAO->Bind();
-		_linesVAO->Draw(DrawMode::LineList);
-		_linesVAO->Unbind();
-		_lineOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
-	}
+	_FlushStream(_lineBuffer, _linesVBO, _linesVAO, DrawMode::LineList);
 }
 
 void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3) {
@@ -95,40 +116,91 @@ void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::v
 
 void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& c3)
 {
-	_triBuffer[_triangleOffset + 0].Color = glm::vec4(c1, 1.0f);
-	_triBuffer[_triangleOffset + 0].Position = p1;
-	_triBuffer[_triangleOffset + 1].Color = glm::vec4(c2, 1.0f);
-	_triBuffer[_triangleOffset + 1].Position = p2;
-	_triBuffer[_triangleOffset + 2].Color = glm::vec4(c3, 1.0f);
-	_triBuffer[_triangleOffset + 2].Position = p3;
-
-	_triangleOffset += 3;
-	if (_triangleOffset >= TRI_BATCH_SIZE) {
-		FlushTris();
+	if (!IsCategoryEnabled(_categoryStack.top())) {
+		return;
+	}
+
+	VertexPosCol verts[3] = {
+		VertexPosCol(_ToWorld(p1), glm::vec4(c1, 1.0f)),
+		VertexPosCol(_ToWorld(p2), glm::vec4(c2, 1.0f)),
+		VertexPosCol(_ToWorld(p3), glm::vec4(c3, 1.0f))
+	};
+	if (!_IsCulled(verts, 3)) {
+		_triBuffer.insert(_triBuffer.end(), verts, verts + 3);
 	}
 }
 
 void DebugDrawer::FlushTris()
 {
-	if (_triangleOffset > 0) {
-		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_trisVBO->LoadData<VertexPosCol>(_triBuffer, TRI_BATCH_SIZE * 3);
-		_trisVAO->Bind();
-		_trisVAO->Draw(DrawMode::LineList);
-		_trisVAO->Unbind();
-		_triangleOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
+	_FlushStream(_triBuffer, _trisVBO, _trisVAO, DrawMode::TriangleList);
+}
+
+void DebugDrawer::AddLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& color, float duration) {
+	TimedPrimitive prim = TimedPrimitive();
+	prim.Verts[0] = VertexPosCol(_ToWorld(p1), glm::vec4(color, 1.0f));
+	prim.Verts[1] = VertexPosCol(_ToWorld(p2), glm::vec4(color, 1.0f));
+	prim.VertexCount = 2;
+	prim.Remaining = duration < 0.0f ? std::numeric_limits<float>::infinity() : duration;
+	prim.Category = _categoryStack.top();
+	prim.WasDrawn = false;
+	_timed.push_back(prim);
+}
+
+void DebugDrawer::AddTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& color, float duration) {
+	TimedPrimitive prim = TimedPrimitive();
+	prim.Verts[0] = VertexPosCol(_ToWorld(p1), glm::vec4(color, 1.0f));
+	prim.Verts[1] = VertexPosCol(_ToWorld(p2), glm::vec4(color, 1.0f));
+	prim.Verts[2] = VertexPosCol(_ToWorld(p3), glm::vec4(color, 1.0f));
+	prim.VertexCount = 3;
+	prim.Remaining = duration < 0.0f ? std::numeric_limits<float>::infinity() : duration;
+	prim.Category = _categoryStack.top();
+	prim.WasDrawn = false;
+	_timed.push_back(prim);
+}
+
+void DebugDrawer::AddBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& color, float duration) {
+	glm::vec3 corners[8];
+	for (int ix = 0; ix < 8; ix++) {
+		corners[ix] = glm::vec3(ix & 1 ? max.x : min.x, ix & 2 ? max.y : min.y, ix & 4 ? max.z : min.z);
+	}
+	// Each edge connects two corners that differ in a single axis
+	for (int ix = 0; ix < 8; ix++) {
+		for (int axis = 1; axis < 8; axis <<= 1) {
+			if ((ix & axis) == 0) {
+				AddLine(corners[ix], corners[ix | axis], color, duration);
+			}
 		}
 	}
 }
 
+void DebugDrawer::ClearTimed() {
+	_timed.clear();
+}
+
+void DebugDrawer::Update(float dt) {
+	for (auto& prim : _timed) {
+		prim.Remaining -= dt;
+	}
+	// Primitives always get drawn at least once, even if they expire before the next flush
+	_timed.erase(std::remove_if(_timed.begin(), _timed.end(), [](const TimedPrimitive& prim) {
+		return prim.WasDrawn && prim.Remaining <= 0.0f;
+	}), _timed.end());
+}
+
 void DebugDrawer::FlushAll()
 {
+	// Timed primitives are already in world space, so they can go straight into the streams
+	for (auto& prim : _timed) {
+		if (!IsCategoryEnabled(prim.Category)) {
+			continue;
+		}
+		prim.WasDrawn = true;
+		if (!_IsCulled(prim.Verts, prim.VertexCount)) {
+			std::vector<VertexPosCol>& stream = prim.VertexCount == 2 ? _lineBuffer : _triBuffer;
+			stream.insert(stream.end(), prim.Verts, prim.Verts + prim.VertexCount);
+		}
+	}
+
 	FlushLines();
 	FlushTris();
 }
@@ -136,6 +208,52 @@ void DebugDrawer::FlushAll()
 void DebugDrawer::SetViewProjection(const glm::mat4& viewProjection)
 {
 	_viewProjection = viewProjection;
+
+	// We only need the sign of the distance, so the planes don't need to be normalized
+	ExtractFrustumPlanes(viewProjection, _frustumPlanes);
+}
+
+glm::vec3 DebugDrawer::_ToWorld(const glm::vec3& point) const {
+	return _isWorldIdentity ? point : glm::vec3(_transformStack.top() * glm::vec4(point, 1.0f));
+}
+
+bool DebugDrawer::_IsCulled(const VertexPosCol* verts, uint32_t count) const {
+	if (!EnableCulling) {
+		return false;
+	}
+	for (const glm::vec4& plane : _frustumPlanes) {
+		bool allOutside = true;
+		for (uint32_t ix = 0; ix < count && allOutside; ix++) {
+			allOutside = glm::dot(glm::vec3(plane), verts[ix].Position) + plane.w < 0.0f;
+		}
+		if (allOutside) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void DebugDrawer::_FlushStream(std::vector<VertexPosCol>& stream, const VertexBuffer::Sptr& vbo, const VertexArrayObject::Sptr& vao, DrawMode mode) {
+	if (stream.empty()) {
+		return;
+	}
+
+	// Grow the buffer geometrically, so large scenes only reallocate a handful of times
+	uint32_t count = (uint32_t)stream.size();
+	if (count * sizeof(VertexPosCol) > vbo->GetTotalSize()) {
+		vbo->LoadData<VertexPosCol>(nullptr, glm::max(count, vbo->GetTotalSize() / (uint32_t)sizeof(VertexPosCol) * 2));
+	}
+	// Only upload the range that was written
+	vbo->UpdateData(stream.data(), sizeof(VertexPosCol), count, false);
+
+	// Everything is already in world space
+	__Shader->Bind();
+	__Shader->SetUniformMatrix(U_MVP, _viewProjection);
+	vao->Bind();
+	glDrawArrays((GLenum)mode, 0, count);
+	VertexArrayObject::Unbind();
+
+	stream.clear();
 }
 
 DebugDrawer& DebugDrawer::Get() {
@@ -179,4 +297,4 @@ void DebugDrawer::Uninitialize()
 		__Instance = nullptr;
 		__Shader = nullptr;
 	}
-}
\ No newline at end of file
+}
@@ -1,21 +1,40 @@
 #pragma once
 #include <GLM/glm.hpp>
 #include <stack>
+#include <vector>
+#include <EnumToString.h>
 #include "Graphics/VertexTypes.h"
 #include "Graphics/ShaderProgram.h"
 
+/// <summary>
+/// Groups of debug primitives that can be toggled on and off together
+/// </summary>
+ENUM_FLAGS(DebugDrawCategory, uint32_t,
+	None     = 0,
+	General  = 1, //(1 << 0)
+	Physics  = 2, //(1 << 1)
+	Lighting = 4, //(1 << 2)
+	Gameplay = 8  //(1 << 3)
+);
+
 /// <summary>
 /// Utility class for drawing lines and triangles in an immediate mode style
-/// 
+///
 /// Includes a stack for transformations and color, to ease implementation of complex
-/// debuggers
+/// debuggers. Primitives are transformed into world space as they are submitted, so changing
+/// the transform does not need to flush. Primitives can also be added with a lifetime, in which
+/// case they are drawn every frame until they expire (see Update)
 /// </summary>
 class DebugDrawer
 {
 public:
+	// The number of primitives to allocate space for up front, the buffers will grow past this as needed
 	inline static const size_t LINE_BATCH_SIZE = 8192;
 	inline static const size_t TRI_BATCH_SIZE = 4096;
 
+	// If true, primitives that are entirely outside of the camera's frustum are skipped
+	inline static bool EnableCulling = true;
+
 	// Delete copy and mode
 
 	DebugDrawer(const DebugDrawer& other) = delete;
@@ -47,15 +66,38 @@ public:
 	glm::vec3 PopColor();
 
 	/// <summary>
-	/// Pushes a new transform to the stack, replacing the existing value and flushing all lines and tris
+	/// Pushes a new transform to the stack, replacing the existing value. Primitives are transformed
+	/// when they are drawn, so this does not need to flush
 	/// </summary>
 	/// <param name="world">The new world transform to use for drawing</param>
 	void PushWorldMatrix(const glm::mat4& world);
 	/// <summary>
-	/// Pops a transform from the stack, replacing the existing value and flushing all lines and tris
+	/// Pops a transform from the stack, replacing the existing value
 	/// </summary>
 	void PopWorldMatrix();
 
+	/// <summary>
+	/// Pushes a category to the stack, primitives drawn after this belong to that category and will be
+	/// skipped if it is disabled
+	/// </summary>
+	/// <param name="category">The category for primitives drawn until the matching PopCategory</param>
+	void PushCategory(DebugDrawCategory category);
+	/// <summary>
+	/// Pops a category from the stack, restoring the previous category
+	/// </summary>
+	void PopCategory();
+	/// <summary>
+	/// Enables or disables drawing of all primitives in a category
+	/// </summary>
+	/// <param name="category">The category to toggle</param>
+	/// <param name="enabled">True if primitives in the category should be drawn</param>
+	void SetCategoryEnabled(DebugDrawCategory category, bool enabled);
+	/// <summary>
+	/// Checks whether primitives in a category will be drawn, can be used to skip generating debug
+	/// geometry altogether
+	/// </summary>
+	bool IsCategoryEnabled(DebugDrawCategory category) const;
+
 	/// <summary>
 	/// Draws a line between 2 points using the current debug color
 	/// </summary>
@@ -116,27 +158,81 @@ public:
 	void FlushTris();
 
 	/// <summary>
-	/// Flushes any remaining triangles and lines, drawing them to the screen and resetting their counters
+	/// Adds a line that will be drawn every frame for a given amount of time, using the current
+	/// transform and category
+	/// </summary>
+	/// <param name="p1">The first point</param>
+	/// <param name="p2">The second point</param>
+	/// <param name="color">Color for line</param>
+	/// <param name="duration">The number of seconds to draw the line for, 0 to draw for a single frame, or negative to draw until ClearTimed is called</param>
+	void AddLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& color, float duration);
+	/// <summary>
+	/// Adds a triangle that will be drawn every frame for a given amount of time, using the current
+	/// transform and category
+	/// </summary>
+	/// <param name="p1">The first point</param>
+	/// <param name="p2">The second point</param>
+	/// <param name="p3">The third point</param>
+	/// <param name="color">Color for triangle</param>
+	/// <param name="duration">The number of seconds to draw the triangle for, see AddLine</param>
+	void AddTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& color, float duration);
+	/// <summary>
+	/// Adds the outline of an axis aligned box that will be drawn every frame for a given amount of time,
+	/// using the current transform and category
+	/// </summary>
+	/// <param name="min">The minimum corner of the box</param>
+	/// <param name="max">The maximum corner of the box</param>
+	/// <param name="color">Color for the box</param>
+	/// <param name="duration">The number of seconds to draw the box for, see AddLine</param>
+	void AddBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& color, float duration);
+	/// <summary>
+	/// Removes all primitives that were added with a lifetime
+	/// </summary>
+	void ClearTimed();
+	/// <summary>
+	/// Counts down the lifetimes of primitives added with AddLine, AddTri or AddBox, and removes the
+	/// ones that have expired and been drawn at least once
+	/// </summary>
+	/// <param name="dt">The time since the last update, in seconds</param>
+	void Update(float dt);
+
+	/// <summary>
+	/// Flushes any remaining triangles and lines, along with all timed primitives, drawing them to the
+	/// screen and resetting their counters
 	/// </summary>
 	void FlushAll();
 
 	/// <summary>
-	/// Set the view projection matrix used by this debug drawer
+	/// Set the view projection matrix used by this debug drawer, primitives are culled against this
+	/// as they are submitted
 	/// </summary>
 	void SetViewProjection(const glm::mat4& viewProjection);
 
 protected:
 	DebugDrawer();
 
+	// A primitive that is drawn every frame until it expires, stored in world space
+	struct TimedPrimitive {
+		VertexPosCol      Verts[3];
+		uint32_t          VertexCount;
+		float             Remaining;
+		DebugDrawCategory Category;
+		bool              WasDrawn;
+	};
+
 	std::stack<glm::vec3> _colorStack;
 	std::stack<glm::mat4> _transformStack;
+	std::stack<DebugDrawCategory> _categoryStack;
+	DebugDrawCategory _enabledCategories;
 	glm::mat4    _viewProjection;
-	glm::mat4    _worldMatrix;
+	// The planes of the view frustum, as (normal, distance) with normals pointing inwards
+	glm::vec4    _frustumPlanes[6];
+	// True if the top of the transform stack is the identity, so we can skip transforming points
+	bool         _isWorldIdentity;
 
-	size_t       _lineOffset;
-	VertexPosCol _lineBuffer[LINE_BATCH_SIZE * 2];
-	size_t       _triangleOffset;
-	VertexPosCol _triBuffer[TRI_BATCH_SIZE * 3];
+	std::vector<VertexPosCol> _lineBuffer;
+	std::vector<VertexPosCol> _triBuffer;
+	std::vector<TimedPrimitive> _timed;
 
 	VertexBuffer::Sptr _linesVBO;
 	VertexArrayObject::Sptr _linesVAO;
@@ -145,4 +241,17 @@ protected:
 
 	inline static DebugDrawer* __Instance = nullptr;
 	inline static ShaderProgram::Sptr __Shader = nullptr;
-};
\ No newline at end of file
+
+	/// <summary>
+	/// Transforms a point by the current world matrix
+	/// </summary>
+	glm::vec3 _ToWorld(const glm::vec3& point) const;
+	/// <summary>
+	/// Returns true if all the given world space points are outside of the same frustum plane
+	/// </summary>
+	bool _IsCulled(const VertexPosCol* verts, uint32_t count) const;
+	/// <summary>
+	/// Uploads the written range of a stream and draws it
+	/// </summary>
+	void _FlushStream(std::vector<VertexPosCol>& stream, const VertexBuffer::Sptr& vbo, const VertexArrayObject::Sptr& vao, DrawMode mode);
+};
@@ -11,6 +11,9 @@
 #define OVERSAMPLE_X 1
 #define OVERSAMPLE_Y 1
 #define PADDING 1
+// Distance fields extend this many pixels past the edge of each glyph, and store the edge at half intensity
+#define SDF_PADDING 4
+#define SDF_ON_EDGE 128
 
 Font::Font() : Font("", 0.0f) { }
 
@@ -19,6 +22,7 @@ Font::Font(const std::string& fontPath, float size) :
 	_fontPath(fontPath),
 	_fontSize(size),
 	_glyphs(nullptr),
+	_glyphCount(0),
 	_atlas(nullptr),
 	_ascent(0),
 	_descent(0),
@@ -28,7 +32,11 @@ Font::Font(const std::string& fontPath, float size) :
 	_fontInfo(stbtt_fontinfo()),
 	_defaultGlyph(GlyphInfo()),
 	_atlasWidth(256),
-	_atlasHeight(256)
+	_atlasHeight(256),
+	_isDynamic(false),
+	_isDistanceField(false),
+	_dynamicPacker(stbrp_context()),
+	_hasWarnedFull(false)
 {
 	// For the box character
 	_glyphRanges.push_back({ 0xE000u, 0xE000u });
@@ -58,6 +66,7 @@ void Font::Load(const std::string& fontPath, float size /*= 16.0f*/)
 		if (_glyphs != nullptr) {
 			delete[] _glyphs;
 			_glyphs = nullptr;
+			_glyphCount = 0;
 		}
 		_atlas = nullptr;
 
@@ -83,10 +92,40 @@ void Font::AddGlyphRange(uint32_t min, uint32_t max) {
 	_glyphRanges.push_back({ min, max });
 }
 
+void Font::SetDynamic(bool value) {
+	LOG_ASSERT(_atlas == nullptr, "Cannot change a font to dynamic after it has been baked!");
+	_isDynamic = value;
+}
+
+bool Font::IsDynamic() const {
+	return _isDynamic;
+}
+
+void Font::SetDistanceField(bool value) {
+	LOG_ASSERT(_atlas == nullptr, "Cannot change a font to a distance field after it has been baked!");
+	_isDistanceField = value;
+}
+
+bool Font::IsDistanceField() const {
+	return _isDistanceField;
+}
+
 void Font::Bake() {
 	LOG_ASSERT(_atlas == nullptr, "Bake has already been called!");
 	LOG_ASSERT(_fontInfo.data != nullptr, "Have not loaded a font asset!");
 
+	_latinGlyphLoaded.reset();
+	_glyphMap.clear();
+
+	// Kerning doesn't depend on the atlas, so we can build it for both static and dynamic fonts
+	__BuildKerningTable();
+
+	// stb_truetype can only pack coverage, so distance fields are generated one glyph at a time like dynamic fonts
+	if (_isDynamic || _isDistanceField) {
+		__BakeIncremental();
+		return;
+	}
+
 	uint8_t* rawFontData = reinterpret_cast<uint8_t*>(_fontData.data());
 
 	// Collect all codepoint ranges into a set, so we have a list of unique codepoints
@@ -104,6 +143,7 @@ void Font::Bake() {
 
 	// Allocate our glyph data for the number of unicode character's we're supporting
 	_glyphs = new stbtt_packedchar[numCodepoints];
+	_glyphCount = numCodepoints;
 	memset(_glyphs, 0, sizeof(stbtt_packedchar) * numCodepoints);
 
 	// Collect unicode ranges, may differ from input ranges!
@@ -192,11 +232,160 @@ void Font::Bake() {
 
 	uint32_t index = 0;
 	for (uint32_t codepoint : codePoints) {
-		_glyphMap[codepoint] = __CreateGlyph(index);
+		GlyphInfo glyph = __CreateGlyph(index);
+		__StoreGlyph(codepoint, glyph);
 		index++;
 
 		if (codepoint == 0xE000u)
-			_defaultGlyph = _glyphMap[codepoint];
+			_defaultGlyph = glyph;
+	}
+
+	// Characters that weren't baked fall back to the default glyph, so the lookup never has to search
+	for (uint32_t ix = 0; ix < LATIN_GLYPH_COUNT; ix++) {
+		if (!_latinGlyphLoaded[ix]) {
+			__StoreGlyph(ix, _defaultGlyph);
+		}
+	}
+}
+
+void Font::__BakeIncremental() {
+	_atlasWidth = DynamicAtlasSize;
+	_atlasHeight = DynamicAtlasSize;
+
+	// We don't want mips, since they would need to be regenerated every time we add a glyph
+	Texture2DDescription desc;
+	desc.Width = _atlasWidth;
+	desc.Height = _atlasHeight;
+	desc.Format = InternalFormat::R8;
+	desc.GenerateMipMaps = false;
+	desc.MinificationFilter = MinFilter::Linear;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	_atlas = std::make_shared<Texture2D>(desc);
+	_atlas->Clear(glm::vec4(0.0f));
+
+	_dynamicNodes.resize(_atlasWidth);
+	stbrp_init_target(&_dynamicPacker, _atlasWidth, _atlasHeight, _dynamicNodes.data(), static_cast<int>(_dynamicNodes.size()));
+	_hasWarnedFull = false;
+
+	// The box character is used for any characters the font doesn't have, so we always need it
+	_defaultGlyph = __RasterizeGlyph(0xE000u);
+	__StoreGlyph(0xE000u, _defaultGlyph);
+
+	// Fonts that aren't dynamic still need all their glyph ranges up front
+	if (!_isDynamic) {
+		for (const auto& range : _glyphRanges) {
+			for (uint32_t codepoint = range.x; codepoint <= range.y; codepoint++) {
+				if (codepoint < LATIN_GLYPH_COUNT ? !_latinGlyphLoaded[codepoint] : _glyphMap.count(codepoint) == 0) {
+					__StoreGlyph(codepoint, __RasterizeGlyph(codepoint));
+				}
+			}
+		}
+		for (uint32_t ix = 0; ix < LATIN_GLYPH_COUNT; ix++) {
+			if (!_latinGlyphLoaded[ix]) {
+				__StoreGlyph(ix, _defaultGlyph);
+			}
+		}
+	}
+}
+
+GlyphInfo Font::__RasterizeGlyph(uint32_t codePoint) {
+	int glyphIndex = stbtt_FindGlyphIndex(&_fontInfo, codePoint);
+	if (glyphIndex == 0) {
+		return _defaultGlyph;
+	}
+
+	int advance, leftBearing;
+	stbtt_GetGlyphHMetrics(&_fontInfo, glyphIndex, &advance, &leftBearing);
+	// Distance fields are generated by stb_truetype, so we only know their size after they've been generated
+	int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	uint8_t* sdf = nullptr;
+	if (_isDistanceField) {
+		sdf = stbtt_GetGlyphSDF(&_fontInfo, _pixelHeightScale, glyphIndex, SDF_PADDING, SDF_ON_EDGE, SDF_ON_EDGE / (float)SDF_PADDING, &x1, &y1, &x0, &y0);
+		x1 += x0;
+		y1 += y0;
+	} else {
+		stbtt_GetGlyphBitmapBox(&_fontInfo, glyphIndex, _pixelHeightScale, _pixelHeightScale, &x0, &y0, &x1, &y1);
+	}
+	int width = x1 - x0;
+	int height = y1 - y0;
+
+	GlyphInfo info = GlyphInfo();
+	info.OffsetX = advance * _pixelHeightScale;
+	info.OffsetY = 0.0f;
+	info.IsPacked = true;
+
+	// Whitespace has no image, it only moves the pen
+	if (sdf == nullptr && (width <= 0 || height <= 0)) {
+		return info;
+	}
+
+	stbrp_rect rect = stbrp_rect();
+	rect.w = width + PADDING;
+	rect.h = height + PADDING;
+	if (!stbrp_pack_rects(&_dynamicPacker, &rect, 1) || !rect.was_packed) {
+		if (!_hasWarnedFull) {
+			LOG_WARN("Font atlas for {} is full, missing glyphs will be drawn with the default glyph", _fontPath);
+			_hasWarnedFull = true;
+		}
+		stbtt_FreeSDF(sdf, nullptr);
+		return _defaultGlyph;
+	}
+
+	// Rasterize just this glyph and upload it into the free space we found
+	if (sdf != nullptr) {
+		_atlas->LoadData(width, height, PixelFormat::Red, PixelType::UByte, sdf, rect.x, rect.y);
+		stbtt_FreeSDF(sdf, nullptr);
+	} else {
+		std::vector<uint8_t> bitmap(width * (size_t)height);
+		stbtt_MakeGlyphBitmap(&_fontInfo, bitmap.data(), width, height, width, _pixelHeightScale, _pixelHeightScale, glyphIndex);
+		_atlas->LoadData(width, height, PixelFormat::Red, PixelType::UByte, bitmap.data(), rect.x, rect.y);
+	}
+
+	// Same layout as __CreateGlyph, y is down in the atlas and in text space
+	float s0 = rect.x / (float)_atlasWidth;
+	float t0 = rect.y / (float)_atlasHeight;
+	float s1 = (rect.x + width) / (float)_atlasWidth;
+	float t1 = (rect.y + height) / (float)_atlasHeight;
+	info.Positions[0] = { (float)x1, (float)y1 };
+	info.Positions[1] = { (float)x1, (float)y0 };
+	info.Positions[2] = { (float)x0, (float)y0 };
+	info.Positions[3] = { (float)x0, (float)y1 };
+	info.UVs[0]       = { s1, t1 };
+	info.UVs[1]       = { s1, t0 };
+	info.UVs[2]       = { s0, t0 };
+	info.UVs[3]       = { s0, t1 };
+
+	return info;
+}
+
+void Font::__StoreGlyph(uint32_t codePoint, const GlyphInfo& glyph) {
+	if (codePoint < LATIN_GLYPH_COUNT) {
+		_latinGlyphs[codePoint] = glyph;
+		_latinGlyphLoaded[codePoint] = true;
+	} else {
+		_glyphMap[codePoint] = glyph;
+	}
+}
+
+void Font::__BuildKerningTable() {
+	_kerningTable.assign(KERNING_TABLE_SIZE * KERNING_TABLE_SIZE, 0.0f);
+	_kerningCache.clear();
+
+	// Only printable characters can have kerning, we look up glyph indices once instead of once per pair
+	int glyphIndices[KERNING_TABLE_SIZE] = { 0 };
+	for (uint32_t ix = ' '; ix < KERNING_TABLE_SIZE; ix++) {
+		glyphIndices[ix] = stbtt_FindGlyphIndex(&_fontInfo, ix);
+	}
+	for (uint32_t left = ' '; left < KERNING_TABLE_SIZE; left++) {
+		if (glyphIndices[left] == 0) {
+			continue;
+		}
+		for (uint32_t right = ' '; right < KERNING_TABLE_SIZE; right++) {
+			if (glyphIndices[right] != 0) {
+				_kerningTable[left * KERNING_TABLE_SIZE + right] = stbtt_GetGlyphKernAdvance(&_fontInfo, glyphIndices[left], glyphIndices[right]) * _pixelHeightScale;
+			}
+		}
 	}
 }
 
@@ -204,10 +393,21 @@ const Texture2D::Sptr& Font::GetAtlas() {
 	return _atlas;
 }
 
-GlyphInfo Font::GetGlyph(uint32_t codePoint, float offsetX, float offsetY) const {
-	// Try and get glyph info from the codepoint, otherwise grab the default glyph
-	auto it = _glyphMap.find(codePoint);		
-	GlyphInfo result = it == _glyphMap.end() ? _defaultGlyph : it->second;
+GlyphInfo Font::GetGlyph(uint32_t codePoint, float offsetX, float offsetY) {
+	// ASCII and Latin-1 are looked up directly, everything else goes through the hash map
+	GlyphInfo result;
+	auto it = codePoint < LATIN_GLYPH_COUNT ? _glyphMap.end() : _glyphMap.find(codePoint);
+	if (codePoint < LATIN_GLYPH_COUNT && _latinGlyphLoaded[codePoint]) {
+		result = _latinGlyphs[codePoint];
+	} else if (it != _glyphMap.end()) {
+		result = it->second;
+	} else if (_isDynamic && _atlas != nullptr) {
+		// Rasterize the glyph the first time it's used, missing glyphs get stored as the default so we only try once
+		result = __RasterizeGlyph(codePoint);
+		__StoreGlyph(codePoint, result);
+	} else {
+		result = _defaultGlyph;
+	}
 
 	result.OffsetX += offsetX;
 	result.OffsetY += offsetY;
@@ -215,8 +415,19 @@ GlyphInfo Font::GetGlyph(uint32_t codePoint, float offsetX, float offsetY) const
 	return result;
 }
 
-float Font::GetKerning(int char1, int char2) const {
-	return stbtt_GetCodepointKernAdvance(&_fontInfo, char1, char2) * _pixelHeightScale;
+float Font::GetKerning(int char1, int char2) {
+	if ((uint32_t)char1 < KERNING_TABLE_SIZE && (uint32_t)char2 < KERNING_TABLE_SIZE && !_kerningTable.empty()) {
+		return _kerningTable[char1 * KERNING_TABLE_SIZE + char2];
+	}
+
+	uint64_t key = ((uint64_t)(uint32_t)char1 << 32) | (uint32_t)char2;
+	auto it = _kerningCache.find(key);
+	if (it != _kerningCache.end()) {
+		return it->second;
+	}
+	float kerning = stbtt_GetCodepointKernAdvance(&_fontInfo, char1, char2) * _pixelHeightScale;
+	_kerningCache[key] = kerning;
+	return kerning;
 }
 
 float Font::GetLineHeight() const {
@@ -299,7 +510,9 @@ nlohmann::json Font::ToJson() const
 {
 	nlohmann::json blob = {
 		{ "filename", _fontPath },
-		{ "font_size", _fontSize }
+		{ "font_size", _fontSize },
+		{ "dynamic", _isDynamic },
+		{ "sdf", _isDistanceField }
 	};
 
 	nlohmann::json ranges = std::vector<nlohmann::json>();
@@ -317,6 +530,8 @@ Font::Sptr Font::FromJson(const nlohmann::json& data) {
 	std::string path = JsonGet<std::string>(data, "filename", "");
 	float size = JsonGet(data, "font_size", 16.0f);
 	result->Load(path, size);
+	result->SetDynamic(JsonGet(data, "dynamic", false));
+	result->SetDistanceField(JsonGet(data, "sdf", false));
 		
 	// Iterate over the ranges and add them to the font
 	if (data.contains("ranges") && data["ranges"].is_array()) {
@@ -330,3 +545,18 @@ Font::Sptr Font::FromJson(const nlohmann::json& data) {
 	result->Bake();
 	return result;
 }
+
+size_t Font::GetCpuMemoryUsage() const {
+	// Hash maps are estimated as one node per entry plus their bucket array
+	auto mapSize = [](const auto& map) {
+		return map.size() * (sizeof(typename std::decay_t<decltype(map)>::value_type) + sizeof(void*) * 2) + map.bucket_count() * sizeof(void*);
+	};
+
+	size_t result = _fontData.capacity() + _fontPath.capacity();
+	result += _glyphCount * sizeof(stbtt_packedchar);
+	result += _glyphRanges.capacity() * sizeof(glm::uvec2);
+	result += _kerningTable.capacity() * sizeof(float);
+	result += _dynamicNodes.capacity() * sizeof(stbrp_node);
+	result += mapSize(_glyphMap) + mapSize(_kerningCache);
+	return result;
+}
@@ -3,6 +3,10 @@
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/Textures/Texture2D.h"
 
+#include <bitset>
+#include <unordered_map>
+// stb_truetype uses the real rect packer if it's included first
+#include <stb_rect_pack.h>
 #include <stb_truetype.h>
 
 	struct GlyphInfo {
@@ -21,6 +25,8 @@
 		typedef std::shared_ptr<Font> Sptr;
 		typedef std::weak_ptr<Font> Wptr;
 
+		// The width and height of the atlas used by dynamic and distance field fonts
+		inline static uint32_t DynamicAtlasSize = 1024;
 
 		Font();
 		Font(const std::string& fontPath, float size = 16.0f);
@@ -43,6 +49,30 @@
 		/// <param name="max">The maximum unicode character (inclusive)</param>
 		void AddGlyphRange(uint32_t min, uint32_t max);
 
+		/// <summary>
+		/// Sets whether this font rasterizes glyphs into it's atlas the first time they are used, instead of
+		/// packing every glyph range when the font is baked. Dynamic fonts start faster and can render any
+		/// character in the font (ex: CJK text), at the cost of a small upload whenever a new glyph is used.
+		/// Glyph ranges are ignored for dynamic fonts. Must be set before the font is baked
+		/// </summary>
+		void SetDynamic(bool value);
+		/// <summary>
+		/// Gets whether this font rasterizes glyphs on demand, see SetDynamic
+		/// </summary>
+		bool IsDynamic() const;
+
+		/// <summary>
+		/// Sets whether this font's atlas stores signed distance fields instead of coverage. A distance field
+		/// atlas stays sharp when text is scaled up or down, so one font can be used for any text scale. The
+		/// font size should be large enough to keep details in the glyphs (ex: 32). Must be set before the font
+		/// is baked
+		/// </summary>
+		void SetDistanceField(bool value);
+		/// <summary>
+		/// Gets whether this font's atlas stores signed distance fields, see SetDistanceField
+		/// </summary>
+		bool IsDistanceField() const;
+
 		/// <summary>
 		/// Generates the texture to use when rendering with this font, must be called
 		/// before the font is used
@@ -55,19 +85,22 @@
 
 		/// <summary>
 		/// Extracts information about a glyph with the given codepoint, positioning
-		/// it at the offset provided
+		/// it at the offset provided. For dynamic fonts, this will rasterize the glyph
+		/// into the atlas if it has not been used before
 		/// </summary>
 		/// <param name="codePoint">The unicode codepoint to attempt to lookup</param>
 		/// <param name="offsetX">The x position of the glyph</param>
 		/// <param name="offsetY">The y position of the glyph</param>
-		GlyphInfo GetGlyph(uint32_t codePoint, float offsetX, float offsetY) const;
+		GlyphInfo GetGlyph(uint32_t codePoint, float offsetX, float offsetY);
 		/// <summary>
-		/// Gets the kerning (horizontal space) between 2 unicode characters
+		/// Gets the kerning (horizontal space) between 2 unicode characters. Pairs of
+		/// ASCII characters are looked up from a table built when the font is baked,
+		/// other pairs are cached the first time they are requested
 		/// </summary>
 		/// <param name="char1">The left character</param>
 		/// <param name="char2">The right character</param>
 		/// <returns>The space between characters</returns>
-		float  GetKerning(int char1, int char2) const;
+		float  GetKerning(int char1, int char2);
 		/// <summary>
 		/// Returns the vertical height of a line of text for this font
 		/// </summary>
@@ -91,11 +124,25 @@
 
 		virtual nlohmann::json ToJson() const override;
 		static Font::Sptr FromJson(const nlohmann::json& data);
+		/// <summary>
+		/// Gets the size of the font file and the glyph and kerning tables we keep around for layout
+		/// </summary>
+		virtual size_t GetCpuMemoryUsage() const override;
 
 	protected:
+		// Glyphs for codepoints below this are stored in a table indexed by codepoint
+		static constexpr uint32_t LATIN_GLYPH_COUNT = 256;
+		// Kerning for pairs of codepoints below this is stored in a table indexed by both codepoints
+		static constexpr uint32_t KERNING_TABLE_SIZE = 128;
+
 		std::vector<glm::uvec2> _glyphRanges;
-		std::map<uint32_t, GlyphInfo> _glyphMap;
+		GlyphInfo                     _latinGlyphs[LATIN_GLYPH_COUNT];
+		// Tracks which entries in _latinGlyphs have been filled, missing glyphs are filled with the default glyph
+		std::bitset<LATIN_GLYPH_COUNT> _latinGlyphLoaded;
+		std::unordered_map<uint32_t, GlyphInfo> _glyphMap;
 		GlyphInfo                     _defaultGlyph;
+		std::vector<float>            _kerningTable;
+		std::unordered_map<uint64_t, float> _kerningCache;
 		Texture2D::Sptr   _atlas;
 		std::string       _fontPath;
 		std::string       _fontData;
@@ -111,7 +158,18 @@
 			              _atlasHeight;
 
 		stbtt_packedchar* _glyphs;
+		uint32_t          _glyphCount;
 		stbtt_fontinfo    _fontInfo;
 
+		bool                    _isDynamic;
+		bool                    _isDistanceField;
+		stbrp_context           _dynamicPacker;
+		std::vector<stbrp_node> _dynamicNodes;
+		bool                    _hasWarnedFull;
+
 		GlyphInfo __CreateGlyph(uint32_t index);
+		GlyphInfo __RasterizeGlyph(uint32_t codePoint);
+		void __StoreGlyph(uint32_t codePoint, const GlyphInfo& glyph);
+		void __BuildKerningTable();
+		void __BakeIncremental();
 	};
\ No newline at end of file
@@ -44,7 +44,9 @@ ENUM(InternalFormat, GLint,
 	RGB8         = GL_RGB8,
 	SRGB         = GL_SRGB8,
 	RGB10        = GL_RGB10,
+	RGB10A2      = GL_RGB10_A2,
 	RGB16        = GL_RGB16,
+	RGB16F       = GL_RGB16F,
 	RGB32F       = GL_RGB32F,
 	RGBA8        = GL_RGBA8,
 	SRGBA        = GL_SRGB8_ALPHA8,
@@ -120,6 +122,7 @@ constexpr size_t GetTexelComponentSize(PixelType type) {
 		return 2;
 	case PixelType::Int:
 	case PixelType::UInt:
+	case PixelType::Float:
 		return 4;
 	default:
 		LOG_ASSERT(false, "Unknown type: {}", type);
@@ -191,6 +194,43 @@ constexpr size_t GetTexelSize(PixelFormat format, PixelType type) {
 	return GetTexelComponentSize(type) * GetTexelComponentCount(format);
 }
 
+/*
+ * Gets the number of bytes a single texel of the given internal format will take up on the GPU. Note that
+ * drivers are free to pad formats (ex: RGB8 is often stored as RGBA8), so this is an estimate
+ * @param format The internal format to get the size of
+ * @returns The size of a single texel stored in the given format, in bytes
+ */
+constexpr size_t GetInternalFormatSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::R8:
+			return 1;
+		case InternalFormat::R16:
+		case InternalFormat::RG8:
+			return 2;
+		case InternalFormat::RGB8:
+		case InternalFormat::SRGB:
+			return 3;
+		case InternalFormat::Depth:
+		case InternalFormat::DepthStencil:
+		case InternalFormat::RGB10:
+		case InternalFormat::RGB10A2:
+		case InternalFormat::RGBA8:
+		case InternalFormat::SRGBA:
+			return 4;
+		case InternalFormat::RGB16:
+		case InternalFormat::RGB16F:
+			return 6;
+		case InternalFormat::RGBA16:
+			return 8;
+		case InternalFormat::RGB32F:
+			return 12;
+		case InternalFormat::RGB32AF:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
 
 /*
 	* Represents the type of data used in a shader in a more useful format for us
@@ -6,8 +6,6 @@
 #include <codecvt>
 
 
-std::unordered_map<Texture2D*, GuiBatcher::MeshData> GuiBatcher::_meshBuilders;
-
 VertexArrayObject::Sptr GuiBatcher::__vao = nullptr;
 IndexBuffer::Sptr GuiBatcher::__ibo = nullptr;
 
@@ -16,12 +14,80 @@ int GuiBatcher::__defaultEdgeRadius = 0;
 
 VertexBuffer::Sptr GuiBatcher::__vbo = nullptr;
 ShaderProgram::Sptr GuiBatcher::__shader = nullptr;
-ShaderProgram::Sptr GuiBatcher::__fontShader = nullptr;
 glm::ivec2 GuiBatcher::__windowSize = {0, 0};
 glm::mat4 GuiBatcher::__projection = glm::mat4(1.0f);
 glm::mat3 GuiBatcher::__model = glm::mat3(1.0f);
 std::vector<glm::mat3> GuiBatcher::__modelTransformStack = std::vector<glm::mat3>();
 std::vector<GuiBatcher::IRect> GuiBatcher::__scissorRects = std::vector<GuiBatcher::IRect>();
+MeshBuilder<VertexPosColTex> GuiBatcher::__frameBuilder = MeshBuilder<VertexPosColTex>();
+std::vector<GuiBatcher::DrawCall> GuiBatcher::__drawCalls = std::vector<GuiBatcher::DrawCall>();
+std::vector<GuiBatcher::SubmittedCache> GuiBatcher::__lastFlush = std::vector<GuiBatcher::SubmittedCache>();
+TextureAtlas::Sptr GuiBatcher::__atlas = nullptr;
+std::vector<std::weak_ptr<Texture2D>> GuiBatcher::__pendingAtlasTextures = std::vector<std::weak_ptr<Texture2D>>();
+GuiGeometryCache::Sptr GuiBatcher::__immediate = std::make_shared<GuiGeometryCache>();
+GuiGeometryCache* GuiBatcher::__recording = GuiBatcher::__immediate.get();
+std::vector<GuiBatcher::RecordState> GuiBatcher::__recordStack = std::vector<GuiBatcher::RecordState>();
+std::vector<GuiGeometryCache::Sptr> GuiBatcher::__queuedCaches = std::vector<GuiGeometryCache::Sptr>();
+uint32_t GuiBatcher::__cacheGeneration = 0;
+
+GuiGeometryCache::GuiGeometryCache() :
+	_builder(MeshBuilder<VertexPosColTex>()),
+	_ranges(std::vector<Range>()),
+	_generation(0),
+	_revision(0),
+	_isRecorded(false)
+{ }
+
+GuiGeometryCache::~GuiGeometryCache() = default;
+
+bool GuiGeometryCache::IsValid() const {
+	return _isRecorded && _generation == GuiBatcher::__cacheGeneration;
+}
+
+size_t GuiGeometryCache::GetVertexCount() const {
+	return _builder.GetVertexCount();
+}
+
+MeshBuilder<VertexPosColTex>& GuiBatcher::__GetBuilder(const Texture2D::Sptr& tex, GuiTextureMode mode) {
+	// Geometry can be recorded before the first flush, so make sure the default texture exists to fall back on
+	__StaticInit();
+	const Texture2D::Sptr& texture = tex != nullptr ? tex : __defaultUITexture;
+
+	GuiGeometryCache& cache = *__recording;
+	// Geometry is kept in the order it was submitted, so we only need a new range when the texture changes
+	if (cache._ranges.empty() || cache._ranges.back().Texture != texture || cache._ranges.back().Mode != mode) {
+		cache._ranges.push_back({ texture, mode, (uint32_t)cache._builder.GetVertexCount(), (uint32_t)cache._builder.GetIndexCount() });
+	}
+	return cache._builder;
+}
+
+const TextureAtlas::Region* GuiBatcher::__FindInAtlas(const Texture2D::Sptr& tex) {
+	// An expired pending entry would compare equal to a null texture, so we never look those up
+	if (__atlas == nullptr || tex == nullptr) {
+		return nullptr;
+	}
+
+	// Try to pack the texture if it's waiting to be added, it may not have been loaded when it was registered
+	// Expired entries are pruned every flush, so this list only holds textures that are still loading
+	auto it = std::find_if(__pendingAtlasTextures.begin(), __pendingAtlasTextures.end(), [&](const std::weak_ptr<Texture2D>& ptr) {
+		return ptr.lock() == tex;
+	});
+	if (it != __pendingAtlasTextures.end() && tex->GetLoadState() != TextureLoadState::Pending) {
+		// We didn't know the size of the texture until it loaded
+		if (tex->GetWidth() <= MaxAtlasImageSize && tex->GetHeight() <= MaxAtlasImageSize) {
+			__atlas->TryAdd(tex);
+		}
+		__pendingAtlasTextures.erase(it);
+	}
+
+	return __atlas->Find(tex.get());
+}
+
+void GuiBatcher::__PrunePendingAtlasTextures() {
+	__pendingAtlasTextures.erase(std::remove_if(__pendingAtlasTextures.begin(), __pendingAtlasTextures.end(), [](const std::weak_ptr<Texture2D>& ptr) {
+		return ptr.expired();
+	}), __pendingAtlasTextures.end());
+}
 
 void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, const glm::vec2 uvMin, const glm::vec2 uvMax) {
 	// Create vertices and transform positions
@@ -31,32 +97,46 @@ void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm:
 	verts[2].Position = __model * glm::vec3(max.x, max.y, 1.0f);
 	verts[3].Position = __model * glm::vec3(max.x, min.y, 1.0f);
 		
+	// If the texture has been packed into the atlas, we draw from there instead and remap the UVs to match
+	glm::vec2 uvMinAtlas = uvMin;
+	glm::vec2 uvMaxAtlas = uvMax;
+	const TextureAtlas::Region* region = __FindInAtlas(tex);
+	if (region != nullptr) {
+		uvMinAtlas = glm::mix(region->UvMin, region->UvMax, uvMin);
+		uvMaxAtlas = glm::mix(region->UvMin, region->UvMax, uvMax);
+	}
+
 	// Grab mesh info for the texture batch
-	MeshData& mesh = _meshBuilders[tex.get()];
-	// We can use the vertex count for depth, so that things drawn later have a bit of spacing
-	float depth = mesh.Builder.GetVertexCount() / 1000.0f;
+	MeshBuilder<VertexPosColTex>& mesh = __GetBuilder(region != nullptr ? __atlas->GetTexture() : tex, GuiTextureMode::Color);
 
-	// Copy in all color and set depth 
+	// Copy in all color, Z gets filled in with the texture slot when the frame is built
 	for (int ix = 0; ix < 4; ix++) {
 		verts[ix].Color = color;
-		verts[ix].Position.z = depth;
+		verts[ix].Position.z = 0.0f;
 	}
 
 	// Copy over UV coords
-	verts[0].UV = glm::vec2(uvMin.x, uvMax.y);
-	verts[1].UV = glm::vec2(uvMin.x, uvMin.y);
-	verts[2].UV = glm::vec2(uvMax.x, uvMin.y);
-	verts[3].UV = glm::vec2(uvMax.x, uvMax.y);
+	verts[0].UV = glm::vec2(uvMinAtlas.x, uvMaxAtlas.y);
+	verts[1].UV = glm::vec2(uvMinAtlas.x, uvMinAtlas.y);
+	verts[2].UV = glm::vec2(uvMaxAtlas.x, uvMinAtlas.y);
+	verts[3].UV = glm::vec2(uvMaxAtlas.x, uvMaxAtlas.y);
 
 	// Add vertices and indices to range
-	uint32_t ix = mesh.Builder.AddVertexRange(verts, 4);
-	mesh.Builder.AddIndexTri(ix + 0, ix + 2, ix + 1);
-	mesh.Builder.AddIndexTri(ix + 0, ix + 3, ix + 2);
+	uint32_t ix = mesh.AddVertexRange(verts, 4);
+	mesh.AddIndexTri(ix + 0, ix + 2, ix + 1);
+	mesh.AddIndexTri(ix + 0, ix + 3, ix + 2);
 }
 
 void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, int edgeRadius)
 {
-	if (edgeRadius <= 0) {
+	// The border offsets depend on the texture size, so we need a texture to work from
+	__StaticInit();
+	if (tex == nullptr && __defaultUITexture != nullptr) {
+		PushRect(min, max, color, __defaultUITexture, edgeRadius);
+		return;
+	}
+
+	if (edgeRadius <= 0 || tex == nullptr) {
 		PushRect(min, max, color, tex, { 0,0 }, { 1,1 });
 	} 
 	else {
@@ -97,132 +177,232 @@ void GuiBatcher::SetProjection(const glm::mat4& projection) {
 	__projection = projection;
 }
 
-void GuiBatcher::RenderText(const std::wstring& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/) {
-	// How many characters we have
-	size_t length = text.size();
-
-	// Tracks the offset of the character
-	glm::vec2 offset = glm::vec2(0.0f);
+void GuiBatcher::RenderText(const std::wstring& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/, TextAlignment alignment /*= TextAlignment::Left*/, float maxWidth /*= 0.0f*/) {
+	RenderText(TextLayoutCache::Get(text, font, scale, color, alignment, maxWidth), position);
+}
 
-	// Transform the origin based off the model transform
-	glm::vec2 origin = position;
+void GuiBatcher::RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/, TextAlignment alignment /*= TextAlignment::Left*/, float maxWidth /*= 0.0f*/)
+{
+	static std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+	RenderText(converter.from_bytes(text), font, position, color, scale, alignment, maxWidth);
+}
 
-	// Gets the texture used to render the font
-	Texture2D::Sptr atlas = font->GetAtlas();
+void GuiBatcher::RenderText(const TextLayoutCache::Layout& layout, const glm::vec2& position) {
+	if (layout.Vertices.empty()) {
+		return;
+	}
 
-	// Grab the mesh builder and make sure it's a texture batch
-	MeshData& mesh = _meshBuilders[atlas.get()];
-	mesh.IsFont = true;
+	// Grab the mesh builder and make sure it's a font batch
+	MeshBuilder<VertexPosColTex>& mesh = __GetBuilder(layout.Atlas, layout.IsDistanceField ? GuiTextureMode::DistanceField : GuiTextureMode::Coverage);
 
-	// Allocate some space for the vertices
+	// The glyphs are already positioned, we only need to move them into model space
 	VertexPosColTex verts[4];
-	verts[0].Color = color;
-	verts[1].Color = color;
-	verts[2].Color = color;
-	verts[3].Color = color;
-
-	float depth = mesh.Builder.GetVertexCount() / 1000.0f;
-
-	// Iterate over all characters in string
-	for (int i = 0; i < length; i++) {
-		// Grab the glyph data for the character
-		GlyphInfo glyph = font->GetGlyph(text[i], offset.x, offset.y);
-
-		// A newline will advance to the next line and return to the start of the line
-		if (text[i] == '\n') {
-			offset.y  += font->GetLineHeight() * scale;
-			offset.x = 0;
-		}
-		// A return character simply returns to the start of the line
-		else if (text[i] == '\r') {
-			offset.x = 0;
-		}
-		// A tab character is 4 spaces
-		else if (text[i] == '\t') {
-			float xOffTemp{ 0 }, yOffTemp{ 0 };
-			glyph = font->GetGlyph(' ', xOffTemp, yOffTemp);
-			offset.x += glyph.OffsetX * 4;
-		}
-		// All other characters get rendered
-		else {
-			verts[0].Position = __model * glm::vec3(origin + (offset + glyph.Positions[0]) * scale, 1.0f);
-			verts[1].Position = __model * glm::vec3(origin + (offset + glyph.Positions[1]) * scale, 1.0f);
-			verts[2].Position = __model * glm::vec3(origin + (offset + glyph.Positions[2]) * scale, 1.0f);
-			verts[3].Position = __model * glm::vec3(origin + (offset + glyph.Positions[3]) * scale, 1.0f);
-			verts[0].UV = glyph.UVs[0];
-			verts[1].UV = glyph.UVs[1];
-			verts[2].UV = glyph.UVs[2];
-			verts[3].UV = glyph.UVs[3];
-
-			verts[0].Position.z = verts[1].Position.z = verts[2].Position.z = verts[3].Position.z = depth;
-
-			uint32_t ix = mesh.Builder.AddVertexRange(verts, 4);
-			mesh.Builder.AddIndexTri(ix + 0, ix + 1, ix + 2);
-			mesh.Builder.AddIndexTri(ix + 0, ix + 2, ix + 3);
-
-			// Advance the offset based on the size of the glyph
-			offset.x = glyph.OffsetX;
-			offset.y = glyph.OffsetY;
-
-			// If we have more characters, see if there's any kerning between the
-			// current and next character and add it to the x offset
-			if (i < length - 1) {
-				float kerning = font->GetKerning(text[i], text[i + 1]);
-				offset.x += kerning;
-			}
+	for (size_t glyph = 0; glyph < layout.Vertices.size(); glyph += 4) {
+		for (int ix = 0; ix < 4; ix++) {
+			verts[ix] = layout.Vertices[glyph + ix];
+			verts[ix].Position = __model * glm::vec3(position + glm::vec2(verts[ix].Position), 1.0f);
+			verts[ix].Position.z = 0.0f;
 		}
 
+		uint32_t ix = mesh.AddVertexRange(verts, 4);
+		mesh.AddIndexTri(ix + 0, ix + 1, ix + 2);
+		mesh.AddIndexTri(ix + 0, ix + 2, ix + 3);
 	}
-
-}
-
-void GuiBatcher::RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale /*= 1.0f*/)
-{
-	static std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	RenderText(converter.from_bytes(text), font, position, color, scale);
 }
 
 void GuiBatcher::Flush()
 {
 	__StaticInit();
+	__PrunePendingAtlasTextures();
+
+	// Anything drawn outside of a cache goes on top
+	if (!__immediate->_ranges.empty()) {
+		__queuedCaches.push_back(__immediate);
+		__immediate = std::make_shared<GuiGeometryCache>();
+		__recording = __recordStack.empty() ? __immediate.get() : __recording;
+	}
+
+	// If we're drawing the same caches as last time, and none of them have been re-recorded, we can re-use
+	// the buffers and draw calls from the last flush
+	bool isSameAsLast = __queuedCaches.size() == __lastFlush.size();
+	for (size_t ix = 0; isSameAsLast && ix < __queuedCaches.size(); ix++) {
+		isSameAsLast = __queuedCaches[ix] == __lastFlush[ix].Cache && __queuedCaches[ix]->_revision == __lastFlush[ix].Revision;
+	}
+	if (!isSameAsLast) {
+		__BuildFrame();
+
+		// Holding on to the caches keeps their textures alive for the draw calls, and means a new cache can't
+		// be allocated at the same address as one from this flush
+		__lastFlush.clear();
+		for (const auto& cache : __queuedCaches) {
+			__lastFlush.push_back({ cache, cache->_revision });
+		}
+	}
+	__queuedCaches.clear();
 
-	// Iterate over each texture and it's mesh
-	for (auto&[key, value] : _meshBuilders) {
-		Texture2D* tex = key;
-		// If the texture exists and the mesh has data
-		if (tex != nullptr && value.Builder.GetIndexCount() > 0) {
-			// Update the VAO and it's buffers
-			__vao->Bind();
-			__vbo->UpdateData(value.Builder.GetVertexDataPtr(), sizeof(VertexPosColTex), value.Builder.GetVertexCount(), true);
-			__ibo->UpdateData(value.Builder.GetIndexDataPtr(), sizeof(uint32_t), value.Builder.GetIndexCount(), true);
-
-			// Bind texture, send uniforms to shader
-			tex->Bind(0);
-			ShaderProgram::Sptr shader = value.IsFont ? __fontShader : __shader;
-			shader->Bind();
-			shader->SetUniformMatrix(0, &__projection, 1, false);
-
-			// Draw geometry
-			__vao->Draw();
-
-			// Clear mesh
-			value.Builder.Reset();
+	if (__drawCalls.empty()) {
+		return;
+	}
+
+	__shader->Bind();
+	__shader->SetUniformMatrix(0, &__projection, 1, false);
+	__vao->Bind();
+	for (const DrawCall& draw : __drawCalls) {
+		for (int ix = 0; ix < draw.TextureCount; ix++) {
+			draw.Textures[ix]->Bind(ix);
+		}
+		glDrawElements(GL_TRIANGLES, draw.IndexCount, GL_UNSIGNED_INT, (void*)(draw.IndexStart * sizeof(uint32_t)));
+	}
+	VertexArrayObject::Unbind();
+}
+
+void GuiBatcher::__BuildFrame() {
+	__frameBuilder.Reset();
+	__drawCalls.clear();
+
+	DrawCall* draw = nullptr;
+	for (const auto& cache : __queuedCaches) {
+		const MeshBuilder<VertexPosColTex>& source = cache->_builder;
+		uint32_t vertexOffset = (uint32_t)__frameBuilder.GetVertexCount();
+		__frameBuilder.ReserveVertexSpace(source.GetVertexCount());
+		__frameBuilder.ReserveIndexSpace(source.GetIndexCount());
+
+		for (size_t rangeIx = 0; rangeIx < cache->_ranges.size(); rangeIx++) {
+			const GuiGeometryCache::Range& range = cache->_ranges[rangeIx];
+			uint32_t vertexEnd = rangeIx + 1 < cache->_ranges.size() ? cache->_ranges[rangeIx + 1].VertexStart : (uint32_t)source.GetVertexCount();
+			uint32_t indexEnd  = rangeIx + 1 < cache->_ranges.size() ? cache->_ranges[rangeIx + 1].IndexStart  : (uint32_t)source.GetIndexCount();
+			// Ranges without a texture have nothing to bind, so they're skipped rather than drawn
+			if (indexEnd == range.IndexStart || range.Texture == nullptr) {
+				continue;
+			}
+
+			// Find the texture in the current draw call, or start a new one if all the slots are taken
+			int slot = -1;
+			for (int ix = 0; draw != nullptr && ix < draw->TextureCount; ix++) {
+				if (draw->Textures[ix] == range.Texture.get()) {
+					slot = ix;
+					break;
+				}
+			}
+			if (slot == -1) {
+				if (draw == nullptr || draw->TextureCount == MAX_DRAW_TEXTURES) {
+					__drawCalls.push_back({ (uint32_t)__frameBuilder.GetIndexCount(), 0, { nullptr }, 0 });
+					draw = &__drawCalls.back();
+				}
+				slot = draw->TextureCount++;
+				draw->Textures[slot] = range.Texture.get();
+			}
+
+			// The shader gets the texture slot and how to sample it from the Z coordinate
+			float mode = (float)(slot * 3 + (int)range.Mode);
+			const VertexPosColTex* verts = source.GetVertexDataPtr();
+			for (uint32_t ix = range.VertexStart; ix < vertexEnd; ix++) {
+				VertexPosColTex vert = verts[ix];
+				vert.Position.z = mode;
+				__frameBuilder.AddVertex(vert);
+			}
+			const uint32_t* indices = source.GetIndexDataPtr();
+			for (uint32_t ix = range.IndexStart; ix < indexEnd; ix++) {
+				__frameBuilder.AddIndex(indices[ix] + vertexOffset);
+			}
+			draw->IndexCount += indexEnd - range.IndexStart;
 		}
 	}
+
+	if (__frameBuilder.GetIndexCount() > 0) {
+		__vbo->UpdateData(__frameBuilder.GetVertexDataPtr(), sizeof(VertexPosColTex), (uint32_t)__frameBuilder.GetVertexCount(), true);
+		__ibo->UpdateData(__frameBuilder.GetIndexDataPtr(), sizeof(uint32_t), (uint32_t)__frameBuilder.GetIndexCount(), true);
+	}
 }
 
 void GuiBatcher::PushModelTransform(const glm::mat3& transform) {
-	__modelTransformStack.push_back(transform);
+	__modelTransformStack.push_back(__model);
 	__model = __model * transform;
 }
 
 void GuiBatcher::PopModelTransform()
 {
 	LOG_ASSERT(__modelTransformStack.size() > 0, "Transform push/pop mismatch");
-	__model = __model * glm::inverse(__modelTransformStack.back());
+	__model = __modelTransformStack.back();
 	__modelTransformStack.pop_back();
 }
 
+void GuiBatcher::BeginCache(GuiGeometryCache& cache) {
+	// Store the current state, and start from an identity transform so the cache is relative to the caller
+	__recordStack.push_back({ __recording, __model, std::move(__modelTransformStack) });
+	__modelTransformStack.clear();
+	__model = glm::mat3(1.0f);
+	__recording = &cache;
+
+	cache._builder.Reset();
+	cache._ranges.clear();
+}
+
+void GuiBatcher::EndCache() {
+	LOG_ASSERT(__recordStack.size() > 0, "Cache begin/end mismatch");
+	LOG_ASSERT(__modelTransformStack.empty(), "Transform push/pop mismatch while recording");
+
+	__recording->_generation = __cacheGeneration;
+	__recording->_revision++;
+	__recording->_isRecorded = true;
+
+	RecordState& state = __recordStack.back();
+	__recording = state.Cache;
+	__model = state.Model;
+	__modelTransformStack = std::move(state.ModelStack);
+	__recordStack.pop_back();
+}
+
+void GuiBatcher::SubmitCache(const GuiGeometryCache::Sptr& cache) {
+	if (cache->_ranges.empty()) {
+		return;
+	}
+
+	// Top level caches can be drawn as-is
+	if (__recordStack.empty() && __modelTransformStack.empty()) {
+		// Keep anything drawn before this cache underneath it
+		if (!__immediate->_ranges.empty()) {
+			__queuedCaches.push_back(__immediate);
+			__immediate = std::make_shared<GuiGeometryCache>();
+			__recording = __immediate.get();
+		}
+		__queuedCaches.push_back(cache);
+		return;
+	}
+
+	// Otherwise we append the cached geometry to the cache being recorded, which is still much cheaper than
+	// regenerating it
+	const MeshBuilder<VertexPosColTex>& source = cache->_builder;
+	for (size_t rangeIx = 0; rangeIx < cache->_ranges.size(); rangeIx++) {
+		const GuiGeometryCache::Range& range = cache->_ranges[rangeIx];
+		uint32_t vertexEnd = rangeIx + 1 < cache->_ranges.size() ? cache->_ranges[rangeIx + 1].VertexStart : (uint32_t)source.GetVertexCount();
+		uint32_t indexEnd  = rangeIx + 1 < cache->_ranges.size() ? cache->_ranges[rangeIx + 1].IndexStart  : (uint32_t)source.GetIndexCount();
+
+		MeshBuilder<VertexPosColTex>& mesh = __GetBuilder(range.Texture, range.Mode);
+		// Indices in the range are relative to the start of the source cache
+		uint32_t offset = (uint32_t)mesh.GetVertexCount() - range.VertexStart;
+
+		mesh.ReserveVertexSpace(vertexEnd - range.VertexStart);
+		const VertexPosColTex* verts = source.GetVertexDataPtr();
+		for (uint32_t ix = range.VertexStart; ix < vertexEnd; ix++) {
+			VertexPosColTex vert = verts[ix];
+			vert.Position = __model * glm::vec3(vert.Position.x, vert.Position.y, 1.0f);
+			vert.Position.z = 0.0f;
+			mesh.AddVertex(vert);
+		}
+
+		mesh.ReserveIndexSpace(indexEnd - range.IndexStart);
+		const uint32_t* indices = source.GetIndexDataPtr();
+		for (uint32_t ix = range.IndexStart; ix < indexEnd; ix++) {
+			mesh.AddIndex(indices[ix] + offset);
+		}
+	}
+}
+
+void GuiBatcher::InvalidateCaches() {
+	__cacheGeneration++;
+}
+
 void GuiBatcher::SetWindowSize(const glm::ivec2& size) {
 	__windowSize = size;
 }
@@ -231,6 +411,8 @@ void GuiBatcher::__StaticInit()
 {
 	static bool needsInit = true;
 	if (needsInit) {
+		// All GUI geometry is drawn with a single shader, Z stores which texture slot to sample, and how the
+		// texture should be interpreted (slot * 3 + GuiTextureMode)
 		__shader = ShaderProgram::Create();
 		__shader->LoadShaderPart(R"LIT(#version 460
 					layout(location = 0) in vec3 inPos;
@@ -239,65 +421,57 @@ void GuiBatcher::__StaticInit()
 
 					layout(location = 0) out vec4 outColor;
 					layout(location = 1) out vec2 outUV;
+					layout(location = 2) flat out int outMode;
 
 					layout(location = 0) uniform mat4 u_Projection;
 
 					void main() {
 						outColor = inColor;
 						outUV = inUV;
-						gl_Position = u_Projection * vec4(inPos, 1);
+						outMode = int(inPos.z + 0.5);
+						gl_Position = u_Projection * vec4(inPos.xy, 0, 1);
 					}
 				)LIT", ShaderPartType::Vertex);
 
 		__shader->LoadShaderPart(R"LIT(#version 460
 					layout(location = 0) in vec4 inColor;
 					layout(location = 1) in vec2 inUV;
+					layout(location = 2) flat in int inMode;
 
 					layout(location = 0) out vec4 outColor;
 
-					uniform layout(binding=0) sampler2D s_Texture;
+					uniform layout(binding=0) sampler2D s_Textures[8];
 
 					void main() {
-						outColor = texture(s_Texture, inUV) * inColor;
+						// Sampler arrays can only be indexed with uniform values, so we branch instead. Derivatives
+						// are taken outside of the branch, since they're undefined in non-uniform control flow
+						vec2 dx = dFdx(inUV);
+						vec2 dy = dFdy(inUV);
+						vec4 texel;
+						switch (inMode / 3) {
+							case 0:  texel = textureGrad(s_Textures[0], inUV, dx, dy); break;
+							case 1:  texel = textureGrad(s_Textures[1], inUV, dx, dy); break;
+							case 2:  texel = textureGrad(s_Textures[2], inUV, dx, dy); break;
+							case 3:  texel = textureGrad(s_Textures[3], inUV, dx, dy); break;
+							case 4:  texel = textureGrad(s_Textures[4], inUV, dx, dy); break;
+							case 5:  texel = textureGrad(s_Textures[5], inUV, dx, dy); break;
+							case 6:  texel = textureGrad(s_Textures[6], inUV, dx, dy); break;
+							default: texel = textureGrad(s_Textures[7], inUV, dx, dy); break;
+						}
+
+						// Font atlases only store coverage or distance in the red channel. For distance fields, the
+						// edge is at 0.5, and we smooth over about a pixel so edges stay crisp at any scale
+						float edgeWidth = max(fwidth(texel.r) * 0.7, 0.0001);
+						switch (inMode % 3) {
+							case 1:  outColor = vec4(inColor.rgb, texel.r); break;
+							case 2:  outColor = vec4(inColor.rgb, smoothstep(0.5 - edgeWidth, 0.5 + edgeWidth, texel.r)); break;
+							default: outColor = texel * inColor; break;
+						}
 					}
 				)LIT", ShaderPartType::Fragment);
 
 		__shader->Link();
 
-		__fontShader = ShaderProgram::Create();
-		__fontShader->LoadShaderPart(R"LIT(#version 460
-					layout(location = 0) in vec3 inPos;
-					layout(location = 1) in vec4 inColor;
-					layout(location = 3) in vec2 inUV;
-
-					layout(location = 0) out vec4 outColor;
-					layout(location = 1) out vec2 outUV;
-
-					layout(location = 0) uniform mat4 u_Projection;
-
-					void main() {
-						outColor = inColor;
-						outUV = inUV;
-						gl_Position = u_Projection * vec4(inPos, 1);
-					}
-				)LIT", ShaderPartType::Vertex);
-
-		__fontShader->LoadShaderPart(R"LIT(#version 460
-					layout(location = 0) in vec4 inColor;
-					layout(location = 1) in vec2 inUV;
-
-					layout(location = 0) out vec4 outColor;
-
-					uniform layout(binding=0) sampler2D s_Texture;
-
-					void main() {
-						float fontPow = texture(s_Texture, inUV).r;
-						outColor = vec4(inColor.rgb, fontPow);
-					}
-				)LIT" , ShaderPartType::Fragment);
-
-		__fontShader->Link();
-
 		__vbo = VertexBuffer::Create(BufferUsage::DynamicDraw);
 		__ibo = IndexBuffer::Create(BufferUsage::DynamicDraw, IndexType::UInt);
 
@@ -334,6 +508,9 @@ void GuiBatcher::__StaticInit()
 }
 
 void GuiBatcher::PushScissorRect(const glm::vec2& min, const glm::vec2& max) {
+	// Scissoring invokes a flush, which can't be stored in a cache
+	LOG_ASSERT(__recordStack.empty(), "Scissor rects can not be used while recording a GUI cache");
+
 	// Convert input to the current space
 	glm::vec2 modelMin = __model * glm::vec3(min, 1.0f);
 	glm::vec2 modelMax = __model * glm::vec3(max, 1.0f);
@@ -376,16 +553,44 @@ void GuiBatcher::PopScissorRect() {
 
 void GuiBatcher::SetDefaultTexture(const Texture2D::Sptr& value) {
 	__defaultUITexture = value;
+	AddToAtlas(value);
+	InvalidateCaches();
 }
 
 const Texture2D::Sptr& GuiBatcher::GetDefaultTexture() {
+	__StaticInit();
 	return __defaultUITexture;
 }
 
 void GuiBatcher::SetDefaultBorderRadius(int value) {
 	__defaultEdgeRadius = value;
+	InvalidateCaches();
 }
 
 int GuiBatcher::GetDefaultBorderRadius() {
 	return __defaultEdgeRadius;
 }
+
+void GuiBatcher::AddToAtlas(const Texture2D::Sptr& texture) {
+	if (texture == nullptr || texture->GetWidth() > MaxAtlasImageSize || texture->GetHeight() > MaxAtlasImageSize) {
+		return;
+	}
+	if (__atlas == nullptr) {
+		__atlas = TextureAtlas::Create(AtlasSize);
+	}
+
+	// If the texture hasn't finished loading, we'll pack it the first time it's drawn after it's ready
+	__PrunePendingAtlasTextures();
+	if (__atlas->Find(texture.get()) == nullptr && !__atlas->TryAdd(texture) && texture->GetLoadState() == TextureLoadState::Pending) {
+		bool isQueued = std::any_of(__pendingAtlasTextures.begin(), __pendingAtlasTextures.end(), [&](const std::weak_ptr<Texture2D>& ptr) {
+			return ptr.lock() == texture;
+		});
+		if (!isQueued) {
+			__pendingAtlasTextures.push_back(texture);
+		}
+	}
+}
+
+int GuiBatcher::GetDrawCallCount() {
+	return static_cast<int>(__drawCalls.size());
+}
\ No newline at end of file
@@ -7,8 +7,62 @@
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
+#include "Graphics/TextLayoutCache.h"
+#include "Graphics/Textures/TextureAtlas.h"
 #include "Utils/MeshBuilder.h"
 #include <unordered_map>
+#include <EnumToString.h>
+
+/// <summary>
+/// How the GUI shader interprets the texture that geometry is drawn with
+/// </summary>
+ENUM(GuiTextureMode, int,
+	 Color         = 0, // The texture is multiplied by the vertex color
+	 Coverage      = 1, // The red channel is the alpha of a glyph, see Font
+	 DistanceField = 2  // The red channel is the distance to the edge of a glyph, see Font::SetDistanceField
+);
+
+	/// <summary>
+	/// Stores the geometry generated by the GUI batcher between GuiBatcher::BeginCache and GuiBatcher::EndCache,
+	/// so that it can be submitted again on later frames without being regenerated. Geometry is recorded relative
+	/// to the transform that was active when recording started, so a cache stays valid when it's parent moves
+	/// </summary>
+	class GuiGeometryCache {
+	public:
+		typedef std::shared_ptr<GuiGeometryCache> Sptr;
+
+		GuiGeometryCache();
+		~GuiGeometryCache();
+
+		/// <summary>
+		/// Returns true if this cache has been recorded, and has not been invalidated since
+		/// (see GuiBatcher::InvalidateCaches)
+		/// </summary>
+		bool IsValid() const;
+		/// <summary>
+		/// Gets the number of vertices stored in this cache
+		/// </summary>
+		size_t GetVertexCount() const;
+
+	private:
+		friend class GuiBatcher;
+
+		// A run of geometry in submission order that uses the same texture, ends where the next range starts
+		struct Range {
+			// We hold a reference to the texture, since the cache can outlive the objects that recorded it
+			Texture2D::Sptr Texture;
+			GuiTextureMode  Mode;
+			uint32_t        VertexStart;
+			uint32_t        IndexStart;
+		};
+
+		MeshBuilder<VertexPosColTex> _builder;
+		std::vector<Range>           _ranges;
+		uint32_t _generation;
+		// Incremented every time the cache is recorded, so the batcher can tell when it has changed
+		uint32_t _revision;
+		bool     _isRecorded;
+	};
 
 	/// <summary>
 	/// The GUI Batcher class provides utilities for drawing rectangles and
@@ -38,23 +92,34 @@
 		/// <param name="uvMin">The maximum coord of the UV range</param>
 		static void PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, const glm::vec2 uvMin, const glm::vec2 uvMax);
 		/// <summary>
-		/// Renders a left-aligned line of text at the given position using a font
+		/// Renders text at the given position using a font. The layout of the text is cached by the
+		/// TextLayoutCache, so text that is drawn every frame does not need to be laid out every frame
 		/// </summary>
 		/// <param name="text">The unicode text to render</param>
 		/// <param name="font">The font to render with</param>
-		/// <param name="position">The position of the text in model space</param>
+		/// <param name="position">The position of the first line's baseline in model space</param>
 		/// <param name="color">The color of the text</param>
 		/// <param name="scale">The scaling to apply to the text</param>
-		static void RenderText(const std::wstring& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f);
+		/// <param name="alignment">How to align each line of text</param>
+		/// <param name="maxWidth">The width at which lines are broken between words, or 0 to disable wrapping</param>
+		static void RenderText(const std::wstring& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f, TextAlignment alignment = TextAlignment::Left, float maxWidth = 0.0f);
 		/// <summary>
-		/// Renders a left-aligned line of text at the given position using a font
+		/// Renders text at the given position using a font
 		/// </summary>
-		/// <param name="text">The ASCII text to render</param>
+		/// <param name="text">The UTF-8 text to render</param>
 		/// <param name="font">The font to render with</param>
-		/// <param name="position">The position of the text in model space</param>
+		/// <param name="position">The position of the first line's baseline in model space</param>
 		/// <param name="color">The color of the text</param>
 		/// <param name="scale">The scaling to apply to the text</param>
-		static void RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f);
+		/// <param name="alignment">How to align each line of text</param>
+		/// <param name="maxWidth">The width at which lines are broken between words, or 0 to disable wrapping</param>
+		static void RenderText(const std::string& text, const Font::Sptr& font, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f, TextAlignment alignment = TextAlignment::Left, float maxWidth = 0.0f);
+		/// <summary>
+		/// Renders a block of text that has already been laid out, see TextLayoutCache
+		/// </summary>
+		/// <param name="layout">The layout to render</param>
+		/// <param name="position">The position of the first line's baseline in model space</param>
+		static void RenderText(const TextLayoutCache::Layout& layout, const glm::vec2& position);
 
 		/// <summary>
 		/// Sets the projection matrix to use for rendering, should ideally be an orthographic
@@ -81,6 +146,29 @@
 		/// </summary>
 		static void PopModelTransform();
 
+		/// <summary>
+		/// Starts recording all geometry pushed to the batcher into a cache, clearing any existing contents. The
+		/// model transform is reset while recording, and restored by EndCache. Recording may be nested
+		/// </summary>
+		/// <param name="cache">The cache to record into</param>
+		static void BeginCache(GuiGeometryCache& cache);
+		/// <summary>
+		/// Finishes recording into the cache that was passed to the last call to BeginCache
+		/// </summary>
+		static void EndCache();
+		/// <summary>
+		/// Submits the contents of a cache, transformed by the current model transform. When not recording and
+		/// no transforms are pushed, the cache is drawn as-is during the next flush, and if the same caches are
+		/// submitted without being re-recorded, the last flush's vertex buffer is re-used
+		/// </summary>
+		/// <param name="cache">The cache to submit</param>
+		static void SubmitCache(const GuiGeometryCache::Sptr& cache);
+		/// <summary>
+		/// Invalidates all recorded caches, should be invoked when something that all GUI geometry depends on
+		/// changes (ex: the default texture)
+		/// </summary>
+		static void InvalidateCaches();
+
 		/// <summary>
 		/// Sets a new scissor region in model space. Note that this will invoke a 
 		/// flush
@@ -112,31 +200,101 @@
 		/// </summary>
 		static int GetDefaultBorderRadius();
 
+		/// <summary>
+		/// Marks a texture as one that GUI elements will use, so that it will be packed into the GUI atlas once
+		/// it has loaded. Textures in the atlas can be drawn along with any other GUI geometry in a single draw
+		/// call. Should only be used for small textures that don't change after loading
+		/// </summary>
+		static void AddToAtlas(const Texture2D::Sptr& texture);
+
+		/// <summary>
+		/// Gets the number of draw calls that the last flush issued
+		/// </summary>
+		static int GetDrawCallCount();
+
+		// The size of the GUI atlas in pixels, must be set before the first GUI element is drawn
+		inline static uint32_t AtlasSize = 1024;
+		// Textures larger than this along either axis won't be packed into the atlas
+		inline static uint32_t MaxAtlasImageSize = 256;
+		// The number of textures that can be used in a single draw call
+		static constexpr int MAX_DRAW_TEXTURES = 8;
+
 	private:
+		friend class GuiGeometryCache;
+
 		struct IRect {
 			glm::ivec2 Min;
 			glm::ivec2 Max;
 		};
 
-		struct MeshData {
-			MeshBuilder<VertexPosColTex> Builder;
-			bool IsFont;
+		// A single draw call in a flush, covering a range of the frame's indices
+		struct DrawCall {
+			uint32_t   IndexStart;
+			uint32_t   IndexCount;
+			Texture2D* Textures[MAX_DRAW_TEXTURES];
+			int        TextureCount;
+		};
+
+		// The cache that was last submitted, along with it's revision at the time
+		struct SubmittedCache {
+			GuiGeometryCache::Sptr Cache;
+			uint32_t               Revision;
 		};
 
 		static glm::ivec2 __windowSize;
 		static glm::mat4 __projection;
 		static glm::mat3 __model;
+		// Stores the model transform from before each push, so pops can restore it exactly
 		static std::vector<glm::mat3> __modelTransformStack;
 		static std::vector<IRect> __scissorRects;
 		static ShaderProgram::Sptr __shader;
-		static ShaderProgram::Sptr __fontShader;
-		static std::unordered_map<Texture2D*, MeshData> _meshBuilders;
 		static VertexArrayObject::Sptr __vao;
 		static VertexBuffer::Sptr __vbo;
 		static IndexBuffer::Sptr __ibo;
 
+		// The geometry for the current flush, and how it gets split into draw calls
+		static MeshBuilder<VertexPosColTex> __frameBuilder;
+		static std::vector<DrawCall> __drawCalls;
+		// The caches that were drawn by the last flush, so we can tell if anything has changed
+		static std::vector<SubmittedCache> __lastFlush;
+
+		static TextureAtlas::Sptr __atlas;
+		// Textures that should go in the atlas, but haven't been packed yet
+		static std::vector<std::weak_ptr<Texture2D>> __pendingAtlasTextures;
+
 		static Texture2D::Sptr __defaultUITexture;
 		static int __defaultEdgeRadius;
 
+		// The state to restore when a cache finishes recording
+		struct RecordState {
+			GuiGeometryCache*      Cache;
+			glm::mat3              Model;
+			std::vector<glm::mat3> ModelStack;
+		};
+
+		// Geometry that is pushed outside of any cache gets recorded here
+		static GuiGeometryCache::Sptr __immediate;
+		static GuiGeometryCache* __recording;
+		static std::vector<RecordState> __recordStack;
+		static std::vector<GuiGeometryCache::Sptr> __queuedCaches;
+		static uint32_t __cacheGeneration;
+
 		static void __StaticInit();
+		/// <summary>
+		/// Gets the mesh to add geometry for the given texture to in the cache being recorded, starting a new
+		/// range if the texture differs from the last one used
+		/// </summary>
+		static MeshBuilder<VertexPosColTex>& __GetBuilder(const Texture2D::Sptr& tex, GuiTextureMode mode);
+		/// <summary>
+		/// Looks up a texture in the GUI atlas, packing it first if it's waiting to be added
+		/// </summary>
+		static const TextureAtlas::Region* __FindInAtlas(const Texture2D::Sptr& tex);
+		/// <summary>
+		/// Removes textures that were destroyed before they could be packed from the pending atlas list
+		/// </summary>
+		static void __PrunePendingAtlasTextures();
+		/// <summary>
+		/// Combines all queued caches into the frame's vertex stream, and splits it into draw calls
+		/// </summary>
+		static void __BuildFrame();
 	};
@@ -3,15 +3,22 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
 
 #include "Utils/FileHelpers.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/HashHelpers.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Graphics/ShaderSourceCache.h"
 
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
 	IResource()
 {
 	_rendererId = glCreateProgram();
+	_livePrograms.insert(this);
 }
 
 ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
@@ -19,6 +26,7 @@ ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::strin
 	IResource()
 {
 	_rendererId = glCreateProgram();
+	_livePrograms.insert(this);
 	for (auto& [type, path] : filePaths) {
 		LoadShaderPartFromFile(path.c_str(), type);
 	}
@@ -26,6 +34,7 @@ ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::strin
 }
 
 ShaderProgram::~ShaderProgram() {
+	_livePrograms.erase(this);
 	if (_rendererId != 0) {
 		glDeleteProgram(_rendererId);
 		_rendererId = 0;
@@ -33,6 +42,29 @@ ShaderProgram::~ShaderProgram() {
 }
 
 bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
+	bool result = true;
+
+	// If we're using the binary cache, we hold onto the source and only compile if we miss the cache
+	if (BinaryCacheEnabled) {
+		if (_pendingSources.count(type) > 0) {
+			LOG_WARN("Another shader has been attached to this slot, overwriting");
+		}
+		_pendingSources[type] = source;
+	} else {
+		result = _CompilePart(source, type);
+		if (!result) {
+			return false;
+		}
+	}
+
+	// Store info about where we got this data from
+	_fileSourceMap[type].IsFilePath = false;
+	_fileSourceMap[type].Source = source;
+
+	return result;
+}
+
+bool ShaderProgram::_CompilePart(const char* source, ShaderPartType type) {
 	// Creates a new shader part (VS, FS, GS, etc...)
 	GLuint handle = glCreateShader((GLenum)type);
 
@@ -55,8 +87,8 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 		// Get the log
 		glGetShaderInfoLog(handle, logSize, &logSize, log);
 
-		// Dump error log
-		LOG_ERROR("Failed to compile shader part:\n{}", log);
+		// Dump error log, mapping the source string numbers from our #line directives back to file names
+		LOG_ERROR("Failed to compile shader part:\n{}", ShaderSourceCache::AnnotateLog(log));
 
 		// Clean up our log memory
 		delete[] log;
@@ -75,19 +107,15 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 	}
 	_handles[type] = handle;
 
-	// Store info about where we got this data from
-	_fileSourceMap[type].IsFilePath = false;
-	_fileSourceMap[type].Source = source;
-
 	return status != GL_FALSE;
 }
 
 bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
 	// Make sure that the file exists before we try reading
-	if (std::filesystem::exists(path)) {
-		// Load the source from the file, using our helper that will
+	if (VirtualFileSystem::Exists(path)) {
+		// Load the source from the file, using our cache that will
 		// resolve #include directives
-		std::string source = FileHelpers::ReadResolveIncludes(path);
+		const std::string& source = ShaderSourceCache::Resolve(path);
 		// Pass off to LoadShaderPart
 		bool result =  LoadShaderPart(source.c_str(), type);
 		_fileSourceMap[type].IsFilePath = true;
@@ -105,6 +133,41 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 bool ShaderProgram::Link() {
 
 	LOG_TRACE("Starting shader link:");
+
+	// If we have sources that haven't been compiled, try and skip the compile by loading from the binary cache
+	uint64_t binaryHash = 0;
+	if (!_pendingSources.empty()) {
+		binaryHash = _GetBinaryHash();
+		if (_TryLoadBinary(binaryHash)) {
+			_pendingSources.clear();
+			LOG_TRACE("Loaded program binary {} from cache, starting introspection", HashHelpers::ToHex(binaryHash));
+			_Introspect();
+			return true;
+		}
+
+		// Cache miss (or the driver rejected the binary), compile as normal
+		for (auto& [type, source] : _pendingSources) {
+			if (!_CompilePart(source.c_str(), type) && _fileSourceMap[type].IsFilePath) {
+				LOG_ERROR("Source File: {}", _fileSourceMap[type].Source);
+			}
+		}
+		_pendingSources.clear();
+	}
+
+	// Varyings only take effect on the next link, and loading a binary may have replaced them
+	if (!_varyings.empty()) {
+		std::vector<const char*> names;
+		names.reserve(_varyings.size());
+		for (const auto& name : _varyings) {
+			names.push_back(name.c_str());
+		}
+		glTransformFeedbackVaryings(_rendererId, (GLsizei)names.size(), names.data(), _interleavedVaryings ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+	}
+
+	// Let the driver know we want to read the binary back for the cache
+	if (binaryHash != 0) {
+		glProgramParameteri(_rendererId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	
 	// Attach all our shaders
 	for (auto& [type, id] : _handles) {
@@ -148,6 +211,9 @@ bool ShaderProgram::Link() {
 		}
 	} else {
 		LOG_TRACE("Linking complete, starting introspection");
+		if (binaryHash != 0) {
+			_SaveBinary(binaryHash);
+		}
 	}
 
 	// Perform our uniform introspection to see what uniforms are in the shader
@@ -156,6 +222,49 @@ bool ShaderProgram::Link() {
 	return status != GL_FALSE;
 }
 
+bool ShaderProgram::Reload() {
+	// Copy our sources, since loading the parts will overwrite the map
+	std::unordered_map<ShaderPartType, ShaderSource> sources = _fileSourceMap;
+	for (auto& [type, source] : sources) {
+		if (source.IsFilePath) {
+			LoadShaderPartFromFile(source.Source.c_str(), type);
+		} else {
+			LoadShaderPart(source.Source.c_str(), type);
+		}
+	}
+	return Link();
+}
+
+void ShaderProgram::ReloadChangedShaders() {
+	static std::chrono::steady_clock::time_point lastCheck;
+	if (!HotReloadEnabled) {
+		return;
+	}
+
+	// Checking the file times isn't free, so we only do it every so often
+	auto now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<float>(now - lastCheck).count() < HotReloadInterval) {
+		return;
+	}
+	lastCheck = now;
+
+	std::unordered_set<std::string> changed = ShaderSourceCache::PollChanges();
+	if (changed.empty()) {
+		return;
+	}
+
+	// Only rebuild programs that have a part that was loaded from one of the changed files
+	for (ShaderProgram* program : _livePrograms) {
+		for (auto& [type, source] : program->_fileSourceMap) {
+			if (source.IsFilePath && changed.count(ShaderSourceCache::NormalizePath(source.Source)) > 0) {
+				LOG_INFO("Shader source changed, rebuilding \"{}\"", program->GetDebugName());
+				program->Reload();
+				break;
+			}
+		}
+	}
+}
+
 void ShaderProgram::Bind() {
 	// Simply calls glUseProgram with our shader handle
 	glUseProgram(_rendererId);
@@ -306,11 +415,25 @@ void ShaderProgram::SetUniform(int location, ShaderDataType type, void* data, in
 	}
 }
 
-int ShaderProgram::__GetUniformLocation(const std::string& name) {
-	// Since the default constructor for UniformInfo sets location to -1,
-	// we can simply index the map and if it doesn't exist, the default
-	// will be used
-	return _uniforms[name].Location;
+void ShaderProgram::_BuildUniformTable() {
+	// Keep the load factor at or below 50%, and the size a power of 2 so we can mask instead of mod
+	size_t size = 4;
+	while (size < _uniforms.size() * 2) {
+		size <<= 1;
+	}
+	_uniformTable.assign(size, UniformSlot());
+
+	const size_t mask = size - 1;
+	for (const auto& [name, uniform] : _uniforms) {
+		uint64_t hash = HashHelpers::Fnv1a(name);
+		size_t ix = hash & mask;
+		while (_uniformTable[ix].Hash != 0) {
+			LOG_ASSERT(_uniformTable[ix].Hash != hash, "Uniform name hash collision on \"{}\"", name);
+			ix = (ix + 1) & mask;
+		}
+		_uniformTable[ix].Hash = hash;
+		_uniformTable[ix].Location = uniform.Location;
+	}
 }
 
 nlohmann::json ShaderProgram::ToJson() const {
@@ -347,8 +470,13 @@ ShaderProgram::Sptr ShaderProgram::FromJson(const nlohmann::json& data) {
 }
 
 void ShaderProgram::_Introspect() {
+	// We may be re-linking, so throw away anything we found last time
+	_uniforms.clear();
+	_uniformBlocks.clear();
+	_uniformTable.clear();
 	_IntrospectUniforms();
 	_IntrospectUnifromBlocks();
+	_BuildUniformTable();
 }
 
 void ShaderProgram::_IntrospectUniforms() {
@@ -519,5 +647,100 @@ GlResourceType ShaderProgram::GetResourceClass() const {
 
 void ShaderProgram::RegisterVaryings(const char* const* names, int numVaryings, bool interleaved /*= true*/)
 {
-	glTransformFeedbackVaryings(_rendererId, numVaryings, names, interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+	// We store these and apply them when linking, since they are part of the binary cache key
+	_varyings.assign(names, names + numVaryings);
+	_interleavedVaryings = interleaved;
+}
+
+uint64_t ShaderProgram::_GetBinaryHash() const {
+	// Binaries are only valid for the driver that produced them, so we mix that into the hash as well, that way
+	// a driver update gives us a clean miss instead of a rejected binary
+	uint64_t hash = HashHelpers::FNV_OFFSET_BASIS;
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		hash = HashHelpers::Fnv1a(value != nullptr ? value : "", hash);
+	}
+
+	// Stages need to be hashed in a consistent order
+	std::vector<ShaderPartType> stages;
+	for (auto& [type, source] : _pendingSources) {
+		stages.push_back(type);
+	}
+	std::sort(stages.begin(), stages.end());
+	for (ShaderPartType type : stages) {
+		hash = HashHelpers::Combine(hash, type);
+		hash = HashHelpers::Fnv1a(_pendingSources.at(type), hash);
+	}
+
+	hash = HashHelpers::Combine(hash, _interleavedVaryings);
+	for (const auto& name : _varyings) {
+		hash = HashHelpers::Fnv1a(name, hash);
+		hash = HashHelpers::Combine(hash, '\0');
+	}
+	return hash;
+}
+
+std::string ShaderProgram::_GetBinaryPath(uint64_t hash) {
+	return (std::filesystem::path(BinaryCachePath) / (HashHelpers::ToHex(hash) + ".bin")).string();
+}
+
+bool ShaderProgram::_TryLoadBinary(uint64_t hash) {
+	// Some drivers don't support any binary formats at all
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	if (numFormats == 0) {
+		return false;
+	}
+
+	std::ifstream file(_GetBinaryPath(hash), std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	BinaryHeader header = BinaryHeader();
+	file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+	if (!file || memcmp(header.HeaderBytes, BinaryHeader().HeaderBytes, 4) != 0 || header.Version != BINARY_CACHE_VERSION) {
+		return false;
+	}
+
+	std::vector<char> binary(header.BinarySize);
+	file.read(binary.data(), binary.size());
+	if (!file) {
+		return false;
+	}
+
+	// The driver may still reject the binary (ex: after an update), in which case the program is left unlinked and we compile from source
+	glProgramBinary(_rendererId, header.BinaryFormat, binary.data(), (GLsizei)binary.size());
+	GLint status = 0;
+	glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		LOG_TRACE("Driver rejected cached program binary {}, recompiling", HashHelpers::ToHex(hash));
+		return false;
+	}
+	return true;
+}
+
+void ShaderProgram::_SaveBinary(uint64_t hash) {
+	GLint length = 0;
+	glGetProgramiv(_rendererId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	BinaryHeader header = BinaryHeader();
+	header.Version = BINARY_CACHE_VERSION;
+	std::vector<char> binary(length);
+	glGetProgramBinary(_rendererId, length, &length, &header.BinaryFormat, binary.data());
+	header.BinarySize = length;
+
+	// Failing to write the cache isn't fatal, we'll just compile again next time
+	std::error_code err;
+	std::filesystem::create_directories(BinaryCachePath, err);
+	std::ofstream file(_GetBinaryPath(hash), std::ios::binary);
+	if (!file) {
+		LOG_WARN("Failed to write program binary to \"{}\"", _GetBinaryPath(hash));
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+	file.write(binary.data(), header.BinarySize);
 }
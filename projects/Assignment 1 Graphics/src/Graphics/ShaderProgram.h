@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>               // for std::string
 #include <unordered_map>        // for std::unordered_map
+#include <unordered_set>        // for std::unordered_set
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include <Logging.h>            // for the logging functions
@@ -11,6 +12,23 @@
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/GlEnums.h"
 #include "Graphics/IGraphicsResource.h"
+#include "Utils/HashHelpers.h"
+
+/// <summary>
+/// Identifies a uniform by a hash of it's name, so that we can look up uniform locations without
+/// building or comparing strings. When constructed from a string literal the hash can be computed at compile
+/// time, for hot paths declare the ID as constexpr to guarantee this:
+///
+/// static constexpr UniformId U_MVP = UniformId("u_MVP");
+/// </summary>
+struct UniformId {
+	uint64_t    Hash;
+	// The name the ID was made from, only valid for as long as the source string
+	const char* Name;
+
+	constexpr UniformId(const char* name) : Hash(HashHelpers::Fnv1a(name)), Name(name) { }
+	UniformId(const std::string& name) : Hash(HashHelpers::Fnv1a(name)), Name(name.c_str()) { }
+};
 
 /// <summary>
 /// This class will wrap around an OpenGL shader program
@@ -24,6 +42,30 @@ public:
 		return std::make_shared<ShaderProgram>();
 	}
 
+	/// <summary>
+	/// True if linked programs should be stored to and loaded from the on-disk binary cache. When enabled,
+	/// shader parts are not compiled until Link, so that we can skip compilation entirely on a cache hit
+	/// </summary>
+	inline static bool        BinaryCacheEnabled = true;
+	/// <summary>
+	/// The directory that program binaries are stored in
+	/// </summary>
+	inline static std::string BinaryCachePath = "cache/shaders/";
+	/// <summary>
+	/// True if ReloadChangedShaders should check for modified shader files
+	/// </summary>
+	inline static bool        HotReloadEnabled = true;
+	/// <summary>
+	/// The minimum time between checks for modified shader files, in seconds
+	/// </summary>
+	inline static float       HotReloadInterval = 1.0f;
+
+	/// <summary>
+	/// Checks for shader files that have changed on disk, and rebuilds only the programs that use them (directly
+	/// or through an #include). Should be called once per frame from the GL thread
+	/// </summary>
+	static void ReloadChangedShaders();
+
 public:
 	// Stores information about a uniform in the shader
 	struct UniformInfo {
@@ -71,6 +113,7 @@ public:
 
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// If the binary cache is enabled, compilation is deferred until Link and this will always succeed
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -93,11 +136,18 @@ public:
 	void RegisterVaryings(const char* const* names, int numVaryings, bool interleaved = true);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. If the
+	/// binary cache has a program built from the same sources, it will be loaded instead
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
 
+	/// <summary>
+	/// Reloads all of this program's shader parts from their sources and links the program again
+	/// </summary>
+	/// <returns>True if the program was rebuilt successfully</returns>
+	bool Reload();
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -109,6 +159,24 @@ public:
 
 	const std::unordered_map<std::string, UniformInfo>& GetUniforms() const { return _uniforms; }
 
+	/// <summary>
+	/// Gets the location of a uniform by it's hashed name
+	/// </summary>
+	/// <param name="id">The ID of the uniform to find</param>
+	/// <returns>The uniform location, or -1 if the program does not have an active uniform with the given name</returns>
+	int GetUniformLocation(UniformId id) const {
+		// Our table is always at least twice as large as the number of uniforms, so this will almost always hit on the first probe
+		if (!_uniformTable.empty()) {
+			const size_t mask = _uniformTable.size() - 1;
+			for (size_t ix = id.Hash & mask; _uniformTable[ix].Hash != 0; ix = (ix + 1) & mask) {
+				if (_uniformTable[ix].Hash == id.Hash) {
+					return _uniformTable[ix].Location;
+				}
+			}
+		}
+		return -1;
+	}
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
@@ -147,30 +215,30 @@ public:
 	void SetUniform(int location, ShaderDataType type, void* data, int count = 1, bool transposed = false);
 
 	template <typename T>
-	void SetUniform(const std::string& name, const T& value) {
-		int location = __GetUniformLocation(name);
+	void SetUniform(UniformId id, const T& value) {
+		int location = GetUniformLocation(id);
 		if (location != -1) {
 			SetUniform(location, &value, 1);
 		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+			LOG_WARN("Ignoring uniform \"{}\"", id.Name);
 		}
 	}
 	template <typename T>
-	void SetUniform(const std::string& name, const T* values, int count = 1) {
-		int location = __GetUniformLocation(name);
+	void SetUniform(UniformId id, const T* values, int count = 1) {
+		int location = GetUniformLocation(id);
 		if (location != -1) {
-			SetUniform(location, &values, count);
+			SetUniform(location, values, count);
 		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+			LOG_WARN("Ignoring uniform \"{}\"", id.Name);
 		}
 	}
 	template <typename T>
-	void SetUniformMatrix(const std::string& name, const T& value, bool transposed = false) {
-		int location = __GetUniformLocation(name);
+	void SetUniformMatrix(UniformId id, const T& value, bool transposed = false) {
+		int location = GetUniformLocation(id);
 		if (location != -1) {
 			SetUniformMatrix(location, &value, 1, transposed);
 		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+			LOG_WARN("Ignoring uniform \"{}\"", id.Name);
 		}
 	}
 	
@@ -185,6 +253,13 @@ protected:
 	std::unordered_map<std::string, UniformInfo> _uniforms;
 	std::unordered_map<std::string, UniformBlockInfo> _uniformBlocks;
 
+	// Open addressed table mapping name hashes to uniform locations, a hash of 0 marks an empty slot
+	struct UniformSlot {
+		uint64_t Hash     = 0;
+		int      Location = -1;
+	};
+	std::vector<UniformSlot> _uniformTable;
+
 	// Stores information about the source of our shader parts
 	// EX: if a VS shader is loaded from a file, will contain
 	// the file path, and IsFilePath=true
@@ -194,6 +269,47 @@ protected:
 	};
 	std::unordered_map<ShaderPartType, ShaderSource> _fileSourceMap;
 
+	// All shader programs that are currently alive, so that we can find the ones to rebuild when files change
+	inline static std::unordered_set<ShaderProgram*> _livePrograms;
+
+	// The include-resolved source for shader parts that have not been compiled yet
+	std::unordered_map<ShaderPartType, std::string> _pendingSources;
+	// The transform feedback varyings, these are part of the cache key and need to be re-applied if we fall back to compiling
+	std::vector<std::string> _varyings;
+	bool                     _interleavedVaryings = true;
+
+	// Will be put at the start of program binary files
+	struct BinaryHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'S', 'B', 'I', 'N' };
+		uint32_t Version      = 0;
+		GLenum   BinaryFormat = 0;
+		uint32_t BinarySize   = 0;
+	};
+	// The latest version of the binary file format
+	static const uint32_t BINARY_CACHE_VERSION = 0x01;
+
+	/// <summary>
+	/// Compiles a shader part and stores it's handle for linking
+	/// </summary>
+	bool _CompilePart(const char* source, ShaderPartType type);
+	/// <summary>
+	/// Gets a hash of everything that affects the linked program, including the driver that built it
+	/// </summary>
+	uint64_t _GetBinaryHash() const;
+	/// <summary>
+	/// Gets the path that a program binary with the given hash is stored at
+	/// </summary>
+	static std::string _GetBinaryPath(uint64_t hash);
+	/// <summary>
+	/// Attempts to load this program from the binary cache, returns true if the program is linked and ready
+	/// </summary>
+	bool _TryLoadBinary(uint64_t hash);
+	/// <summary>
+	/// Stores this program's binary in the cache, must be called after a successful link
+	/// </summary>
+	void _SaveBinary(uint64_t hash);
+
 	/// <summary>
 	/// Performs program introspection, where we examine the uniforms that
 	/// the program contains
@@ -208,6 +324,8 @@ protected:
 	/// fed data from a uniform buffer
 	/// </summary>
 	void _IntrospectUnifromBlocks();
-
-	int __GetUniformLocation(const std::string& name);
+	/// <summary>
+	/// Builds the uniform hash table from the uniforms found during introspection
+	/// </summary>
+	void _BuildUniformTable();
 };
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "Graphics/ShaderSourceCache.h"
+#include <string_view>
+#include <cctype>
+#include <algorithm>
+#include <Logging.h>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
+
+namespace fs = std::filesystem;
+
+const std::string& ShaderSourceCache::Resolve(const std::string& filename) {
+	static const std::string empty;
+
+	std::string key = NormalizePath(filename);
+	SourceFile* file = _GetFile(key);
+	if (file == nullptr) {
+		return empty;
+	}
+
+	// If we've already resolved this file as a root, we can re-use the result
+	if (file->Resolved.empty()) {
+		std::string result;
+		std::unordered_set<std::string> included = { key };
+		_Append(key, included, result);
+		file->Resolved = std::move(result);
+	}
+	return file->Resolved;
+}
+
+const std::string& ShaderSourceCache::GetFileName(int fileId) {
+	static const std::string empty;
+	return (fileId > 0 && fileId < (int)_idToPath.size()) ? _idToPath[fileId] : empty;
+}
+
+std::string ShaderSourceCache::AnnotateLog(const std::string& log) {
+	std::string result;
+	result.reserve(log.size());
+
+	size_t start = 0;
+	while (start < log.size()) {
+		size_t end = log.find('\n', start);
+		end = end == std::string::npos ? log.size() : end + 1;
+		std::string_view line(log.data() + start, end - start);
+
+		// Drivers report locations as either "id(line)" or "id:line", we look for the first one on the line
+		for (size_t ix = 0; ix < line.size(); ix++) {
+			if (!isdigit(line[ix]) || (ix > 0 && isdigit(line[ix - 1]))) {
+				continue;
+			}
+			size_t seek = ix;
+			int fileId = 0;
+			while (seek < line.size() && isdigit(line[seek])) {
+				fileId = fileId * 10 + (line[seek++] - '0');
+			}
+			if (seek + 1 >= line.size() || (line[seek] != '(' && line[seek] != ':') || !isdigit(line[seek + 1])) {
+				continue;
+			}
+			seek++;
+			int lineNumber = 0;
+			while (seek < line.size() && isdigit(line[seek])) {
+				lineNumber = lineNumber * 10 + (line[seek++] - '0');
+			}
+
+			const std::string& path = GetFileName(fileId);
+			if (!path.empty()) {
+				result += path + "(" + std::to_string(lineNumber) + "): ";
+			}
+			break;
+		}
+
+		result += line;
+		start = end;
+	}
+	return result;
+}
+
+std::unordered_set<std::string> ShaderSourceCache::GetDependents(const std::string& filename) {
+	// Build the reverse of our include graph, so we can walk from a file to everything that includes it
+	std::unordered_map<std::string, std::vector<std::string>> includedBy;
+	for (const auto& [path, file] : _files) {
+		for (const auto& include : file.Includes) {
+			includedBy[include].push_back(path);
+		}
+	}
+
+	std::unordered_set<std::string> result;
+	std::vector<std::string> toVisit = { NormalizePath(filename) };
+	while (!toVisit.empty()) {
+		std::string path = std::move(toVisit.back());
+		toVisit.pop_back();
+		if (result.insert(path).second) {
+			auto it = includedBy.find(path);
+			if (it != includedBy.end()) {
+				toVisit.insert(toVisit.end(), it->second.begin(), it->second.end());
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<std::string> ShaderSourceCache::GetIncludes(const std::string& filename) {
+	std::string key = NormalizePath(filename);
+	std::unordered_set<std::string> visited = { key };
+	std::vector<std::string> toVisit = { key };
+	while (!toVisit.empty()) {
+		std::string path = std::move(toVisit.back());
+		toVisit.pop_back();
+		SourceFile* file = _GetFile(path);
+		if (file == nullptr) {
+			continue;
+		}
+		for (const auto& include : file->Includes) {
+			if (visited.insert(include).second) {
+				toVisit.push_back(include);
+			}
+		}
+	}
+
+	visited.erase(key);
+	std::vector<std::string> result(visited.begin(), visited.end());
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+std::unordered_set<std::string> ShaderSourceCache::PollChanges() {
+	std::vector<std::string> changed;
+	for (const auto& [path, file] : _files) {
+		fs::file_time_type writeTime;
+		if (!VirtualFileSystem::GetWriteTime(path, writeTime) || writeTime != file.WriteTime) {
+			changed.push_back(path);
+		}
+	}
+
+	std::unordered_set<std::string> result;
+	for (const auto& path : changed) {
+		std::unordered_set<std::string> dependents = GetDependents(path);
+		result.insert(dependents.begin(), dependents.end());
+	}
+
+	// Anything that includes a changed file needs to be resolved again, and the changed files need to be re-read
+	for (const auto& path : result) {
+		auto it = _files.find(path);
+		if (it != _files.end()) {
+			it->second.Resolved.clear();
+		}
+	}
+	for (const auto& path : changed) {
+		_files.erase(path);
+	}
+
+	return result;
+}
+
+void ShaderSourceCache::Clear() {
+	_files.clear();
+}
+
+std::string ShaderSourceCache::NormalizePath(const std::string& path) {
+	return fs::path(path).lexically_normal().generic_string();
+}
+
+ShaderSourceCache::SourceFile* ShaderSourceCache::_GetFile(const std::string& path) {
+	SourceFile& file = _files[path];
+	if (file.IsLoaded) {
+		return &file;
+	}
+
+	if (!VirtualFileSystem::Exists(path)) {
+		LOG_ERROR("Shader source \"{}\" does not exist", path);
+		_files.erase(path);
+		return nullptr;
+	}
+
+	// Assign an ID if this is the first time we've seen the file, ID 0 is left for the root source string
+	if (_idToPath.empty()) {
+		_idToPath.push_back("");
+	}
+	auto idIt = _pathToId.find(path);
+	if (idIt == _pathToId.end()) {
+		idIt = _pathToId.emplace(path, (int)_idToPath.size()).first;
+		_idToPath.push_back(path);
+	}
+	file.Id = idIt->second;
+	VirtualFileSystem::GetWriteTime(path, file.WriteTime);
+
+	std::string contents = FileHelpers::ReadFile(path);
+	const fs::path folder = fs::path(path).parent_path();
+
+	// The token we're looking for, and it's length
+	const char* includeToken = "#include";
+	const size_t includeTokenLen = const_strlen(includeToken);
+
+	// Split the file into segments at each #include
+	Segment current = { 1, "", "" };
+	uint32_t lineNumber = 0;
+	size_t seek = 0;
+	while (seek < contents.size()) {
+		size_t eol = contents.find('\n', seek);
+		eol = eol == std::string::npos ? contents.size() : eol;
+		std::string line = contents.substr(seek, eol - seek);
+		seek = eol + 1;
+		lineNumber++;
+
+		std::string trimmed = line;
+		StringTools::Trim(trimmed);
+
+		// Our #line directives can't come before the #version, so everything up to it goes into the preamble
+		if (file.Preamble.empty() && trimmed.compare(0, 8, "#version") == 0) {
+			file.Preamble = current.Text + line + "\n";
+			current = { lineNumber + 1, "", "" };
+		}
+		else if (trimmed.compare(0, includeTokenLen, includeToken) == 0) {
+			// Snip out the path, and trim whitespace and any quotes
+			std::string includePath = trimmed.substr(includeTokenLen);
+			StringTools::Trim(includePath);
+			StringTools::Trim(includePath, '"');
+
+			// If it starts with '/', relative to application directory, otherwise relative to the current file
+			fs::path target = (!includePath.empty() && includePath[0] == '/') ? fs::path(includePath) : folder / includePath;
+			current.Include = NormalizePath(target.string());
+			file.Includes.push_back(current.Include);
+
+			file.Segments.push_back(std::move(current));
+			current = { lineNumber + 1, "", "" };
+		}
+		else {
+			current.Text += line;
+			current.Text += "\n";
+		}
+	}
+	if (!current.Text.empty()) {
+		file.Segments.push_back(std::move(current));
+	}
+
+	file.IsLoaded = true;
+	return &file;
+}
+
+void ShaderSourceCache::_Append(const std::string& path, std::unordered_set<std::string>& included, std::string& output) {
+	SourceFile* file = _GetFile(path);
+	if (file == nullptr) {
+		return;
+	}
+
+	output += file->Preamble;
+
+	for (const auto& segment : file->Segments) {
+		if (!segment.Text.empty()) {
+			if (EmitLineDirectives) {
+				output += "#line " + std::to_string(segment.StartLine) + " " + std::to_string(file->Id) + "\n";
+			}
+			output += segment.Text;
+		}
+		// Each file is only included once
+		if (!segment.Include.empty() && included.insert(segment.Include).second) {
+			_Append(segment.Include, included, output);
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+/// <summary>
+/// Loads shader source files and resolves their #include directives, reading each file from disk only once
+///
+/// Every file that passes through the cache is assigned an ID, which is used as the source string number in
+/// the #line directives we emit, so that driver errors like "3(12)" can be mapped back to the right file with
+/// AnnotateLog. The cache also records which files include which, so that when a file changes on disk we
+/// can find every root shader that needs to be rebuilt
+/// </summary>
+class ShaderSourceCache {
+public:
+	/// <summary>
+	/// True if #line directives should be inserted around included files
+	/// </summary>
+	inline static bool EmitLineDirectives = true;
+
+	/// <summary>
+	/// Gets the contents of a shader file, with all of it's includes resolved. Each file will only be included
+	/// once, any further #includes of the same file are removed
+	/// </summary>
+	/// <param name="filename">The path of the root file to load</param>
+	/// <returns>The resolved source, or an empty string if the file could not be read</returns>
+	static const std::string& Resolve(const std::string& filename);
+
+	/// <summary>
+	/// Gets the path of the file with the given source string number, or an empty string if there is no such file
+	/// </summary>
+	/// <param name="fileId">The source string number from a #line directive or driver error</param>
+	static const std::string& GetFileName(int fileId);
+
+	/// <summary>
+	/// Rewrites a shader compiler log so that source string numbers are replaced with the files they refer to
+	/// </summary>
+	/// <param name="log">The info log from the driver</param>
+	/// <returns>The log, with each line that refers to a known file prefixed with "path(line):"</returns>
+	static std::string AnnotateLog(const std::string& log);
+
+	/// <summary>
+	/// Gets all the files that depend on the given file, either directly or through other includes. The file
+	/// itself is included in the result
+	/// </summary>
+	/// <param name="filename">The path of the file to get the dependents of</param>
+	static std::unordered_set<std::string> GetDependents(const std::string& filename);
+
+	/// <summary>
+	/// Gets all the files that the given file includes, either directly or through other includes. The file
+	/// will be loaded if it is not already in the cache, and is not included in the result
+	/// </summary>
+	/// <param name="filename">The path of the file to get the includes of</param>
+	/// <returns>The normalized paths of all included files, sorted</returns>
+	static std::vector<std::string> GetIncludes(const std::string& filename);
+
+	/// <summary>
+	/// Checks all cached files for changes on disk, and drops any stale files and resolved sources from the cache
+	/// </summary>
+	/// <returns>The normalized paths of all changed files, along with every file that depends on them</returns>
+	static std::unordered_set<std::string> PollChanges();
+
+	/// <summary>
+	/// Removes all files from the cache, file IDs are preserved
+	/// </summary>
+	static void Clear();
+
+	/// <summary>
+	/// Gets the key that the cache uses for a given path
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+protected:
+	ShaderSourceCache() = default;
+	~ShaderSourceCache() = default;
+
+	// A run of lines from a file, optionally followed by an #include
+	struct Segment {
+		// The line number in the file of the first line in Text
+		uint32_t    StartLine;
+		std::string Text;
+		// The normalized path of the file included after this segment, or empty if there is none
+		std::string Include;
+	};
+
+	struct SourceFile {
+		int                             Id = -1;
+		std::filesystem::file_time_type WriteTime;
+		// Everything up to and including the #version line, since #line can't come before it
+		std::string                     Preamble;
+		std::vector<Segment>            Segments;
+		// The files directly included by this file
+		std::vector<std::string>        Includes;
+		// The fully resolved source when this file is used as a root, empty if it has not been resolved
+		std::string                     Resolved;
+		bool                            IsLoaded = false;
+	};
+
+	inline static std::unordered_map<std::string, SourceFile> _files;
+	// Maps IDs back to paths, IDs are never reused so that old logs stay meaningful
+	inline static std::vector<std::string>                   _idToPath;
+	inline static std::unordered_map<std::string, int>       _pathToId;
+
+	/// <summary>
+	/// Gets the cache entry for a file, reading and parsing it if required
+	/// </summary>
+	static SourceFile* _GetFile(const std::string& path);
+	/// <summary>
+	/// Appends the contents of a file (and it's includes) to the output
+	/// </summary>
+	static void _Append(const std::string& path, std::unordered_set<std::string>& included, std::string& output);
+};
@@ -0,0 +1,194 @@
+#include "Graphics/TextLayoutCache.h"
+#include "Utils/HashHelpers.h"
+
+/// <summary>
+/// Advances the pen position past a character, applying kerning with the previous character in the line
+/// </summary>
+inline float AdvancePen(const Font::Sptr& font, const std::wstring& text, size_t lineStart, size_t index, float pen) {
+	wchar_t c = text[index];
+	if (c == '\r') {
+		return 0.0f;
+	} else if (c == '\t') {
+		return pen + font->GetGlyph(' ', 0.0f, 0.0f).OffsetX * 4;
+	} else {
+		if (index > lineStart && text[index - 1] != '\r' && text[index - 1] != '\t') {
+			pen += font->GetKerning(text[index - 1], c);
+		}
+		return font->GetGlyph(c, pen, 0.0f).OffsetX;
+	}
+}
+
+const TextLayoutCache::Layout& TextLayoutCache::Get(const std::wstring& text, const Font::Sptr& font, float scale, const glm::vec4& color, TextAlignment alignment, float maxWidth) {
+	static Layout empty;
+	if (font == nullptr) {
+		return empty;
+	}
+
+	// Hash everything that affects the layout
+	const Font* fontPtr = font.get();
+	uint64_t hash = HashHelpers::Fnv1a(text.data(), text.size() * sizeof(wchar_t));
+	hash = HashHelpers::Fnv1a(&fontPtr, sizeof(fontPtr), hash);
+	hash = HashHelpers::Fnv1a(&scale, sizeof(float), hash);
+	hash = HashHelpers::Fnv1a(&color, sizeof(glm::vec4), hash);
+	hash = HashHelpers::Fnv1a(&alignment, sizeof(TextAlignment), hash);
+	hash = HashHelpers::Fnv1a(&maxWidth, sizeof(float), hash);
+
+	auto range = _lookup.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++) {
+		Entry& entry = *it->second;
+		if (entry.Text == text && entry.FontRef.lock() == font && entry.Scale == scale && entry.Color == color &&
+			entry.Alignment == alignment && entry.MaxWidth == maxWidth) {
+			// Move to the front of the list, so it's the last to get evicted
+			_entries.splice(_entries.begin(), _entries, it->second);
+			return entry.Result;
+		}
+	}
+
+	_entries.push_front({ hash, text, font, scale, color, alignment, maxWidth, Build(text, font, scale, color, alignment, maxWidth) });
+	_lookup.emplace(hash, _entries.begin());
+	_glyphCount += _entries.front().Result.Vertices.size() / 4;
+	_Evict();
+
+	return _entries.front().Result;
+}
+
+TextLayoutCache::Layout TextLayoutCache::Build(const std::wstring& text, const Font::Sptr& font, float scale, const glm::vec4& color, TextAlignment alignment, float maxWidth) {
+	Layout result;
+	if (font == nullptr) {
+		return result;
+	}
+	result.Atlas = font->GetAtlas();
+	result.IsDistanceField = font->IsDistanceField();
+
+	// Wrapping is done before scaling
+	float limit = scale > 0.0f ? maxWidth / scale : 0.0f;
+
+	// Split the text into lines on newlines, and at the last space before a line gets too wide
+	struct Line {
+		size_t Start;
+		size_t End;
+		float  Width;
+	};
+	std::vector<Line> lines;
+	size_t lineStart = 0;
+	size_t lastSpace = std::wstring::npos;
+	float pen = 0.0f;
+	for (size_t ix = 0; ix < text.size(); ix++) {
+		if (text[ix] == '\n') {
+			lines.push_back({ lineStart, ix, 0.0f });
+			lineStart = ix + 1;
+			lastSpace = std::wstring::npos;
+			pen = 0.0f;
+			continue;
+		}
+
+		pen = AdvancePen(font, text, lineStart, ix, pen);
+		if (limit > 0.0f && pen > limit && lastSpace != std::wstring::npos) {
+			lines.push_back({ lineStart, lastSpace, 0.0f });
+			lineStart = lastSpace + 1;
+			lastSpace = std::wstring::npos;
+
+			// Measure the part of the word that's been carried over to the new line
+			pen = 0.0f;
+			for (size_t carry = lineStart; carry <= ix; carry++) {
+				pen = AdvancePen(font, text, lineStart, carry, pen);
+			}
+		}
+		if (text[ix] == ' ') {
+			lastSpace = ix;
+		}
+	}
+	lines.push_back({ lineStart, text.size(), 0.0f });
+
+	// Measure each line so we can align them
+	float blockWidth = 0.0f;
+	for (Line& line : lines) {
+		pen = 0.0f;
+		for (size_t ix = line.Start; ix < line.End; ix++) {
+			pen = AdvancePen(font, text, line.Start, ix, pen);
+			line.Width = glm::max(line.Width, pen);
+		}
+		blockWidth = glm::max(blockWidth, line.Width);
+	}
+	float alignWidth = limit > 0.0f ? limit : blockWidth;
+
+	result.Vertices.reserve(text.size() * 4);
+	float lineHeight = font->GetLineHeight();
+	float firstLineHeight = 0.0f;
+
+	VertexPosColTex verts[4];
+	for (int ix = 0; ix < 4; ix++) {
+		verts[ix].Color = color;
+	}
+
+	for (size_t lineIx = 0; lineIx < lines.size(); lineIx++) {
+		const Line& line = lines[lineIx];
+		float alignOffset = 0.0f;
+		switch (alignment) {
+			case TextAlignment::Center: alignOffset = (alignWidth - line.Width) / 2.0f; break;
+			case TextAlignment::Right:  alignOffset = alignWidth - line.Width; break;
+			default: break;
+		}
+		glm::vec2 origin = glm::vec2(alignOffset, lineIx * lineHeight);
+
+		pen = 0.0f;
+		for (size_t ix = line.Start; ix < line.End; ix++) {
+			wchar_t c = text[ix];
+			float nextPen = AdvancePen(font, text, line.Start, ix, pen);
+
+			// Control characters only move the pen
+			if (c != '\r' && c != '\t') {
+				// The pen was moved past the kerning before the glyph was placed
+				float kerning = (ix > line.Start && text[ix - 1] != '\r' && text[ix - 1] != '\t') ? font->GetKerning(text[ix - 1], c) : 0.0f;
+				GlyphInfo glyph = font->GetGlyph(c, pen + kerning, 0.0f);
+				glm::vec2 offset = origin + glm::vec2(pen + kerning, 0.0f);
+
+				for (int vert = 0; vert < 4; vert++) {
+					verts[vert].Position = glm::vec3((offset + glyph.Positions[vert]) * scale, 0.0f);
+					verts[vert].UV = glyph.UVs[vert];
+				}
+				result.Vertices.insert(result.Vertices.end(), verts, verts + 4);
+
+				if (lineIx == 0) {
+					firstLineHeight = glm::max(firstLineHeight, -glyph.Positions[1].y);
+				}
+			}
+			pen = nextPen;
+		}
+	}
+
+	// Height is measured the same way as Font::MeausureString, from the top of the first line to the
+	// baseline of the last
+	result.Size = glm::vec2(limit > 0.0f ? limit : blockWidth, firstLineHeight + (lines.size() - 1) * lineHeight) * scale;
+	return result;
+}
+
+void TextLayoutCache::Clear() {
+	_entries.clear();
+	_lookup.clear();
+	_glyphCount = 0;
+}
+
+size_t TextLayoutCache::GetLayoutCount() {
+	return _entries.size();
+}
+
+size_t TextLayoutCache::GetGlyphCount() {
+	return _glyphCount;
+}
+
+void TextLayoutCache::_Evict() {
+	// We always keep the most recent layout, since a reference to it is about to be returned
+	while (_glyphCount > MaxCachedGlyphs && _entries.size() > 1) {
+		auto last = std::prev(_entries.end());
+		auto range = _lookup.equal_range(last->Hash);
+		for (auto it = range.first; it != range.second; it++) {
+			if (it->second == last) {
+				_lookup.erase(it);
+				break;
+			}
+		}
+		_glyphCount -= last->Result.Vertices.size() / 4;
+		_entries.erase(last);
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <list>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+#include <EnumToString.h>
+
+#include "Graphics/Font.h"
+#include "Graphics/VertexTypes.h"
+
+/// <summary>
+/// How lines of text are aligned within a block of text
+/// </summary>
+ENUM(TextAlignment, int,
+	 Left   = 0,
+	 Center = 1,
+	 Right  = 2
+);
+
+/// <summary>
+/// Positions the glyphs for strings of text ahead of time, and remembers the results so that text that
+/// doesn't change between frames doesn't need to be laid out again. Layouts are looked up by the text,
+/// font, scale, color and layout settings, and the least recently used layouts are evicted once the
+/// total number of cached glyphs goes over MaxCachedGlyphs
+/// </summary>
+class TextLayoutCache {
+public:
+	/// <summary>
+	/// The pre-positioned glyphs for a string of text
+	/// </summary>
+	struct Layout {
+		// Four vertices per glyph, relative to the origin of the first line's baseline, with Z set to 0
+		std::vector<VertexPosColTex> Vertices;
+		// The size of the text block, after scaling
+		glm::vec2                    Size = glm::vec2(0.0f);
+		// The texture that the glyphs are drawn from
+		Texture2D::Sptr              Atlas;
+		// True if the atlas stores distance fields instead of coverage, see Font::SetDistanceField
+		bool                         IsDistanceField = false;
+	};
+
+	// The maximum number of glyphs to keep across all cached layouts
+	inline static size_t MaxCachedGlyphs = 65536;
+
+	/// <summary>
+	/// Gets the layout for a string of text, building it if it's not in the cache. The result is only valid
+	/// until the next call to Get or Clear
+	/// </summary>
+	/// <param name="text">The unicode text to lay out</param>
+	/// <param name="font">The font to render with</param>
+	/// <param name="scale">The scaling to apply to the text</param>
+	/// <param name="color">The color of the text</param>
+	/// <param name="alignment">How to align each line within the text block</param>
+	/// <param name="maxWidth">The width in pixels at which lines are broken between words, or 0 to disable wrapping</param>
+	static const Layout& Get(const std::wstring& text, const Font::Sptr& font, float scale, const glm::vec4& color, TextAlignment alignment = TextAlignment::Left, float maxWidth = 0.0f);
+	/// <summary>
+	/// Lays out a string of text without caching the result, see Get for parameters
+	/// </summary>
+	static Layout Build(const std::wstring& text, const Font::Sptr& font, float scale, const glm::vec4& color, TextAlignment alignment = TextAlignment::Left, float maxWidth = 0.0f);
+
+	/// <summary>
+	/// Removes all cached layouts, should be invoked if a font's glyphs change
+	/// </summary>
+	static void Clear();
+	/// <summary>
+	/// Gets the number of layouts in the cache
+	/// </summary>
+	static size_t GetLayoutCount();
+	/// <summary>
+	/// Gets the total number of glyphs in all cached layouts
+	/// </summary>
+	static size_t GetGlyphCount();
+
+protected:
+	TextLayoutCache() = default;
+	~TextLayoutCache() = default;
+
+	struct Entry {
+		uint64_t            Hash;
+		std::wstring        Text;
+		// Weak so we can tell if a font was deleted and another was allocated at the same address
+		std::weak_ptr<Font> FontRef;
+		float               Scale;
+		glm::vec4           Color;
+		TextAlignment       Alignment;
+		float               MaxWidth;
+		Layout              Result;
+	};
+
+	// Most recently used layouts are at the front
+	inline static std::list<Entry>                                       _entries;
+	inline static std::unordered_multimap<uint64_t, std::list<Entry>::iterator> _lookup;
+	inline static size_t                                                 _glyphCount = 0;
+
+	static void _Evict();
+};
@@ -0,0 +1,298 @@
+#include "Graphics/Textures/AsyncTextureLoader.h"
+
+#include <stb_image.h>
+#include <GLFW/glfw3.h>
+
+#include "Logging.h"
+
+AsyncTextureLoader::Stats AsyncTextureLoader::_stats = AsyncTextureLoader::Stats();
+
+void AsyncTextureLoader::Init(uint32_t numWorkers) {
+	if (_isRunning) {
+		return;
+	}
+
+	// STBI's flip flag is a global, every loader in the project sets it to true so we set it once here
+	// before the workers start, rather than having our workers write to it concurrently
+	stbi_set_flip_vertically_on_load(true);
+
+	// Leave one core for the GL thread
+	if (numWorkers == 0) {
+		uint32_t cores = std::thread::hardware_concurrency();
+		numWorkers = cores > 1 ? cores - 1 : 1;
+	}
+
+	// Create the placeholder that pending textures will bind
+	Texture2DDescription desc = Texture2DDescription();
+	desc.Width  = 1;
+	desc.Height = 1;
+	desc.Format = InternalFormat::RGBA8;
+	desc.GenerateMipMaps = false;
+	desc.MinificationFilter = MinFilter::Nearest;
+	desc.MagnificationFilter = MagFilter::Nearest;
+	_placeholder = std::make_shared<Texture2D>(desc);
+	glm::u8vec4 texel = glm::u8vec4(glm::clamp(PlaceholderColor, 0.0f, 1.0f) * 255.0f);
+	_placeholder->LoadData(1, 1, PixelFormat::RGBA, PixelType::UByte, &texel);
+	_placeholder->SetDebugName("Async Texture Placeholder");
+
+	_CreatePixelBuffer();
+
+	_isRunning = true;
+	_workers.reserve(numWorkers);
+	for (uint32_t ix = 0; ix < numWorkers; ix++) {
+		_workers.emplace_back(_WorkerMain);
+	}
+
+	LOG_INFO("Started async texture loader with {} workers", numWorkers);
+}
+
+void AsyncTextureLoader::Shutdown() {
+	if (!_isRunning) {
+		return;
+	}
+
+	// Signal the workers and wait for them to finish what they are doing
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isRunning = false;
+		_jobs.clear();
+	}
+	_jobAvailable.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+
+	// Throw away anything we never got around to uploading
+	_results.clear();
+
+	for (auto& [id, texture] : _waiting) {
+		texture->_loadState = TextureLoadState::Failed;
+		texture->_asyncJobId = 0;
+	}
+	_waiting.clear();
+
+	_DestroyPixelBuffer();
+	_placeholder = nullptr;
+}
+
+bool AsyncTextureLoader::IsRunning() {
+	return _isRunning;
+}
+
+void AsyncTextureLoader::Update() {
+	if (!_isRunning) {
+		return;
+	}
+
+	// Let go of the staging ranges the GPU has finished with, without waiting on any
+	while (!_stagedRanges.empty() && glClientWaitSync(_stagedRanges.front().Fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+		glDeleteSync(_stagedRanges.front().Fence);
+		_stagedRanges.pop_front();
+	}
+
+	double startTime = glfwGetTime();
+	const double budget = UploadBudgetMs / 1000.0;
+	const bool wasBusy = !_waiting.empty();
+
+	while (true) {
+		DecodeResult result;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_results.empty()) {
+				break;
+			}
+			result = std::move(_results.front());
+			_results.pop_front();
+		}
+
+		_Upload(result);
+
+		// We always upload at least one image, so the budget is checked after the upload
+		if (glfwGetTime() - startTime >= budget) {
+			break;
+		}
+	}
+
+	// Report our timings whenever the queue drains
+	if (wasBusy && _waiting.empty()) {
+		LOG_INFO("Async texture queue drained: {} loaded, {} failed, {:.2f}ms decoding, {:.2f}ms uploading, {:.2f}ms max latency",
+			_stats.Completed, _stats.Failed, _stats.DecodeMs, _stats.UploadMs, _stats.MaxLatencyMs);
+	}
+}
+
+void AsyncTextureLoader::Flush() {
+	while (_isRunning && !_waiting.empty()) {
+		std::deque<DecodeResult> results;
+		{
+			// Wait for at least one image to be decoded, then grab everything that's ready
+			std::unique_lock<std::mutex> lock(_mutex);
+			_resultAvailable.wait(lock, [] { return !_results.empty() || !_isRunning; });
+			results.swap(_results);
+		}
+		for (auto& result : results) {
+			_Upload(result);
+		}
+	}
+}
+
+size_t AsyncTextureLoader::GetPendingCount() {
+	return _waiting.size();
+}
+
+uint64_t AsyncTextureLoader::_Enqueue(Texture2D* texture, const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips) {
+	uint64_t id = _nextJobId++;
+	_waiting[id] = texture;
+	_stats.Queued++;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back({ id, filename, targetChannels, generateMips, gammaCorrectMips, glfwGetTime() });
+	}
+	_jobAvailable.notify_one();
+	return id;
+}
+
+void AsyncTextureLoader::_Cancel(uint64_t jobId) {
+	// The worker may still decode the image, but the result will be discarded since we are no longer waiting on it
+	if (_waiting.erase(jobId) > 0) {
+		_stats.Cancelled++;
+	}
+}
+
+void AsyncTextureLoader::_Upload(DecodeResult& result) {
+	auto it = _waiting.find(result.Id);
+
+	// Texture was destroyed while we were decoding, nothing to do
+	if (it == _waiting.end()) {
+		return;
+	}
+
+	Texture2D* texture = it->second;
+	_waiting.erase(it);
+	texture->_asyncJobId = 0;
+	_stats.DecodeMs += result.DecodeMs;
+
+	if (!result.Image.IsValid()) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", texture->_description.Filename);
+		texture->_loadState = TextureLoadState::Failed;
+		_stats.Failed++;
+		return;
+	}
+
+	double startTime = glfwGetTime();
+	texture->_UploadCooked(result.Image, UsePixelBuffers);
+	double endTime = glfwGetTime();
+
+	_stats.Completed++;
+	_stats.UploadMs += (endTime - startTime) * 1000.0;
+	_stats.MaxLatencyMs = glm::max(_stats.MaxLatencyMs, (endTime - result.QueuedTime) * 1000.0);
+	_stats.BytesUploaded += result.Image.GetTotalSize();
+}
+
+uint8_t* AsyncTextureLoader::_StagePixels(size_t size, size_t& offset) {
+	if (_pixelBufferData == nullptr || size == 0 || size > _pixelBufferCapacity) {
+		return nullptr;
+	}
+
+	// Keep each range aligned so every level's offset is valid for any pixel type
+	const size_t alignment = 16;
+	offset = (_pixelBufferHead + alignment - 1) & ~(alignment - 1);
+	if (offset + size > _pixelBufferCapacity) {
+		offset = 0;
+	}
+
+	// Find the newest upload that still overlaps our range, fences signal in order so once it's done
+	// so are all of the uploads before it
+	int lastOverlap = -1;
+	for (int ix = 0; ix < (int)_stagedRanges.size(); ix++) {
+		const StagedRange& range = _stagedRanges[ix];
+		if (range.Offset < offset + size && offset < range.Offset + range.Size) {
+			lastOverlap = ix;
+		}
+	}
+	if (lastOverlap >= 0) {
+		// These are normally from earlier frames and already complete, so this rarely waits
+		GLenum status = glClientWaitSync(_stagedRanges[lastOverlap].Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+		if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+			LOG_WARN("Timed out waiting for a pixel buffer range, uploading directly");
+			return nullptr;
+		}
+		for (int ix = 0; ix <= lastOverlap; ix++) {
+			glDeleteSync(_stagedRanges.front().Fence);
+			_stagedRanges.pop_front();
+		}
+	}
+
+	_pixelBufferHead = offset + size;
+	return _pixelBufferData + offset;
+}
+
+void AsyncTextureLoader::_FenceStaged(size_t offset, size_t size) {
+	_stagedRanges.push_back({ offset, size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+}
+
+void AsyncTextureLoader::_CreatePixelBuffer() {
+	if (PixelBufferSize == 0) {
+		return;
+	}
+
+	// The buffer stays mapped for it's whole life, coherent mapping means we don't need to flush our writes
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &_pixelBuffer);
+	glNamedBufferStorage(_pixelBuffer, PixelBufferSize, nullptr, flags);
+	_pixelBufferData = reinterpret_cast<uint8_t*>(glMapNamedBufferRange(_pixelBuffer, 0, PixelBufferSize, flags));
+	if (_pixelBufferData == nullptr) {
+		LOG_WARN("Failed to map the texture upload buffer, textures will be uploaded directly");
+		glDeleteBuffers(1, &_pixelBuffer);
+		_pixelBuffer = 0;
+		return;
+	}
+	_pixelBufferCapacity = PixelBufferSize;
+	_pixelBufferHead = 0;
+}
+
+void AsyncTextureLoader::_DestroyPixelBuffer() {
+	for (const StagedRange& range : _stagedRanges) {
+		glDeleteSync(range.Fence);
+	}
+	_stagedRanges.clear();
+
+	if (_pixelBuffer != 0) {
+		glUnmapNamedBuffer(_pixelBuffer);
+		glDeleteBuffers(1, &_pixelBuffer);
+	}
+	_pixelBuffer = 0;
+	_pixelBufferData = nullptr;
+	_pixelBufferCapacity = 0;
+	_pixelBufferHead = 0;
+}
+
+void AsyncTextureLoader::_WorkerMain() {
+	while (true) {
+		DecodeJob job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobAvailable.wait(lock, [] { return !_jobs.empty() || !_isRunning; });
+			if (!_isRunning) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		// Decoding (or reading the cooked file) is the expensive part, and only touches CPU memory, so we can do it off the GL thread
+		DecodeResult result = DecodeResult();
+		result.Id = job.Id;
+		result.QueuedTime = job.QueuedTime;
+		double startTime = glfwGetTime();
+		result.Image = TextureCache::LoadImage2D(job.Filename, job.TargetChannels, job.GenerateMips, job.GammaCorrectMips);
+		result.DecodeMs = (glfwGetTime() - startTime) * 1000.0;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_results.push_back(std::move(result));
+		}
+		_resultAvailable.notify_all();
+	}
+}
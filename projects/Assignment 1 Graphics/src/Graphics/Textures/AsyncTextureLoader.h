@@ -0,0 +1,194 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "Graphics/Textures/Texture2D.h"
+
+/// <summary>
+/// Decodes texture files (or loads them from the TextureCache) on a pool of worker threads, and
+/// uploads them to OpenGL on the main thread within a per-frame time budget. Textures that are waiting on their data
+/// will bind a small placeholder texture instead
+///
+/// Workers never touch OpenGL or the texture objects themselves, they only decode the file
+/// into CPU memory. All uploads happen during Update, which must be called from the GL thread
+/// </summary>
+class AsyncTextureLoader {
+public:
+	/// <summary>
+	/// Statistics on the textures that have gone through the loader
+	/// </summary>
+	struct Stats {
+		// The number of textures that have been queued for loading
+		uint32_t Queued        = 0;
+		// The number of textures that finished uploading
+		uint32_t Completed     = 0;
+		// The number of textures that failed to decode
+		uint32_t Failed        = 0;
+		// The number of textures that were destroyed before they finished loading
+		uint32_t Cancelled     = 0;
+		// The total time spent decoding images on worker threads, in milliseconds
+		double   DecodeMs      = 0.0;
+		// The total time spent uploading images on the GL thread, in milliseconds
+		double   UploadMs      = 0.0;
+		// The longest time from a texture being queued to it being ready, in milliseconds
+		double   MaxLatencyMs  = 0.0;
+		// The total number of bytes of decoded image data that have been uploaded
+		size_t   BytesUploaded = 0;
+	};
+
+	/// <summary>
+	/// The amount of time per frame (in milliseconds) that Update may spend uploading textures. At
+	/// least one texture is always uploaded per frame so that large images can't stall the queue
+	/// </summary>
+	inline static float UploadBudgetMs   = 2.0f;
+	/// <summary>
+	/// True if uploads should be staged through a persistently mapped pixel buffer ring, letting
+	/// the driver perform the transfer to the GPU asynchronously
+	/// </summary>
+	inline static bool  UsePixelBuffers  = true;
+	/// <summary>
+	/// The size of the pixel buffer ring in bytes, takes effect on the next Init. Images larger
+	/// than this are uploaded directly
+	/// </summary>
+	inline static size_t PixelBufferSize = 32 * 1024 * 1024;
+	/// <summary>
+	/// The color of the placeholder texture that is bound while textures are loading
+	/// </summary>
+	inline static glm::vec4 PlaceholderColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+
+	/// <summary>
+	/// Starts up the worker threads and creates the placeholder texture, requires an OpenGL context
+	/// </summary>
+	/// <param name="numWorkers">The number of decode threads to use, or 0 to pick based on the CPU</param>
+	static void Init(uint32_t numWorkers = 0);
+	/// <summary>
+	/// Stops all worker threads and drops any textures that are still loading, these will be
+	/// left in the Failed state
+	/// </summary>
+	static void Shutdown();
+	/// <summary>
+	/// Returns true if the loader has been initialized and can accept textures
+	/// </summary>
+	static bool IsRunning();
+
+	/// <summary>
+	/// Uploads decoded textures to OpenGL until the upload budget has been used up, should be
+	/// called once per frame from the GL thread
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Blocks until all textures in the queue have been decoded and uploaded
+	/// </summary>
+	static void Flush();
+
+	/// <summary>
+	/// Gets the number of textures that have been queued but are not ready yet
+	/// </summary>
+	static size_t GetPendingCount();
+	/// <summary>
+	/// Returns true if there are no textures waiting to be loaded
+	/// </summary>
+	static bool IsIdle() { return GetPendingCount() == 0; }
+	/// <summary>
+	/// Gets the loading statistics since startup or the last call to ResetStats
+	/// </summary>
+	static const Stats& GetStats() { return _stats; }
+	/// <summary>
+	/// Resets the loading statistics
+	/// </summary>
+	static void ResetStats() { _stats = Stats(); }
+
+	/// <summary>
+	/// Gets the texture that should be bound in place of textures that have not finished loading
+	/// </summary>
+	static const Texture2D::Sptr& GetPlaceholder() { return _placeholder; }
+
+protected:
+	friend class Texture2D;
+
+	AsyncTextureLoader() = default;
+	~AsyncTextureLoader() = default;
+
+	// A request to decode a file, these are consumed by the worker threads
+	struct DecodeJob {
+		uint64_t    Id;
+		std::string Filename;
+		int         TargetChannels;
+		bool        GenerateMips;
+		bool        GammaCorrectMips;
+		double      QueuedTime;
+	};
+
+	// A decoded image waiting to be uploaded on the GL thread
+	struct DecodeResult {
+		uint64_t                    Id;
+		TextureCache::CookedTexture Image;
+		double                      QueuedTime;
+		double                      DecodeMs;
+	};
+
+	inline static std::vector<std::thread>   _workers;
+	inline static std::mutex                 _mutex;
+	inline static std::condition_variable    _jobAvailable;
+	inline static std::condition_variable    _resultAvailable;
+	inline static std::deque<DecodeJob>      _jobs;
+	inline static std::deque<DecodeResult>   _results;
+	// Read on the main thread without holding the lock, Shutdown still clears it under the lock so that the
+	// workers' wait predicates can't miss it
+	inline static std::atomic<bool>          _isRunning = false;
+
+	// A range of the pixel buffer ring that the GPU may still be reading from
+	struct StagedRange {
+		size_t Offset;
+		size_t Size;
+		GLsync Fence;
+	};
+
+	// Only touched from the GL thread, maps job IDs to the textures waiting on them
+	inline static std::unordered_map<uint64_t, Texture2D*> _waiting;
+	inline static uint64_t                   _nextJobId = 1;
+	static Stats                             _stats;
+	inline static Texture2D::Sptr            _placeholder;
+
+	// The persistently mapped pixel buffer that uploads are staged through, GL thread only
+	inline static GLuint                     _pixelBuffer = 0;
+	inline static uint8_t*                   _pixelBufferData = nullptr;
+	inline static size_t                     _pixelBufferCapacity = 0;
+	inline static size_t                     _pixelBufferHead = 0;
+	// In the order they were submitted, so the oldest ranges are at the front
+	inline static std::deque<StagedRange>    _stagedRanges;
+
+	/// <summary>
+	/// Queues a texture to have it's file decoded, returns the ID of the job
+	/// </summary>
+	static uint64_t _Enqueue(Texture2D* texture, const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips);
+	/// <summary>
+	/// Cancels a job, called when a texture is destroyed before it's data has arrived
+	/// </summary>
+	static void _Cancel(uint64_t jobId);
+	/// <summary>
+	/// Uploads a single decoded result to it's texture
+	/// </summary>
+	static void _Upload(DecodeResult& result);
+	/// <summary>
+	/// Reserves space in the pixel buffer ring, waiting for the GPU to finish with any earlier uploads in that
+	/// space. The range must be handed to _FenceStaged once the upload commands have been issued
+	/// </summary>
+	/// <param name="size">The number of bytes to reserve</param>
+	/// <param name="offset">Receives the offset of the range within the pixel buffer</param>
+	/// <returns>A pointer to write the pixel data to, or nullptr if the ring is unavailable or too small</returns>
+	static uint8_t* _StagePixels(size_t size, size_t& offset);
+	/// <summary>
+	/// Marks a range returned by _StagePixels as in use until the commands issued so far are complete
+	/// </summary>
+	static void _FenceStaged(size_t offset, size_t size);
+	static void _CreatePixelBuffer();
+	static void _DestroyPixelBuffer();
+
+	static void _WorkerMain();
+};
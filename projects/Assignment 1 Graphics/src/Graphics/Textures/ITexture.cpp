@@ -43,6 +43,21 @@ void ITexture::Clear(const glm::vec4& color) {
 	}
 }
 
+size_t ITexture::_CalcStorageSize(InternalFormat format, uint32_t width, uint32_t height, uint32_t depth, bool hasMips) {
+	const size_t texelSize = GetInternalFormatSize(format);
+	size_t result = 0;
+	while (true) {
+		result += (size_t)width * height * depth * texelSize;
+		if (!hasMips || (width == 1 && height == 1 && depth == 1)) {
+			break;
+		}
+		width  = glm::max(width  / 2, 1u);
+		height = glm::max(height / 2, 1u);
+		depth  = glm::max(depth  / 2, 1u);
+	}
+	return result;
+}
+
 GlResourceType ITexture::GetResourceClass() const {
 	return GlResourceType::Texture;
 }
@@ -7,6 +7,16 @@
 #include "Graphics/IGraphicsResource.h"
 #include "Graphics/GLenums.h"
 
+/// <summary>
+/// Represents whether a texture's image data has been loaded, textures that are
+/// being loaded asynchronously will be Pending until their data is uploaded
+/// </summary>
+ENUM(TextureLoadState, int,
+	 Ready   = 0,
+	 Pending = 1,
+	 Failed  = 2
+);
+
 /// <summary>
 /// The abstract base class for all our textures that we'll be implementing
 /// </summary>
@@ -48,6 +58,16 @@ public:
 	/// <param name="color">The color to clear to</param>
 	void Clear(const glm::vec4& color);
 
+	/// <summary>
+	/// Gets whether this texture's data is loaded, textures that load synchronously
+	/// are always Ready (or Failed)
+	/// </summary>
+	virtual TextureLoadState GetLoadState() const { return TextureLoadState::Ready; }
+	/// <summary>
+	/// Returns true if this texture's data has finished loading
+	/// </summary>
+	bool IsLoaded() const { return GetLoadState() == TextureLoadState::Ready; }
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
@@ -60,6 +80,17 @@ protected:
 	/// </summary>
 	virtual void _Recreate();
 
+	/// <summary>
+	/// Estimates the number of bytes needed to store a texture with the given dimensions and format,
+	/// including it's mip chain if it has one
+	/// </summary>
+	/// <param name="format">The internal format of the texture</param>
+	/// <param name="width">The width of the top level, in texels</param>
+	/// <param name="height">The height of the top level, or 1 for 1D textures</param>
+	/// <param name="depth">The depth of the top level, or 1 for 1D and 2D textures</param>
+	/// <param name="hasMips">True if the texture has a full mip chain</param>
+	static size_t _CalcStorageSize(InternalFormat format, uint32_t width, uint32_t height, uint32_t depth, bool hasMips);
+
 	TextureType _type; // The type for this texture, mainly used for debugging
 
 // STATIC SECTION
@@ -1,6 +1,7 @@
 #include "Texture1D.h"
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
 #include <stb_image.h>
 
 inline int CalcRequiredMipLevels(int size) {
@@ -128,9 +129,10 @@ void Texture1D::_LoadDataFromFile()
 		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// Use STBI to load the image
+		// Use STBI to load the image, the file may be in an asset pack so we decode it from memory
 		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
+		FileView file = VirtualFileSystem::Open(_description.Filename);
+		uint8_t* data = file ? stbi_load_from_memory(file.Data(), static_cast<int>(file.Size()), &width, &height, &numChannels, targetChannels) : nullptr;
 
 		// If we could not load any data, warn and return null
 		if (data == nullptr) {
@@ -112,6 +112,7 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture1D::Sptr FromJson(const nlohmann::json& data);
+	virtual size_t GetGpuMemoryUsage() const override { return _CalcStorageSize(_description.Format, _description.Size, 1, 1, _description.GenerateMipMaps); }
 
 protected:
 	Texture1DDescription _description;
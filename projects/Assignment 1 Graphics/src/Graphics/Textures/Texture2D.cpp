@@ -4,6 +4,7 @@
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Graphics/Textures/AsyncTextureLoader.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -23,6 +24,8 @@ nlohmann::json Texture2D::ToJson() const {
 		{ "filter_mag",       ~_description.MagnificationFilter },
 		{ "anisotropic",       _description.MaxAnisotropic },
 		{ "generate_mipmaps",  _description.GenerateMipMaps },
+		{ "async",             _description.LoadAsync },
+		{ "gamma_correct_mips", _description.GammaCorrectMips },
 	};
 
 	if (!_description.Filename.empty()) {
@@ -55,6 +58,8 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.MaxAnisotropic      = JsonGet(data, "anisotropic", 0.0f);
 	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", false);
+	descr.LoadAsync           = JsonGet(data, "async", false);
+	descr.GammaCorrectMips    = JsonGet(data, "gamma_correct_mips", true);
 
 	Texture2D::Sptr result = std::make_shared<Texture2D>(descr);
 
@@ -73,10 +78,26 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	return result;
 }
 
+void Texture2D::Prefetch(const nlohmann::json& data)
+{
+	std::string filename = JsonGet<std::string>(data, "filename", "");
+	// Async textures are decoded by the async loader, so prefetching them would only decode them twice
+	if (JsonGet(data, "async", false) && AsyncTextureLoader::IsRunning()) {
+		return;
+	}
+	if (!filename.empty()) {
+		// FromJson never overrides the format hint, so we use the same default the description does
+		const int targetChannels = GetTexelComponentCount(Texture2DDescription().FormatHint);
+		TextureCache::PrefetchImage2D(filename, targetChannels, JsonGet(data, "generate_mipmaps", false), JsonGet(data, "gamma_correct_mips", true));
+	}
+}
+
 Texture2D::Texture2D(const Texture2DDescription& description) : 
 	ITexture(TextureType::_2D),
 	_description(description),
-	_pixelType(PixelType::Unknown)
+	_pixelType(PixelType::Unknown),
+	_loadState(TextureLoadState::Ready),
+	_asyncJobId(0)
 {
 	_SetTextureParams();
 	if (!description.Filename.empty()) {
@@ -84,16 +105,43 @@ Texture2D::Texture2D(const Texture2DDescription& description) :
 	}
 }
 
-Texture2D::Texture2D(const std::string& filePath) : 
+Texture2D::Texture2D(const std::string& filePath, bool loadAsync, bool gammaCorrectMips) : 
 	ITexture(TextureType::_2D),
 	_description(Texture2DDescription()),
-	_pixelType(PixelType::Unknown)
+	_pixelType(PixelType::Unknown),
+	_loadState(TextureLoadState::Ready),
+	_asyncJobId(0)
 {
 	_description.Filename = filePath;
+	_description.LoadAsync = loadAsync;
+	_description.GammaCorrectMips = gammaCorrectMips;
 	_SetTextureParams();
 	_LoadDataFromFile();
 }
 
+Texture2D::~Texture2D() {
+	// Make sure the loader doesn't try and upload into us after we're gone
+	if (_asyncJobId != 0) {
+		AsyncTextureLoader::_Cancel(_asyncJobId);
+		_asyncJobId = 0;
+	}
+}
+
+void Texture2D::Bind(int slot) {
+	if (_loadState == TextureLoadState::Pending && AsyncTextureLoader::GetPlaceholder() != nullptr) {
+		AsyncTextureLoader::GetPlaceholder()->Bind(slot);
+	} else {
+		ITexture::Bind(slot);
+	}
+}
+
+uint32_t Texture2D::GetHandle() const {
+	if (_loadState == TextureLoadState::Pending && AsyncTextureLoader::GetPlaceholder() != nullptr) {
+		return AsyncTextureLoader::GetPlaceholder()->GetHandle();
+	}
+	return ITexture::GetHandle();
+}
+
 void Texture2D::SetMinFilter(MinFilter value) {
 	if (_description.MultisampleCount == 1) {
 		_description.MinificationFilter = value;
@@ -118,7 +166,8 @@ void Texture2D::SetAnisoLevel(float value) {
 		_description.MaxAnisotropic = glm::clamp(value, 1.0f, ITexture::GetLimits().MAX_ANISOTROPY);
 		glTextureParameterf(_rendererId, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 
-		if (_description.GenerateMipMaps) {
+		// Textures that are still loading have no storage yet, they'll generate mips once uploaded
+		if (_description.GenerateMipMaps && _loadState == TextureLoadState::Ready) {
 			glGenerateTextureMipmap(_rendererId);
 		}
 	}
@@ -135,10 +184,11 @@ void Texture2D::LoadData(uint32_t width, uint32_t height, PixelFormat format, Pi
 	// Align the data store to the size of a single component to ensure we don't get weirdness with images that aren't RGBA
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 	int componentSize = (GLint)GetTexelComponentSize(type);
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
 
 	// Upload our data to our image
 	glTextureSubImage2D(_rendererId, 0, offsetX, offsetY, width, height, (GLenum)format, (GLenum)type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
 	// If requested, generate mip-maps for our texture
 	if (_description.GenerateMipMaps) {
@@ -150,53 +200,91 @@ void Texture2D::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
 		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// Use STBI to load the image
+		// Hand the file off to the worker threads, we'll get our data during a later AsyncTextureLoader::Update
+		if (_description.LoadAsync && AsyncTextureLoader::IsRunning()) {
+			_loadState = TextureLoadState::Pending;
+			_asyncJobId = AsyncTextureLoader::_Enqueue(this, _description.Filename, targetChannels, _description.GenerateMipMaps, _description.GammaCorrectMips);
+			SetDebugName(_description.Filename);
+			return;
+		}
+
+		// Use the texture cache to load the image, this will skip decoding and mip generation if
+		// we have already cooked this file
 		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
+		TextureCache::CookedTexture image = TextureCache::LoadImage2D(_description.Filename, targetChannels, _description.GenerateMipMaps, _description.GammaCorrectMips);
 
 		// If we could not load any data, warn and return null
-		if (data == nullptr) {
+		if (!image.IsValid()) {
 			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
+			_loadState = TextureLoadState::Failed;
 			return ;
 		}
 
-		// We should estimate a good format for our data
+		_UploadCooked(image);
+	}
+	
+	SetDebugName(_description.Filename);
+}
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+void Texture2D::_UploadCooked(const TextureCache::CookedTexture& image, bool usePixelBuffer) {
+	const TextureCache::MipLevel& base = image.Levels[0];
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	// Update our description to match what we loaded
+	_description.Format = image.Format;
+	_description.FormatHint = image.Layout;
+	_description.Width = base.Width;
+	_description.Height = base.Height;
+	_pixelType = image.ComponentType;
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+	// Allocates our memory
+	_SetTextureParams();
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+	// Only upload as many levels as we allocated storage for
+	const int allocatedLevels = _description.GenerateMipMaps ? CalcRequiredMipLevels(base.Width, base.Height) : 1;
+	const int numLevels = glm::min(allocatedLevels, static_cast<int>(image.Levels.size()));
 
-		// Allocates our memory
-		_SetTextureParams();
+	// Cooked data is tightly packed, so we can't rely on the default 4 byte row alignment
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+	// Copy the levels into the loader's mapped pixel buffer ring, the driver can then DMA them into the texture
+	// without blocking us, while we go on to fill the next range of the ring
+	size_t totalSize = 0;
+	for (int ix = 0; ix < numLevels; ix++) {
+		totalSize += image.Levels[ix].Data.size();
+	}
+	size_t stagedOffset = 0;
+	uint8_t* staged = usePixelBuffer ? AsyncTextureLoader::_StagePixels(totalSize, stagedOffset) : nullptr;
+
+	if (staged != nullptr) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, AsyncTextureLoader::_pixelBuffer);
+
+		size_t offset = 0;
+		for (int ix = 0; ix < numLevels; ix++) {
+			const TextureCache::MipLevel& level = image.Levels[ix];
+			memcpy(staged + offset, level.Data.data(), level.Data.size());
+			glTextureSubImage2D(_rendererId, ix, 0, 0, level.Width, level.Height, *image.Layout, *image.ComponentType, reinterpret_cast<const void*>(stagedOffset + offset));
+			offset += level.Data.size();
+		}
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		AsyncTextureLoader::_FenceStaged(stagedOffset, totalSize);
+	} else {
+		for (int ix = 0; ix < numLevels; ix++) {
+			const TextureCache::MipLevel& level = image.Levels[ix];
+			glTextureSubImage2D(_rendererId, ix, 0, 0, level.Width, level.Height, *image.Layout, *image.ComponentType, level.Data.data());
+		}
 	}
-	
-	SetDebugName(_description.Filename);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// If the image didn't come with a full mip chain, let the GPU fill in the rest
+	if (numLevels < allocatedLevels) {
+		glGenerateTextureMipmap(_rendererId);
+	}
+
+	_loadState = TextureLoadState::Ready;
 }
 
 void Texture2D::_SetTextureParams() {
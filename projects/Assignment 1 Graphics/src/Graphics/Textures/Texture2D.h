@@ -1,5 +1,6 @@
 #pragma once
 #include "ITexture.h"
+#include "Graphics/Textures/TextureCache.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -60,6 +61,19 @@ struct Texture2DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the file should be decoded on a worker thread by the AsyncTextureLoader, the
+	/// texture will have no size and bind a placeholder until the data arrives. Ignored if
+	/// the loader is not running
+	/// </summary>
+	bool           LoadAsync;
+
+	/// <summary>
+	/// True if the image holds sRGB encoded color, so mips generated on the CPU are averaged in linear
+	/// space. Should be false for linear data such as normal, specular, roughness or displacement maps
+	/// </summary>
+	bool           GammaCorrectMips;
+
 	Texture2DDescription() :
 		Width(0), Height(0),
 		Format(InternalFormat::Unknown),
@@ -71,7 +85,9 @@ struct Texture2DDescription {
 		GenerateMipMaps(true),
 		MultisampleCount(1),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		LoadAsync(false),
+		GammaCorrectMips(true)
 	{ }
 };
 
@@ -80,10 +96,10 @@ public:
 	DEFINE_RESOURCE(Texture2D)
 
 	// Make sure we mark our destructor as virtual so base class is called
-	virtual ~Texture2D() = default;
+	virtual ~Texture2D();
 
 public:
-	Texture2D(const std::string& filePath);
+	Texture2D(const std::string& filePath, bool loadAsync = false, bool gammaCorrectMips = true);
 	Texture2D(const Texture2DDescription& description);
 
 	/// <summary>
@@ -141,12 +157,35 @@ public:
 	/// </summary>
 	const Texture2DDescription& GetDescription() const { return _description; }
 
+	// Inherited from ITexture
+
+	virtual TextureLoadState GetLoadState() const override { return _loadState; }
+	/// <summary>
+	/// Binds this texture to the given slot, or the placeholder texture if we are still loading
+	/// </summary>
+	virtual void Bind(int slot) override;
+	/// <summary>
+	/// Gets the OpenGL handle for this texture, or the placeholder's if we are still loading
+	/// </summary>
+	virtual uint32_t GetHandle() const override;
+
 	virtual nlohmann::json ToJson() const override;
 	static Texture2D::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Does the CPU side of loading a texture from it's JSON data (decoding, cooking) and stages the result
+	/// in the TextureCache, so that FromJson can skip straight to uploading. Safe to call from worker threads
+	/// </summary>
+	static void Prefetch(const nlohmann::json& data);
+	virtual size_t GetGpuMemoryUsage() const override { return _CalcStorageSize(_description.Format, _description.Width, _description.Height, 1, _description.GenerateMipMaps); }
 
 protected:
+	friend class AsyncTextureLoader;
+
 	Texture2DDescription _description;
 	PixelType _pixelType;
+	TextureLoadState _loadState;
+	// The ID of our job in the AsyncTextureLoader, or 0 if we are not waiting on one
+	uint64_t _asyncJobId;
 
 	/// <summary>
 	/// Loads this texture from the file specified in the description
@@ -154,6 +193,13 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Allocates storage for and uploads a cooked image and it's mip levels, updating our description to match.
+	/// If the image does not contain mips and we want them, they will be generated on the GPU
+	/// </summary>
+	/// <param name="image">The image to upload</param>
+	/// <param name="usePixelBuffer">True to stage the data through the AsyncTextureLoader's pixel buffer ring</param>
+	void _UploadCooked(const TextureCache::CookedTexture& image, bool usePixelBuffer = false);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
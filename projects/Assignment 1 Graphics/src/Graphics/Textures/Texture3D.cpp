@@ -2,16 +2,93 @@
 #include "Utils/Base64.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 #include <Logging.h>
 #include <stb_image.h>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <cstring>
+#include <cmath>
 
 inline int CalcRequiredMipLevels(int width, int height, int depth) {
 	return (1 + floor(log2(std::max(width, std::max(height, depth)))));
 }
 
+namespace {
+	// Fast helpers for parsing the contents of .cube files, these work directly on the file buffer so we
+	// don't pay for a string and stringstream per line (LUTs can easily have hundreds of thousands of lines)
+
+	inline bool IsBlank(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// Moves to the start of the next line
+	inline const char* SkipLine(const char* p, const char* end) {
+		while (p < end && *p != '\n') { p++; }
+		return p < end ? p + 1 : end;
+	}
+
+	inline const char* SkipBlanks(const char* p, const char* end) {
+		while (p < end && IsBlank(*p)) { p++; }
+		return p;
+	}
+
+	// Parses a decimal number with an optional sign, fraction and exponent, returns false if there is no number at p
+	bool ParseFloat(const char*& p, const char* end, float& result) {
+		p = SkipBlanks(p, end);
+		const char* start = p;
+
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+
+		double value = 0.0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			value = value * 10.0 + (*p - '0');
+			p++;
+		}
+		if (p < end && *p == '.') {
+			p++;
+			double scale = 0.1;
+			while (p < end && *p >= '0' && *p <= '9') {
+				value += (*p - '0') * scale;
+				scale *= 0.1;
+				p++;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			p++;
+			bool negExp = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negExp = *p == '-';
+				p++;
+			}
+			int exponent = 0;
+			while (p < end && *p >= '0' && *p <= '9') {
+				exponent = exponent * 10 + (*p - '0');
+				p++;
+			}
+			value *= std::pow(10.0, negExp ? -exponent : exponent);
+		}
+
+		result = static_cast<float>(negative ? -value : value);
+		return p != start;
+	}
+
+	// Checks if the text at p starts with the given keyword followed by whitespace, and moves past it if so
+	inline bool MatchKeyword(const char*& p, const char* end, const char* keyword) {
+		size_t len = strlen(keyword);
+		if (static_cast<size_t>(end - p) > len && strncmp(p, keyword, len) == 0 && IsBlank(p[len])) {
+			p += len;
+			return true;
+		}
+		return false;
+	}
+}
+
 Texture3D::Texture3D(const std::string& filePath) : 
 	ITexture(TextureType::_3D),
 	_description(Texture3DDescription()),
@@ -26,9 +103,11 @@ Texture3D::Texture3D(const Texture3DDescription& description) :
 	_description(description),
 	_pixelType(PixelType::Unknown)
 {
-	_SetTextureParams();
+	// If we're loading from a file, it will determine our size
 	if (!description.Filename.empty()) {
 		_LoadDataFromFile();
+	} else {
+		_SetTextureParams();
 	}
 }
 
@@ -74,6 +153,7 @@ nlohmann::json Texture3D::ToJson() const
 		{ "filter_min",       ~_description.MinificationFilter },
 		{ "filter_mag",       ~_description.MagnificationFilter },
 		{ "generate_mipmaps",  _description.GenerateMipMaps },
+		{ "internal_format",  ~_description.Format },
 	};
 
 	if (!_description.Filename.empty()) {
@@ -114,6 +194,7 @@ Texture3D::Sptr Texture3D::FromJson(const nlohmann::json& data)
 	description.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	description.GenerateMipMaps = JsonGet(data, "generate_mipmaps", false);
 	description.FormatHint = JsonParseEnum(PixelFormat, data, "format", PixelFormat::Unknown);
+	description.Format = JsonParseEnum(InternalFormat, data, "internal_format", InternalFormat::Unknown);
 
 	Texture3D::Sptr result = std::make_shared<Texture3D>(description);
 
@@ -147,123 +228,195 @@ void Texture3D::_LoadDataFromFile()
 	}
 }
 
-void Texture3D::_LoadCubeFile()
+void Texture3D::Prefetch(const nlohmann::json& data)
 {
-	std::ifstream inFile(_description.Filename);
-
-	if (!inFile.is_open()) {
-		LOG_WARN("Failed to open file .cube file: {}", _description.Filename);
+	std::string filename = JsonGet<std::string>(data, "filename", "");
+	std::string extension = std::filesystem::path(filename).extension().string();
+	StringTools::ToLower(extension);
+	if (extension.compare(".cube") != 0) {
 		return;
 	}
 
-	glm::u8vec3* textureData = nullptr;
-	uint32_t lutSize{ 0 };
-	uint32_t ix{ 0 };
-	glm::vec3 rgb { 0, 0, 0 };
-
-	std::string line;
-	// Iterate as long as we have lines from the file
-	while (std::getline(inFile, line)) {
-
-		// Trim whitespace from start and end of the line
-		StringTools::Trim(line);
+	InternalFormat format = _GetLutFormat(JsonParseEnum(InternalFormat, data, "internal_format", InternalFormat::Unknown));
+	const bool generateMips = JsonGet(data, "generate_mipmaps", false);
+	TextureCache::Prefetch({ filename }, _GetLutVariant(format, generateMips), [&]() {
+		std::string title;
+		return _CookLut(filename, format, generateMips, title);
+	});
+}
 
-		// Skip empty lines
-		if (line.empty()) {
-			continue;
-		}
+InternalFormat Texture3D::_GetLutFormat(InternalFormat requested)
+{
+	// Only formats we know how to fill from a LUT are allowed
+	InternalFormat format = requested == InternalFormat::Unknown ? DefaultLutFormat : requested;
+	if (format != InternalFormat::RGB8 && format != InternalFormat::RGB10A2 && format != InternalFormat::RGB16F) {
+		LOG_WARN("Format {} is not supported for LUTs, using {}", format, DefaultLutFormat);
+		format = DefaultLutFormat;
+	}
+	return format;
+}
 
-		// Skip comments
-		else if (line[0] == '#') {
-			continue;
-		}
+std::string Texture3D::_GetLutVariant(InternalFormat format, bool generateMips)
+{
+	// We can only generate mips for 8 bit LUTs on the CPU, higher precision LUTs get their mips from the driver
+	const bool cookMips = generateMips && format == InternalFormat::RGB8;
+	return "3d-lut:" + std::to_string(*format) + (cookMips ? ":mips" : "");
+}
 
-		// Handle sizing the LUT
-		else if (line.find("LUT_3D_SIZE") != std::string::npos) {
+TextureCache::CookedTexture Texture3D::_CookLut(const std::string& filename, InternalFormat format, bool generateMips, std::string& title)
+{
+	TextureCache::CookedTexture result = _ParseCubeFile(filename, format, title);
+	// LUTs store linear data, so we never want to gamma correct them
+	if (generateMips && format == InternalFormat::RGB8 && result.IsValid()) {
+		TextureCache::GenerateMipChain(result, false);
+	}
+	return result;
+}
 
-			// Skip over the LUT_3D_SIZE text and read in the value
-			std::stringstream lReader(line.substr(12));
-			lReader >> lutSize;
+void Texture3D::_LoadCubeFile()
+{
+	InternalFormat format = _GetLutFormat(_description.Format);
+	const bool generateMips = _description.GenerateMipMaps;
+	std::string title;
 
-			// Update the description's size
-			_description.Width = _description.Height = _description.Depth = lutSize;
+	// Parsing the text LUT is slow for large tables, so we go through the cache, which also stores the parsed data in the format we want
+	TextureCache::CookedTexture image = TextureCache::LoadOrCook({ _description.Filename }, _GetLutVariant(format, generateMips), [&]() {
+		return _CookLut(_description.Filename, format, generateMips, title);
+	});
 
-			// If the size we read is non-zero, allocate our data!
-			if (lutSize > 0) {
-				// If we had data already, delete it
-				if (textureData != nullptr) {
-					delete[] textureData;
-				} 
+	if (!image.IsValid()) {
+		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
+		return;
+	}
 
-				// Allocate data to store texels in
-				textureData = new glm::u8vec3[(size_t)lutSize * lutSize * lutSize];
-				ix = 0;
-			}
-		}
+	// The title only exists in the source file, so fall back to the file name if we loaded from the cache
+	SetDebugName(title.empty() ? std::filesystem::path(_description.Filename).filename().string() : title);
 
-		// We'll grab the title for our debug name, nice lil use of it
-		else if (line.find("TITLE") != std::string::npos) {
+	// Update the description's size and format
+	_description.Width = _description.Height = _description.Depth = image.Levels[0].Width;
+	_description.Format = image.Format;
+	_description.FormatHint = image.Layout;
+	_pixelType = image.ComponentType;
+	// We need to clamp to edge for LUTS
+	_description.WrapS = _description.WrapT = _description.WrapR = WrapMode::ClampToEdge;
 
-			// Skip over the TITLE token and the space after it
-			std::string name = line.substr(6);
+	// Allocate data and configure params
+	_SetTextureParams();
 
-			// Trim any excess whitespace
-			StringTools::Trim(name);
+	// Upload each level of the chain, our rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	const uint32_t numLevels = generateMips ? glm::min(static_cast<uint32_t>(image.Levels.size()), TextureCache::CalcMipLevels(_description.Width, _description.Height, _description.Depth)) : 1;
+	for (uint32_t level = 0; level < numLevels; level++) {
+		const TextureCache::MipLevel& data = image.Levels[level];
+		glTextureSubImage3D(_rendererId, level, 0, 0, 0, data.Width, data.Height, data.Depth, *image.Layout, *image.ComponentType, data.Data.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-			// We'll store this in the debug name
-			SetDebugName(name);
-		}
+	// Let the driver build any levels that weren't cooked
+	if (generateMips && numLevels == 1) {
+		glGenerateTextureMipmap(_rendererId);
+	}
+}
 
-		else if (line.find("DOMAIN_MIN") != std::string::npos)
-		{ /* ignore for now */ }
+TextureCache::CookedTexture Texture3D::_ParseCubeFile(const std::string& filename, InternalFormat format, std::string& title)
+{
+	TextureCache::CookedTexture result;
 
-		else if (line.find("DOMAIN_MAX") != std::string::npos)
-		{ /* ignore for now */ }
+	// Grab the whole file in one go, we'll parse directly out of the view
+	FileView file = VirtualFileSystem::Open(filename);
+	if (!file) {
+		LOG_WARN("Failed to open file .cube file: {}", filename);
+		return result;
+	}
+	std::string_view buffer = file.AsString();
 
-		else if (line.find("LUT_1D_SIZE") != std::string::npos)
-		{ /* ignore for now */ }
+	const bool isFloat = format != InternalFormat::RGB8;
+	const size_t texelSize = isFloat ? sizeof(glm::vec3) : sizeof(glm::u8vec3);
 
-		// Reading data lines
-		else if (!line.empty() && textureData != nullptr) {
+	uint32_t lutSize{ 0 };
+	size_t numTexels{ 0 };
+	size_t ix{ 0 };
+	uint8_t* texels = nullptr;
+
+	const char* p = buffer.data();
+	const char* end = p + buffer.size();
+	while (p < end) {
+		p = SkipBlanks(p, end);
+
+		// Skip empty lines and comments
+		if (p >= end || *p == '\n' || *p == '#') {
+			p = SkipLine(p, end);
+			continue;
+		}
 
-			// Make sure we don't case a write access violation
-			if (ix >= (lutSize * lutSize * lutSize) && lutSize > 0) {
-				LOG_ASSERT(false, "Attempting to write outside the bounds of the LUT");
+		// Data lines are by far the most common, so check for them first
+		if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.') {
+			glm::vec3 rgb;
+			if (texels != nullptr && ParseFloat(p, end, rgb.r) && ParseFloat(p, end, rgb.g) && ParseFloat(p, end, rgb.b)) {
+				// Make sure we don't cause a write access violation
+				if (ix >= numTexels) {
+					LOG_ASSERT(false, "Attempting to write outside the bounds of the LUT");
+					break;
+				}
+
+				rgb = glm::clamp(rgb, glm::vec3(0), glm::vec3(1));
+				if (isFloat) {
+					reinterpret_cast<glm::vec3*>(texels)[ix] = rgb;
+				} else {
+					// Convert to the correct scale for bytes
+					reinterpret_cast<glm::u8vec3*>(texels)[ix] = glm::u8vec3(rgb * 255.0f);
+				}
+
+				// Move to the next texel
+				ix++;
 			}
+		}
 
-			// Read RGB from the line
-			std::stringstream lReader(line);
-			lReader >> rgb.r >> rgb.g >> rgb.b;
+		// Handle sizing the LUT
+		else if (MatchKeyword(p, end, "LUT_3D_SIZE")) {
+			float size = 0.0f;
+			ParseFloat(p, end, size);
+			lutSize = static_cast<uint32_t>(size);
 
-			rgb = glm::clamp(rgb, glm::vec3(0), glm::vec3(1));
+			// If the size we read is non-zero, allocate data to store texels in
+			if (lutSize > 0) {
+				numTexels = (size_t)lutSize * lutSize * lutSize;
+				result.Levels.resize(1);
+				result.Levels[0].Width = result.Levels[0].Height = result.Levels[0].Depth = lutSize;
+				result.Levels[0].Data.assign(numTexels * texelSize, 0);
+				texels = result.Levels[0].Data.data();
+				ix = 0;
+			}
+		}
 
-			// Store in the array, converting to the correct scale for bytes
-			textureData[ix].r = static_cast<uint8_t>(rgb.r * 255);
-			textureData[ix].g = static_cast<uint8_t>(rgb.g * 255);
-			textureData[ix].b = static_cast<uint8_t>(rgb.b * 255);
+		// We'll grab the title for our debug name, nice lil use of it
+		else if (MatchKeyword(p, end, "TITLE")) {
+			const char* lineEnd = SkipLine(p, end);
+			title.assign(p, lineEnd);
 
-			// Move to the next texel
-			ix++;
+			// Trim any excess whitespace
+			StringTools::Trim(title);
+			p = lineEnd;
+			continue;
 		}
-	} 
-
-	if (textureData != nullptr) {
-		// Set the pixel format
-		_description.Format = InternalFormat::RGB8;
-		// We need to clamp to edge for LUTS
-		_description.WrapS = _description.WrapT = _description.WrapR = WrapMode::ClampToEdge;
 
-		// Allocate data and configure params
-		_SetTextureParams();
-		// Load data
-		LoadData(lutSize, lutSize, lutSize, PixelFormat::RGB, PixelType::UByte, textureData);
+		// DOMAIN_MIN, DOMAIN_MAX, LUT_1D_SIZE and anything else we don't know about is ignored for now
+		p = SkipLine(p, end);
+	}
 
-		// Clean up after ourselves
-		delete[] textureData;
+	if (texels == nullptr) {
+		result.Levels.clear();
+		return result;
 	}
-	else {
-		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
+	if (ix != numTexels) {
+		LOG_WARN("LUT \"{}\" only contained {} of {} entries", filename, ix, numTexels);
 	}
+
+	result.Type          = TextureType::_3D;
+	result.Format        = format;
+	result.Layout        = PixelFormat::RGB;
+	result.ComponentType = isFloat ? PixelType::Float : PixelType::UByte;
+	return result;
 }
 
 void Texture3D::_SetTextureParams()
@@ -1,5 +1,6 @@
 #pragma once
 #include "ITexture.h"
+#include "Graphics/Textures/TextureCache.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -18,7 +19,8 @@ struct Texture3DDescription {
 	/// </summary>
 	uint32_t       Depth;
 	/// <summary>
-	/// The internal format that OpenGL should use when storing this texture
+	/// The internal format that OpenGL should use when storing this texture. For LUTs loaded
+	/// from files, this may be RGB8, RGB10A2 or RGB16F, and Unknown will use Texture3D::DefaultLutFormat
 	/// </summary>
 	InternalFormat Format;
 	/// <summary>
@@ -84,6 +86,12 @@ public:
 	Texture3D(const std::string& filePath);
 	Texture3D(const Texture3DDescription& description);
 
+	/// <summary>
+	/// The storage format to use for LUTs loaded from .cube files when the description does not
+	/// specify one. 8 bit LUTs will cause visible banding in smooth gradients after grading
+	/// </summary>
+	inline static InternalFormat DefaultLutFormat = InternalFormat::RGB16F;
+
 	/// <summary>
 	/// Gets the internal format OpenGL is using for this texture
 	/// </summary>
@@ -145,8 +153,16 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture3D::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Does the CPU side of loading a texture from it's JSON data (decoding, cooking) and stages the result
+	/// in the TextureCache, so that FromJson can skip straight to uploading. Safe to call from worker threads
+	/// </summary>
+	static void Prefetch(const nlohmann::json& data);
+	virtual size_t GetGpuMemoryUsage() const override { return _CalcStorageSize(_description.Format, _description.Width, _description.Height, _description.Depth, _description.GenerateMipMaps); }
 
 protected:
+	friend class AssetCooker;
+
 	Texture3DDescription _description;
 	PixelType _pixelType;
 
@@ -156,10 +172,30 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
-	/// Loads a 3D LUT from a .cube file
+	/// Loads a 3D LUT from a .cube file, via the TextureCache
 	/// </summary>
 	void _LoadCubeFile();
 	/// <summary>
+	/// Parses a .cube file into a single level texture, storing either 8 bit or float data
+	/// depending on the format we want to store the LUT in
+	/// </summary>
+	/// <param name="filename">The path to the .cube file</param>
+	/// <param name="format">The internal format the LUT will be stored in</param>
+	/// <param name="title">Will store the title from the file, if it has one</param>
+	static TextureCache::CookedTexture _ParseCubeFile(const std::string& filename, InternalFormat format, std::string& title);
+	/// <summary>
+	/// Gets the format a LUT will be stored in, falling back to DefaultLutFormat if the requested format is not supported
+	/// </summary>
+	static InternalFormat _GetLutFormat(InternalFormat requested);
+	/// <summary>
+	/// Gets the TextureCache variant key for a LUT stored in the given format
+	/// </summary>
+	static std::string _GetLutVariant(InternalFormat format, bool generateMips);
+	/// <summary>
+	/// Parses a .cube file and builds it's mip chain if we can do so on the CPU
+	/// </summary>
+	static TextureCache::CookedTexture _CookLut(const std::string& filename, InternalFormat format, bool generateMips, std::string& title);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
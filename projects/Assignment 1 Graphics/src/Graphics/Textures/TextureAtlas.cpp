@@ -0,0 +1,86 @@
+#include "Graphics/Textures/TextureAtlas.h"
+#include <Logging.h>
+
+TextureAtlas::TextureAtlas(uint32_t size, InternalFormat format, uint32_t padding) :
+	_texture(nullptr),
+	_size(size),
+	_padding(padding),
+	_packer(stbrp_context()),
+	_nodes(std::vector<stbrp_node>(size)),
+	_entries(std::unordered_map<const Texture2D*, Entry>())
+{
+	// We don't want mips, since everything should be drawn close to 1:1, and mips would bleed between images
+	Texture2DDescription desc = Texture2DDescription();
+	desc.Width = size;
+	desc.Height = size;
+	desc.Format = format;
+	desc.GenerateMipMaps = false;
+	desc.MinificationFilter = MinFilter::Linear;
+	desc.MagnificationFilter = MagFilter::Linear;
+	desc.HorizontalWrap = WrapMode::ClampToEdge;
+	desc.VerticalWrap = WrapMode::ClampToEdge;
+	_texture = std::make_shared<Texture2D>(desc);
+	_texture->Clear(glm::vec4(0.0f));
+
+	stbrp_init_target(&_packer, size, size, _nodes.data(), static_cast<int>(_nodes.size()));
+}
+
+TextureAtlas::~TextureAtlas() = default;
+
+bool TextureAtlas::TryAdd(const Texture2D::Sptr& texture) {
+	if (texture == nullptr) {
+		return false;
+	}
+	if (Find(texture.get()) != nullptr) {
+		return true;
+	}
+
+	// We can only copy between textures of the same format, and the image needs to be filtered like the atlas
+	if (texture->GetLoadState() != TextureLoadState::Ready ||
+		texture->GetFormat() != _texture->GetFormat() ||
+		texture->GetMagFilter() != _texture->GetMagFilter() ||
+		texture->GetDescription().MultisampleCount != 1) {
+		return false;
+	}
+
+	uint32_t width = texture->GetWidth();
+	uint32_t height = texture->GetHeight();
+
+	stbrp_rect rect = stbrp_rect();
+	rect.w = width + _padding * 2;
+	rect.h = height + _padding * 2;
+	if (!stbrp_pack_rects(&_packer, &rect, 1) || !rect.was_packed) {
+		LOG_WARN("Texture atlas is full, could not add {}x{} texture", width, height);
+		return false;
+	}
+
+	GLuint src = texture->GetHandle();
+	GLuint dst = _texture->GetHandle();
+	int x = rect.x + _padding;
+	int y = rect.y + _padding;
+
+	// Copy the image, then extrude it's edges into the padding so that filtering at the edges doesn't pick up
+	// neighbouring images
+	glCopyImageSubData(src, GL_TEXTURE_2D, 0, 0, 0, 0, dst, GL_TEXTURE_2D, 0, x, y, 0, width, height, 1);
+	for (int ix = 1; ix <= (int)_padding; ix++) {
+		glCopyImageSubData(src, GL_TEXTURE_2D, 0, 0,         0, 0, dst, GL_TEXTURE_2D, 0, x - ix,             y, 0, 1, height, 1);
+		glCopyImageSubData(src, GL_TEXTURE_2D, 0, width - 1, 0, 0, dst, GL_TEXTURE_2D, 0, x + width - 1 + ix, y, 0, 1, height, 1);
+		glCopyImageSubData(src, GL_TEXTURE_2D, 0, 0, 0,          0, dst, GL_TEXTURE_2D, 0, x, y - ix,              0, width, 1, 1);
+		glCopyImageSubData(src, GL_TEXTURE_2D, 0, 0, height - 1, 0, dst, GL_TEXTURE_2D, 0, x, y + height - 1 + ix, 0, width, 1, 1);
+	}
+
+	Entry& entry = _entries[texture.get()];
+	entry.Source = texture;
+	entry.Area.UvMin = glm::vec2(x, y) / (float)_size;
+	entry.Area.UvMax = glm::vec2(x + width, y + height) / (float)_size;
+	return true;
+}
+
+const TextureAtlas::Region* TextureAtlas::Find(const Texture2D* texture) const {
+	auto it = _entries.find(texture);
+	// If the texture was deleted, the pointer may now belong to a different texture
+	if (it == _entries.end() || it->second.Source.expired()) {
+		return nullptr;
+	}
+	return &it->second.Area;
+}
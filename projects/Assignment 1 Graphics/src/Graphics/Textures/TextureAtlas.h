@@ -0,0 +1,81 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+#include <stb_rect_pack.h>
+
+#include "Graphics/Textures/Texture2D.h"
+
+/// <summary>
+/// Packs small textures into a single larger texture, so that geometry using any of them can be drawn
+/// together. Images are copied on the GPU with glCopyImageSubData, so textures must be loaded and use the
+/// same internal format as the atlas. The atlas does not track changes to the source textures, so only
+/// textures that don't change after they are loaded should be added
+/// </summary>
+class TextureAtlas {
+public:
+	typedef std::shared_ptr<TextureAtlas> Sptr;
+
+	/// <summary>
+	/// The area of the atlas that a texture was copied to
+	/// </summary>
+	struct Region {
+		glm::vec2 UvMin;
+		glm::vec2 UvMax;
+	};
+
+	/// <summary>
+	/// Creates a new, empty texture atlas
+	/// </summary>
+	/// <param name="size">The width and height of the atlas in pixels</param>
+	/// <param name="format">The internal format of the atlas, only textures with this format can be added</param>
+	/// <param name="padding">The number of pixels to extrude around each texture, to avoid bleeding when filtering</param>
+	TextureAtlas(uint32_t size = 1024, InternalFormat format = InternalFormat::RGBA8, uint32_t padding = 2);
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas& other) = delete;
+	TextureAtlas(TextureAtlas&& other) = delete;
+	TextureAtlas& operator =(const TextureAtlas& other) = delete;
+	TextureAtlas& operator =(TextureAtlas&& other) = delete;
+
+	static inline Sptr Create(uint32_t size = 1024, InternalFormat format = InternalFormat::RGBA8, uint32_t padding = 2) {
+		return std::make_shared<TextureAtlas>(size, format, padding);
+	}
+
+	/// <summary>
+	/// Attempts to copy a texture into the atlas. Will fail if the texture is still loading, does not
+	/// match the atlas's format or filtering, or there is not enough space left
+	/// </summary>
+	/// <param name="texture">The texture to add</param>
+	/// <returns>True if the texture is in the atlas</returns>
+	bool TryAdd(const Texture2D::Sptr& texture);
+	/// <summary>
+	/// Gets the region of the atlas that a texture has been packed into, or nullptr if it is not in the atlas
+	/// </summary>
+	/// <param name="texture">The texture to search for</param>
+	const Region* Find(const Texture2D* texture) const;
+
+	/// <summary>
+	/// Gets the texture that all images are packed into
+	/// </summary>
+	const Texture2D::Sptr& GetTexture() const { return _texture; }
+	/// <summary>
+	/// Gets the number of textures that have been packed into this atlas
+	/// </summary>
+	size_t GetEntryCount() const { return _entries.size(); }
+
+protected:
+	struct Entry {
+		// Used to detect when a texture was deleted and another was allocated in it's place
+		std::weak_ptr<Texture2D> Source;
+		Region                   Area;
+	};
+
+	Texture2D::Sptr                         _texture;
+	uint32_t                                _size;
+	uint32_t                                _padding;
+	stbrp_context                           _packer;
+	std::vector<stbrp_node>                 _nodes;
+	std::unordered_map<const Texture2D*, Entry> _entries;
+};
@@ -0,0 +1,488 @@
+#include "Graphics/Textures/TextureCache.h"
+
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <stb_image.h>
+
+#include "Utils/HashHelpers.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Logging.h"
+
+// SSE2 is always available on x64, other platforms fall back to the scalar loops
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURES_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define TEXTURES_USE_SSE 0
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+	// Resolution of the linear -> sRGB lookup, high enough that round tripping 8 bit values is exact
+	const int LINEAR_TO_SRGB_STEPS = 4096;
+
+	// Lookup tables for converting between sRGB encoded bytes and linear floats
+	struct SrgbTables {
+		float   ToLinear[256];
+		uint8_t ToSrgb[LINEAR_TO_SRGB_STEPS + 1];
+
+		SrgbTables() {
+			for (int ix = 0; ix < 256; ix++) {
+				float c = ix / 255.0f;
+				ToLinear[ix] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int ix = 0; ix <= LINEAR_TO_SRGB_STEPS; ix++) {
+				float l = ix / static_cast<float>(LINEAR_TO_SRGB_STEPS);
+				float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				ToSrgb[ix] = static_cast<uint8_t>(glm::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+			}
+		}
+	};
+
+	const SrgbTables& GetSrgbTables() {
+		// Function local statics are initialized thread safely
+		static SrgbTables tables;
+		return tables;
+	}
+
+#if TEXTURES_USE_SSE
+	/// <summary>
+	/// Downsamples as many texels of an RGBA8 row pair as possible with SSE2, 2 output texels at a time.
+	/// Returns the number of output texels written, the rest (including any clamped odd edge) are left for
+	/// the scalar loop. Rounds the same way as the scalar path, (sum + 2) / 4
+	/// </summary>
+	uint32_t DownsampleRowRgba8(const uint8_t* row0, const uint8_t* row1, uint32_t srcW, uint8_t* dstRow, uint32_t dstW) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(2);
+
+		uint32_t x = 0;
+		for (; x + 2 <= dstW && x * 2 + 4 <= srcW; x += 2) {
+			// 4 source texels from each row, widened to 16 bits so the sums can't overflow
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+			// lo holds texels 0 and 1, hi holds 2 and 3, so pairing up the 64 bit halves adds neighbours
+			__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dstRow + x * 4), _mm_packus_epi16(sum, sum));
+		}
+		return x;
+	}
+#endif
+
+	/// <summary>
+	/// Downsamples a single 2D image by 2x2, where each output texel averages up to 4 source texels. Linear
+	/// RGBA data takes an SSE2 path, sRGB color channels go through lookup tables one texel at a time
+	/// </summary>
+	void Downsample2D(const uint8_t* src, uint32_t srcW, uint32_t srcH, uint8_t* dst, uint32_t dstW, uint32_t dstH, int channels, bool gammaCorrect) {
+		const SrgbTables& tables = GetSrgbTables();
+		const int colorChannels = gammaCorrect && channels >= 3 ? 3 : 0;
+
+		std::vector<float> row(static_cast<size_t>(dstW) * channels);
+		for (uint32_t y = 0; y < dstH; y++) {
+			// Clamp our source rows, this handles odd sizes (the last row gets sampled twice)
+			const uint8_t* row0 = src + static_cast<size_t>(glm::min(y * 2,     srcH - 1)) * srcW * channels;
+			const uint8_t* row1 = src + static_cast<size_t>(glm::min(y * 2 + 1, srcH - 1)) * srcW * channels;
+			uint8_t* dstRow = dst + static_cast<size_t>(y) * dstW * channels;
+
+			uint32_t first = 0;
+#if TEXTURES_USE_SSE
+			if (channels == 4 && colorChannels == 0) {
+				first = DownsampleRowRgba8(row0, row1, srcW, dstRow, dstW);
+			}
+#endif
+
+			std::fill(row.begin(), row.end(), 0.0f);
+			for (uint32_t x = first; x < dstW; x++) {
+				const size_t x0 = static_cast<size_t>(glm::min(x * 2,     srcW - 1)) * channels;
+				const size_t x1 = static_cast<size_t>(glm::min(x * 2 + 1, srcW - 1)) * channels;
+				float* out = &row[static_cast<size_t>(x) * channels];
+				for (int c = 0; c < channels; c++) {
+					if (c < colorChannels) {
+						out[c] = tables.ToLinear[row0[x0 + c]] + tables.ToLinear[row0[x1 + c]] + tables.ToLinear[row1[x0 + c]] + tables.ToLinear[row1[x1 + c]];
+					} else {
+						out[c] = static_cast<float>(row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]);
+					}
+				}
+			}
+
+			for (uint32_t x = first; x < dstW; x++) {
+				const float* in = &row[static_cast<size_t>(x) * channels];
+				for (int c = 0; c < channels; c++) {
+					if (c < colorChannels) {
+						dstRow[x * channels + c] = tables.ToSrgb[static_cast<int>(glm::clamp(in[c] * 0.25f, 0.0f, 1.0f) * LINEAR_TO_SRGB_STEPS + 0.5f)];
+					} else {
+						dstRow[x * channels + c] = static_cast<uint8_t>(in[c] * 0.25f + 0.5f);
+					}
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Downsamples a 3D image by 2x2x2, by downsampling each pair of slices and averaging the results
+	/// </summary>
+	void Downsample3D(const uint8_t* src, uint32_t srcW, uint32_t srcH, uint32_t srcD, uint8_t* dst, uint32_t dstW, uint32_t dstH, uint32_t dstD, int channels) {
+		const size_t srcSlice = static_cast<size_t>(srcW) * srcH * channels;
+		const size_t dstSlice = static_cast<size_t>(dstW) * dstH * channels;
+		std::vector<uint8_t> a(dstSlice), b(dstSlice);
+		for (uint32_t z = 0; z < dstD; z++) {
+			Downsample2D(src + glm::min(z * 2,     srcD - 1) * srcSlice, srcW, srcH, a.data(), dstW, dstH, channels, false);
+			Downsample2D(src + glm::min(z * 2 + 1, srcD - 1) * srcSlice, srcW, srcH, b.data(), dstW, dstH, channels, false);
+			uint8_t* out = dst + z * dstSlice;
+			size_t ix = 0;
+#if TEXTURES_USE_SSE
+			// pavgb rounds up, the same as the scalar (a + b + 1) / 2
+			for (; ix + 16 <= dstSlice; ix += 16) {
+				__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + ix));
+				__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + ix));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + ix), _mm_avg_epu8(va, vb));
+			}
+#endif
+			for (; ix < dstSlice; ix++) {
+				out[ix] = static_cast<uint8_t>((a[ix] + b[ix] + 1) / 2);
+			}
+		}
+	}
+
+	// Gets a normalized, forward slashed copy of a path so that the same file always hashes to the same key
+	std::string NormalizePath(const std::string& path) {
+		return fs::path(path).lexically_normal().generic_string();
+	}
+
+	// Largest width, height or depth we'll accept from a cooked file, well above what any GL driver supports
+	const uint32_t MAX_COOKED_DIMENSION = 1 << 16;
+
+	/// <summary>
+	/// Gets the size of a texel in a cooked file, or 0 if the layout or component type is not one we cook. Unlike
+	/// GetTexelSize this doesn't assert on unknown values, since they come from a file that may be corrupt
+	/// </summary>
+	size_t GetCookedTexelSize(PixelFormat layout, PixelType type) {
+		switch (layout) {
+			case PixelFormat::Red:
+			case PixelFormat::RG:
+			case PixelFormat::RGB:
+			case PixelFormat::RGBA:
+				break;
+			default:
+				return 0;
+		}
+		switch (type) {
+			case PixelType::UByte:
+			case PixelType::UShort:
+			case PixelType::Float:
+				return GetTexelSize(layout, type);
+			default:
+				return 0;
+		}
+	}
+}
+
+size_t TextureCache::CookedTexture::GetTotalSize() const {
+	size_t result = 0;
+	for (const auto& level : Levels) {
+		result += level.Data.size();
+	}
+	return result;
+}
+
+TextureCache::CookedTexture TextureCache::LoadOrCook(const std::vector<std::string>& sources, const std::string& variant, const std::function<CookedTexture()>& cook) {
+	CookedTexture result;
+	if (TryLoad(sources, variant, result)) {
+		return result;
+	}
+
+	result = cook();
+	if (result.IsValid()) {
+		Store(sources, variant, result);
+	}
+	return result;
+}
+
+bool TextureCache::TryLoad(const std::vector<std::string>& sources, const std::string& variant, CookedTexture& result) {
+	std::string cachePath = GetCacheFilePath(sources, variant);
+
+	// Anything that was prefetched is handed over without touching the disk
+	{
+		std::lock_guard<std::mutex> lock(_stagedMutex);
+		auto it = _staged.find(cachePath);
+		if (it != _staged.end()) {
+			result = std::move(it->second);
+			_staged.erase(it);
+			return true;
+		}
+	}
+
+	if (!Enabled) {
+		return false;
+	}
+
+	// The cache is only usable if it is newer than every source file. Cooked textures may be shipped in an
+	// asset pack, so we go through the VFS for the cache file as well
+	fs::file_time_type cacheTime;
+	if (!VirtualFileSystem::GetWriteTime(cachePath, cacheTime)) {
+		return false;
+	}
+	// Sources may be served from an asset pack, so we ask the VFS for their write times
+	for (const auto& source : sources) {
+		fs::file_time_type sourceTime;
+		if (!VirtualFileSystem::GetWriteTime(source, sourceTime) || sourceTime > cacheTime) {
+			return false;
+		}
+	}
+	return LoadFile(cachePath, result);
+}
+
+bool TextureCache::Store(const std::vector<std::string>& sources, const std::string& variant, const CookedTexture& texture) {
+	return Enabled && texture.IsValid() && SaveFile(GetCacheFilePath(sources, variant), texture);
+}
+
+void TextureCache::Stage(const std::vector<std::string>& sources, const std::string& variant, CookedTexture texture) {
+	if (!texture.IsValid()) {
+		return;
+	}
+	std::string cachePath = GetCacheFilePath(sources, variant);
+	std::lock_guard<std::mutex> lock(_stagedMutex);
+	_staged[cachePath] = std::move(texture);
+}
+
+void TextureCache::Prefetch(const std::vector<std::string>& sources, const std::string& variant, const std::function<CookedTexture()>& cook) {
+	Stage(sources, variant, LoadOrCook(sources, variant, cook));
+}
+
+void TextureCache::ClearStaged() {
+	std::lock_guard<std::mutex> lock(_stagedMutex);
+	_staged.clear();
+}
+
+TextureCache::CookedTexture TextureCache::DecodeImage(const std::string& filename, int targetChannels) {
+	CookedTexture result;
+
+	// NOTE: We don't set STBI's flip flag here since it's global, it's always set to true before any loading happens
+	// (the runtime loaders and AssetCooker::Cook both set it)
+	// The source image may be in an asset pack, so we decode it from memory rather than letting STBI open it
+	FileView file = VirtualFileSystem::Open(filename);
+	if (!file || file.Size() > INT_MAX) {
+		return result;
+	}
+	int width, height, numChannels;
+	uint8_t* data = stbi_load_from_memory(file.Data(), static_cast<int>(file.Size()), &width, &height, &numChannels, targetChannels);
+	if (data == nullptr) {
+		return result;
+	}
+
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	if (targetChannels != 0) {
+		numChannels = targetChannels;
+	}
+
+	result.Type          = TextureType::_2D;
+	result.Format        = GetInternalFormatForChannels8(numChannels);
+	result.Layout        = GetPixelFormatForChannels(numChannels);
+	result.ComponentType = PixelType::UByte;
+	result.Levels.resize(1);
+	result.Levels[0].Width  = width;
+	result.Levels[0].Height = height;
+	result.Levels[0].Depth  = 1;
+	result.Levels[0].Data.assign(data, data + static_cast<size_t>(width) * height * numChannels);
+	stbi_image_free(data);
+
+	return result;
+}
+
+TextureCache::CookedTexture TextureCache::LoadImage2D(const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips) {
+	return LoadOrCook({ filename }, _GetImage2DVariant(targetChannels, generateMips, gammaCorrectMips), [&]() {
+		return CookImage2D(filename, targetChannels, generateMips, gammaCorrectMips);
+	});
+}
+
+TextureCache::CookedTexture TextureCache::CookImage2D(const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips) {
+	CookedTexture result = DecodeImage(filename, targetChannels);
+	if (generateMips && result.IsValid()) {
+		GenerateMipChain(result, gammaCorrectMips);
+	}
+	return result;
+}
+
+void TextureCache::PrefetchImage2D(const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips) {
+	Stage({ filename }, _GetImage2DVariant(targetChannels, generateMips, gammaCorrectMips), LoadImage2D(filename, targetChannels, generateMips, gammaCorrectMips));
+}
+
+std::string TextureCache::_GetImage2DVariant(int targetChannels, bool generateMips, bool gammaCorrectMips) {
+	return "2d:" + std::to_string(targetChannels) + (generateMips ? (gammaCorrectMips ? ":mips-srgb" : ":mips") : "");
+}
+
+void TextureCache::GenerateMipChain(CookedTexture& texture, bool gammaCorrect) {
+	if (texture.Levels.empty()) {
+		return;
+	}
+	if (texture.ComponentType != PixelType::UByte) {
+		LOG_WARN("CPU mip generation only supports 8 bit textures, skipping");
+		return;
+	}
+
+	const int channels = GetTexelComponentCount(texture.Layout);
+	const bool is3D = texture.Type == TextureType::_3D;
+
+	texture.Levels.resize(1);
+	const MipLevel& base = texture.Levels[0];
+	uint32_t numLevels = CalcMipLevels(base.Width, base.Height, is3D ? base.Depth : 1);
+	texture.Levels.reserve(numLevels);
+
+	for (uint32_t ix = 1; ix < numLevels; ix++) {
+		const MipLevel& src = texture.Levels[ix - 1];
+		MipLevel dst;
+		dst.Width  = glm::max(1u, src.Width / 2);
+		dst.Height = glm::max(1u, src.Height / 2);
+		// 3D textures shrink along z, cubemaps keep all 6 faces in every level
+		dst.Depth  = is3D ? glm::max(1u, src.Depth / 2) : src.Depth;
+		dst.Data.resize(static_cast<size_t>(dst.Width) * dst.Height * dst.Depth * channels);
+
+		if (is3D) {
+			Downsample3D(src.Data.data(), src.Width, src.Height, src.Depth, dst.Data.data(), dst.Width, dst.Height, dst.Depth, channels);
+		} else {
+			const size_t srcLayer = static_cast<size_t>(src.Width) * src.Height * channels;
+			const size_t dstLayer = static_cast<size_t>(dst.Width) * dst.Height * channels;
+			for (uint32_t layer = 0; layer < dst.Depth; layer++) {
+				Downsample2D(src.Data.data() + layer * srcLayer, src.Width, src.Height, dst.Data.data() + layer * dstLayer, dst.Width, dst.Height, channels, gammaCorrect);
+			}
+		}
+
+		texture.Levels.push_back(std::move(dst));
+	}
+}
+
+uint32_t TextureCache::CalcMipLevels(uint32_t width, uint32_t height, uint32_t depth) {
+	uint32_t size = glm::max(width, glm::max(height, depth));
+	uint32_t result = 1;
+	while (size > 1) {
+		size >>= 1;
+		result++;
+	}
+	return result;
+}
+
+bool TextureCache::LoadFile(const std::string& path, CookedTexture& result) {
+	FileView view = VirtualFileSystem::Open(path);
+	FileViewStream file(view);
+	if (!file) {
+		return false;
+	}
+
+	FileHeader header = FileHeader();
+	file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+	if (!file || memcmp(header.HeaderBytes, FileHeader().HeaderBytes, 4) != 0 || header.Version != CURRENT_VERSION) {
+		return false;
+	}
+
+	// The sizes in the file drive our allocations, so we check them all before trusting any of them. Returning
+	// false means the texture will be re-cooked from its source
+	const size_t texelSize = GetCookedTexelSize(header.Layout, header.ComponentType);
+	if (texelSize == 0 || header.NumLevels == 0 || header.NumLevels > 32) {
+		LOG_WARN("Cooked texture \"{}\" has an invalid header, ignoring", path);
+		return false;
+	}
+
+	std::vector<LevelHeader> levels(header.NumLevels);
+	file.read(reinterpret_cast<char*>(levels.data()), levels.size() * sizeof(LevelHeader));
+	if (!file) {
+		return false;
+	}
+
+	const bool is3D = header.Type == TextureType::_3D;
+	uint64_t totalSize = 0;
+	for (const LevelHeader& level : levels) {
+		if (level.Width == 0 || level.Height == 0 || level.Depth == 0 ||
+			level.Width > MAX_COOKED_DIMENSION || level.Height > MAX_COOKED_DIMENSION || level.Depth > MAX_COOKED_DIMENSION ||
+			level.DataSize != static_cast<uint64_t>(level.Width) * level.Height * level.Depth * texelSize) {
+			LOG_WARN("Cooked texture \"{}\" has an invalid mip level, ignoring", path);
+			return false;
+		}
+		totalSize += level.DataSize;
+	}
+	if (header.NumLevels > CalcMipLevels(levels[0].Width, levels[0].Height, is3D ? levels[0].Depth : 1) || totalSize > view.Size()) {
+		LOG_WARN("Cooked texture \"{}\" has an invalid header, ignoring", path);
+		return false;
+	}
+
+	result = CookedTexture();
+	result.Type          = header.Type;
+	result.Format        = header.Format;
+	result.Layout        = header.Layout;
+	result.ComponentType = header.ComponentType;
+	result.Levels.resize(header.NumLevels);
+	for (uint32_t ix = 0; ix < header.NumLevels; ix++) {
+		MipLevel& level = result.Levels[ix];
+		level.Width  = levels[ix].Width;
+		level.Height = levels[ix].Height;
+		level.Depth  = levels[ix].Depth;
+		level.Data.resize(levels[ix].DataSize);
+		file.read(reinterpret_cast<char*>(level.Data.data()), level.Data.size());
+	}
+
+	// If we hit the end of the file early, the cache is corrupt
+	if (!file) {
+		LOG_WARN("Cooked texture \"{}\" was truncated, ignoring", path);
+		result = CookedTexture();
+		return false;
+	}
+	return result.IsValid();
+}
+
+bool TextureCache::SaveFile(const std::string& path, const CookedTexture& texture) {
+	std::error_code err;
+	fs::create_directories(fs::path(path).parent_path(), err);
+
+	// Multiple workers may cook the same texture at once, so we write to a unique temporary file and then
+	// move it into place, that way readers will never see a partially written file
+	std::string tempPath = path + "." + HashHelpers::ToHex(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file) {
+			LOG_WARN("Failed to open \"{}\" for writing cooked texture", tempPath);
+			return false;
+		}
+
+		FileHeader header = FileHeader();
+		header.Version       = CURRENT_VERSION;
+		header.Type          = texture.Type;
+		header.Format        = texture.Format;
+		header.Layout        = texture.Layout;
+		header.ComponentType = texture.ComponentType;
+		header.NumLevels     = static_cast<uint32_t>(texture.Levels.size());
+		file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+
+		for (const auto& level : texture.Levels) {
+			LevelHeader levelHeader = { level.Width, level.Height, level.Depth, level.Data.size() };
+			file.write(reinterpret_cast<const char*>(&levelHeader), sizeof(LevelHeader));
+		}
+		for (const auto& level : texture.Levels) {
+			file.write(reinterpret_cast<const char*>(level.Data.data()), level.Data.size());
+		}
+	}
+
+	fs::rename(tempPath, path, err);
+	if (err) {
+		// Another thread probably beat us to it, which is fine
+		fs::remove(tempPath, err);
+		return false;
+	}
+	return true;
+}
+
+std::string TextureCache::GetCacheFilePath(const std::vector<std::string>& sources, const std::string& variant) {
+	uint64_t hash = HashHelpers::Fnv1a(variant);
+	for (const auto& source : sources) {
+		hash = HashHelpers::Fnv1a(NormalizePath(source), hash);
+	}
+	// Keep the source's name in the file name, makes it a lot easier to find things in the cache folder
+	std::string stem = sources.empty() ? "texture" : fs::path(sources[0]).stem().string();
+	return (fs::path(CachePath) / (stem + "-" + HashHelpers::ToHex(hash) + ".ctex")).string();
+}
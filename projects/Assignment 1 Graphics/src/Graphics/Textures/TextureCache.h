@@ -0,0 +1,212 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+#include "Graphics/GlEnums.h"
+
+/// <summary>
+/// Stores textures that have been "cooked" into a binary format containing their full mip chain, so
+/// that we can skip image decoding and mipmap generation on subsequent loads. Cooked files contain all
+/// of the format information needed to upload each level directly with glTextureSubImage
+///
+/// Cache files are keyed by a hash of the source paths and cooking options, and are considered stale
+/// if any of their source files have been modified since the cache file was written
+/// </summary>
+class TextureCache {
+public:
+	/// <summary>
+	/// A single level of a cooked texture's mip chain
+	/// </summary>
+	struct MipLevel {
+		uint32_t             Width  = 0;
+		uint32_t             Height = 0;
+		// The depth of 3D textures, or the number of faces for cubemaps
+		uint32_t             Depth  = 1;
+		// Tightly packed texel data (no row alignment), layers/faces are back to back
+		std::vector<uint8_t> Data;
+	};
+
+	/// <summary>
+	/// A texture and it's mip chain, ready to be uploaded to OpenGL
+	/// </summary>
+	struct CookedTexture {
+		TextureType           Type        = TextureType::_2D;
+		InternalFormat        Format      = InternalFormat::Unknown;
+		PixelFormat           Layout      = PixelFormat::Unknown;
+		PixelType             ComponentType = PixelType::Unknown;
+		// Level 0 is the full resolution image
+		std::vector<MipLevel> Levels;
+
+		/// <summary>
+		/// Returns true if this texture contains data that can be uploaded
+		/// </summary>
+		bool IsValid() const { return !Levels.empty() && !Levels[0].Data.empty() && Format != InternalFormat::Unknown; }
+		/// <summary>
+		/// Gets the number of bytes in all levels of the texture
+		/// </summary>
+		size_t GetTotalSize() const;
+	};
+
+	/// <summary>
+	/// True if textures should be loaded from and saved to the cache, if false textures will always be cooked from source
+	/// </summary>
+	inline static bool        Enabled = true;
+	/// <summary>
+	/// The directory that cooked textures are stored in
+	/// </summary>
+	inline static std::string CachePath = "cache/textures/";
+
+	/// <summary>
+	/// Loads a cooked texture from the cache, or cooks it from source and stores the result if the cache is missing
+	/// or out of date. This is safe to call from worker threads
+	/// </summary>
+	/// <param name="sources">The source files the texture is built from, used for the key and staleness checks</param>
+	/// <param name="variant">Any options that change the cooked output (channel counts, mip settings, etc...)</param>
+	/// <param name="cook">Builds the texture from source if the cache is not usable</param>
+	/// <returns>The cooked texture, or an invalid texture if cooking failed</returns>
+	static CookedTexture LoadOrCook(const std::vector<std::string>& sources, const std::string& variant, const std::function<CookedTexture()>& cook);
+	/// <summary>
+	/// Loads a cooked texture from the cache if it exists and is newer than all of it's sources. Use this along with
+	/// Store when the texture needs to be used while it is being cooked. This is safe to call from worker threads
+	/// </summary>
+	/// <param name="sources">The source files the texture is built from</param>
+	/// <param name="variant">Any options that change the cooked output</param>
+	/// <param name="result">Will store the cached texture</param>
+	/// <returns>True if the cache was usable and loaded</returns>
+	static bool TryLoad(const std::vector<std::string>& sources, const std::string& variant, CookedTexture& result);
+	/// <summary>
+	/// Stores a cooked texture in the cache, does nothing if the cache is disabled
+	/// </summary>
+	/// <param name="sources">The source files the texture was built from</param>
+	/// <param name="variant">Any options that change the cooked output</param>
+	/// <param name="texture">The texture to store</param>
+	/// <returns>True if the texture was written</returns>
+	static bool Store(const std::vector<std::string>& sources, const std::string& variant, const CookedTexture& texture);
+
+	/// <summary>
+	/// Keeps a cooked texture in memory, the next TryLoad (or LoadOrCook) with the same sources and variant will
+	/// take it instead of going to disk. This lets worker threads do all the CPU side work for a texture ahead of time.
+	/// This is safe to call from worker threads
+	/// </summary>
+	/// <param name="sources">The source files the texture was built from</param>
+	/// <param name="variant">Any options that change the cooked output</param>
+	/// <param name="texture">The texture to stage</param>
+	static void Stage(const std::vector<std::string>& sources, const std::string& variant, CookedTexture texture);
+	/// <summary>
+	/// Loads or cooks a texture as with LoadOrCook, and stages the result so it can be picked up later without
+	/// touching the disk. This is safe to call from worker threads
+	/// </summary>
+	static void Prefetch(const std::vector<std::string>& sources, const std::string& variant, const std::function<CookedTexture()>& cook);
+	/// <summary>
+	/// Drops all staged textures that have not been picked up yet
+	/// </summary>
+	static void ClearStaged();
+
+	/// <summary>
+	/// Decodes an image file into a single level cooked texture using STBI
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="targetChannels">The number of channels to force the image to, or 0 to use the file's channel count</param>
+	/// <returns>The decoded image, or an invalid texture if decoding failed</returns>
+	static CookedTexture DecodeImage(const std::string& filename, int targetChannels);
+
+	/// <summary>
+	/// Loads an image file as a 2D texture via the cache, optionally with a full mip chain
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="targetChannels">The number of channels to force the image to, or 0 to use the file's channel count</param>
+	/// <param name="generateMips">True to generate the full mip chain on the CPU</param>
+	/// <param name="gammaCorrectMips">True if the image holds sRGB color, see GenerateMipChain</param>
+	static CookedTexture LoadImage2D(const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips);
+	/// <summary>
+	/// Decodes an image file and optionally generates it's mip chain, without going through the cache
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="targetChannels">The number of channels to force the image to, or 0 to use the file's channel count</param>
+	/// <param name="generateMips">True to generate the full mip chain on the CPU</param>
+	/// <param name="gammaCorrectMips">True if the image holds sRGB color, see GenerateMipChain</param>
+	static CookedTexture CookImage2D(const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips);
+
+	/// <summary>
+	/// Loads an image file as with LoadImage2D and stages the result, so the next LoadImage2D with the
+	/// same parameters is served from memory
+	/// </summary>
+	static void PrefetchImage2D(const std::string& filename, int targetChannels, bool generateMips, bool gammaCorrectMips);
+
+	/// <summary>
+	/// Replaces all levels after level 0 with a complete mip chain generated with a box filter. 2D levels
+	/// are filtered 2x2, cubemap faces are filtered independently, and 3D textures are filtered 2x2x2
+	/// Only 8 bit unsigned formats are supported
+	/// </summary>
+	/// <param name="texture">The texture to generate mips for</param>
+	/// <param name="gammaCorrect">True to average the color channels of 3 and 4 channel images in linear space, which keeps
+	/// mips of sRGB color data from getting darker than the source. Should be false for linear data such as normal, specular,
+	/// roughness or displacement maps. Alpha is always filtered linearly</param>
+	static void GenerateMipChain(CookedTexture& texture, bool gammaCorrect);
+
+	/// <summary>
+	/// Gets the number of levels in a full mip chain for a texture of the given size
+	/// </summary>
+	static uint32_t CalcMipLevels(uint32_t width, uint32_t height, uint32_t depth = 1);
+
+	/// <summary>
+	/// Loads a cooked texture file
+	/// </summary>
+	/// <param name="path">The path of the cooked file</param>
+	/// <param name="result">Will store the loaded texture</param>
+	/// <returns>True if the file was valid and loaded</returns>
+	static bool LoadFile(const std::string& path, CookedTexture& result);
+	/// <summary>
+	/// Writes a cooked texture to a file
+	/// </summary>
+	/// <param name="path">The path to write to, will be written atomically via a temp file</param>
+	/// <param name="texture">The texture to write</param>
+	/// <returns>True if the file was written</returns>
+	static bool SaveFile(const std::string& path, const CookedTexture& texture);
+
+	/// <summary>
+	/// Gets the path that a cooked texture with the given sources and variant would be stored at
+	/// </summary>
+	static std::string GetCacheFilePath(const std::vector<std::string>& sources, const std::string& variant);
+
+protected:
+	friend class AssetCooker;
+
+	TextureCache() = default;
+	~TextureCache() = default;
+
+	// Will be put at the start of cooked files, followed by a LevelHeader for each level, then the level data
+	struct FileHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char           HeaderBytes[4] = { 'C', 'T', 'E', 'X' };
+		// The version code, cache files from other versions are ignored
+		uint16_t       Version       = 0;
+		TextureType    Type          = TextureType::_2D;
+		InternalFormat Format        = InternalFormat::Unknown;
+		PixelFormat    Layout        = PixelFormat::Unknown;
+		PixelType      ComponentType = PixelType::Unknown;
+		uint32_t       NumLevels     = 0;
+	};
+
+	struct LevelHeader {
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Depth;
+		uint64_t DataSize;
+	};
+
+	// Textures that have been prefetched, keyed by their cache file path, and removed once they are loaded
+	inline static std::mutex                                     _stagedMutex;
+	inline static std::unordered_map<std::string, CookedTexture> _staged;
+
+	/// <summary>
+	/// Gets the variant key used for 2D images loaded with the given parameters
+	/// </summary>
+	static std::string _GetImage2DVariant(int targetChannels, bool generateMips, bool gammaCorrectMips);
+
+	// The latest version of the cooked format, bump this when the format or cooking changes
+	static const uint16_t CURRENT_VERSION = 0x02;
+};
@@ -1,7 +1,12 @@
 #include "TextureCube.h"
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 #include "stb_image.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
 
 TextureCube::TextureCube(const std::string& baseFilename) :
 	ITexture(TextureType::Cubemap),
@@ -31,6 +36,8 @@ nlohmann::json TextureCube::ToJson() const
 	nlohmann::json result;
 	result["filter_min"] = ~_description.MinificationFilter;
 	result["filter_mag"] = ~_description.MagnificationFilter;
+	result["generate_mipmaps"] = _description.GenerateMipMaps;
+	result["gamma_correct_mips"] = _description.GammaCorrectMips;
 	
 	if (!_description.FaceFileNames.empty()) {
 		result["face_filenames"] = nlohmann::json();
@@ -45,10 +52,51 @@ nlohmann::json TextureCube::ToJson() const
 }
 
 TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
+{
+	return std::make_shared<TextureCube>(_ParseDescription(data));
+}
+
+void TextureCube::Prefetch(const nlohmann::json& data)
+{
+	// Pre-packed cubemaps are already cooked, and will be read on the GL thread
+	TextureCubeDescription descr = _ParseDescription(data);
+	if (!descr.Filename.empty() && std::filesystem::path(descr.Filename).extension() == ".ctex") {
+		return;
+	}
+
+	_FindFaceFiles(descr);
+	if (descr.FaceFileNames.size() != 6) {
+		return;
+	}
+
+	// We're already on a worker, so the faces are decoded one after another. Anything that doesn't
+	// make a valid cube is left for the GL thread to report
+	std::vector<std::string> sources = _GetSources(descr.FaceFileNames);
+	const bool generateMips = descr.GenerateMipMaps;
+	const bool gammaCorrectMips = descr.GammaCorrectMips;
+	TextureCache::Prefetch(sources, _GetCacheVariant(generateMips, gammaCorrectMips), [&]() {
+		std::vector<TextureCache::CookedTexture> faces(6);
+		for (int ix = 0; ix < 6; ix++) {
+			faces[ix] = TextureCache::DecodeImage(sources[ix], 0);
+			if (!faces[ix].IsValid() || faces[ix].Levels[0].Width != faces[ix].Levels[0].Height ||
+				faces[ix].Levels[0].Width != faces[0].Levels[0].Width || faces[ix].Format != faces[0].Format) {
+				return TextureCache::CookedTexture();
+			}
+			if (generateMips) {
+				TextureCache::GenerateMipChain(faces[ix], gammaCorrectMips);
+			}
+		}
+		return _PackFaces(faces);
+	});
+}
+
+TextureCubeDescription TextureCube::_ParseDescription(const nlohmann::json& data)
 {
 	TextureCubeDescription descr = TextureCubeDescription();
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
+	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", descr.GenerateMipMaps);
+	descr.GammaCorrectMips    = JsonGet(data, "gamma_correct_mips", descr.GammaCorrectMips);
 	descr.Filename       = JsonGet<std::string>(data, "base_filename", "");
 	if (data.contains("face_filenames") && data["face_filenames"].is_object()) {
 		for (auto& [key, value] : data["face_filenames"].items()) {
@@ -58,15 +106,35 @@ TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
 			}
 		}
 	}
-	return std::make_shared<TextureCube>(descr);
+	return descr;
 }
 
 void TextureCube::_LoadFromDescription()
 {
+	// Pre-packed cubemaps already contain all faces and mips, no need to go looking for faces
+	if (!_description.Filename.empty() && std::filesystem::path(_description.Filename).extension() == ".ctex") {
+		_LoadPacked(_description.Filename);
+		return;
+	}
+
 	// If we weren't passed face filenames but WERE passed a base filename, try and get the 6 face files
-	if (_description.FaceFileNames.empty() && !_description.Filename.empty()) {
+	_FindFaceFiles(_description);
+
+	// If we don't have 6 faces for our cube, something has gone horribly wrong (or the files don't exist)
+	if (_description.FaceFileNames.size() != 6) {
+		LOG_ERROR("TextureCube was not given 6 faces, aborting load");
+		return;
+	}
+
+	// Load all the images into the texture
+	_LoadImages(_description.FaceFileNames);
+}
+
+void TextureCube::_FindFaceFiles(TextureCubeDescription& description)
+{
+	if (description.FaceFileNames.empty() && !description.Filename.empty()) {
 		// Get the file path and it's directory to extract the root file name w/o extension
-		std::filesystem::path baseName = std::filesystem::absolute(std::filesystem::path(_description.Filename));
+		std::filesystem::path baseName = std::filesystem::absolute(std::filesystem::path(description.Filename));
 		std::filesystem::path directory = baseName.parent_path();
 		std::filesystem::path rootFileName = directory / baseName.stem();
 
@@ -82,106 +150,210 @@ void TextureCube::_LoadFromDescription()
 			targetPath += baseName.extension();
 
 			// If the file exists, store it in the description
-			if (std::filesystem::exists(targetPath)) {
-				_description.FaceFileNames[face] = targetPath.string();
+			if (VirtualFileSystem::Exists(targetPath.string())) {
+				description.FaceFileNames[face] = targetPath.string();
 			}
 		}
 	}
+}
 
-	// If we don't have 6 faces for our cube, something has gone horribly wrong (or the files don't exist)
-	if (_description.FaceFileNames.size() != 6) {
-		LOG_ERROR("TextureCube was not given 6 faces, aborting load");
-		return;
+std::vector<std::string> TextureCube::_GetSources(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
+{
+	std::vector<std::string> sources(6);
+	for (int ix = 0; ix < 6; ix++) {
+		sources[ix] = faceFilenames.at((CubeMapFace)ix);
 	}
+	return sources;
+}
 
-	// Load all the images into the texture
-	_LoadImages(_description.FaceFileNames);
+std::string TextureCube::_GetCacheVariant(bool generateMips, bool gammaCorrectMips)
+{
+	return std::string("cube") + (generateMips ? (gammaCorrectMips ? ":mips-srgb" : ":mips") : "");
+}
+
+TextureCache::CookedTexture TextureCube::_PackFaces(const std::vector<TextureCache::CookedTexture>& faces)
+{
+	// Each level stores all 6 faces back to back
+	TextureCache::CookedTexture packed;
+	packed.Type          = TextureType::Cubemap;
+	packed.Format        = faces[0].Format;
+	packed.Layout        = faces[0].Layout;
+	packed.ComponentType = faces[0].ComponentType;
+	packed.Levels.resize(faces[0].Levels.size());
+	for (size_t level = 0; level < packed.Levels.size(); level++) {
+		TextureCache::MipLevel& out = packed.Levels[level];
+		out.Width  = faces[0].Levels[level].Width;
+		out.Height = faces[0].Levels[level].Height;
+		out.Depth  = 6;
+		out.Data.reserve(faces[0].Levels[level].Data.size() * 6);
+		for (auto& face : faces) {
+			out.Data.insert(out.Data.end(), face.Levels[level].Data.begin(), face.Levels[level].Data.end());
+		}
+	}
+	return packed;
 }
 
 void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
 {
-	// Will store all of our texture data, back to back in memory
-	uint8_t* datastore = nullptr;
-	// The size of a single face's texture, in bytes
-	size_t textureDataSize = 0;
+	// The cache is keyed by all 6 face files, and goes stale if any of them change
+	std::vector<std::string> sources = _GetSources(faceFilenames);
 
-	// The number of channels that we're expecting
-	int numChannels = 0;
+	const bool generateMips = _description.GenerateMipMaps;
+	const bool gammaCorrectMips = _description.GammaCorrectMips;
+	std::string variant = _GetCacheVariant(generateMips, gammaCorrectMips);
 
-	// Load all 6 faces
+	// If we've cooked this cubemap before, we can upload it all in one go
+	TextureCache::CookedTexture cached;
+	if (TextureCache::TryLoad(sources, variant, cached)) {
+		_UploadCooked(cached);
+		return;
+	}
+
+	// Otherwise we decode all 6 faces at once, and upload each one as soon as it's ready. The workers
+	// also build each face's mip chain, since cube faces are filtered independently anyways
+	std::vector<TextureCache::CookedTexture> faces(6);
+	std::mutex mutex;
+	std::condition_variable faceReady;
+	std::deque<int> completed;
+
+	// NOTE: STBI's flip flag is global, so we set it before starting any workers
+	stbi_set_flip_vertically_on_load(true);
+	std::vector<std::thread> workers;
+	workers.reserve(6);
 	for (int ix = 0; ix < 6; ix++) {
-		CubeMapFace face = (CubeMapFace)ix;
-		
-		const std::string& filename = _description.FaceFileNames[face];
-		int fileWidth, fileHeight, fileNumChannels;
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 0);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			if (data != nullptr) { delete[] datastore; }
+		workers.emplace_back([&, ix]() {
+			TextureCache::CookedTexture face = TextureCache::DecodeImage(sources[ix], 0);
+			if (generateMips && face.IsValid()) {
+				TextureCache::GenerateMipChain(face, gammaCorrectMips);
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			faces[ix] = std::move(face);
+			completed.push_back(ix);
+			faceReady.notify_one();
+		});
+	}
+
+	// Set our pixel alignment to a single byte so we don't get banding
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	bool isAllocated = false;
+	bool hasFailed = false;
+	for (int received = 0; received < 6; received++) {
+		int ix;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			faceReady.wait(lock, [&] { return !completed.empty(); });
+			ix = completed.front();
+			completed.pop_front();
+		}
+
+		// Once something has gone wrong, we still need to wait for the other workers to finish
+		if (hasFailed) {
+			continue;
+		}
+
+		const std::string& filename = sources[ix];
+		const TextureCache::CookedTexture& face = faces[ix];
+
+		// If we could not load any data, warn and abort
+		if (!face.IsValid()) {
 			LOG_ERROR("STBI Failed to load image from \"{}\"", filename);
-			return;
+			hasFailed = true;
+			continue;
 		}
 		// If the texture is not square, warn and abort
-		if (fileWidth != fileHeight) {
-			if (data != nullptr) { delete[] datastore; }
+		if (face.Levels[0].Width != face.Levels[0].Height) {
 			LOG_ERROR("Image loaded from \"{}\" was not square", filename);
-			stbi_image_free(data);
-			return;
+			hasFailed = true;
+			continue;
 		}
-		// If the dataStore is empty, this is the first texture we loaded
-		if (datastore == nullptr) {
-			// Store the size and number of channels
-			_description.Size = fileWidth;
-			numChannels = fileNumChannels;
-
-			// Get the format and pixel format for the number of channels
-			_description.Format = GetInternalFormatForChannels8(numChannels);
-			_description.FormatHint = GetPixelFormatForChannels(numChannels);
-
-			// Determine how many bytes we'll need to store a single face worth of data
-			textureDataSize = ((size_t)_description.Size * _description.Size * GetTexelSize(_description.FormatHint, PixelType::Byte));
-
-			// This is one of those poorly documented things in OpenGL
-			if ((GetTexelSize(_description.FormatHint, PixelType::Byte) * _description.Size) % 4 != 0) {
-				LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-			}
 
-			// Allocate the data store for our image data
-			datastore = new uint8_t[textureDataSize * 6];
+		// The first face to arrive determines the size and format of the cube
+		if (!isAllocated) {
+			_description.Size = face.Levels[0].Width;
+			_description.Format = face.Format;
+			_description.FormatHint = face.Layout;
+			_SetTextureParams();
+			isAllocated = true;
 		}
-		// If this is NOT the first image, and it does not match previous images, abort
-		else if (fileWidth != _description.Size || fileNumChannels != numChannels) {
-			delete[] datastore;
+		// If it does not match previous images, abort
+		else if (face.Levels[0].Width != _description.Size || face.Format != _description.Format) {
 			LOG_WARN("Image \"{}\" did not match size or format of texture cube", filename);
-			stbi_image_free(data);
-			return;
+			hasFailed = true;
+			continue;
+		}
+
+		// Upload this face's levels into it's layer of the cube
+		const uint32_t numLevels = generateMips ? static_cast<uint32_t>(face.Levels.size()) : 1u;
+		for (uint32_t level = 0; level < numLevels; level++) {
+			const TextureCache::MipLevel& data = face.Levels[level];
+			glTextureSubImage3D(_rendererId, level, 0, 0, ix, data.Width, data.Height, 1, *face.Layout, *face.ComponentType, data.Data.data());
 		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-		// Copy the data we loaded into the corresponding location in the data store
-		memcpy(datastore + textureDataSize * ix, data, textureDataSize);
-		stbi_image_free(data);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	if (hasFailed) {
+		return;
 	}
 
+	// Pack the faces into a single cubemap for the cache
+	TextureCache::Store(sources, variant, _PackFaces(faces));
+}
+
+void TextureCube::_LoadPacked(const std::string& filename)
+{
+	TextureCache::CookedTexture image;
+	if (!TextureCache::LoadFile(filename, image)) {
+		LOG_ERROR("Failed to load packed cubemap from \"{}\"", filename);
+		return;
+	}
+	if (image.Type != TextureType::Cubemap || image.Levels[0].Depth != 6 || image.Levels[0].Width != image.Levels[0].Height) {
+		LOG_ERROR("File \"{}\" does not contain a cubemap", filename);
+		return;
+	}
+
+	// Only keep the mips if we want them, and the file contains them
+	_description.GenerateMipMaps = _description.GenerateMipMaps && image.Levels.size() > 1;
+	_UploadCooked(image);
+}
+
+void TextureCube::_UploadCooked(const TextureCache::CookedTexture& image) {
+	_description.Size = image.Levels[0].Width;
+	_description.Format = image.Format;
+	_description.FormatHint = image.Layout;
+
 	// Allocate memory and set up initial parameters
 	_SetTextureParams();
 
 	// Set our pixel alignment to a single byte so we don't get banding
-	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// Upload each level, all 6 faces at once (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
+	const uint32_t numLevels = glm::min(static_cast<uint32_t>(image.Levels.size()), _description.GenerateMipMaps ? TextureCache::CalcMipLevels(_description.Size, _description.Size) : 1u);
+	for (uint32_t ix = 0; ix < numLevels; ix++) {
+		const TextureCache::MipLevel& level = image.Levels[ix];
+		glTextureSubImage3D(_rendererId, ix, 0, 0, 0, level.Width, level.Height, 6, *image.Layout, *image.ComponentType, level.Data.data());
+	}
 
-	// Upload our data to our image (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
-	glTextureSubImage3D(_rendererId, 0, 0, 0, 0, _description.Size, _description.Size, 6, *_description.FormatHint, *PixelType::UByte, datastore);
-	delete[] datastore;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// If the image didn't come with a full chain, let the driver fill in the rest
+	if (_description.GenerateMipMaps && numLevels < TextureCache::CalcMipLevels(_description.Size, _description.Size)) {
+		glGenerateTextureMipmap(_rendererId);
+	}
 }
 
 void TextureCube::_SetTextureParams(){
 	// Make sure the size is greater than zero and that we have a format specified before trying to set parameters
 	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown) {
-		// Allocates the memory for our texture
-		glTextureStorage2D(_rendererId, 1, (GLenum)_description.Format, _description.Size, _description.Size);
+		// Allocates the memory for our texture, including the mip chain if we want one
+		int levels = _description.GenerateMipMaps ? TextureCache::CalcMipLevels(_description.Size, _description.Size) : 1;
+		glTextureStorage2D(_rendererId, levels, (GLenum)_description.Format, _description.Size, _description.Size);
 
 		// Set up our texture parameters
 		glTextureParameteri(_rendererId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
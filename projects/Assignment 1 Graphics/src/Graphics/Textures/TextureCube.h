@@ -1,6 +1,7 @@
 #pragma once
 #include <EnumToString.h>
 #include "ITexture.h"
+#include "Graphics/Textures/TextureCache.h"
 
 /*
 0 	GL_TEXTURE_CUBE_MAP_POSITIVE_X
@@ -41,10 +42,21 @@ struct TextureCubeDescription {
 	/// The filter to use when one texel will map to multiple pixels
 	/// </summary>
 	MagFilter      MagnificationFilter;
+	/// <summary>
+	/// True if this texture should have a full mip chain (generated when the faces are cooked)
+	/// </summary>
+	bool           GenerateMipMaps;
+	/// <summary>
+	/// True if the faces hold sRGB encoded color, so their mips are averaged in linear space. Should be
+	/// false for cubemaps holding linear data
+	/// </summary>
+	bool           GammaCorrectMips;
 
 	/// <summary>
 	/// The base filename to load all cubemap faces from, will select files
 	/// for each face with the format "Filename_Face.ext" (ex: "Skybox_NegX.png")
+	/// If this is a ".ctex" file, it is loaded as a pre-packed cubemap containing
+	/// all faces and mips (as found in the TextureCache folder)
 	/// </summary>
 	std::string    Filename;
 
@@ -68,6 +80,8 @@ struct TextureCubeDescription {
 		Format(InternalFormat::Unknown),
 		MinificationFilter(MinFilter::NearestMipLinear),
 		MagnificationFilter(MagFilter::Linear),
+		GenerateMipMaps(true),
+		GammaCorrectMips(true),
 		Filename(""),
 		FormatHint(PixelFormat::RGBA)
 	{ }
@@ -110,6 +124,12 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static TextureCube::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Does the CPU side of loading a texture from it's JSON data (decoding, cooking) and stages the result
+	/// in the TextureCache, so that FromJson can skip straight to uploading. Safe to call from worker threads
+	/// </summary>
+	static void Prefetch(const nlohmann::json& data);
+	virtual size_t GetGpuMemoryUsage() const override { return _CalcStorageSize(_description.Format, _description.Size, _description.Size, 1, _description.GenerateMipMaps) * 6; }
 
 protected:
 	TextureCubeDescription _description;
@@ -117,8 +137,39 @@ protected:
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
 
+	/// <summary>
+	/// Reads a description from it's JSON representation
+	/// </summary>
+	static TextureCubeDescription _ParseDescription(const nlohmann::json& data);
+	/// <summary>
+	/// Fills in a description's face file names from it's base filename, if it has no face file names
+	/// </summary>
+	static void _FindFaceFiles(TextureCubeDescription& description);
+	/// <summary>
+	/// Gets the face file names in face order, which are used as the TextureCache sources
+	/// </summary>
+	static std::vector<std::string> _GetSources(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
+	/// <summary>
+	/// Gets the TextureCache variant key for a cubemap
+	/// </summary>
+	static std::string _GetCacheVariant(bool generateMips, bool gammaCorrectMips);
+	/// <summary>
+	/// Packs 6 faces with matching sizes and formats into a single cooked cubemap
+	/// </summary>
+	static TextureCache::CookedTexture _PackFaces(const std::vector<TextureCache::CookedTexture>& faces);
+	/// <summary>
+	/// Loads a pre-packed cubemap in the TextureCache format
+	/// </summary>
+	/// <param name="filename">The path to the .ctex file</param>
+	void _LoadPacked(const std::string& filename);
+
 	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
+	/// <summary>
+	/// Allocates storage for and uploads a cooked cubemap, where each level stores all 6 faces back to back
+	/// </summary>
+	/// <param name="image">The cubemap to upload</param>
+	void _UploadCooked(const TextureCache::CookedTexture& image);
 };
\ No newline at end of file
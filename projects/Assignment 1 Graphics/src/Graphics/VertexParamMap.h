@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <vector>
 #include <GLM/glm.hpp>
+#include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Graphics/VertexArrayObject.h"
 
 /// <summary>
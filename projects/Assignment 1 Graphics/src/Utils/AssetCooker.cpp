@@ -0,0 +1,381 @@
+#include "Utils/AssetCooker.h"
+
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stb_truetype.h>
+#include <stb_image.h>
+#include <Logging.h>
+
+#include "Utils/HashHelpers.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Graphics/ShaderSourceCache.h"
+#include "Graphics/Textures/TextureCache.h"
+#include "Graphics/Textures/Texture2D.h"
+#include "Graphics/Textures/Texture3D.h"
+
+namespace fs = std::filesystem;
+
+AssetCooker::Report AssetCooker::Cook(const Settings& settings) {
+	Report report;
+	auto startTime = std::chrono::steady_clock::now();
+
+	// STBI's flip flag is a global, the runtime loaders all set it to true so we do the same here before any
+	// cook jobs start, otherwise cooked textures would come out upside down
+	stbi_set_flip_vertically_on_load(true);
+
+	std::error_code err;
+	const fs::path resourceDir = fs::absolute(settings.ResourceDirectory, err);
+	const fs::path outputDir = fs::absolute(settings.OutputDirectory, err);
+	if (!fs::is_directory(resourceDir, err)) {
+		report.Errors.push_back("Resource directory \"" + resourceDir.string() + "\" does not exist");
+		report.NumFailed++;
+		return report;
+	}
+	fs::create_directories(outputDir, err);
+
+	// Collect our sources, sorted so that cooks are repeatable
+	std::vector<std::string> sources;
+	for (const auto& entry : fs::recursive_directory_iterator(resourceDir, err)) {
+		if (entry.is_regular_file()) {
+			sources.push_back(CookManifest::NormalizePath(fs::relative(entry.path(), resourceDir, err).generic_string()));
+		}
+	}
+	std::sort(sources.begin(), sources.end());
+
+	// Make sure the output directory has up to date copies of the sources, so that everything is cooked from
+	// (and validated against) the same files the runtime will see
+	if (!fs::equivalent(resourceDir, outputDir, err)) {
+		_SyncSources(resourceDir.string(), outputDir.string(), sources);
+	}
+
+	// Everything from here on works with paths relative to the output directory, the same as the runtime
+	const fs::path previousDir = fs::current_path(err);
+	fs::current_path(outputDir, err);
+
+	CookManifest::Clear();
+	CookManifest::Load(CookManifest::DefaultPath);
+	std::unordered_map<std::string, std::vector<nlohmann::json>> variants = _CollectSettings(sources);
+
+	// Work out which sources need to be cooked
+	std::vector<Job> jobs;
+	for (const auto& source : sources) {
+		CookAssetType type = GetAssetType(source);
+		if (type == CookAssetType::Unknown) {
+			continue;
+		}
+
+		Job job;
+		job.Path = source;
+		job.Type = type;
+		auto it = variants.find(source);
+		if (it != variants.end()) {
+			job.Variants = it->second;
+		}
+
+		// Our previous dependencies are good enough to tell if anything changed, they get updated when we cook
+		const CookManifest::Entry* previous = CookManifest::Find(source);
+		std::vector<std::string> dependencies = previous != nullptr ? previous->Dependencies : std::vector<std::string>();
+		uint64_t cookKey = 0;
+		if (!CookManifest::HashFile(source, job.Entry.SourceHash) || !_CalcCookKey(job, dependencies, cookKey)) {
+			job.NeedsCook = true;
+		} else {
+			job.NeedsCook = settings.Force || previous == nullptr || previous->CookKey != cookKey;
+			for (const auto& output : previous != nullptr ? previous->Outputs : std::vector<std::string>()) {
+				job.NeedsCook |= !fs::exists(output, err);
+			}
+		}
+		if (!job.NeedsCook) {
+			job.Entry = *previous;
+		}
+		job.Entry.Type = ~type;
+		job.Entry.CookKey = cookKey;
+		jobs.push_back(std::move(job));
+	}
+	report.NumAssets = jobs.size();
+
+	auto runJob = [](Job& job) {
+		bool success = false;
+		try {
+			switch (job.Type) {
+				case CookAssetType::Mesh:    success = _CookMesh(job); break;
+				case CookAssetType::Texture: success = _CookTexture(job); break;
+				case CookAssetType::Lut:     success = _CookLut(job); break;
+				case CookAssetType::Font:    success = _CookFont(job); break;
+				case CookAssetType::Shader:  success = _CookShader(job); break;
+				default: break;
+			}
+		}
+		catch (const std::exception& e) {
+			job.Error = e.what();
+			success = false;
+		}
+		job.Failed = !success;
+	};
+
+	// Everything except shaders is independent, so we spread them over our workers. The shader cache is not
+	// thread safe, but shaders are cheap to process, so they are handled on this thread afterwards
+	std::vector<Job*> parallelJobs;
+	std::vector<Job*> serialJobs;
+	for (auto& job : jobs) {
+		if (job.NeedsCook) {
+			(job.Type == CookAssetType::Shader ? serialJobs : parallelJobs).push_back(&job);
+		}
+	}
+
+	int numThreads = settings.NumThreads > 0 ? settings.NumThreads : static_cast<int>(std::thread::hardware_concurrency());
+	numThreads = std::clamp(numThreads, 1, std::max(1, static_cast<int>(parallelJobs.size())));
+	std::atomic<size_t> nextJob(0);
+	std::vector<std::thread> workers;
+	for (int ix = 0; ix < numThreads; ix++) {
+		workers.emplace_back([&]() {
+			for (size_t jobIx = nextJob++; jobIx < parallelJobs.size(); jobIx = nextJob++) {
+				runJob(*parallelJobs[jobIx]);
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	for (Job* job : serialJobs) {
+		runJob(*job);
+	}
+
+	// Update the manifest with our results, and clean up anything that is no longer produced
+	std::set<std::string> cooked;
+	for (auto& job : jobs) {
+		cooked.insert(job.Path);
+		const CookManifest::Entry* previous = CookManifest::Find(job.Path);
+
+		if (!job.NeedsCook) {
+			report.NumSkipped++;
+		} else if (job.Failed) {
+			report.NumFailed++;
+			report.Errors.push_back(job.Path + ": " + (job.Error.empty() ? "Failed to cook" : job.Error));
+			// Leaving a failed asset out of the manifest makes sure the next cook tries again
+			CookManifest::Remove(job.Path);
+			continue;
+		} else {
+			report.NumCooked++;
+			_CalcCookKey(job, job.Entry.Dependencies, job.Entry.CookKey);
+			if (previous != nullptr) {
+				for (const auto& output : previous->Outputs) {
+					if (std::find(job.Entry.Outputs.begin(), job.Entry.Outputs.end(), output) == job.Entry.Outputs.end()) {
+						fs::remove(output, err);
+					}
+				}
+			}
+		}
+
+		// Record the write time of the file we hashed, so the runtime can skip hashing unchanged files
+		job.Entry.WriteTime = fs::last_write_time(job.Path, err).time_since_epoch().count();
+		CookManifest::Set(job.Path, job.Entry);
+	}
+	for (const auto& source : CookManifest::GetSources()) {
+		if (cooked.count(source) == 0) {
+			for (const auto& output : CookManifest::Find(source)->Outputs) {
+				fs::remove(output, err);
+			}
+			CookManifest::Remove(source);
+		}
+	}
+	CookManifest::Save(CookManifest::DefaultPath);
+
+	fs::current_path(previousDir, err);
+	report.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return report;
+}
+
+CookAssetType AssetCooker::GetAssetType(const std::string& path) {
+	std::string extension = fs::path(path).extension().string();
+	StringTools::ToLower(extension);
+
+	if (extension == ".obj") {
+		return CookAssetType::Mesh;
+	} else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp") {
+		return CookAssetType::Texture;
+	} else if (extension == ".cube") {
+		return CookAssetType::Lut;
+	} else if (extension == ".ttf" || extension == ".otf") {
+		return CookAssetType::Font;
+	} else if (extension == ".glsl" || extension == ".vert" || extension == ".frag" || extension == ".geom" || extension == ".comp" || extension == ".tesc" || extension == ".tese") {
+		return CookAssetType::Shader;
+	}
+	return CookAssetType::Unknown;
+}
+
+void AssetCooker::_SyncSources(const std::string& resourceDir, const std::string& outputDir, const std::vector<std::string>& sources) {
+	std::error_code err;
+	for (const auto& source : sources) {
+		fs::path from = fs::path(resourceDir) / source;
+		fs::path to = fs::path(outputDir) / source;
+
+		fs::file_time_type fromTime = fs::last_write_time(from, err);
+		if (fs::exists(to, err) && fs::file_size(to, err) == fs::file_size(from, err) && fs::last_write_time(to, err) == fromTime) {
+			continue;
+		}
+		fs::create_directories(to.parent_path(), err);
+		fs::copy_file(from, to, fs::copy_options::overwrite_existing, err);
+		// Keep the source's write time, so that the copy doesn't look newer than anything cooked from it
+		fs::last_write_time(to, fromTime, err);
+	}
+}
+
+std::unordered_map<std::string, std::vector<nlohmann::json>> AssetCooker::_CollectSettings(const std::vector<std::string>& sources) {
+	std::unordered_map<std::string, std::vector<nlohmann::json>> result;
+	for (const auto& source : sources) {
+		if (fs::path(source).extension() != ".json") {
+			continue;
+		}
+
+		// Resource manifests are objects keyed by type name, containing resource blobs keyed by GUID
+		nlohmann::json blob = nlohmann::json::parse(VirtualFileSystem::ReadText(source), nullptr, false);
+		if (blob.is_discarded() || !blob.is_object()) {
+			continue;
+		}
+		for (const char* typeName : { "Texture2D", "Texture3D" }) {
+			if (!blob.contains(typeName) || !blob[typeName].is_object()) {
+				continue;
+			}
+			for (auto& [guid, resource] : blob[typeName].items()) {
+				std::string filename = JsonGet<std::string>(resource, "filename", "");
+				if (!filename.empty()) {
+					result[CookManifest::NormalizePath(filename)].push_back(resource);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+std::string AssetCooker::_GetSettingsKey(const Job& job) {
+	// Only the settings that change the cooked data are part of the key, so changing a texture's filtering
+	// (for instance) doesn't cause a re-cook
+	std::vector<nlohmann::json> blobs = job.Variants.empty() ? std::vector<nlohmann::json>{ nlohmann::json::object() } : job.Variants;
+	std::set<std::string> keys;
+	for (const auto& blob : blobs) {
+		switch (job.Type) {
+			case CookAssetType::Texture:
+				keys.insert(TextureCache::_GetImage2DVariant(GetTexelComponentCount(Texture2DDescription().FormatHint), JsonGet(blob, "generate_mipmaps", false), JsonGet(blob, "gamma_correct_mips", true)));
+				break;
+			case CookAssetType::Lut:
+				keys.insert(Texture3D::_GetLutVariant(Texture3D::_GetLutFormat(JsonParseEnum(InternalFormat, blob, "internal_format", InternalFormat::Unknown)), JsonGet(blob, "generate_mipmaps", false)));
+				break;
+			default:
+				break;
+		}
+	}
+
+	std::string result = ~job.Type;
+	for (const auto& key : keys) {
+		result += ";" + key;
+	}
+	return result;
+}
+
+bool AssetCooker::_CalcCookKey(const Job& job, const std::vector<std::string>& dependencies, uint64_t& result) {
+	result = HashHelpers::Fnv1a(_GetSettingsKey(job));
+	result = HashHelpers::Combine(result, COOKER_VERSION);
+	result = HashHelpers::Combine(result, job.Entry.SourceHash);
+	for (const auto& dependency : dependencies) {
+		uint64_t hash = 0;
+		if (!CookManifest::HashFile(dependency, hash)) {
+			return false;
+		}
+		result = HashHelpers::Fnv1a(dependency, HashHelpers::Combine(result, hash));
+	}
+	return true;
+}
+
+bool AssetCooker::_CookMesh(Job& job) {
+	std::string output = fs::path(job.Path).replace_extension(".bin").generic_string();
+	OptimizedObjLoader::ConvertToBinary(job.Path, output);
+	job.Entry.Outputs = { output };
+	return true;
+}
+
+bool AssetCooker::_CookTexture(Job& job) {
+	std::vector<nlohmann::json> blobs = job.Variants.empty() ? std::vector<nlohmann::json>{ nlohmann::json::object() } : job.Variants;
+	const int targetChannels = GetTexelComponentCount(Texture2DDescription().FormatHint);
+
+	// Multiple resources may use the same variant, so we only cook each one once
+	std::set<std::string> outputs;
+	for (const auto& blob : blobs) {
+		const bool generateMips = JsonGet(blob, "generate_mipmaps", false);
+		const bool gammaCorrectMips = JsonGet(blob, "gamma_correct_mips", true);
+		std::string variant = TextureCache::_GetImage2DVariant(targetChannels, generateMips, gammaCorrectMips);
+		std::string output = TextureCache::GetCacheFilePath({ job.Path }, variant);
+		if (!outputs.insert(output).second) {
+			continue;
+		}
+
+		TextureCache::CookedTexture texture = TextureCache::CookImage2D(job.Path, targetChannels, generateMips, gammaCorrectMips);
+		if (!texture.IsValid()) {
+			job.Error = "Failed to decode image";
+			return false;
+		}
+		if (!TextureCache::SaveFile(output, texture)) {
+			job.Error = "Failed to write \"" + output + "\"";
+			return false;
+		}
+	}
+	job.Entry.Outputs.assign(outputs.begin(), outputs.end());
+	return true;
+}
+
+bool AssetCooker::_CookLut(Job& job) {
+	std::vector<nlohmann::json> blobs = job.Variants.empty() ? std::vector<nlohmann::json>{ nlohmann::json::object() } : job.Variants;
+
+	std::set<std::string> outputs;
+	for (const auto& blob : blobs) {
+		InternalFormat format = Texture3D::_GetLutFormat(JsonParseEnum(InternalFormat, blob, "internal_format", InternalFormat::Unknown));
+		const bool generateMips = JsonGet(blob, "generate_mipmaps", false);
+		std::string output = TextureCache::GetCacheFilePath({ job.Path }, Texture3D::_GetLutVariant(format, generateMips));
+		if (!outputs.insert(output).second) {
+			continue;
+		}
+
+		std::string title;
+		TextureCache::CookedTexture texture = Texture3D::_CookLut(job.Path, format, generateMips, title);
+		if (!texture.IsValid()) {
+			job.Error = "Failed to parse LUT";
+			return false;
+		}
+		if (!TextureCache::SaveFile(output, texture)) {
+			job.Error = "Failed to write \"" + output + "\"";
+			return false;
+		}
+	}
+	job.Entry.Outputs.assign(outputs.begin(), outputs.end());
+	return true;
+}
+
+bool AssetCooker::_CookFont(Job& job) {
+	// Font atlases are baked at runtime, we just make sure that the font can actually be loaded
+	FileView file = VirtualFileSystem::Open(job.Path);
+	stbtt_fontinfo info;
+	if (!file || stbtt_GetFontOffsetForIndex(file.Data(), 0) < 0 || !stbtt_InitFont(&info, file.Data(), stbtt_GetFontOffsetForIndex(file.Data(), 0))) {
+		job.Error = "Not a valid font file";
+		return false;
+	}
+	job.Entry.Outputs.clear();
+	return true;
+}
+
+bool AssetCooker::_CookShader(Job& job) {
+	// Shader binaries depend on the driver, so we can only check that the source and all of it's includes can
+	// be resolved. The includes are recorded so that changing an included file re-validates everything using it
+	if (ShaderSourceCache::Resolve(job.Path).empty()) {
+		job.Error = "Failed to resolve shader source";
+		return false;
+	}
+	job.Entry.Dependencies = ShaderSourceCache::GetIncludes(job.Path);
+	job.Entry.Outputs.clear();
+	return true;
+}
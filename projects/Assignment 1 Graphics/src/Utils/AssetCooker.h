@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <json.hpp>
+
+#include <EnumToString.h>
+
+#include "Utils/CookManifest.h"
+
+/// <summary>
+/// The kinds of assets that the cooker knows how to process
+/// </summary>
+ENUM(CookAssetType, int,
+	 Unknown = 0,
+	 Mesh    = 1,
+	 Texture = 2,
+	 Lut     = 3,
+	 Font    = 4,
+	 Shader  = 5
+);
+
+/// <summary>
+/// Processes the contents of a resource directory ahead of time, so the runtime can load the results directly
+/// instead of converting assets the first time they are used. Only assets whose contents, settings or
+/// dependencies have changed since the last cook are processed, and the results are recorded in a CookManifest
+/// in the output directory
+///
+/// The output directory is the runtime's working directory, cooked data is written where the loaders expect it:
+///  - Meshes are converted to binary meshes (with their LODs) next to the source
+///  - Textures and LUTs are stored in the TextureCache, using the settings from any resource manifests in the
+///    resource directory (or the loader's defaults for images that aren't in a manifest)
+///  - Fonts and shaders are validated, and shaders have their includes recorded as dependencies. Font atlases
+///    and shader binaries depend on the GL context, so they are still built at runtime
+/// </summary>
+class AssetCooker {
+public:
+	/// <summary>
+	/// Settings for a single run of the cooker
+	/// </summary>
+	struct Settings {
+		// The directory containing the source assets
+		std::string ResourceDirectory;
+		// The directory to cook into, this should be the directory the game runs from
+		std::string OutputDirectory;
+		// The number of worker threads, or 0 to use one per hardware thread
+		int         NumThreads = 0;
+		// True to cook everything, even if it is up to date
+		bool        Force = false;
+	};
+
+	/// <summary>
+	/// Summarizes the results of a cook
+	/// </summary>
+	struct Report {
+		size_t                   NumAssets  = 0;
+		size_t                   NumCooked  = 0;
+		size_t                   NumSkipped = 0;
+		size_t                   NumFailed  = 0;
+		double                   Seconds    = 0.0;
+		std::vector<std::string> Errors;
+	};
+
+	// Bump this whenever the cooker's output changes, so that everything gets re-cooked
+	static const uint32_t COOKER_VERSION = 2;
+
+	/// <summary>
+	/// Cooks all out of date assets in a resource directory. Note that this changes the working directory to
+	/// the output directory for the duration of the cook
+	/// </summary>
+	/// <param name="settings">The settings for the cook</param>
+	/// <returns>A summary of what was cooked</returns>
+	static Report Cook(const Settings& settings);
+
+	/// <summary>
+	/// Gets what type of asset a file is from it's extension
+	/// </summary>
+	static CookAssetType GetAssetType(const std::string& path);
+
+protected:
+	AssetCooker() = default;
+	~AssetCooker() = default;
+
+	// A single source asset to cook
+	struct Job {
+		std::string                 Path;
+		CookAssetType               Type = CookAssetType::Unknown;
+		// The resource blobs from manifests that reference this asset, each one may need a different cooked variant
+		std::vector<nlohmann::json> Variants;
+		CookManifest::Entry         Entry;
+		bool                        NeedsCook = false;
+		bool                        Failed = false;
+		std::string                 Error;
+	};
+
+	/// <summary>
+	/// Copies source files into the output directory when they are missing or differ from the copy there
+	/// </summary>
+	static void _SyncSources(const std::string& resourceDir, const std::string& outputDir, const std::vector<std::string>& sources);
+	/// <summary>
+	/// Collects the settings blobs for every file referenced by Texture2D and Texture3D resources in any
+	/// resource manifests in the given files
+	/// </summary>
+	static std::unordered_map<std::string, std::vector<nlohmann::json>> _CollectSettings(const std::vector<std::string>& sources);
+	/// <summary>
+	/// Gets a string describing all the settings that affect the cooked output of a job
+	/// </summary>
+	static std::string _GetSettingsKey(const Job& job);
+	/// <summary>
+	/// Hashes everything that affects a job's output, returns false if the source or a dependency can't be read
+	/// </summary>
+	static bool _CalcCookKey(const Job& job, const std::vector<std::string>& dependencies, uint64_t& result);
+
+	static bool _CookMesh(Job& job);
+	static bool _CookTexture(Job& job);
+	static bool _CookLut(Job& job);
+	static bool _CookFont(Job& job);
+	static bool _CookShader(Job& job);
+};
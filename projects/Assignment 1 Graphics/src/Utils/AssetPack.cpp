@@ -0,0 +1,162 @@
+#include "Utils/AssetPack.h"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+std::string AssetPack::NormalizePath(const std::string& path) {
+	std::string result = fs::path(path).lexically_normal().generic_string();
+	while (result.compare(0, 2, "./") == 0) {
+		result.erase(0, 2);
+	}
+	// Windows paths are case insensitive, so we are too
+	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return result;
+}
+
+AssetPackWriter::AssetPackWriter(bool compress, float maxCompressedRatio) :
+	_compress(compress),
+	_maxCompressedRatio(maxCompressedRatio),
+	_entries(std::vector<PendingEntry>())
+{ }
+
+bool AssetPackWriter::AddFile(const std::string& sourcePath, const std::string& packPath) {
+	std::ifstream file(sourcePath, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+	std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0, std::ios::beg);
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	if (!file) {
+		return false;
+	}
+
+	std::error_code err;
+	int64_t writeTime = fs::last_write_time(sourcePath, err).time_since_epoch().count();
+	AddData(packPath, std::move(data), writeTime);
+	return true;
+}
+
+void AssetPackWriter::AddData(const std::string& packPath, std::vector<uint8_t> data, int64_t writeTime) {
+	std::string path = AssetPack::NormalizePath(packPath);
+
+	// Adding the same path twice replaces the old contents
+	auto it = std::find_if(_entries.begin(), _entries.end(), [&](const PendingEntry& entry) { return entry.Path == path; });
+	if (it != _entries.end()) {
+		it->Data = std::move(data);
+		it->WriteTime = writeTime;
+	} else {
+		_entries.push_back({ path, std::move(data), writeTime });
+	}
+}
+
+size_t AssetPackWriter::GetTotalSize() const {
+	size_t result = 0;
+	for (const auto& entry : _entries) {
+		result += entry.Data.size();
+	}
+	return result;
+}
+
+bool AssetPackWriter::Write(const std::string& path, std::string& error) const {
+	// The index is sorted by path so that the reader can binary search it
+	std::vector<const PendingEntry*> sorted;
+	sorted.reserve(_entries.size());
+	for (const auto& entry : _entries) {
+		sorted.push_back(&entry);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const PendingEntry* a, const PendingEntry* b) { return a->Path < b->Path; });
+
+	std::error_code err;
+	if (fs::path(path).has_parent_path()) {
+		fs::create_directories(fs::path(path).parent_path(), err);
+	}
+
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file) {
+			error = "Failed to open \"" + tempPath + "\" for writing";
+			return false;
+		}
+
+		// We come back and fill the header in once we know where the index is
+		AssetPack::FileHeader header = AssetPack::FileHeader();
+		file.write(reinterpret_cast<const char*>(&header), sizeof(AssetPack::FileHeader));
+		uint64_t offset = sizeof(AssetPack::FileHeader);
+
+		auto pad = [&](uint64_t alignment) {
+			static const char zeros[AssetPack::BLOB_ALIGNMENT] = { 0 };
+			uint64_t padding = (alignment - (offset % alignment)) % alignment;
+			file.write(zeros, padding);
+			offset += padding;
+		};
+
+		std::vector<AssetPack::IndexEntry> index;
+		std::string strings;
+		index.reserve(sorted.size());
+		std::vector<uint8_t> compressed;
+
+		for (const PendingEntry* entry : sorted) {
+			pad(AssetPack::BLOB_ALIGNMENT);
+
+			AssetPack::IndexEntry indexEntry = AssetPack::IndexEntry();
+			indexEntry.PathOffset = static_cast<uint32_t>(strings.size());
+			indexEntry.PathLength = static_cast<uint32_t>(entry->Path.size());
+			indexEntry.DataOffset = offset;
+			indexEntry.Size       = entry->Data.size();
+			indexEntry.StoredSize = entry->Data.size();
+			indexEntry.WriteTime  = entry->WriteTime;
+			indexEntry.Flags      = 0;
+			strings += entry->Path;
+
+			const uint8_t* data = entry->Data.data();
+
+			// Only keep the compressed data if it's worth paying for decompression when loading
+			if (_compress && !entry->Data.empty()) {
+				uLongf compressedSize = compressBound(static_cast<uLong>(entry->Data.size()));
+				compressed.resize(compressedSize);
+				if (compress2(compressed.data(), &compressedSize, entry->Data.data(), static_cast<uLong>(entry->Data.size()), Z_BEST_COMPRESSION) == Z_OK &&
+					compressedSize <= entry->Data.size() * _maxCompressedRatio) {
+					indexEntry.StoredSize = compressedSize;
+					indexEntry.Flags |= AssetPack::FLAG_COMPRESSED;
+					data = compressed.data();
+				}
+			}
+
+			file.write(reinterpret_cast<const char*>(data), indexEntry.StoredSize);
+			offset += indexEntry.StoredSize;
+			index.push_back(indexEntry);
+		}
+
+		pad(alignof(AssetPack::IndexEntry));
+		header.Version         = AssetPack::CURRENT_VERSION;
+		header.NumEntries      = static_cast<uint32_t>(index.size());
+		header.StringTableSize = static_cast<uint32_t>(strings.size());
+		header.IndexOffset     = offset;
+		file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(AssetPack::IndexEntry));
+		file.write(strings.data(), strings.size());
+
+		file.seekp(0, std::ios::beg);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(AssetPack::FileHeader));
+
+		if (!file) {
+			error = "Failed while writing \"" + tempPath + "\"";
+			return false;
+		}
+	}
+
+	fs::remove(path, err);
+	fs::rename(tempPath, path, err);
+	if (err) {
+		error = "Failed to move pack into place: " + err.message();
+		fs::remove(tempPath, err);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Describes the layout of asset packs, which bundle the contents of a resource directory into a single
+/// file so that loading doesn't pay for opening and seeking hundreds of individual files
+///
+/// A pack is a FileHeader, followed by the file data (each blob starting on a BLOB_ALIGNMENT boundary),
+/// followed by the index. The index is one IndexEntry per file, then the path strings that they point into.
+/// Entries are sorted by path so the index can be binary searched. Each blob is either stored as-is, so that
+/// it can be read straight out of the mapped pack, or compressed with zlib if that saved enough space
+/// </summary>
+class AssetPack {
+public:
+	AssetPack() = delete;
+
+	// Blobs start on multiples of this, so that the data can be used in place
+	static const uint32_t BLOB_ALIGNMENT  = 16;
+	// The latest version of the pack format, packs from other versions are rejected
+	static const uint16_t CURRENT_VERSION = 0x01;
+
+	// Set on entries whose data is compressed with zlib
+	static const uint32_t FLAG_COMPRESSED = 1 << 0;
+
+	// Will be put at the start of pack files
+	struct FileHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'O', 'P', 'A', 'K' };
+		// The version code of the pack format
+		uint16_t Version        = 0;
+		uint16_t Reserved       = 0;
+		// The number of IndexEntries in the index
+		uint32_t NumEntries     = 0;
+		// The size of the path string table that follows the index entries
+		uint32_t StringTableSize = 0;
+		// The offset from the start of the file to the first IndexEntry
+		uint64_t IndexOffset    = 0;
+	};
+
+	// Describes a single file in the pack
+	struct IndexEntry {
+		// The offset of the entry's path in the string table, and it's length
+		uint32_t PathOffset;
+		uint32_t PathLength;
+		// The offset from the start of the file to the entry's data
+		uint64_t DataOffset;
+		// The number of bytes of data stored in the pack
+		uint64_t StoredSize;
+		// The size of the file once decompressed, equal to StoredSize for uncompressed entries
+		uint64_t Size;
+		// The last write time of the source file, as a count of std::filesystem::file_time_type ticks
+		int64_t  WriteTime;
+		uint32_t Flags;
+		uint32_t Reserved;
+	};
+
+	/// <summary>
+	/// Converts a path into the form used as keys in the pack index (lexically normal, forward slashes,
+	/// lower case, with no leading "./")
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+};
+
+/// <summary>
+/// Builds asset pack files. Files are added to the writer (which holds their contents in memory),
+/// and the whole pack is written in one go with Write
+/// </summary>
+class AssetPackWriter {
+public:
+	/// <summary>
+	/// Creates a new writer
+	/// </summary>
+	/// <param name="compress">True if entries should be compressed when it saves space</param>
+	/// <param name="maxCompressedRatio">Compressed entries are only kept if they are at most this fraction of their original size</param>
+	AssetPackWriter(bool compress = true, float maxCompressedRatio = 0.9f);
+
+	/// <summary>
+	/// Adds a file from disk to the pack
+	/// </summary>
+	/// <param name="sourcePath">The path of the file to read</param>
+	/// <param name="packPath">The path the file will have inside of the pack</param>
+	/// <returns>True if the file could be read</returns>
+	bool AddFile(const std::string& sourcePath, const std::string& packPath);
+	/// <summary>
+	/// Adds a block of data to the pack
+	/// </summary>
+	/// <param name="packPath">The path the file will have inside of the pack</param>
+	/// <param name="data">The contents of the file</param>
+	/// <param name="writeTime">The last write time to record for the file, in file_time_type ticks</param>
+	void AddData(const std::string& packPath, std::vector<uint8_t> data, int64_t writeTime);
+
+	/// <summary>
+	/// Gets the number of files that have been added to the pack
+	/// </summary>
+	size_t GetEntryCount() const { return _entries.size(); }
+	/// <summary>
+	/// Gets the total size of all files added to the pack, before compression
+	/// </summary>
+	size_t GetTotalSize() const;
+
+	/// <summary>
+	/// Writes all the files that have been added to a pack file
+	/// </summary>
+	/// <param name="path">The path of the pack file to write, will be written via a temp file so that readers never see a partial pack</param>
+	/// <param name="error">Will store a description of what went wrong if the pack could not be written</param>
+	/// <returns>True if the pack was written</returns>
+	bool Write(const std::string& path, std::string& error) const;
+
+protected:
+	struct PendingEntry {
+		std::string          Path;
+		std::vector<uint8_t> Data;
+		int64_t              WriteTime;
+	};
+
+	bool                      _compress;
+	float                     _maxCompressedRatio;
+	std::vector<PendingEntry> _entries;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include <cereal/cereal.hpp>
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+// Note that CerealGLM needs the quaternion types, so it must come after GLM/gtc/quaternion.hpp
+#include <CerealGLM.h>
+
+// GUIDs only provide their cereal functions when this is defined for the whole project
+#ifndef GUID_CEREAL_ARCHIVES
+#error GUID_CEREAL_ARCHIVES must be defined project wide (see Premake5.lua)
+#endif
+#include "Utils/GUID.hpp"
+
+/// <summary>
+/// The archive that binary scenes and manifests are written with. Types that can be stored in binary files
+/// provide a member serialize (or save and load) that accepts these archives, see RenderComponent for an example
+/// </summary>
+typedef cereal::BinaryOutputArchive BinaryOutputArchive;
+/// <summary>
+/// The archive that binary scenes and manifests are read with
+/// </summary>
+typedef cereal::BinaryInputArchive  BinaryInputArchive;
+
+/// <summary>
+/// Scenes and resource manifests saved with this extension are written in their binary formats instead of JSON.
+/// This is deliberately not ".bin", which the OptimizedObjLoader already uses for it's mesh files
+/// </summary>
+constexpr const char* BINARY_FILE_EXTENSION = ".scnb";
+
+/// <summary>
+/// Builds a four character code for identifying binary file formats
+/// </summary>
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+	return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+/// <summary>
+/// Gets the GUID of a resource to store in place of the resource, or an invalid GUID if the resource is null.
+/// Load the resource back with ResourceManager::Get
+/// </summary>
+/// <typeparam name="T">The type of resource</typeparam>
+/// <param name="resource">The resource to get the GUID for</param>
+template <typename T>
+inline Guid GuidOrNull(const std::shared_ptr<T>& resource) {
+	return resource != nullptr ? resource->GetGUID() : Guid();
+}
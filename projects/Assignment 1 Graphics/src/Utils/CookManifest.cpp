@@ -0,0 +1,184 @@
+#include "Utils/CookManifest.h"
+
+#include <filesystem>
+#include <algorithm>
+#include <json.hpp>
+#include <Logging.h>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/HashHelpers.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
+
+namespace fs = std::filesystem;
+
+bool CookManifest::Load(const std::string& path) {
+	std::string contents = VirtualFileSystem::ReadText(path);
+	if (contents.empty()) {
+		return false;
+	}
+
+	nlohmann::json blob = nlohmann::json::parse(contents, nullptr, false);
+	if (blob.is_discarded() || JsonGet(blob, "version", 0) != CURRENT_VERSION || !blob.contains("assets") || !blob["assets"].is_object()) {
+		LOG_WARN("Ignoring cook manifest \"{}\", it is invalid or from another version", path);
+		return false;
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_entries.clear();
+	_validated.clear();
+	for (auto& [source, data] : blob["assets"].items()) {
+		Entry entry;
+		entry.Type         = JsonGet<std::string>(data, "type", "");
+		entry.SourceHash   = HashHelpers::FromHex(JsonGet<std::string>(data, "source_hash", ""));
+		entry.WriteTime    = JsonGet<int64_t>(data, "write_time", 0);
+		entry.CookKey      = HashHelpers::FromHex(JsonGet<std::string>(data, "cook_key", ""));
+		entry.Outputs      = JsonGet(data, "outputs", std::vector<std::string>());
+		entry.Dependencies = JsonGet(data, "dependencies", std::vector<std::string>());
+		_entries[NormalizePath(source)] = std::move(entry);
+	}
+	return true;
+}
+
+void CookManifest::Save(const std::string& path) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	// Sort our entries so that the manifest diffs nicely between cooks
+	std::vector<std::string> sources = GetSources();
+	nlohmann::ordered_json assets = nlohmann::ordered_json::object();
+	for (const auto& source : sources) {
+		const Entry& entry = _entries[source];
+		nlohmann::ordered_json& data = assets[source];
+		data["type"]         = entry.Type;
+		data["source_hash"]  = HashHelpers::ToHex(entry.SourceHash);
+		data["write_time"]   = entry.WriteTime;
+		data["cook_key"]     = HashHelpers::ToHex(entry.CookKey);
+		data["outputs"]      = entry.Outputs;
+		data["dependencies"] = entry.Dependencies;
+	}
+
+	nlohmann::ordered_json blob;
+	blob["version"] = CURRENT_VERSION;
+	blob["assets"] = assets;
+	FileHelpers::WriteContentsToFile(path, blob.dump(1, '\t'));
+}
+
+void CookManifest::Clear() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_entries.clear();
+	_validated.clear();
+}
+
+const CookManifest::Entry* CookManifest::Find(const std::string& source) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	auto it = _entries.find(NormalizePath(source));
+	return it != _entries.end() ? &it->second : nullptr;
+}
+
+void CookManifest::Set(const std::string& source, const Entry& entry) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_entries[NormalizePath(source)] = entry;
+	_validated.clear();
+}
+
+void CookManifest::Remove(const std::string& source) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	_entries.erase(NormalizePath(source));
+	_validated.clear();
+}
+
+std::vector<std::string> CookManifest::GetSources() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	std::vector<std::string> result;
+	result.reserve(_entries.size());
+	for (const auto& [source, entry] : _entries) {
+		result.push_back(source);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+size_t CookManifest::GetEntryCount() {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	return _entries.size();
+}
+
+bool CookManifest::IsUpToDate(const std::string& source) {
+	std::string key = NormalizePath(source);
+
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+	auto cached = _validated.find(key);
+	if (cached != _validated.end()) {
+		return cached->second;
+	}
+	auto it = _entries.find(key);
+	if (it == _entries.end()) {
+		return false;
+	}
+
+	// Mark ourselves as valid while we check our dependencies, so that include cycles can't recurse forever
+	_validated[key] = true;
+	bool result = _CheckSource(key, it->second);
+	for (const auto& dependency : it->second.Dependencies) {
+		result = result && IsUpToDate(dependency);
+	}
+	_validated[key] = result;
+	return result;
+}
+
+std::string CookManifest::GetCookedOutput(const std::string& source, const std::string& extension) {
+	if (!IsUpToDate(source)) {
+		return std::string();
+	}
+	const Entry* entry = Find(source);
+	for (const auto& output : entry->Outputs) {
+		if (fs::path(output).extension() == extension) {
+			return output;
+		}
+	}
+	return std::string();
+}
+
+size_t CookManifest::ValidateAll() {
+	size_t result = 0;
+	for (const auto& source : GetSources()) {
+		if (!IsUpToDate(source)) {
+			LOG_TRACE("Cooked data for \"{}\" is out of date", source);
+			result++;
+		}
+	}
+	return result;
+}
+
+bool CookManifest::HashFile(const std::string& path, uint64_t& result) {
+	FileView file = VirtualFileSystem::Open(path);
+	if (!file) {
+		return false;
+	}
+	result = HashHelpers::Fnv1a(file.Data(), file.Size());
+	return true;
+}
+
+std::string CookManifest::NormalizePath(const std::string& path) {
+	return fs::path(path).lexically_normal().generic_string();
+}
+
+bool CookManifest::_CheckSource(const std::string& key, const Entry& entry) {
+	for (const auto& output : entry.Outputs) {
+		if (!VirtualFileSystem::Exists(output)) {
+			return false;
+		}
+	}
+
+	fs::file_time_type writeTime;
+	if (!VirtualFileSystem::GetWriteTime(key, writeTime)) {
+		return false;
+	}
+	// If the write time matches we trust that the contents do too, otherwise the file may have just been
+	// touched (or copied) so we compare the contents
+	if (writeTime.time_since_epoch().count() == entry.WriteTime) {
+		return true;
+	}
+	uint64_t hash = 0;
+	return HashFile(key, hash) && hash == entry.SourceHash;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+/// <summary>
+/// Records what the asset cooker produced for each source asset, along with a hash of the source's contents
+/// at the time it was cooked. The cooker uses this to only re-cook assets that have changed, and the runtime
+/// uses it to check that cooked data is still valid before using it
+///
+/// Checking a source first compares it's write time to the recorded one, and only hashes the file if they
+/// differ, so validating an unchanged tree is cheap
+/// </summary>
+class CookManifest {
+public:
+	/// <summary>
+	/// Describes the cooked outputs for a single source asset
+	/// </summary>
+	struct Entry {
+		// The type of asset, see CookAssetType in AssetCooker.h
+		std::string              Type;
+		// The FNV-1a hash of the source file's contents
+		uint64_t                 SourceHash = 0;
+		// The write time of the source when it was hashed, in file_time_type ticks
+		int64_t                  WriteTime = 0;
+		// A hash of everything that affects the cooked output (source, settings, dependencies and cooker version)
+		uint64_t                 CookKey = 0;
+		// The files produced from this source, relative to the working directory
+		std::vector<std::string> Outputs;
+		// Other source files that this source depends on (ex: shader includes)
+		std::vector<std::string> Dependencies;
+	};
+
+	// The latest version of the manifest format, manifests from other versions are ignored
+	static const int CURRENT_VERSION = 1;
+
+	/// <summary>
+	/// The path that the cooker writes the manifest to, relative to the working directory
+	/// </summary>
+	inline static std::string DefaultPath = "cook-manifest.json";
+
+	/// <summary>
+	/// Loads a manifest, replacing any loaded entries
+	/// </summary>
+	/// <param name="path">The path of the manifest to load</param>
+	/// <returns>True if the manifest was loaded</returns>
+	static bool Load(const std::string& path);
+	/// <summary>
+	/// Writes all entries to a manifest file
+	/// </summary>
+	/// <param name="path">The path to write the manifest to</param>
+	static void Save(const std::string& path);
+	/// <summary>
+	/// Removes all entries
+	/// </summary>
+	static void Clear();
+
+	/// <summary>
+	/// Gets the entry for a source file, or nullptr if it is not in the manifest. The pointer is only valid until
+	/// the manifest is next modified
+	/// </summary>
+	static const Entry* Find(const std::string& source);
+	/// <summary>
+	/// Adds or replaces the entry for a source file
+	/// </summary>
+	static void Set(const std::string& source, const Entry& entry);
+	/// <summary>
+	/// Removes the entry for a source file
+	/// </summary>
+	static void Remove(const std::string& source);
+	/// <summary>
+	/// Gets the normalized paths of all sources in the manifest
+	/// </summary>
+	static std::vector<std::string> GetSources();
+	/// <summary>
+	/// Gets the number of entries in the manifest
+	/// </summary>
+	static size_t GetEntryCount();
+
+	/// <summary>
+	/// Returns true if the source (and all of it's dependencies) match what was cooked, and all of it's outputs
+	/// exist. Results are remembered, so each source is only checked once per load. Safe to call from any thread
+	/// </summary>
+	/// <param name="source">The path of the source file</param>
+	static bool IsUpToDate(const std::string& source);
+	/// <summary>
+	/// Gets the first output of a source with the given extension, if the source is up to date
+	/// </summary>
+	/// <param name="source">The path of the source file</param>
+	/// <param name="extension">The extension of the output to find, including the dot</param>
+	/// <returns>The path of the output, or an empty string if there is no valid output</returns>
+	static std::string GetCookedOutput(const std::string& source, const std::string& extension);
+	/// <summary>
+	/// Checks every entry in the manifest
+	/// </summary>
+	/// <returns>The number of sources that are out of date</returns>
+	static size_t ValidateAll();
+
+	/// <summary>
+	/// Hashes the contents of a file
+	/// </summary>
+	/// <param name="path">The path of the file to hash</param>
+	/// <param name="result">Will store the hash</param>
+	/// <returns>True if the file could be read</returns>
+	static bool HashFile(const std::string& path, uint64_t& result);
+	/// <summary>
+	/// Gets the key that the manifest uses for a given path
+	/// </summary>
+	static std::string NormalizePath(const std::string& path);
+
+protected:
+	CookManifest() = default;
+	~CookManifest() = default;
+
+	inline static std::recursive_mutex                     _mutex;
+	inline static std::unordered_map<std::string, Entry>   _entries;
+	// The results of IsUpToDate, cleared whenever the manifest changes
+	inline static std::unordered_map<std::string, bool>    _validated;
+
+	static bool _CheckSource(const std::string& key, const Entry& entry);
+};
@@ -35,3 +35,13 @@ glm::mat4 NormalizeScale(const glm::mat4& transform) {
 	NormalizeScaleRef(result);
 	return result;
 }
+
+void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+	glm::mat4 rows = glm::transpose(viewProjection);
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[3] + rows[2];
+	planes[5] = rows[3] - rows[2];
+}
@@ -32,6 +32,15 @@ void NormalizeScaleRef(glm::mat4& transform);
 /// <returns>A copy of transform with scaling normalized</returns>
 glm::mat4 NormalizeScale(const glm::mat4& transform);
 
+/// <summary>
+/// Extracts the frustum planes from the rows of a view projection matrix (Gribb & Hartmann), as
+/// (normal, distance) with normals pointing inwards. The planes are not normalized, so they are only
+/// suitable for checking which side of a plane a point is on
+/// </summary>
+/// <param name="viewProjection">The view projection matrix to extract the planes from</param>
+/// <param name="planes">The array to store the left, right, bottom, top, near and far planes in</param>
+void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
 template <typename T, typename V>
 T Wrap(const T& x, const V& min, const V& max) {
 	return glm::mod((glm::mod((x - min), (max - min)) + (max - min)), (max - min)) + min;
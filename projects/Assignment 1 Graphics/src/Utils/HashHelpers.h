@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/// <summary>
+/// Provides 64 bit FNV-1a hashing, used for content addressed caches where we need
+/// a hash that is stable between runs and platforms (unlike std::hash)
+/// </summary>
+class HashHelpers {
+public:
+	HashHelpers() = delete;
+
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME        = 1099511628211ull;
+
+	/// <summary>
+	/// Hashes a null terminated string, can be evaluated at compile time
+	/// </summary>
+	/// <param name="str">The string to hash</param>
+	/// <param name="hash">The hash to continue from, for chaining multiple values together</param>
+	static constexpr uint64_t Fnv1a(const char* str, uint64_t hash = FNV_OFFSET_BASIS) {
+		return *str ? Fnv1a(str + 1, (hash ^ static_cast<uint8_t>(*str)) * FNV_PRIME) : hash;
+	}
+
+	/// <summary>
+	/// Hashes a block of raw bytes
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <param name="hash">The hash to continue from, for chaining multiple values together</param>
+	static inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t ix = 0; ix < size; ix++) {
+			hash = (hash ^ bytes[ix]) * FNV_PRIME;
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Hashes the contents of a string
+	/// </summary>
+	/// <param name="str">The string to hash</param>
+	/// <param name="hash">The hash to continue from, for chaining multiple values together</param>
+	static inline uint64_t Fnv1a(const std::string& str, uint64_t hash = FNV_OFFSET_BASIS) {
+		return Fnv1a(str.data(), str.size(), hash);
+	}
+
+	/// <summary>
+	/// Mixes the bytes of a trivially copyable value into an existing hash
+	/// </summary>
+	/// <typeparam name="T">The type of value to combine, must be trivially copyable</typeparam>
+	/// <param name="hash">The hash to continue from</param>
+	/// <param name="value">The value to mix in</param>
+	template <typename T>
+	static inline uint64_t Combine(uint64_t hash, const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Combine requires a trivially copyable type");
+		return Fnv1a(&value, sizeof(T), hash);
+	}
+
+	/// <summary>
+	/// Converts a hash into a fixed width hexadecimal string, useful for cache file names
+	/// </summary>
+	/// <param name="hash">The hash to convert</param>
+	static inline std::string ToHex(uint64_t hash) {
+		static const char* digits = "0123456789abcdef";
+		std::string result(16, '0');
+		for (int ix = 15; ix >= 0; ix--) {
+			result[ix] = digits[hash & 0xF];
+			hash >>= 4;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Parses a hash from a hexadecimal string as written by ToHex, invalid characters are treated as 0
+	/// </summary>
+	/// <param name="hex">The string to parse</param>
+	static inline uint64_t FromHex(const std::string& hex) {
+		uint64_t result = 0;
+		for (char c : hex) {
+			uint64_t digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 0;
+			result = (result << 4) | digit;
+		}
+		return result;
+	}
+};
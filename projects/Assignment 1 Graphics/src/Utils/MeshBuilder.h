@@ -140,7 +140,31 @@ public:
 
 		return result;
 	}
-	
+
+	/// <summary>
+	/// Creates a VertexArrayObject from the current data, as well as a VAO for each level of detail. All
+	/// of the resulting VAOs will share a single vertex buffer, and only differ in their index buffers
+	/// </summary>
+	/// <param name="lodIndices">The index lists for LOD 1 through N, as generated by the MeshSimplifier</param>
+	/// <returns>The VAOs for each level of detail, where element 0 is the full detail mesh</returns>
+	std::vector<VertexArrayObject::Sptr> BakeLODs(const std::vector<std::vector<uint32_t>>& lodIndices) {
+		std::vector<VertexArrayObject::Sptr> result;
+		result.reserve(lodIndices.size() + 1);
+		result.push_back(Bake());
+
+		for (const auto& indices : lodIndices) {
+			IndexBuffer::Sptr ebo = IndexBuffer::Create();
+			ebo->LoadData(indices.data(), static_cast<uint32_t>(indices.size()));
+
+			// Cloning will share the vertex buffer, we just need to swap in our new indices
+			VertexArrayObject::Sptr lod = result[0]->Clone();
+			lod->SetIndexBuffer(ebo);
+			result.push_back(lod);
+		}
+
+		return result;
+	}
+
 	/// <summary>
 	/// Resets this mesh, removing all vertices and indices
 	/// </summary>
@@ -1,4 +1,5 @@
 #include "Utils/MeshFactory.h"
+#include <algorithm>
 
 MeshBuilderParam MeshBuilderParam::CreateCube(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& eulerDeg /*= glm::vec3(0.0f)*/, const glm::vec4& col /*= glm::vec4(1.0f)*/) {
 	MeshBuilderParam result;
@@ -78,4 +79,30 @@ nlohmann::json MeshBuilderParam::ToJson() const {
 		result["params"][key] = value;
 	}
 	return result;
-}
\ No newline at end of file
+}
+
+uint64_t MeshBuilderParam::GetHash(uint64_t seed) const {
+	uint64_t result = HashHelpers::Combine(seed, static_cast<int>(Type));
+	result = HashHelpers::Combine(result, Color);
+
+	// Unordered map iteration order isn't stable, so we hash the params in key order
+	std::vector<const std::pair<const std::string, glm::vec3>*> sorted;
+	sorted.reserve(Params.size());
+	for (const auto& pair : Params) {
+		sorted.push_back(&pair);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+	for (const auto* pair : sorted) {
+		result = HashHelpers::Fnv1a(pair->first, result);
+		result = HashHelpers::Combine(result, pair->second);
+	}
+	return result;
+}
+
+uint64_t MeshBuilderParam::HashList(const std::vector<MeshBuilderParam>& params) {
+	uint64_t result = HashHelpers::Combine(HashHelpers::FNV_OFFSET_BASIS, static_cast<uint32_t>(params.size()));
+	for (const auto& param : params) {
+		result = param.GetHash(result);
+	}
+	return result;
+}
@@ -3,6 +3,7 @@
 #include <GLM/gtc/matrix_transform.hpp>
 #include "MeshBuilder.h"
 #include "Graphics/VertexTypes.h"
+#include "Utils/HashHelpers.h"
 #include <json.hpp>
 
 #include <EnumToString.h>
@@ -37,6 +38,18 @@ struct MeshBuilderParam {
 
 	static MeshBuilderParam FromJson(const nlohmann::json& blob);
 	nlohmann::json   ToJson() const;
+
+	/// <summary>
+	/// Gets a hash of this parameter's type, color and parameters, which will be the same
+	/// between runs for identical parameters (regardless of map ordering)
+	/// </summary>
+	/// <param name="seed">The hash to continue from, for chaining multiple params together</param>
+	uint64_t GetHash(uint64_t seed = HashHelpers::FNV_OFFSET_BASIS) const;
+	/// <summary>
+	/// Gets a combined hash for a list of mesh builder parameters, order dependent
+	/// </summary>
+	/// <param name="params">The parameters to hash</param>
+	static uint64_t HashList(const std::vector<MeshBuilderParam>& params);
 };
 
 
@@ -150,6 +163,10 @@ public:
 
 	/// <summary>
 	/// Calculates the tangents and bitangents from the normal and UV coords
+	/// 
+	/// Face tangents are accumulated per vertex weighted by the corner angle, split over
+	/// multiple threads for large meshes, then orthonormalized against the vertex normal.
+	/// The bitangent is rebuilt as cross(N, T), flipped for mirrored UVs
 	/// </summary>
 	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
 	/// <param name="mesh">The mesh to manipulate</param>
@@ -161,6 +178,8 @@ protected:
 	~MeshFactory() = default;
 
 	inline static const glm::mat4 MAT4_IDENTITY = glm::mat4(1.0f);
+	// Meshes with fewer triangles than this per thread will not be worth splitting up in CalculateTBN
+	inline static const size_t TBN_MIN_TRIS_PER_THREAD = 4096;
 };
 
 #include "MeshFactory.inl"
\ No newline at end of file
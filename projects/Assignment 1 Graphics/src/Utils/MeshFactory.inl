@@ -4,6 +4,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <GLM/gtx/euler_angles.hpp>
 #include <unordered_map>
+#include <thread>
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Graphics/VertexArrayObject.h"
 #include "Logging.h"
@@ -570,50 +571,137 @@ void MeshFactory::CalculateTBN(MeshBuilder<Vertex>& mesh)
 		return;
 	}
 
-	for (size_t i = 0; i < mesh._vertices.size(); i++) {
-		vMap.SetTangent(mesh._vertices[i], glm::vec3(0.0f));
-		vMap.SetBiTangent(mesh._vertices[i], glm::vec3(0.0f));
+	const size_t numVerts = mesh._vertices.size();
+	const size_t numTris  = mesh._indices.size() / 3;
+	const uint32_t* indices = mesh._indices.data();
+
+	// Pull the attributes we need out of the interleaved vertices into flat arrays, so that the
+	// hot loops below are not going through the byte offset accessors
+	std::vector<glm::vec3> positions(numVerts);
+	std::vector<glm::vec2> uvs(numVerts);
+	std::vector<glm::vec3> normals(numVerts, glm::vec3(0.0f));
+	for (size_t ix = 0; ix < numVerts; ix++) {
+		positions[ix] = vMap.GetPosition(mesh._vertices[ix]);
+		uvs[ix]       = vMap.GetTexture(mesh._vertices[ix]);
+		normals[ix]   = vMap.GetNormal(mesh._vertices[ix]);
 	}
 
-	// Iterate over all indices in the mesh, we'll assume that the mesh is indexed
-	for (size_t i = 0; i < mesh._indices.size(); i += 3) {
-		Vertex& v1 = mesh._vertices[mesh._indices[i + 0u]];
-		Vertex& v2 = mesh._vertices[mesh._indices[i + 1u]];
-		Vertex& v3 = mesh._vertices[mesh._indices[i + 2u]];
-
-		// Extract the positions from the mesh
-		glm::vec3 pos[3];
-		pos[0] = vMap.GetPosition(v1);
-		pos[1] = vMap.GetPosition(v2);
-		pos[2] = vMap.GetPosition(v3);
-
-		// Extract the UVs from the mesh
-		glm::vec2 uvs[3];
-		uvs[0] = vMap.GetTexture(v1);
-		uvs[1] = vMap.GetTexture(v2);
-		uvs[2] = vMap.GetTexture(v3);
-
-		// Calculate 2 corner vectors
-		glm::vec3 deltaP1 = pos[1] - pos[0];
-		glm::vec3 deltaP2 = pos[2] - pos[0];
-
-		// Calculate UV deltas
-		glm::vec2 deltaT1 = uvs[1] - uvs[0];
-		glm::vec2 deltaT2 = uvs[2] - uvs[0];
-
-		// Use the deltas in position and UV to calculate the tangent and bitangent
-		// https://learnopengl.com/Advanced-Lighting/Normal-Mapping
-		float r = 1.0f / (deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x);
-		glm::vec3 tangent = glm::normalize((deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r);
-		glm::vec3 bitangent = glm::normalize((deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r);
-
-		// Set attributes in the vertex
-		vMap.SetTangent(v1, glm::normalize((vMap.GetTangent(v1) + tangent) / 2.0f));
-		vMap.SetTangent(v2, glm::normalize((vMap.GetTangent(v2) + tangent) / 2.0f));
-		vMap.SetTangent(v3, glm::normalize((vMap.GetTangent(v3) + tangent) / 2.0f));
-
-		vMap.SetBiTangent(v1, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
-		vMap.SetBiTangent(v2, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
-		vMap.SetBiTangent(v3, glm::normalize((vMap.GetBiTangent(v1) + bitangent) / 2.0f));
+	// Split the triangles into chunks, each chunk gets it's own accumulation buffers so that
+	// we don't need any synchronization between threads
+	const size_t numThreads = glm::clamp<size_t>(numTris / TBN_MIN_TRIS_PER_THREAD, 1, glm::max(1u, std::thread::hardware_concurrency()));
+	const size_t chunkSize  = (numTris + numThreads - 1) / numThreads;
+
+	struct TbnScratch {
+		std::vector<float> TX, TY, TZ;
+		std::vector<float> BX, BY, BZ;
+		std::vector<float> NX, NY, NZ;
+	};
+	std::vector<TbnScratch> scratch(numThreads);
+
+	auto accumulate = [&](size_t chunk) {
+		TbnScratch& s = scratch[chunk];
+		s.TX.assign(numVerts, 0.0f); s.TY.assign(numVerts, 0.0f); s.TZ.assign(numVerts, 0.0f);
+		s.BX.assign(numVerts, 0.0f); s.BY.assign(numVerts, 0.0f); s.BZ.assign(numVerts, 0.0f);
+		s.NX.assign(numVerts, 0.0f); s.NY.assign(numVerts, 0.0f); s.NZ.assign(numVerts, 0.0f);
+
+		const size_t first = chunk * chunkSize;
+		const size_t last  = glm::min(first + chunkSize, numTris);
+		for (size_t t = first; t < last; t++) {
+			const uint32_t* tri = indices + t * 3;
+
+			// Calculate 2 corner vectors and UV deltas
+			glm::vec3 deltaP1 = positions[tri[1]] - positions[tri[0]];
+			glm::vec3 deltaP2 = positions[tri[2]] - positions[tri[0]];
+			glm::vec2 deltaT1 = uvs[tri[1]] - uvs[tri[0]];
+			glm::vec2 deltaT2 = uvs[tri[2]] - uvs[tri[0]];
+
+			// Skip triangles that are degenerate in either position or UV space, they have no meaningful tangent
+			glm::vec3 faceNormal = glm::cross(deltaP1, deltaP2);
+			float det = deltaT1.x * deltaT2.y - deltaT1.y * deltaT2.x;
+			if (glm::dot(faceNormal, faceNormal) <= 1e-20f || glm::abs(det) <= 1e-12f) {
+				continue;
+			}
+
+			// Use the deltas in position and UV to calculate the tangent and bitangent
+			// https://learnopengl.com/Advanced-Lighting/Normal-Mapping
+			// We only keep the directions, and let the corner angle decide how much each face contributes
+			float r = 1.0f / det;
+			glm::vec3 tangent   = glm::normalize((deltaP1 * deltaT2.y - deltaP2 * deltaT1.y) * r);
+			glm::vec3 bitangent = glm::normalize((deltaP2 * deltaT1.x - deltaP1 * deltaT2.x) * r);
+			faceNormal = glm::normalize(faceNormal);
+
+			for (int corner = 0; corner < 3; corner++) {
+				const uint32_t v = tri[corner];
+				glm::vec3 e1 = positions[tri[(corner + 1) % 3]] - positions[v];
+				glm::vec3 e2 = positions[tri[(corner + 2) % 3]] - positions[v];
+				float lengths = glm::length(e1) * glm::length(e2);
+				if (lengths <= 0.0f) continue;
+
+				// Angle weighting makes the result independent of how the surface is tessellated
+				float weight = glm::acos(glm::clamp(glm::dot(e1, e2) / lengths, -1.0f, 1.0f));
+				s.TX[v] += tangent.x * weight;    s.TY[v] += tangent.y * weight;    s.TZ[v] += tangent.z * weight;
+				s.BX[v] += bitangent.x * weight;  s.BY[v] += bitangent.y * weight;  s.BZ[v] += bitangent.z * weight;
+				s.NX[v] += faceNormal.x * weight; s.NY[v] += faceNormal.y * weight; s.NZ[v] += faceNormal.z * weight;
+			}
+		}
+	};
+
+	// Sums the chunk buffers for a range of vertices, then orthonormalizes the frame against the vertex normal
+	std::vector<glm::vec3> tangents(numVerts);
+	std::vector<glm::vec3> bitangents(numVerts);
+	auto resolve = [&](size_t chunk) {
+		const size_t first = chunk * ((numVerts + numThreads - 1) / numThreads);
+		const size_t last  = glm::min(first + (numVerts + numThreads - 1) / numThreads, numVerts);
+		for (size_t v = first; v < last; v++) {
+			glm::vec3 t(0.0f), b(0.0f), faceN(0.0f);
+			for (const TbnScratch& s : scratch) {
+				t     += glm::vec3(s.TX[v], s.TY[v], s.TZ[v]);
+				b     += glm::vec3(s.BX[v], s.BY[v], s.BZ[v]);
+				faceN += glm::vec3(s.NX[v], s.NY[v], s.NZ[v]);
+			}
+
+			// Prefer the authored normal, but fall back to the accumulated face normal if the vertex has none
+			glm::vec3 n = normals[v];
+			if (glm::dot(n, n) <= 1e-12f) {
+				n = faceN;
+			}
+			if (glm::dot(n, n) <= 1e-12f) {
+				n = glm::vec3(0.0f, 0.0f, 1.0f);
+			}
+			n = glm::normalize(n);
+
+			// Gram-Schmidt the tangent against the normal, picking any perpendicular if it has collapsed
+			t = t - n * glm::dot(n, t);
+			if (glm::dot(t, t) <= 1e-12f) {
+				t = glm::abs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+			}
+			t = glm::normalize(t);
+
+			// The bitangent is rebuilt from the normal and tangent so the frame is orthonormal, we
+			// only use the accumulated bitangent to work out the handedness (mirrored UVs)
+			float handedness = glm::dot(glm::cross(n, t), b) < 0.0f ? -1.0f : 1.0f;
+			tangents[v]   = t;
+			bitangents[v] = glm::cross(n, t) * handedness;
+		}
+	};
+
+	// Runs a job for each chunk, using the calling thread for the first one
+	auto runChunks = [&](const auto& job) {
+		std::vector<std::thread> workers;
+		workers.reserve(numThreads - 1);
+		for (size_t chunk = 1; chunk < numThreads; chunk++) {
+			workers.emplace_back(job, chunk);
+		}
+		job(0);
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	};
+	runChunks(accumulate);
+	runChunks(resolve);
+
+	for (size_t ix = 0; ix < numVerts; ix++) {
+		vMap.SetTangent(mesh._vertices[ix], tangents[ix]);
+		vMap.SetBiTangent(mesh._vertices[ix], bitangents[ix]);
 	}
-}
\ No newline at end of file
+}
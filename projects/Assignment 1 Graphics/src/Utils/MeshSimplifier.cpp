@@ -0,0 +1,290 @@
+#include "Utils/MeshSimplifier.h"
+
+#include <queue>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Logging.h"
+
+namespace {
+	/// <summary>
+	/// Stores the symmetric 4x4 error quadric for a vertex, we only need the upper
+	/// triangle of the matrix (10 values)
+	/// </summary>
+	struct Quadric {
+		double A2 = 0.0, AB = 0.0, AC = 0.0, AD = 0.0;
+		double B2 = 0.0, BC = 0.0, BD = 0.0;
+		double C2 = 0.0, CD = 0.0;
+		double D2 = 0.0;
+
+		// Creates a quadric from the plane ax + by + cz + d = 0, weighted by the given value
+		static Quadric FromPlane(const glm::dvec3& n, double d, double weight) {
+			Quadric q;
+			q.A2 = n.x * n.x * weight; q.AB = n.x * n.y * weight; q.AC = n.x * n.z * weight; q.AD = n.x * d * weight;
+			q.B2 = n.y * n.y * weight; q.BC = n.y * n.z * weight; q.BD = n.y * d * weight;
+			q.C2 = n.z * n.z * weight; q.CD = n.z * d * weight;
+			q.D2 = d * d * weight;
+			return q;
+		}
+
+		Quadric& operator +=(const Quadric& other) {
+			A2 += other.A2; AB += other.AB; AC += other.AC; AD += other.AD;
+			B2 += other.B2; BC += other.BC; BD += other.BD;
+			C2 += other.C2; CD += other.CD;
+			D2 += other.D2;
+			return *this;
+		}
+
+		Quadric operator +(const Quadric& other) const {
+			Quadric result = *this;
+			result += other;
+			return result;
+		}
+
+		// Evaluates the squared distance error of a point against all planes in this quadric
+		double Error(const glm::vec3& p) const {
+			const double x = p.x, y = p.y, z = p.z;
+			return A2 * x * x + 2.0 * AB * x * y + 2.0 * AC * x * z + 2.0 * AD * x +
+				   B2 * y * y + 2.0 * BC * y * z + 2.0 * BD * y +
+				   C2 * z * z + 2.0 * CD * z +
+				   D2;
+		}
+	};
+
+	/// <summary>
+	/// A candidate half-edge collapse, moving vertex From onto vertex To
+	/// </summary>
+	struct Collapse {
+		double   Cost;
+		uint32_t From;
+		uint32_t To;
+		// The versions of the vertices when this collapse was calculated, lets us lazily
+		// throw out collapses that are out of date
+		uint32_t FromVersion;
+		uint32_t ToVersion;
+
+		bool operator >(const Collapse& other) const { return Cost > other.Cost; }
+	};
+
+	// Gets an order independent key for the edge between two vertices
+	inline uint64_t EdgeKey(uint32_t a, uint32_t b) {
+		return a < b ?
+			(static_cast<uint64_t>(a) << 32ull) | static_cast<uint64_t>(b) :
+			(static_cast<uint64_t>(b) << 32ull) | static_cast<uint64_t>(a);
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetTriangles) {
+	const size_t numTris  = indices.size() / 3;
+	const size_t numVerts = positions.size();
+
+	// Nothing to do if we're already below our target
+	if (numTris <= targetTriangles || numVerts == 0) {
+		return indices;
+	}
+
+	// Working copy of the triangles, we'll be re-pointing indices as we collapse edges
+	std::vector<uint32_t> tris = indices;
+	std::vector<bool>     triAlive(numTris, true);
+	size_t                liveTris = numTris;
+
+	// Build the vertex -> triangle adjacency, and accumulate the error quadrics for each vertex
+	std::vector<std::vector<uint32_t>> vertexTris(numVerts);
+	std::vector<Quadric> quadrics(numVerts);
+	std::unordered_map<uint64_t, uint32_t> edgeCounts;
+	edgeCounts.reserve(indices.size());
+
+	for (size_t t = 0; t < numTris; t++) {
+		const uint32_t* tri = &tris[t * 3];
+		const glm::dvec3 p0 = positions[tri[0]];
+		const glm::dvec3 p1 = positions[tri[1]];
+		const glm::dvec3 p2 = positions[tri[2]];
+
+		// Area weighted plane quadric, so that large faces are preserved over small ones
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double length = glm::length(normal);
+		if (length > 0.0) {
+			normal /= length;
+			Quadric q = Quadric::FromPlane(normal, -glm::dot(normal, p0), length * 0.5);
+			for (int ix = 0; ix < 3; ix++) {
+				quadrics[tri[ix]] += q;
+			}
+		}
+
+		for (int ix = 0; ix < 3; ix++) {
+			vertexTris[tri[ix]].push_back(static_cast<uint32_t>(t));
+			edgeCounts[EdgeKey(tri[ix], tri[(ix + 1) % 3])]++;
+		}
+	}
+
+	// Lock any vertices that are on open borders or non-manifold edges, collapsing these would open holes in the mesh
+	std::vector<bool> locked(numVerts, false);
+	for (const auto& [key, count] : edgeCounts) {
+		if (count != 2) {
+			locked[static_cast<uint32_t>(key >> 32ull)] = true;
+			locked[static_cast<uint32_t>(key & 0xFFFFFFFFull)] = true;
+		}
+	}
+
+	// Lock any vertices that share a position with another vertex, these are UV or normal seams, and moving
+	// one side of the seam without the other would tear the mesh
+	std::vector<uint32_t> sorted(numVerts);
+	std::iota(sorted.begin(), sorted.end(), 0u);
+	std::sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) {
+		const glm::vec3& pa = positions[a];
+		const glm::vec3& pb = positions[b];
+		return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z);
+	});
+	for (size_t ix = 1; ix < numVerts; ix++) {
+		if (positions[sorted[ix]] == positions[sorted[ix - 1]]) {
+			locked[sorted[ix]] = true;
+			locked[sorted[ix - 1]] = true;
+		}
+	}
+
+	std::vector<uint32_t> versions(numVerts, 0);
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+	// Helper for pushing a new candidate collapse into the queue
+	auto pushCollapse = [&](uint32_t from, uint32_t to) {
+		if (locked[from]) return;
+		double cost = (quadrics[from] + quadrics[to]).Error(positions[to]);
+		queue.push({ cost, from, to, versions[from], versions[to] });
+	};
+
+	for (const auto& [key, count] : edgeCounts) {
+		uint32_t a = static_cast<uint32_t>(key >> 32ull);
+		uint32_t b = static_cast<uint32_t>(key & 0xFFFFFFFFull);
+		pushCollapse(a, b);
+		pushCollapse(b, a);
+	}
+
+	// Collapsing is only valid if it does not flip or degenerate any of the remaining triangles
+	auto isCollapseValid = [&](uint32_t from, uint32_t to) {
+		for (uint32_t t : vertexTris[from]) {
+			if (!triAlive[t]) continue;
+			const uint32_t* tri = &tris[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+			glm::vec3 before[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+			glm::vec3 after[3];
+			for (int ix = 0; ix < 3; ix++) {
+				after[ix] = tri[ix] == from ? positions[to] : before[ix];
+			}
+
+			glm::vec3 oldNormal = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 newNormal = glm::cross(after[1] - after[0], after[2] - after[0]);
+			float newLength = glm::length(newNormal);
+			if (newLength <= 1e-12f || glm::dot(oldNormal, newNormal) <= 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	std::vector<bool> removed(numVerts, false);
+	std::vector<uint32_t> neighbours;
+	while (liveTris > targetTriangles && !queue.empty()) {
+		Collapse collapse = queue.top();
+		queue.pop();
+
+		// Skip anything that has been invalidated by previous collapses
+		if (removed[collapse.From] || removed[collapse.To] ||
+			versions[collapse.From] != collapse.FromVersion ||
+			versions[collapse.To] != collapse.ToVersion) {
+			continue;
+		}
+		if (!isCollapseValid(collapse.From, collapse.To)) {
+			continue;
+		}
+
+		const uint32_t from = collapse.From;
+		const uint32_t to   = collapse.To;
+
+		// Move all the triangles from our source vertex over to the target, killing any that shared the edge
+		for (uint32_t t : vertexTris[from]) {
+			if (!triAlive[t]) continue;
+			uint32_t* tri = &tris[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) {
+				triAlive[t] = false;
+				liveTris--;
+			} else {
+				for (int ix = 0; ix < 3; ix++) {
+					if (tri[ix] == from) tri[ix] = to;
+				}
+				vertexTris[to].push_back(t);
+			}
+		}
+		vertexTris[from].clear();
+		removed[from] = true;
+		quadrics[to] += quadrics[from];
+		versions[to]++;
+
+		// Strip dead triangles from the target, and gather its neighbours
+		auto& toTris = vertexTris[to];
+		toTris.erase(std::remove_if(toTris.begin(), toTris.end(), [&](uint32_t t) { return !triAlive[t]; }), toTris.end());
+		neighbours.clear();
+		for (uint32_t t : toTris) {
+			for (int ix = 0; ix < 3; ix++) {
+				uint32_t v = tris[t * 3 + ix];
+				if (v != to) neighbours.push_back(v);
+			}
+		}
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+		// Our target's quadric has changed, so all of it's edges need new costs
+		for (uint32_t neighbour : neighbours) {
+			pushCollapse(neighbour, to);
+			pushCollapse(to, neighbour);
+		}
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(liveTris * 3);
+	for (size_t t = 0; t < numTris; t++) {
+		if (triAlive[t]) {
+			result.push_back(tris[t * 3 + 0]);
+			result.push_back(tris[t * 3 + 1]);
+			result.push_back(tris[t * 3 + 2]);
+		}
+	}
+	return result;
+}
+
+std::vector<std::vector<uint32_t>> MeshSimplifier::GenerateLODs(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, int maxLevels, size_t minTriangles) {
+	std::vector<std::vector<uint32_t>> result;
+	const std::vector<uint32_t>* source = &indices;
+
+	for (int level = 0; level < maxLevels; level++) {
+		size_t sourceTris = source->size() / 3;
+		size_t target = sourceTris / 2;
+		if (target < minTriangles) {
+			break;
+		}
+
+		// Each level is simplified from the previous one, which is much cheaper than starting from the full mesh
+		std::vector<uint32_t> lod = Simplify(positions, *source, target);
+
+		// If we couldn't get rid of at least 10% of the triangles, the mesh is mostly locked and
+		// further levels would be a waste of memory
+		if (lod.size() / 3 > (sourceTris * 9) / 10) {
+			break;
+		}
+
+		LOG_TRACE("Generated LOD {} with {} triangles (from {})", level + 1, lod.size() / 3, indices.size() / 3);
+		result.push_back(std::move(lod));
+		source = &result.back();
+	}
+
+	return result;
+}
+
+float MeshSimplifier::CalculateBoundingRadius(const std::vector<glm::vec3>& positions) {
+	float result = 0.0f;
+	for (const glm::vec3& pos : positions) {
+		result = glm::max(result, glm::dot(pos, pos));
+	}
+	return glm::sqrt(result);
+}
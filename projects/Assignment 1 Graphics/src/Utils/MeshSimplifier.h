@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <cstring>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+#include "Graphics/VertexParamMap.h"
+
+/// <summary>
+/// Provides quadric error metric (Garland-Heckbert) mesh simplification, used for
+/// generating levels of detail from MeshBuilder data
+///
+/// Simplification uses half-edge collapses, so every level of detail is a new index
+/// list into the SAME vertex data as the source mesh. This lets all LODs share a single
+/// vertex buffer on the GPU and in our binary mesh files
+/// </summary>
+class MeshSimplifier {
+public:
+	/// <summary>
+	/// Simplifies a triangle list down to (roughly) the target number of triangles
+	///
+	/// Vertices on open borders and UV/normal seams (vertices sharing a position with
+	/// another vertex) are locked in place, so simplification will never open holes
+	/// or tear seams in the mesh
+	/// </summary>
+	/// <param name="positions">The positions of all the vertices in the mesh</param>
+	/// <param name="indices">The triangle list to simplify, must be a multiple of 3</param>
+	/// <param name="targetTriangles">The number of triangles we want to reduce the mesh to</param>
+	/// <returns>A new triangle list indexing into the same vertices as the input</returns>
+	static std::vector<uint32_t> Simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetTriangles);
+
+	/// <summary>
+	/// Generates a chain of simplified index lists from the given positions and indices, where each
+	/// level has roughly half the triangles of the previous one. The source indices are NOT included
+	/// in the result (LOD 0 is the source mesh itself)
+	/// </summary>
+	/// <param name="positions">The positions of all the vertices in the mesh</param>
+	/// <param name="indices">The triangle list for the full detail mesh</param>
+	/// <param name="maxLevels">The maximum number of simplified levels to generate</param>
+	/// <param name="minTriangles">Meshes with fewer triangles than this will not be simplified any further</param>
+	/// <returns>The index lists for LOD 1 through LOD N</returns>
+	static std::vector<std::vector<uint32_t>> GenerateLODs(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, int maxLevels = 3, size_t minTriangles = 64);
+
+	/// <summary>
+	/// Generates a chain of simplified index lists for a mesh builder, see the overload above
+	/// </summary>
+	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
+	template <typename Vertex>
+	static std::vector<std::vector<uint32_t>> GenerateLODs(const MeshBuilder<Vertex>& mesh, int maxLevels = 3, size_t minTriangles = 64);
+
+	/// <summary>
+	/// Extracts the positions of all vertices in a mesh builder
+	/// </summary>
+	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
+	/// <param name="mesh">The mesh to extract positions from</param>
+	/// <returns>The positions, or an empty vector if the vertex type has no position attribute</returns>
+	template <typename Vertex>
+	static std::vector<glm::vec3> ExtractPositions(const MeshBuilder<Vertex>& mesh);
+
+	/// <summary>
+	/// Calculates the radius of the sphere around the mesh's origin that contains all the given positions,
+	/// used for estimating how large the mesh appears on screen
+	/// </summary>
+	/// <param name="positions">The positions to find the bounds of</param>
+	static float CalculateBoundingRadius(const std::vector<glm::vec3>& positions);
+
+protected:
+	MeshSimplifier() = default;
+	~MeshSimplifier() = default;
+};
+
+template <typename Vertex>
+std::vector<glm::vec3> MeshSimplifier::ExtractPositions(const MeshBuilder<Vertex>& mesh) {
+	VertexParamMap vMap = VertexParamMap(Vertex::V_DECL);
+	std::vector<glm::vec3> result;
+	if (vMap.PositionOffset == (uint32_t)-1) {
+		return result;
+	}
+
+	// We copy the bytes out manually, since the param map only works with non-const vertices
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(mesh.GetVertexDataPtr());
+	result.resize(mesh.GetVertexCount());
+	for (size_t ix = 0; ix < result.size(); ix++) {
+		memcpy(&result[ix], data + (ix * sizeof(Vertex)) + vMap.PositionOffset, sizeof(glm::vec3));
+	}
+	return result;
+}
+
+template <typename Vertex>
+std::vector<std::vector<uint32_t>> MeshSimplifier::GenerateLODs(const MeshBuilder<Vertex>& mesh, int maxLevels, size_t minTriangles) {
+	// We can only simplify indexed meshes
+	if (mesh.GetIndexCount() == 0) {
+		return std::vector<std::vector<uint32_t>>();
+	}
+
+	std::vector<uint32_t> indices(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+	return GenerateLODs(ExtractPositions(mesh), indices, maxLevels, minTriangles);
+}
@@ -11,6 +11,7 @@
 #include "MeshFactory.h"
 #include "Graphics/VertexTypes.h"
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
 
 class ObjLoader
 {
@@ -18,6 +19,17 @@ public:
 	template <typename VertexType = VertexPosNormTexColTangents>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, bool calcTangents = true);
 
+	/// <summary>
+	/// Loads an OBJ file into a mesh builder without baking it, allowing further processing
+	/// (such as LOD generation) before it is sent to the GPU
+	/// </summary>
+	/// <typeparam name="VertexType">The type of vertex to load into</typeparam>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="calcTangents">True if tangents and bitangents should be calculated</param>
+	/// <returns>The mesh data loaded from the file</returns>
+	template <typename VertexType = VertexPosNormTexColTangents>
+	static MeshBuilder<VertexType> LoadMeshBuilder(const std::string& filename, bool calcTangents = true);
+
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
@@ -26,9 +38,14 @@ protected:
 
 template <typename VertexType>
 VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, bool calcTangents) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	// Move our data into a VAO and return it
+	return LoadMeshBuilder<VertexType>(filename, calcTangents).Bake();
+}
+
+template <typename VertexType>
+MeshBuilder<VertexType> ObjLoader::LoadMeshBuilder(const std::string& filename, bool calcTangents) {
+	// Open our file through the VFS, so it can come from an asset pack
+	FileViewStream file(VirtualFileSystem::Open(filename));
 
 	// If our file fails to open, we will throw an error
 	if (!file) {
@@ -187,6 +204,5 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, boo
 	float endTime = static_cast<float>(glfwGetTime());
 	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, mesh.GetVertexCount(), mesh.GetIndexCount());
 
-	// Move our data into a VAO and return it
-	return mesh.Bake();
+	return mesh;
 }
\ No newline at end of file
@@ -3,12 +3,16 @@
 #include "ObjLoader.h"
 
 #include <string>
+#include <cstring>
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 
 #include "Utils/StringUtils.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Utils/CookManifest.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
@@ -18,6 +22,11 @@ const std::string binaryExtension = ".bin";
 namespace fs = std::filesystem;
 
 VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename) {
+	LodChain chain = LoadLODsFromFile(filename);
+	return chain.Levels.empty() ? nullptr : chain.Levels[0];
+}
+
+OptimizedObjLoader::LodChain OptimizedObjLoader::LoadLODsFromFile(const std::string& filename) {
 	// Get the file extension and lowercase it
 	fs::path filePath = std::filesystem::path(filename);
 	std::string extension = filePath.extension().string();
@@ -25,14 +34,8 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 
 	// Load regular 'ol OBJ files
 	if (extension == ".obj") {
-		// Get the binary path
-		fs::path binPath = filePath.replace_extension(binaryExtension);
-		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
-			ConvertToBinary(filename, binPath.string());
-		}
-		// Load the corresponding binary file
-		return _LoadFromBinFile(binPath.string());
+		// Load the corresponding binary file, converting it first if needed
+		return _LoadFromBinFile(PrepareFile(filename));
 	} 
 	// Load our fancy binary files
 	else if (extension == ".bin") {
@@ -41,8 +44,51 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	// We've never met this extension in our life
 	else {
 		LOG_WARN("Cannot load model from \"{}\"", filename);
-		return nullptr;
+		return LodChain();
+	}
+}
+
+std::string OptimizedObjLoader::PrepareFile(const std::string& filename) {
+	// Get the binary path
+	fs::path binPath = fs::path(filename).replace_extension(binaryExtension);
+	std::string binName = binPath.string();
+
+	// If another thread is already converting this file, we wait for it rather than converting it twice
+	{
+		std::unique_lock<std::mutex> lock(_convertMutex);
+		_convertDone.wait(lock, [&] { return _converting.count(binName) == 0; });
+		_converting.insert(binName);
 	}
+
+	auto release = [&]() {
+		{
+			std::lock_guard<std::mutex> lock(_convertMutex);
+			_converting.erase(binName);
+		}
+		_convertDone.notify_all();
+	};
+
+	// If the file does not exist, is from an older version, has a damaged LOD table, or the source has changed since it was converted, convert
+	// the OBJ file to a binary file. The cook manifest can tell us if the contents changed, otherwise we compare write times
+	try {
+		bool stale = !VirtualFileSystem::Exists(binName) || !_IsBinaryValid(binName);
+		if (!stale && CookManifest::Find(filename) != nullptr) {
+			stale = !CookManifest::IsUpToDate(filename);
+		} else if (!stale) {
+			fs::file_time_type sourceTime, binTime;
+			stale = VirtualFileSystem::GetWriteTime(filename, sourceTime) && VirtualFileSystem::GetWriteTime(binName, binTime) && sourceTime > binTime;
+		}
+		if (stale) {
+			ConvertToBinary(filename, binName);
+		}
+	}
+	catch (...) {
+		release();
+		throw;
+	}
+
+	release();
+	return binName;
 }
 
 void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
@@ -62,20 +108,22 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 		outFileName = path.string();
 	}
 
+	// Generate our levels of detail, these get stored in the binary file so we only need to simplify once
+	std::vector<std::vector<uint32_t>> lods = MeshSimplifier::GenerateLODs(*mesh);
+
 	// Save the mesh to the file
-	SaveBinaryFile(*mesh, outFileName);
+	SaveBinaryFile(*mesh, outFileName, lods);
 
 	float endTime = static_cast<float>(glfwGetTime());
-	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount());
+	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices, {} LODs)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount(), lods.size());
 
 	// We no longer need the mesh data, free it
 	delete mesh;
 }
 
 MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
+	// Open our file through the VFS, so it can come from an asset pack
+	FileViewStream file(VirtualFileSystem::Open(filename));
 
 	// If our file fails to open, we will throw an error
 	if (!file) {
@@ -233,33 +281,101 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 	return mesh;
 }
 
-VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
+uint16_t OptimizedObjLoader::_ReadBinaryVersion(const std::string& filename) {
+	FileView view = VirtualFileSystem::Open(filename);
+	BinaryHeader header = BinaryHeader();
+	header.Version = 0;
+	if (view.Size() < sizeof(BinaryHeader)) {
+		return 0;
+	}
+	memcpy(&header, view.Data(), sizeof(BinaryHeader));
+	return memcmp(header.HeaderBytes, HEADER_BYTES, 4) == 0 ? header.Version : 0;
+}
+
+bool OptimizedObjLoader::_IsBinaryValid(const std::string& filename) {
+	FileView view = VirtualFileSystem::Open(filename);
+	BinaryHeader header = BinaryHeader();
+	if (view.Size() < sizeof(BinaryHeader)) {
+		return false;
+	}
+	memcpy(&header, view.Data(), sizeof(BinaryHeader));
+	if (memcmp(header.HeaderBytes, HEADER_BYTES, 4) != 0 || header.Version != CURRENT_VERSION) {
+		return false;
+	}
+
+	// The LOD table sits right after the vertex data
+	size_t lodOffset =
+		sizeof(BinaryHeader) +
+		(header.NumAttributes * sizeof(BufferAttribute)) +
+		(header.VertexStride * (size_t)header.NumVertices) +
+		(header.NumIndices * GetIndexTypeSize(header.IndicesType));
+	std::vector<uint32_t> counts;
+	return _ReadLodTable(view.Data(), view.Size(), lodOffset, counts);
+}
+
+bool OptimizedObjLoader::_ReadLodTable(const uint8_t* data, size_t size, size_t offset, std::vector<uint32_t>& counts) {
+	counts.clear();
+
+	LodTableHeader lodHeader = LodTableHeader();
+	if (size < offset + sizeof(LodTableHeader)) {
+		return false;
+	}
+	memcpy(&lodHeader, data + offset, sizeof(LodTableHeader));
+	offset += sizeof(LodTableHeader);
 
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
+	if (memcmp(lodHeader.HeaderBytes, LodTableHeader().HeaderBytes, 4) != 0 || lodHeader.NumLods > MAX_LODS) {
+		return false;
+	}
+	if (size < offset + lodHeader.NumLods * sizeof(uint32_t)) {
+		return false;
+	}
+	counts.resize(lodHeader.NumLods);
+	memcpy(counts.data(), data + offset, lodHeader.NumLods * sizeof(uint32_t));
+	offset += lodHeader.NumLods * sizeof(uint32_t);
+
+	// Every level has to be whole triangles, and all of them have to fit in the file
+	for (uint32_t count : counts) {
+		if (count % 3 != 0 || size < offset + count * (size_t)sizeof(uint32_t)) {
+			counts.clear();
+			return false;
+		}
+		offset += count * (size_t)sizeof(uint32_t);
+	}
+	return true;
+}
+
+OptimizedObjLoader::LodChain OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
+
+	// Grab a view of the file, if it's in an asset pack we can read straight out of the mapped pack
+	FileView view = VirtualFileSystem::Open(filename);
 	// If our file fails to open, we will throw an error
-	if (!file) { throw std::runtime_error("Failed to open file"); }
+	if (!view) { throw std::runtime_error("Failed to open file"); }
 
 	float startTime = static_cast<float>(glfwGetTime());
 
-	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	// We keep track of where we are in the file so we can avoid reading past the end
+	const uint8_t* data = view.Data();
+	size_t size = view.Size();
+	size_t seek = 0;
 
 	// Read the header from the file
 	BinaryHeader header = BinaryHeader();
 	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+		memcpy(&header, data, sizeof(BinaryHeader));
+		seek += sizeof(BinaryHeader);
 	} else {
 		LOG_ERROR("Not enough data in the file!");
-		return nullptr;
+		return LodChain();
 	}
 
-	// TODO: validate header
+	// Make sure we're actually looking at one of our files
+	if (memcmp(header.HeaderBytes, HEADER_BYTES, 4) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file!", filename);
+		return LodChain();
+	}
 
-	// Handle our version
-	if (header.Version == 0x01) {
+	// Handle our version, version 2 is identical to version 1 with an LOD table appended
+	if (header.Version == 0x01 || header.Version == 0x02) {
 		// Determine how many bytes we need in the file
 		size_t requiredBytes =
 			sizeof(BinaryHeader) +
@@ -270,59 +386,119 @@ VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string&
 		// Make sure there's enough data in the file
 		if (size < requiredBytes) {
 			LOG_ERROR("Not enough data in the file!");
-			return nullptr;
+			return LodChain();
 		}
 
 		// Read all attributes from the file, this is basically our VDECL
 		std::vector<BufferAttribute> vertexDeclaration;
 		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
-		}
+		memcpy(vertexDeclaration.data(), data + seek, header.NumAttributes * sizeof(BufferAttribute));
+		seek += header.NumAttributes * sizeof(BufferAttribute);
 
 		// These will have the buffer pointers
 		IndexBuffer::Sptr indices = nullptr;
 		VertexBuffer::Sptr vertices = nullptr;
 
-		// If we have index data, load it
+		// If we have index data, load it straight from the file data
 		if (header.NumIndices > 0) {
-			// Create index buffer
 			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
-
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+			indices->LoadData(data + seek, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
+			seek += header.NumIndices * GetIndexTypeSize(header.IndicesType);
 		}
 
-		// Create a new VBO
+		// Create a new VBO and load our vertices from the file data
+		const uint8_t* vertexStore = data + seek;
 		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
-
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
-
-		// Load data into OpenGL and free the CPU copy
 		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
+		seek += header.NumVertices * (size_t)header.VertexStride;
+
+		LodChain result;
+
+		// Find our bounding radius from the vertex data
+		auto posAttrib = std::find_if(vertexDeclaration.begin(), vertexDeclaration.end(), [](const BufferAttribute& attrib) {
+			return attrib.Usage == AttribUsage::Position && attrib.Size == 3 && attrib.Type == AttributeType::Float;
+		});
+		if (posAttrib != vertexDeclaration.end()) {
+			for (uint32_t ix = 0; ix < header.NumVertices; ix++) {
+				glm::vec3 pos;
+				memcpy(&pos, vertexStore + (ix * (size_t)header.VertexStride) + posAttrib->Offset, sizeof(glm::vec3));
+				result.BoundingRadius = glm::max(result.BoundingRadius, glm::length(pos));
+			}
+		}
 
 		// Create the VAO and attach our index and vertex buffers
-		VertexArrayObject::Sptr result = VertexArrayObject::Create();
-		result->SetIndexBuffer(indices);
-		result->AddVertexBuffer(vertices, vertexDeclaration);
+		VertexArrayObject::Sptr vao = VertexArrayObject::Create();
+		vao->SetIndexBuffer(indices);
+		vao->AddVertexBuffer(vertices, vertexDeclaration);
 
 		// Copy in the vertex declaration we loaded
-		result->SetVDecl(vertexDeclaration);
+		vao->SetVDecl(vertexDeclaration);
+		result.Levels.push_back(vao);
+
+		// Version 2 files have an LOD table after the vertex data
+		if (header.Version >= 0x02) {
+			std::vector<uint32_t> lodCounts;
+			if (_ReadLodTable(data, size, seek, lodCounts)) {
+				seek += sizeof(LodTableHeader) + lodCounts.size() * sizeof(uint32_t);
+
+				for (uint32_t count : lodCounts) {
+					// The index data may not be aligned, so we don't read it as uint32s ourselves
+					IndexBuffer::Sptr lodBuffer = IndexBuffer::Create(BufferUsage::StaticDraw);
+					lodBuffer->LoadData(data + seek, sizeof(uint32_t), count, IndexType::UInt);
+					seek += count * sizeof(uint32_t);
+
+					// Cloning shares the vertex buffer, we just need our new indices
+					VertexArrayObject::Sptr lod = vao->Clone();
+					lod->SetIndexBuffer(lodBuffer);
+					result.Levels.push_back(lod);
+				}
+			}
+			// The table is damaged, rather than trusting any of it we simplify the mesh again from the full detail data
+			else if (posAttrib != vertexDeclaration.end() && header.NumIndices > 0) {
+				LOG_WARN("Invalid LOD table in \"{}\", regenerating levels of detail", filename);
+
+				std::vector<glm::vec3> positions(header.NumVertices);
+				for (uint32_t ix = 0; ix < header.NumVertices; ix++) {
+					memcpy(&positions[ix], vertexStore + (ix * (size_t)header.VertexStride) + posAttrib->Offset, sizeof(glm::vec3));
+				}
+
+				// Widen the indices to 32 bits, since that's what the simplifier works with
+				const uint8_t* indexStore = vertexStore - header.NumIndices * GetIndexTypeSize(header.IndicesType);
+				std::vector<uint32_t> sourceIndices(header.NumIndices);
+				for (uint32_t ix = 0; ix < header.NumIndices; ix++) {
+					switch (header.IndicesType) {
+						case IndexType::UByte:
+							sourceIndices[ix] = indexStore[ix];
+							break;
+						case IndexType::UShort: {
+							uint16_t value;
+							memcpy(&value, indexStore + ix * sizeof(uint16_t), sizeof(uint16_t));
+							sourceIndices[ix] = value;
+							break;
+						}
+						default:
+							memcpy(&sourceIndices[ix], indexStore + ix * sizeof(uint32_t), sizeof(uint32_t));
+							break;
+					}
+				}
+
+				for (const std::vector<uint32_t>& lodIndices : MeshSimplifier::GenerateLODs(positions, sourceIndices)) {
+					IndexBuffer::Sptr lodBuffer = IndexBuffer::Create(BufferUsage::StaticDraw);
+					lodBuffer->LoadData(lodIndices.data(), (uint32_t)lodIndices.size());
+
+					VertexArrayObject::Sptr lod = vao->Clone();
+					lod->SetIndexBuffer(lodBuffer);
+					result.Levels.push_back(lod);
+				}
+			}
+		}
 
 		// Calculate and trace out how long it took us to load
 		float endTime = static_cast<float>(glfwGetTime());
-		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, header.NumVertices, header.NumIndices);
+		LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices, {} LODs)", filename, endTime - startTime, header.NumVertices, header.NumIndices, result.Levels.size() - 1);
 
 		return result;
 	}
 
-	return nullptr;
+	return LodChain();
 }
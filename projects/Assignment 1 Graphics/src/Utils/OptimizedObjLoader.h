@@ -7,11 +7,15 @@
  */
 #pragma once
 #include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/MeshSimplifier.h"
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -19,6 +23,21 @@
 /// </summary>
 class OptimizedObjLoader {
 public:
+	/// <summary>
+	/// Stores a mesh loaded from a binary file, along with all of it's levels of detail
+	/// </summary>
+	struct LodChain {
+		/// <summary>
+		/// The VAOs for each level of detail, where element 0 is the full detail mesh. All
+		/// levels share the same vertex buffer
+		/// </summary>
+		std::vector<VertexArrayObject::Sptr> Levels;
+		/// <summary>
+		/// The radius of the sphere around the mesh's origin that contains all vertices
+		/// </summary>
+		float BoundingRadius = 0.0f;
+	};
+
 	/// <summary>
 	/// Loads a VAO from an OBJ file. On the first time this is called for an OBJ file, will convert the OBJ file 
 	/// to a binary file and load that instead. On subsequent runs, the binary file will be loaded instead
@@ -27,6 +46,21 @@ public:
 	/// <returns>A VAO loaded from disk</returns>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
 	/// <summary>
+	/// Loads a mesh and all of it's levels of detail from an OBJ or binary file. OBJ files will be converted
+	/// to a binary file (generating the LODs) if the binary file does not exist or is from an older version
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <returns>The mesh and it's LODs, Levels will be empty if the load failed</returns>
+	static LodChain LoadLODsFromFile(const std::string& filename);
+	/// <summary>
+	/// Makes sure that an OBJ file has an up to date binary file, converting it if required. This only
+	/// touches CPU memory and the disk, so it is safe to call from worker threads to get the expensive
+	/// conversion out of the way before the mesh is loaded
+	/// </summary>
+	/// <param name="filename">The path to the .obj file</param>
+	/// <returns>The path to the binary file to load</returns>
+	static std::string PrepareFile(const std::string& filename);
+	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
@@ -39,8 +73,9 @@ public:
 	/// <typeparam name="VertexType"></typeparam>
 	/// <param name="mesh"></param>
 	/// <param name="outFilename"></param>
+	/// <param name="lods">The index lists for LOD 1 through N, as generated by the MeshSimplifier</param>
 	template <typename VertexType>
-	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
+	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, const std::vector<std::vector<uint32_t>>& lods = std::vector<std::vector<uint32_t>>());
 
 protected:
 	// Will be put at the start of the binary file, contains info about the contents of the file
@@ -61,15 +96,48 @@ protected:
 		uint8_t   NumAttributes = 0;
 	};
 
+	// Will be put after the vertex data in version 2 files, contains the index counts for each level of detail.
+	// The indices for LOD 1 through N follow the table, back to back
+	struct LodTableHeader {
+		// A check value so we can ensure that we're loading in the right chunk
+		char      HeaderBytes[4] ={ 'L', 'O', 'D', 'S' };
+		// The number of simplified levels stored, not including the full detail mesh
+		uint32_t  NumLods = 0;
+	};
+
+	// The latest version of our binary format, OBJ files with older binaries will be re-converted
+	static const uint16_t CURRENT_VERSION = 0x02;
+	// We never generate more than a handful of levels, a table claiming more than this is corrupt
+	static const uint32_t MAX_LODS = 16;
+
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
-	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	static LodChain _LoadFromBinFile(const std::string& filename);
+	static uint16_t _ReadBinaryVersion(const std::string& filename);
+	/// <summary>
+	/// Checks that a binary file is the current version and that it's LOD table is intact
+	/// </summary>
+	static bool _IsBinaryValid(const std::string& filename);
+	/// <summary>
+	/// Reads and validates the LOD table that follows the vertex data of a version 2 file
+	/// </summary>
+	/// <param name="data">The contents of the file</param>
+	/// <param name="size">The size of the file, in bytes</param>
+	/// <param name="offset">The offset of the LOD table header from the start of the file</param>
+	/// <param name="counts">Receives the number of indices in each level</param>
+	/// <returns>False if the table is missing, has the wrong magic, or claims more data than the file has</returns>
+	static bool _ReadLodTable(const uint8_t* data, size_t size, size_t offset, std::vector<uint32_t>& counts);
+
+	// The binary files that are currently being converted, so that two threads never write the same file
+	inline static std::mutex                      _convertMutex;
+	inline static std::condition_variable         _convertDone;
+	inline static std::unordered_set<std::string> _converting;
 };
 
 template <typename VertexType>
-void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename) {
+void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, const std::vector<std::vector<uint32_t>>& lods) {
 	// Open the output file
 	std::ofstream file(outFilename, std::ios::binary);
 	if (!file) {
@@ -78,7 +146,7 @@ void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std
 
 	// Create the fixed size header for our output file
 	BinaryHeader header  = BinaryHeader();
-	header.Version       = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
+	header.Version       = CURRENT_VERSION; // Update this and implement different readers if changes to format are made
 	header.NumIndices    = mesh.GetIndexCount();
 	header.IndicesType   = IndexType::UInt;
 	header.NumVertices   = mesh.GetVertexCount();
@@ -99,4 +167,16 @@ void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std
 
 	// Write vertex data to file
 	file.write(reinterpret_cast<const char*>(mesh.GetVertexDataPtr()), mesh.GetVertexCount() * sizeof(VertexType));
+
+	// Write the LOD table, followed by the indices for each level
+	LodTableHeader lodHeader = LodTableHeader();
+	lodHeader.NumLods = static_cast<uint32_t>(lods.size());
+	file.write(reinterpret_cast<const char*>(&lodHeader), sizeof(LodTableHeader));
+	for (const auto& lod : lods) {
+		uint32_t count = static_cast<uint32_t>(lod.size());
+		file.write(reinterpret_cast<const char*>(&count), sizeof(uint32_t));
+	}
+	for (const auto& lod : lods) {
+		file.write(reinterpret_cast<const char*>(lod.data()), lod.size() * sizeof(uint32_t));
+	}
 }
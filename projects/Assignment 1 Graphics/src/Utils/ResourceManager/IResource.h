@@ -41,6 +41,17 @@ public:
 	/// <returns>The JSON blob for the resource</returns>
 	virtual nlohmann::json ToJson() const = 0;
 
+	/// <summary>
+	/// Gets an estimate of the number of bytes of GPU memory this resource is holding on to,
+	/// used by the resource manager for memory accounting
+	/// </summary>
+	virtual size_t GetGpuMemoryUsage() const { return 0; }
+	/// <summary>
+	/// Gets an estimate of the number of bytes of CPU memory this resource is holding on to,
+	/// not including the size of the object itself
+	/// </summary>
+	virtual size_t GetCpuMemoryUsage() const { return 0; }
+
 protected:
 	Guid _guid;
 	IResource() : _guid(Guid::New()){}
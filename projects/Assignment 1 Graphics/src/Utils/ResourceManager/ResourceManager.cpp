@@ -1,8 +1,21 @@
 #include "Utils/ResourceManager/ResourceManager.h"
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <set>
+#include <fstream>
+#include <filesystem>
+#include <Logging.h>
 
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/VirtualFileSystem.h"
+#include "Graphics/Textures/TextureCache.h"
 
 std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
 std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
@@ -21,12 +34,50 @@ const nlohmann::ordered_json& ResourceManager::GetManifest() {
 	return _manifest;
 }
 
-void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets) {
-	std::string contents = FileHelpers::ReadFile(path);
-	nlohmann::ordered_json blob = nlohmann::ordered_json::parse(contents);
+bool ResourceManager::LoadManifest(const std::string& path, bool preloadAssets) {
+	FileView file = VirtualFileSystem::Open(path);
+
+	// Binary manifests start with our magic number, anything else we treat as JSON
+	uint32_t magic = 0;
+	if (file.Size() >= sizeof(uint32_t)) {
+		memcpy(&magic, file.Data(), sizeof(uint32_t));
+	}
+	nlohmann::ordered_json blob;
+	if (magic == BINARY_MANIFEST_MAGIC) {
+		try {
+			FileViewStream stream(file);
+			BinaryInputArchive archive(stream);
+			uint32_t version = 0;
+			std::vector<uint8_t> data;
+			archive(magic, version);
+			if (version != BINARY_MANIFEST_VERSION) {
+				LOG_ERROR("Binary manifest \"{}\" is from another version, re-export it from the JSON manifest", path);
+				return false;
+			}
+			archive(data);
+			blob = nlohmann::ordered_json::from_cbor(data);
+		}
+		catch (const std::exception& e) {
+			LOG_ERROR("Failed to load binary manifest \"{}\": {}", path, e.what());
+			return false;
+		}
+	} else {
+		blob = nlohmann::ordered_json::parse(file.Data(), file.Data() + file.Size());
+	}
 	_manifest = blob;
 
-	if (preloadAssets) {
+	// Index every GUID in the manifest, so we can spot references between entries when loading asynchronously
+	_guidTypes.clear();
+	for (auto& [typeName, items] : _manifest.items()) {
+		for (auto& [guid, item] : items.items()) {
+			_guidTypes[guid] = typeName;
+		}
+	}
+
+	if (preloadAssets && ParallelPreload) {
+		Preload();
+	}
+	else if (preloadAssets) {
 		for (auto& [typeName, items] : blob.items()) {
 			auto& func = _typeLoaders[typeName];
 			if (func) {
@@ -36,6 +87,7 @@ void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets)
 			}
 		}
 	}
+	return true;
 }
 
 void ResourceManager::SaveManifest(const std::string& path) {
@@ -49,12 +101,446 @@ void ResourceManager::SaveManifest(const std::string& path) {
 			}
 		}
 	}
-	FileHelpers::WriteContentsToFile(path, _manifest.dump(1,'\t'));
+	if (std::filesystem::path(path).extension() == BINARY_FILE_EXTENSION) {
+		// Resources are loaded lazily from their JSON blobs, so the binary format stores the same data in CBOR,
+		// which saves us from parsing the text
+		std::ofstream file(path, std::ios::binary);
+		BinaryOutputArchive archive(file);
+		archive(BINARY_MANIFEST_MAGIC, BINARY_MANIFEST_VERSION, nlohmann::ordered_json::to_cbor(_manifest));
+	} else {
+		FileHelpers::WriteContentsToFile(path, _manifest.dump(1,'\t'));
+	}
+}
+
+void ResourceManager::Preload(uint32_t numWorkers) {
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Millis;
+
+	struct PreloadItem {
+		std::string    TypeName;
+		Guid           Id;
+		// Workers get their own copy of the data, so they never touch the manifest while the main thread is using it
+		nlohmann::json Data;
+		bool           IsPrefetched = false;
+		PreloadTiming  Timing;
+	};
+
+	auto startTime = Clock::now();
+
+	// Build our work list, with types that others depend on coming first
+	std::vector<PreloadItem> items;
+	for (const auto& typeName : _SortTypesByDependency()) {
+		if (!_typeLoaders[typeName]) {
+			continue;
+		}
+		const bool hasPrefetch = _typePrefetchers.count(typeName) > 0;
+		for (auto& [guid, blob] : _manifest[typeName].items()) {
+			Guid id = Guid(guid);
+			if (_FindLoaded(id, typeName) != nullptr) {
+				continue;
+			}
+			PreloadItem item;
+			item.TypeName = typeName;
+			item.Id = id;
+			item.Data = blob;
+			item.IsPrefetched = !hasPrefetch;
+			item.Timing.TypeName = typeName;
+			item.Timing.Id = id;
+			item.Timing.Label = JsonGet<std::string>(item.Data, "name", JsonGet<std::string>(item.Data, "filename", guid));
+			items.push_back(std::move(item));
+		}
+	}
+
+	// Leave one core for the main thread, it will be busy creating resources
+	if (numWorkers == 0) {
+		uint32_t cores = std::thread::hardware_concurrency();
+		numWorkers = cores > 1 ? cores - 1 : 1;
+	}
+
+	// Workers pull items in order, so the things the main thread needs first are prefetched first
+	std::mutex mutex;
+	std::condition_variable itemReady;
+	std::atomic<size_t> nextItem(0);
+	std::vector<std::thread> workers;
+	workers.reserve(numWorkers);
+	for (uint32_t ix = 0; ix < numWorkers; ix++) {
+		workers.emplace_back([&]() {
+			for (size_t index = nextItem++; index < items.size(); index = nextItem++) {
+				PreloadItem& item = items[index];
+				if (item.IsPrefetched) {
+					continue;
+				}
+
+				// A failed prefetch isn't fatal, the resource will just do all of it's loading on the main thread
+				auto prefetchStart = Clock::now();
+				try {
+					_typePrefetchers.at(item.TypeName)(item.Data);
+				}
+				catch (std::exception& e) {
+					LOG_WARN("Failed to prefetch {} \"{}\": {}", item.TypeName, item.Timing.Label, e.what());
+				}
+				item.Timing.PrefetchMs = Millis(Clock::now() - prefetchStart).count();
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					item.IsPrefetched = true;
+				}
+				itemReady.notify_all();
+			}
+		});
+	}
+
+	// Create the resources in order as their prefetches finish, anything referenced by a resource of the
+	// same type will be loaded on demand through Get
+	for (auto& item : items) {
+		auto waitStart = Clock::now();
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			itemReady.wait(lock, [&] { return item.IsPrefetched; });
+		}
+		item.Timing.WaitMs = Millis(Clock::now() - waitStart).count();
+
+		auto finalizeStart = Clock::now();
+		if (_FindLoaded(item.Id, item.TypeName) == nullptr) {
+			_typeLoaders[item.TypeName](item.Data);
+		}
+		_Touch(item.Id);
+		item.Timing.FinalizeMs = Millis(Clock::now() - finalizeStart).count();
+	}
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Anything that was prefetched but never picked up (ex: textures that went to the async loader, or failed
+	// to finalize) would otherwise sit in memory forever
+	TextureCache::ClearStaged();
+	for (auto& [typeName, cleanup] : _typePrefetchCleanup) {
+		cleanup();
+	}
+
+	// Report where our time went, slowest resources first
+	_preloadTimings.clear();
+	_preloadTimings.reserve(items.size());
+	std::map<std::string, PreloadTiming> typeTotals;
+	for (const auto& item : items) {
+		_preloadTimings.push_back(item.Timing);
+		PreloadTiming& total = typeTotals[item.TypeName];
+		total.PrefetchMs += item.Timing.PrefetchMs;
+		total.WaitMs     += item.Timing.WaitMs;
+		total.FinalizeMs += item.Timing.FinalizeMs;
+	}
+	std::sort(_preloadTimings.begin(), _preloadTimings.end(), [](const PreloadTiming& a, const PreloadTiming& b) {
+		return a.PrefetchMs + a.FinalizeMs > b.PrefetchMs + b.FinalizeMs;
+	});
+
+	LOG_INFO("Preloaded {} resources in {:.2f}ms using {} workers", items.size(), Millis(Clock::now() - startTime).count(), numWorkers);
+	for (const auto& [typeName, total] : typeTotals) {
+		LOG_INFO("\t{:<16} prefetch {:>9.2f}ms  wait {:>9.2f}ms  finalize {:>9.2f}ms", typeName, total.PrefetchMs, total.WaitMs, total.FinalizeMs);
+	}
+	for (const auto& timing : _preloadTimings) {
+		LOG_INFO("\t\t{:<16} {:<40} prefetch {:>9.2f}ms  wait {:>9.2f}ms  finalize {:>9.2f}ms", timing.TypeName, timing.Label, timing.PrefetchMs, timing.WaitMs, timing.FinalizeMs);
+	}
+}
+
+void ResourceManager::Update() {
+	_frameIndex++;
+
+	// Load as many queued resources as we can within our budget, we always load at least one
+	auto startTime = std::chrono::high_resolution_clock::now();
+	while (!_loadQueue.empty()) {
+		std::shared_ptr<LoadRequest> request = _loadQueue.front();
+		_loadQueue.pop_front();
+		_ProcessRequest(request);
+
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+		if (elapsed.count() >= LoadBudgetMs) {
+			break;
+		}
+	}
+
+	if (MemoryBudget > 0) {
+		// Anything held outside of the manager is in use, so we keep it's timestamp fresh
+		for (auto& [type, map] : _resources) {
+			for (auto& [guid, res] : map) {
+				if (res != nullptr && res.use_count() > 1) {
+					_Touch(guid);
+				}
+			}
+		}
+		if (GetTotalMemoryUsage() > MemoryBudget) {
+			Evict(MemoryBudget);
+		}
+	}
+}
+
+void ResourceManager::Flush() {
+	while (!_loadQueue.empty()) {
+		std::shared_ptr<LoadRequest> request = _loadQueue.front();
+		_loadQueue.pop_front();
+		_ProcessRequest(request);
+	}
+}
+
+size_t ResourceManager::GetPendingCount() {
+	return _loadQueue.size();
+}
+
+std::map<std::string, ResourceManager::MemoryStats> ResourceManager::GetMemoryStats() {
+	std::map<std::string, MemoryStats> result;
+	for (auto& [type, map] : _resources) {
+		MemoryStats& stats = result[StringTools::SanitizeClassName(type.name())];
+		for (auto& [guid, res] : map) {
+			if (res != nullptr) {
+				stats.Count++;
+				stats.Referenced += res.use_count() > 1 ? 1 : 0;
+				stats.CpuBytes   += res->GetCpuMemoryUsage();
+				stats.GpuBytes   += res->GetGpuMemoryUsage();
+			}
+		}
+	}
+	return result;
+}
+
+size_t ResourceManager::GetTotalMemoryUsage() {
+	size_t result = 0;
+	for (auto& [type, map] : _resources) {
+		for (auto& [guid, res] : map) {
+			if (res != nullptr) {
+				result += res->GetCpuMemoryUsage() + res->GetGpuMemoryUsage();
+			}
+		}
+	}
+	return result;
+}
+
+size_t ResourceManager::Evict(size_t targetBytes) {
+	struct Candidate {
+		std::type_index Type;
+		Guid            Id;
+		uint64_t        LastUsed;
+		size_t          Size;
+	};
+
+	// Only resources that nobody else is holding on to, and that haven't been used recently, can go
+	std::vector<Candidate> candidates;
+	size_t total = 0;
+	for (auto& [type, map] : _resources) {
+		for (auto& [guid, res] : map) {
+			if (res == nullptr) {
+				continue;
+			}
+			size_t size = res->GetCpuMemoryUsage() + res->GetGpuMemoryUsage();
+			total += size;
+
+			auto it = _lastUsed.find(guid);
+			uint64_t lastUsed = it != _lastUsed.end() ? it->second : 0;
+			if (res.use_count() == 1 && _frameIndex - lastUsed >= EvictionDelayFrames) {
+				candidates.push_back({ type, guid, lastUsed, size });
+			}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		return a.LastUsed < b.LastUsed;
+	});
+
+	size_t evicted = 0;
+	for (const Candidate& candidate : candidates) {
+		if (total <= targetBytes) {
+			break;
+		}
+		auto& map = _resources[candidate.Type];
+		auto it = map.find(candidate.Id);
+
+		// Make sure the manifest is up to date so that we can load the resource again later
+		std::string typeName = StringTools::SanitizeClassName(candidate.Type.name());
+		std::string guid = candidate.Id.str();
+		_manifest[typeName][guid] = it->second->ToJson();
+		_manifest[typeName][guid]["guid"] = guid;
+		_guidTypes[guid] = typeName;
+
+		map.erase(it);
+		_lastUsed.erase(candidate.Id);
+		total -= candidate.Size;
+		evicted++;
+	}
+
+	if (evicted > 0) {
+		LOG_INFO("Evicted {} resources, {:.2f}MB in use", evicted, total / (1024.0 * 1024.0));
+	}
+	return evicted;
 }
 
 void ResourceManager::Cleanup() {
 	for (auto& [type, map] : _resources) {
 		map.clear();
 	}
+	_loadQueue.clear();
+	_pendingLoads.clear();
+	_lastUsed.clear();
+}
+
+std::shared_ptr<ResourceManager::LoadRequest> ResourceManager::_Enqueue(Guid id, const std::string& typeName) {
+	_Touch(id);
+
+	// If the resource is already queued, we can share the request
+	auto pending = _pendingLoads.find(id);
+	if (pending != _pendingLoads.end()) {
+		return pending->second;
+	}
+
+	std::shared_ptr<LoadRequest> request = std::make_shared<LoadRequest>();
+	request->Id = id;
+	request->TypeName = typeName;
+
+	// Already loaded, nothing to wait on
+	request->Result = _FindLoaded(id, typeName);
+	if (request->Result != nullptr) {
+		request->IsDone = true;
+		return request;
+	}
+
+	std::string guid = id.str();
+	if (!_manifest.contains(typeName) || !_manifest[typeName].contains(guid)) {
+		LOG_WARN("Cannot load {} \"{}\", it is not in the manifest", typeName, guid);
+		request->IsDone = true;
+		return request;
+	}
+
+	_pendingLoads[id] = request;
+	std::unordered_set<std::string> visited;
+	_EnqueueWithDependencies(guid, typeName, visited);
+	return request;
+}
+
+void ResourceManager::_EnqueueWithDependencies(const std::string& guid, const std::string& typeName, std::unordered_set<std::string>& visited) {
+	if (!visited.insert(guid).second) {
+		return;
+	}
+
+	// Queue up everything this resource refers to first, so that it's references resolve when it loads
+	std::vector<std::string> dependencies;
+	_FindDependencies(_manifest[typeName][guid], guid, dependencies);
+	for (const auto& dependency : dependencies) {
+		const std::string& dependencyType = _guidTypes[dependency];
+		Guid dependencyId = Guid(dependency);
+		if (_pendingLoads.count(dependencyId) == 0 && _FindLoaded(dependencyId, dependencyType) == nullptr) {
+			std::shared_ptr<LoadRequest> request = std::make_shared<LoadRequest>();
+			request->Id = dependencyId;
+			request->TypeName = dependencyType;
+			_pendingLoads[dependencyId] = request;
+			_EnqueueWithDependencies(dependency, dependencyType, visited);
+		}
+	}
+
+	auto request = _pendingLoads.find(Guid(guid));
+	if (request != _pendingLoads.end()) {
+		_loadQueue.push_back(request->second);
+	}
+}
+
+void ResourceManager::_FindDependencies(const nlohmann::ordered_json& blob, const std::string& self, std::vector<std::string>& result) {
+	if (blob.is_string()) {
+		const std::string& value = blob.get_ref<const std::string&>();
+		if (value != self && _guidTypes.count(value) > 0) {
+			result.push_back(value);
+		}
+	}
+	else if (blob.is_structured()) {
+		for (const auto& child : blob) {
+			_FindDependencies(child, self, result);
+		}
+	}
+}
+
+IResource::Sptr ResourceManager::_FindLoaded(Guid id, const std::string& typeName) {
+	auto typeIt = _typeIndices.find(typeName);
+	if (typeIt == _typeIndices.end()) {
+		return nullptr;
+	}
+	auto& map = _resources[typeIt->second];
+	auto it = map.find(id);
+	return it != map.end() ? it->second : nullptr;
+}
+
+void ResourceManager::_ProcessRequest(const std::shared_ptr<LoadRequest>& request) {
+	_pendingLoads.erase(request->Id);
+	if (request->IsDone) {
+		return;
+	}
+
+	// The resource may have been loaded with Get while it was waiting in the queue
+	request->Result = _FindLoaded(request->Id, request->TypeName);
+	if (request->Result == nullptr) {
+		auto& loader = _typeLoaders[request->TypeName];
+		if (loader) {
+			loader(_manifest[request->TypeName][request->Id.str()]);
+			request->Result = _FindLoaded(request->Id, request->TypeName);
+		}
+		else {
+			LOG_WARN("Cannot load \"{}\", type {} has not been registered", request->Id.str(), request->TypeName);
+		}
+	}
+	request->IsDone = true;
+	_Touch(request->Id);
+}
+
+std::vector<std::string> ResourceManager::_SortTypesByDependency() {
+	// Find which types refer to which other types
+	std::vector<std::string> types;
+	std::map<std::string, std::set<std::string>> dependsOn;
+	for (auto& [typeName, items] : _manifest.items()) {
+		types.push_back(typeName);
+		std::set<std::string>& typeDeps = dependsOn[typeName];
+		for (auto& [guid, blob] : items.items()) {
+			std::vector<std::string> dependencies;
+			_FindDependencies(blob, guid, dependencies);
+			for (const auto& dependency : dependencies) {
+				const std::string& dependencyType = _guidTypes[dependency];
+				if (dependencyType != typeName) {
+					typeDeps.insert(dependencyType);
+				}
+			}
+		}
+	}
+
+	// Repeatedly take the types whose dependencies have all been taken, keeping the manifest order otherwise
+	std::vector<std::string> result;
+	std::set<std::string> placed;
+	while (result.size() < types.size()) {
+		bool progress = false;
+		for (const auto& typeName : types) {
+			if (placed.count(typeName) > 0) {
+				continue;
+			}
+			bool isReady = std::all_of(dependsOn[typeName].begin(), dependsOn[typeName].end(), [&](const std::string& dep) {
+				return placed.count(dep) > 0 || dependsOn.count(dep) == 0;
+			});
+			if (isReady) {
+				result.push_back(typeName);
+				placed.insert(typeName);
+				progress = true;
+			}
+		}
+
+		// Types that refer to each other can't be ordered, we fall back to manifest order and let Get sort it out
+		if (!progress) {
+			for (const auto& typeName : types) {
+				if (placed.insert(typeName).second) {
+					LOG_WARN("Resource type {} is part of a dependency cycle", typeName);
+					result.push_back(typeName);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+void ResourceManager::_Wait(const std::shared_ptr<LoadRequest>& request) {
+	while (!request->IsDone && !_loadQueue.empty()) {
+		std::shared_ptr<LoadRequest> next = _loadQueue.front();
+		_loadQueue.pop_front();
+		_ProcessRequest(next);
+	}
 }
 
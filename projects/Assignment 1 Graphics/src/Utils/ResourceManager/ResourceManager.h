@@ -2,18 +2,93 @@
 
 #include <json.hpp>
 #include <unordered_map>
+#include <unordered_set>
 #include <typeindex>
+#include <deque>
 
 #include "Utils/GUID.hpp"
+#include "Utils/BinarySerialization.h"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/StringUtils.h"
 
+template <typename T>
+class ResourceHandle;
+
 /// <summary>
 /// Utility class for managing and loading resources from JSON
 /// manifest files
+///
+/// Resources can be loaded synchronously with Get, or queued with LoadAsync, in which case they are loaded
+/// (along with everything they reference in the manifest) during Update within a per-frame time budget.
+/// If a memory budget is set, resources that nothing outside of the manager is holding on to will be
+/// unloaded least recently used first until we are back under budget, they will be reloaded from the
+/// manifest the next time they are requested
 /// </summary>
 class ResourceManager {
 public:
+	/// <summary>
+	/// Memory usage for all loaded resources of a single type
+	/// </summary>
+	struct MemoryStats {
+		// The number of loaded resources
+		size_t Count      = 0;
+		// The number of loaded resources that are referenced outside of the resource manager
+		size_t Referenced = 0;
+		// The estimated CPU memory used by the resources, in bytes
+		size_t CpuBytes   = 0;
+		// The estimated GPU memory used by the resources, in bytes
+		size_t GpuBytes   = 0;
+	};
+
+	/// <summary>
+	/// Timings for a single resource loaded by Preload
+	/// </summary>
+	struct PreloadTiming {
+		std::string TypeName;
+		Guid        Id;
+		// The name or filename of the resource, or it's GUID if it has neither
+		std::string Label;
+		// Time spent in the type's Prefetch on a worker thread
+		double      PrefetchMs = 0.0;
+		// Time the main thread spent waiting for the prefetch to finish
+		double      WaitMs     = 0.0;
+		// Time spent creating the resource on the main thread
+		double      FinalizeMs = 0.0;
+	};
+
+	/// <summary>
+	/// Shared state for a resource queued with LoadAsync
+	/// </summary>
+	struct LoadRequest {
+		Guid            Id;
+		std::string     TypeName;
+		IResource::Sptr Result = nullptr;
+		bool            IsDone = false;
+	};
+
+	// Identifies binary manifest files, and the version of the binary format
+	static constexpr uint32_t BINARY_MANIFEST_MAGIC   = MakeFourCC('M', 'N', 'F', 'B');
+	static constexpr uint32_t BINARY_MANIFEST_VERSION = 1;
+
+	/// <summary>
+	/// The amount of time per frame (in milliseconds) that Update may spend loading queued resources. At
+	/// least one resource is always loaded per frame so that the queue keeps moving
+	/// </summary>
+	inline static float    LoadBudgetMs        = 2.0f;
+	/// <summary>
+	/// The total memory (CPU + GPU, in bytes) that loaded resources may use before unreferenced resources
+	/// start being evicted, or 0 to never evict resources
+	/// </summary>
+	inline static size_t   MemoryBudget        = 0;
+	/// <summary>
+	/// The number of frames a resource must go unused before it can be evicted
+	/// </summary>
+	inline static uint32_t EvictionDelayFrames = 120;
+	/// <summary>
+	/// True if LoadManifest should use Preload when preloading assets, false to load them one by one on the calling thread
+	/// </summary>
+	inline static bool     ParallelPreload     = true;
+
 	/// <summary>
 	/// Initializes the resource manager and performs any first-time
 	/// setup required
@@ -32,6 +107,7 @@ public:
 		// Create and store the asset
 		std::shared_ptr<T> asset = std::make_shared<T>(std::forward<TArgs>(args)...);
 		_resources[std::type_index(typeid(T))][asset->IResource::GetGUID()] = asset;
+		_Touch(asset->IResource::GetGUID());
 
 		// Get the JSON representation of the asset so we can store it in the manifest
 		nlohmann::json data = asset->ToJson();
@@ -41,7 +117,9 @@ public:
 		data["guid"] = guid;
 
 		// Store the JSON data in the resource manifest (based on the type's name)
-		_manifest[StringTools::SanitizeClassName(typeid(T).name())][guid] = data;
+		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		_manifest[typeName][guid] = data;
+		_guidTypes[guid] = typeName;
 		return asset;
 	}
 
@@ -53,6 +131,8 @@ public:
 	/// <returns>The resource with the given GUID, or nullptr if none exists</returns>
 	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
 	static std::shared_ptr<T> Get(Guid id) {
+		_Touch(id);
+
 		// Try and grab the asset from the resource pool
 		std::shared_ptr<T> result =  std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
 
@@ -75,6 +155,19 @@ public:
 		return result;
 	}
 
+	/// <summary>
+	/// Queues a resource to be loaded from the manifest during Update, any resources it references in the
+	/// manifest are queued ahead of it. If the resource is already loaded, the handle is ready immediately
+	/// </summary>
+	/// <typeparam name="T">The type of resource to load</typeparam>
+	/// <param name="id">The ID of the resource to load</param>
+	/// <returns>A handle that can be polled for the resource</returns>
+	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static ResourceHandle<T> LoadAsync(Guid id) {
+		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		return ResourceHandle<T>(_Enqueue(id, typeName));
+	}
+
 	/// <summary>
 	/// Registers a resource type with the resource manager, only types that have been registered
 	/// can be loaded from JSON manifest files!
@@ -85,6 +178,7 @@ public:
 	static void RegisterType() {
 		// Extract the type name from a sanitized version of they typeid name
 		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		_typeIndices.emplace(typeName, std::type_index(typeid(T)));
 
 		// Create the type loader for the type
 		_typeLoaders[typeName] = [](const nlohmann::json& data) {
@@ -94,6 +188,18 @@ public:
 			return res->GetGUID();
 		};
 
+		// Types that can do part of their loading off the main thread provide a static Prefetch method
+		if constexpr (test_prefetch<T, const nlohmann::json&>::value) {
+			_typePrefetchers[typeName] = [](const nlohmann::json& data) {
+				T::Prefetch(data);
+			};
+		}
+		if constexpr (test_clear_prefetched<T>::value) {
+			_typePrefetchCleanup[typeName] = []() {
+				T::ClearPrefetched();
+			};
+		}
+
 		// Make sure we haven't registered the type yet, then add an empty object
 		// to the manifest to ensure it can be saved
 		if (!_manifest.contains(typeName)) {
@@ -133,14 +239,58 @@ public:
 	/// Loads a manifest file into the resource manager. Note that this will not perform load on the assets themselves 
 	/// unless preloadAssets is set to true
 	/// </summary>
-	/// <param name="path">The path to the JSON manifest file</param>
+	/// <param name="path">The path to the JSON or binary manifest file</param>
 	/// <param name="preloadAssets">True if all assets should be loaded into memory</param>
-	static void LoadManifest(const std::string& path, bool preloadAssets = false);
+	/// <returns>False if the manifest could not be read, in which case the current manifest is left as-is</returns>
+	static bool LoadManifest(const std::string& path, bool preloadAssets = false);
 	/// <summary>
-	/// Saves the manifest to the given JSON file
+	/// Saves the manifest to the given file, in the binary format if the path ends with BINARY_FILE_EXTENSION
+	/// (see BinarySerialization.h) or as JSON otherwise
 	/// </summary>
 	/// <param name="path">The path to the file to output</param>
 	static void SaveManifest(const std::string& path);
+	/// <summary>
+	/// Loads every resource in the manifest that isn't loaded yet. Types are ordered by the references between
+	/// them in the manifest, so that (for instance) textures are loaded before the materials that use them. Types
+	/// with a static Prefetch method have that run on a pool of worker threads, while the main thread creates
+	/// the resources (and their OpenGL objects) in dependency order as their prefetches finish
+	/// </summary>
+	/// <param name="numWorkers">The number of worker threads to use, or 0 to pick based on the CPU</param>
+	static void Preload(uint32_t numWorkers = 0);
+	/// <summary>
+	/// Gets the per-resource timings from the last call to Preload
+	/// </summary>
+	static const std::vector<PreloadTiming>& GetPreloadTimings() { return _preloadTimings; }
+
+	/// <summary>
+	/// Loads queued resources until the load budget is used up, and evicts unreferenced resources if we are
+	/// over the memory budget. Should be called once per frame from the GL thread
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Loads all queued resources, blocking until the queue is empty
+	/// </summary>
+	static void Flush();
+	/// <summary>
+	/// Gets the number of resources waiting to be loaded
+	/// </summary>
+	static size_t GetPendingCount();
+
+	/// <summary>
+	/// Gets the memory usage of all loaded resources, grouped by type name
+	/// </summary>
+	static std::map<std::string, MemoryStats> GetMemoryStats();
+	/// <summary>
+	/// Gets the total estimated memory (CPU + GPU) used by all loaded resources, in bytes
+	/// </summary>
+	static size_t GetTotalMemoryUsage();
+	/// <summary>
+	/// Unloads unreferenced resources, least recently used first, until the total memory usage is below
+	/// the given target. Evicted resources remain in the manifest and will be reloaded when requested
+	/// </summary>
+	/// <param name="targetBytes">The memory usage to get down to, in bytes</param>
+	/// <returns>The number of resources that were evicted</returns>
+	static size_t Evict(size_t targetBytes);
 
 	/// <summary>
 	/// Releases all resources held by the resource manager
@@ -148,6 +298,9 @@ public:
 	static void Cleanup();
 
 protected:
+	template <typename T>
+	friend class ResourceHandle;
+
 	/// <summary>
 	/// This is a map of maps
 	/// The top level map uses type_index, so there's a map per resource type
@@ -164,4 +317,94 @@ protected:
 	/// This allows us to register dependencies before the dependent resource
 	/// </summary>
 	static nlohmann::ordered_json _manifest;
+
+	// Stores the Prefetch method for registered types that have one
+	inline static std::map<std::string, std::function<void(const nlohmann::json&)>> _typePrefetchers;
+	// Stores the ClearPrefetched method for registered types that have one, called once Preload finishes
+	inline static std::map<std::string, std::function<void()>> _typePrefetchCleanup;
+	inline static std::vector<PreloadTiming>                       _preloadTimings;
+
+	// Maps registered type names to the type index their resources are stored under
+	inline static std::unordered_map<std::string, std::type_index> _typeIndices;
+	// Maps GUIDs in the manifest to the name of their type, used to find the dependencies of a resource
+	inline static std::unordered_map<std::string, std::string>     _guidTypes;
+	// The frame that each resource was last requested or referenced on, used for LRU eviction
+	inline static std::unordered_map<Guid, uint64_t>               _lastUsed;
+	inline static uint64_t                                         _frameIndex = 0;
+	// Resources waiting to be loaded, dependencies are always queued ahead of the resources that need them
+	inline static std::deque<std::shared_ptr<LoadRequest>>         _loadQueue;
+	inline static std::unordered_map<Guid, std::shared_ptr<LoadRequest>> _pendingLoads;
+
+	/// <summary>
+	/// Marks a resource as being used this frame
+	/// </summary>
+	static void _Touch(Guid id) { _lastUsed[id] = _frameIndex; }
+	/// <summary>
+	/// Queues a resource and any of it's dependencies that are not loaded yet
+	/// </summary>
+	static std::shared_ptr<LoadRequest> _Enqueue(Guid id, const std::string& typeName);
+	/// <summary>
+	/// Recursively queues the dependencies of a manifest entry, followed by the entry itself
+	/// </summary>
+	static void _EnqueueWithDependencies(const std::string& guid, const std::string& typeName, std::unordered_set<std::string>& visited);
+	/// <summary>
+	/// Finds the GUIDs of all other manifest entries that a JSON blob refers to
+	/// </summary>
+	static void _FindDependencies(const nlohmann::ordered_json& blob, const std::string& self, std::vector<std::string>& result);
+	/// <summary>
+	/// Gets the loaded resource with the given type name and ID, or nullptr if it's not loaded
+	/// </summary>
+	static IResource::Sptr _FindLoaded(Guid id, const std::string& typeName);
+	/// <summary>
+	/// Loads a single queued resource
+	/// </summary>
+	static void _ProcessRequest(const std::shared_ptr<LoadRequest>& request);
+	/// <summary>
+	/// Orders the types in the manifest so that every type comes after the types it refers to
+	/// </summary>
+	static std::vector<std::string> _SortTypesByDependency();
+	/// <summary>
+	/// Loads queued resources until the given request is done
+	/// </summary>
+	static void _Wait(const std::shared_ptr<LoadRequest>& request);
+};
+
+/// <summary>
+/// A handle to a resource that was queued with ResourceManager::LoadAsync
+/// </summary>
+/// <typeparam name="T">The type of resource being loaded</typeparam>
+template <typename T>
+class ResourceHandle {
+public:
+	ResourceHandle() : _request(nullptr) {}
+
+	/// <summary>
+	/// Returns true if the resource has finished loading (or failed to load)
+	/// </summary>
+	bool IsReady() const { return _request == nullptr || _request->IsDone; }
+	/// <summary>
+	/// Gets the resource, or nullptr if it is not ready yet or could not be loaded
+	/// </summary>
+	std::shared_ptr<T> Get() const {
+		return IsReady() && _request != nullptr ? std::dynamic_pointer_cast<T>(_request->Result) : nullptr;
+	}
+	/// <summary>
+	/// Loads queued resources until this one is ready, then returns it
+	/// </summary>
+	std::shared_ptr<T> Wait() const {
+		if (_request != nullptr) {
+			ResourceManager::_Wait(_request);
+		}
+		return Get();
+	}
+	/// <summary>
+	/// Gets the ID of the resource being loaded
+	/// </summary>
+	Guid GetGUID() const { return _request != nullptr ? _request->Id : Guid(); }
+
+protected:
+	friend class ResourceManager;
+	ResourceHandle(const std::shared_ptr<ResourceManager::LoadRequest>& request) : _request(request) {}
+
+	std::shared_ptr<ResourceManager::LoadRequest> _request;
 };
\ No newline at end of file
@@ -11,4 +11,30 @@ namespace detail {
 } // detail::
 
 template<class T, class Arg>
-struct test_json : decltype(detail::test_json<T, Arg>(0)){};
\ No newline at end of file
+struct test_json : decltype(detail::test_json<T, Arg>(0)){};
+
+namespace detail {
+	template<class T, class A0>
+	static auto test_prefetch(int)->sfinae_true<decltype(T::Prefetch(std::declval<A0>()))>;
+	template<class, class A0>
+	static auto test_prefetch(long)->std::false_type;
+} // detail::
+
+/// <summary>
+/// True if T has a static Prefetch method that accepts an Arg
+/// </summary>
+template<class T, class Arg>
+struct test_prefetch : decltype(detail::test_prefetch<T, Arg>(0)){};
+
+namespace detail {
+	template<class T>
+	static auto test_clear_prefetched(int)->sfinae_true<decltype(T::ClearPrefetched())>;
+	template<class>
+	static auto test_clear_prefetched(long)->std::false_type;
+} // detail::
+
+/// <summary>
+/// True if T has a static ClearPrefetched method that drops any prefetched data that was never used
+/// </summary>
+template<class T>
+struct test_clear_prefetched : decltype(detail::test_clear_prefetched<T>(0)){};
\ No newline at end of file
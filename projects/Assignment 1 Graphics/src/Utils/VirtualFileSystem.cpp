@@ -0,0 +1,275 @@
+#include "Utils/VirtualFileSystem.h"
+
+#include <fstream>
+#include <cstring>
+#include <zlib.h>
+#include <Logging.h>
+
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+FileViewStream::Buffer::Buffer(const FileView& view) {
+	char* begin = const_cast<char*>(reinterpret_cast<const char*>(view.Data()));
+	setg(begin, begin, begin + view.Size());
+}
+
+std::streambuf::pos_type FileViewStream::Buffer::seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+	char* target = nullptr;
+	switch (dir) {
+		case std::ios_base::beg: target = eback() + offset; break;
+		case std::ios_base::cur: target = gptr() + offset; break;
+		case std::ios_base::end: target = egptr() + offset; break;
+		default: return pos_type(off_type(-1));
+	}
+	if (!(which & std::ios_base::in) || target < eback() || target > egptr()) {
+		return pos_type(off_type(-1));
+	}
+	setg(eback(), target, egptr());
+	return pos_type(target - eback());
+}
+
+std::streambuf::pos_type FileViewStream::Buffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+FileViewStream::FileViewStream(const FileView& view) :
+	std::istream(nullptr),
+	_view(view),
+	_buffer(_view)
+{
+	rdbuf(&_buffer);
+	if (!_view.IsValid()) {
+		setstate(std::ios_base::failbit);
+	}
+}
+
+bool VirtualFileSystem::Mount(const std::string& packPath) {
+	std::unique_ptr<MappedPack> pack = std::make_unique<MappedPack>();
+	pack->Path = packPath;
+	if (!_Map(*pack)) {
+		LOG_WARN("Failed to map asset pack \"{}\"", packPath);
+		return false;
+	}
+
+	// Validate the header and make sure the index fits in the file before we trust anything in it. Offsets come
+	// from the file, so we compare sizes against the space left after an offset rather than adding to it, which
+	// could overflow
+	const AssetPack::FileHeader* header = reinterpret_cast<const AssetPack::FileHeader*>(pack->Data);
+	const AssetPack::FileHeader expected = AssetPack::FileHeader();
+	if (pack->Size < sizeof(AssetPack::FileHeader) ||
+		memcmp(header->HeaderBytes, expected.HeaderBytes, 4) != 0 ||
+		header->Version != AssetPack::CURRENT_VERSION ||
+		header->IndexOffset > pack->Size ||
+		(uint64_t)header->NumEntries * sizeof(AssetPack::IndexEntry) + header->StringTableSize > pack->Size - header->IndexOffset) {
+		LOG_WARN("\"{}\" is not a valid asset pack (or is from another version)", packPath);
+		_Unmap(*pack);
+		return false;
+	}
+
+	const AssetPack::IndexEntry* entries = reinterpret_cast<const AssetPack::IndexEntry*>(pack->Data + header->IndexOffset);
+	const char* strings = reinterpret_cast<const char*>(entries + header->NumEntries);
+	for (uint32_t ix = 0; ix < header->NumEntries; ix++) {
+		const AssetPack::IndexEntry& entry = entries[ix];
+		if (entry.PathOffset + (uint64_t)entry.PathLength > header->StringTableSize || entry.DataOffset > header->IndexOffset || entry.StoredSize > header->IndexOffset - entry.DataOffset) {
+			LOG_WARN("Skipping corrupt entry {} in asset pack \"{}\"", ix, packPath);
+			continue;
+		}
+		_index[std::string(strings + entry.PathOffset, entry.PathLength)] = { pack.get(), &entry };
+	}
+
+	LOG_INFO("Mounted asset pack \"{}\" ({} files, {:.2f}MB)", packPath, header->NumEntries, pack->Size / (1024.0 * 1024.0));
+	_packs.push_back(std::move(pack));
+	return true;
+}
+
+void VirtualFileSystem::UnmountAll() {
+	_index.clear();
+	for (auto& pack : _packs) {
+		_Unmap(*pack);
+	}
+	_packs.clear();
+}
+
+bool VirtualFileSystem::Exists(const std::string& path) {
+	std::error_code err;
+	return _Find(path) != nullptr || fs::exists(path, err);
+}
+
+bool VirtualFileSystem::IsPacked(const std::string& path) {
+	return _Find(path) != nullptr;
+}
+
+bool VirtualFileSystem::GetWriteTime(const std::string& path, fs::file_time_type& result) {
+	auto packed = _Find(path);
+	if (packed != nullptr) {
+		result = fs::file_time_type(fs::file_time_type::duration(packed->second->WriteTime));
+		return true;
+	}
+
+	std::error_code err;
+	result = fs::last_write_time(path, err);
+	return !err;
+}
+
+FileView VirtualFileSystem::Open(const std::string& path) {
+	auto packed = _Find(path);
+	if (packed == nullptr) {
+		return _ReadLoose(path);
+	}
+
+	const MappedPack& pack = *packed->first;
+	const AssetPack::IndexEntry& entry = *packed->second;
+	FileView result;
+
+	// Uncompressed data can be used right out of the mapping
+	if ((entry.Flags & AssetPack::FLAG_COMPRESSED) == 0) {
+		result._data = pack.Data + entry.DataOffset;
+		result._size = entry.Size;
+		return result;
+	}
+
+	std::shared_ptr<std::vector<uint8_t>> buffer = std::make_shared<std::vector<uint8_t>>(entry.Size);
+	uLongf size = static_cast<uLongf>(entry.Size);
+	if (uncompress(buffer->data(), &size, pack.Data + entry.DataOffset, static_cast<uLong>(entry.StoredSize)) != Z_OK || size != entry.Size) {
+		LOG_ERROR("Failed to decompress \"{}\" from asset pack \"{}\"", path, pack.Path);
+		return result;
+	}
+	result._owned = buffer;
+	result._data = buffer->data();
+	result._size = buffer->size();
+	return result;
+}
+
+std::string VirtualFileSystem::ReadText(const std::string& path) {
+	FileView view = Open(path);
+	return std::string(view.AsString());
+}
+
+std::string VirtualFileSystem::_GetKey(const std::string& path) {
+	fs::path result = fs::path(path);
+	if (result.is_absolute()) {
+		std::error_code err;
+		fs::path relative = result.lexically_relative(fs::current_path(err));
+		if (!relative.empty() && *relative.begin() != "..") {
+			result = relative;
+		}
+	}
+	return AssetPack::NormalizePath(result.string());
+}
+
+const std::pair<const VirtualFileSystem::MappedPack*, const AssetPack::IndexEntry*>* VirtualFileSystem::_Find(const std::string& path) {
+	if (_index.empty()) {
+		return nullptr;
+	}
+	auto it = _index.find(_GetKey(path));
+	if (it == _index.end()) {
+		return nullptr;
+	}
+	if (PreferLooseFiles) {
+		std::error_code err;
+		if (fs::exists(path, err)) {
+			return nullptr;
+		}
+	}
+	return &it->second;
+}
+
+FileView VirtualFileSystem::_ReadLoose(const std::string& path) {
+	FileView result;
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return result;
+	}
+
+	std::shared_ptr<std::vector<uint8_t>> buffer = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(file.tellg()));
+	file.seekg(0, std::ios::beg);
+	file.read(reinterpret_cast<char*>(buffer->data()), buffer->size());
+	if (!file) {
+		return result;
+	}
+	result._owned = buffer;
+	result._data = buffer->data();
+	result._size = buffer->size();
+	return result;
+}
+
+#ifdef WINDOWS
+bool VirtualFileSystem::_Map(MappedPack& pack) {
+	HANDLE file = CreateFileA(pack.Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	pack.FileHandle = file;
+	pack.MappingHandle = mapping;
+	pack.Data = static_cast<const uint8_t*>(data);
+	pack.Size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void VirtualFileSystem::_Unmap(MappedPack& pack) {
+	if (pack.Data != nullptr) {
+		UnmapViewOfFile(pack.Data);
+	}
+	if (pack.MappingHandle != nullptr) {
+		CloseHandle(pack.MappingHandle);
+	}
+	if (pack.FileHandle != nullptr) {
+		CloseHandle(pack.FileHandle);
+	}
+	pack = MappedPack();
+}
+#else
+bool VirtualFileSystem::_Map(MappedPack& pack) {
+	int file = open(pack.Path.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps the file alive, we don't need the descriptor anymore
+	close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	pack.Data = static_cast<const uint8_t*>(data);
+	pack.Size = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void VirtualFileSystem::_Unmap(MappedPack& pack) {
+	if (pack.Data != nullptr) {
+		munmap(const_cast<uint8_t*>(pack.Data), pack.Size);
+	}
+	pack = MappedPack();
+}
+#endif
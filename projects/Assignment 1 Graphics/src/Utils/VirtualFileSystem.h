@@ -0,0 +1,157 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <istream>
+#include <filesystem>
+#include <unordered_map>
+
+#include "Utils/AssetPack.h"
+
+/// <summary>
+/// A read-only view of a file's contents. Views of files that are stored uncompressed in a mounted pack
+/// point directly into the mapped pack, anything else owns a buffer with the file's contents
+/// </summary>
+class FileView {
+public:
+	FileView() : _data(nullptr), _size(0), _owned(nullptr) {}
+
+	/// <summary>
+	/// Gets a pointer to the file's contents, valid for as long as this view exists (and the pack stays mounted)
+	/// </summary>
+	const uint8_t* Data() const { return _data; }
+	/// <summary>
+	/// Gets the number of bytes in the file
+	/// </summary>
+	size_t Size() const { return _size; }
+	/// <summary>
+	/// Returns true if the file was opened
+	/// </summary>
+	bool IsValid() const { return _data != nullptr || _owned != nullptr; }
+	explicit operator bool() const { return IsValid(); }
+	/// <summary>
+	/// Gets the file's contents as text
+	/// </summary>
+	std::string_view AsString() const { return std::string_view(reinterpret_cast<const char*>(_data), _size); }
+
+protected:
+	friend class VirtualFileSystem;
+
+	const uint8_t*                        _data;
+	size_t                                _size;
+	std::shared_ptr<std::vector<uint8_t>> _owned;
+};
+
+/// <summary>
+/// An input stream over a FileView, for loaders that parse their files line by line
+/// </summary>
+class FileViewStream : public std::istream {
+public:
+	FileViewStream(const FileView& view);
+
+protected:
+	// Reads directly out of the view's memory, supports seeking so tellg/seekg work as they would on a file
+	class Buffer : public std::streambuf {
+	public:
+		Buffer(const FileView& view);
+	protected:
+		virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+		virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+	};
+
+	FileView _view;
+	Buffer   _buffer;
+};
+
+/// <summary>
+/// Serves reads for asset files, either out of a mounted asset pack or from loose files on disk. The pack
+/// is memory mapped once when it is mounted, and reads of files stored uncompressed are served as views
+/// directly into the mapping, so loading an asset doesn't need to open, seek or copy anything
+///
+/// All loaders should go through here rather than opening files themselves. Reads are safe from any thread
+/// as long as packs are only mounted and unmounted while nothing is loading
+/// </summary>
+class VirtualFileSystem {
+public:
+	/// <summary>
+	/// True if files on disk should be used in place of the packed copies, useful when iterating on assets
+	/// </summary>
+	inline static bool PreferLooseFiles = false;
+
+	/// <summary>
+	/// Memory maps an asset pack and adds it's files to the file system. Paths in the pack are relative to
+	/// the working directory. Packs mounted later take priority over earlier ones
+	/// </summary>
+	/// <param name="packPath">The path to the pack file</param>
+	/// <returns>True if the pack was valid and has been mounted</returns>
+	static bool Mount(const std::string& packPath);
+	/// <summary>
+	/// Unmounts all packs, any views into them become invalid
+	/// </summary>
+	static void UnmountAll();
+	/// <summary>
+	/// Gets the number of files available from mounted packs
+	/// </summary>
+	static size_t GetPackedFileCount() { return _index.size(); }
+
+	/// <summary>
+	/// Returns true if the file exists in a mounted pack or on disk
+	/// </summary>
+	static bool Exists(const std::string& path);
+	/// <summary>
+	/// Returns true if reads of the file will be served from a mounted pack
+	/// </summary>
+	static bool IsPacked(const std::string& path);
+	/// <summary>
+	/// Gets the last write time of a file, for packed files this is the time the source was last modified when it was packed
+	/// </summary>
+	/// <param name="path">The path of the file</param>
+	/// <param name="result">Will store the write time</param>
+	/// <returns>True if the file exists</returns>
+	static bool GetWriteTime(const std::string& path, std::filesystem::file_time_type& result);
+
+	/// <summary>
+	/// Opens a file for reading
+	/// </summary>
+	/// <param name="path">The path of the file to open</param>
+	/// <returns>A view of the file's contents, which will be invalid if the file could not be read</returns>
+	static FileView Open(const std::string& path);
+	/// <summary>
+	/// Reads the entire contents of a file into a string
+	/// </summary>
+	static std::string ReadText(const std::string& path);
+
+protected:
+	VirtualFileSystem() = default;
+	~VirtualFileSystem() = default;
+
+	// A pack that has been mapped into memory
+	struct MappedPack {
+		std::string    Path;
+		const uint8_t* Data = nullptr;
+		size_t         Size = 0;
+		void*          FileHandle = nullptr;
+		void*          MappingHandle = nullptr;
+	};
+
+	inline static std::vector<std::unique_ptr<MappedPack>> _packs;
+	// Maps normalized paths to the pack and entry that stores them
+	inline static std::unordered_map<std::string, std::pair<const MappedPack*, const AssetPack::IndexEntry*>> _index;
+
+	/// <summary>
+	/// Gets the key for a path in our index, absolute paths under the working directory are made relative
+	/// </summary>
+	static std::string _GetKey(const std::string& path);
+	/// <summary>
+	/// Finds a file in the mounted packs, or returns nullptr if it is not packed (or loose files are preferred)
+	/// </summary>
+	static const std::pair<const MappedPack*, const AssetPack::IndexEntry*>* _Find(const std::string& path);
+	/// <summary>
+	/// Reads a file from disk into an owned buffer
+	/// </summary>
+	static FileView _ReadLoose(const std::string& path);
+
+	static bool _Map(MappedPack& pack);
+	static void _Unmap(MappedPack& pack);
+};
@@ -0,0 +1,96 @@
+// Asset cooker, converts the contents of a project's resource directory ahead of time so that the game doesn't
+// have to on first load, and optionally packs the results into an asset pack that the runtime memory maps
+// (see Utils/AssetCooker.h and Utils/VirtualFileSystem.h)
+//
+// Usage: AssetCooker <resource directory> <output directory> [--pack <pack file>] [--jobs <n>] [--force] [--no-compress]
+//
+// Only assets that have changed since the last cook into the same output directory are converted
+
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <Logging.h>
+
+#include "Utils/AssetCooker.h"
+#include "Utils/AssetPack.h"
+#include "Utils/CookManifest.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: AssetCooker <resource directory> <output directory> [--pack <pack file>] [--jobs <n>] [--force] [--no-compress]" << std::endl;
+		return 1;
+	}
+
+	Logger::Init();
+
+	AssetCooker::Settings settings;
+	settings.ResourceDirectory = argv[1];
+	settings.OutputDirectory = argv[2];
+	std::string packPath;
+	bool compress = true;
+	for (int ix = 3; ix < argc; ix++) {
+		std::string arg = argv[ix];
+		if (arg == "--pack" && ix + 1 < argc) {
+			packPath = argv[++ix];
+		} else if (arg == "--jobs" && ix + 1 < argc) {
+			settings.NumThreads = std::stoi(argv[++ix]);
+		} else if (arg == "--force") {
+			settings.Force = true;
+		} else if (arg == "--no-compress") {
+			compress = false;
+		} else {
+			std::cerr << "Unknown argument \"" << arg << "\"" << std::endl;
+			return 1;
+		}
+	}
+
+	AssetCooker::Report report = AssetCooker::Cook(settings);
+	for (const auto& error : report.Errors) {
+		LOG_ERROR(error);
+	}
+	LOG_INFO("Cooked {} of {} assets in {:.2f} seconds ({} up to date, {} failed)", report.NumCooked, report.NumAssets, report.Seconds, report.NumSkipped, report.NumFailed);
+
+	// The pack contains the sources along with everything cooked from them, with paths relative to the output directory
+	if (!packPath.empty()) {
+		std::error_code err;
+		const fs::path resourceDir = fs::absolute(settings.ResourceDirectory, err);
+		const fs::path outputDir = fs::absolute(settings.OutputDirectory, err);
+
+		// A pack that is missing files would only fail later at runtime, so any file we can't read fails the cook
+		AssetPackWriter writer(compress);
+		bool packFailed = false;
+		auto addFile = [&](const fs::path& sourcePath, const std::string& path) {
+			if (!writer.AddFile(sourcePath.string(), path)) {
+				LOG_ERROR("Failed to add \"{}\" to the asset pack", sourcePath.string());
+				packFailed = true;
+			}
+		};
+		for (const auto& entry : fs::recursive_directory_iterator(resourceDir, err)) {
+			if (entry.is_regular_file()) {
+				fs::path relative = fs::relative(entry.path(), resourceDir, err);
+				addFile(outputDir / relative, relative.generic_string());
+			}
+		}
+		for (const auto& source : CookManifest::GetSources()) {
+			for (const auto& output : CookManifest::Find(source)->Outputs) {
+				addFile(outputDir / output, output);
+			}
+		}
+		addFile(outputDir / CookManifest::DefaultPath, CookManifest::DefaultPath);
+		if (packFailed) {
+			return 1;
+		}
+
+		std::string error;
+		if (!writer.Write(packPath, error)) {
+			LOG_ERROR(error);
+			return 1;
+		}
+		LOG_INFO("Packed {} files ({:.2f}MB) into \"{}\"", writer.GetEntryCount(), writer.GetTotalSize() / (1024.0 * 1024.0), packPath);
+	}
+
+	Logger::Uninitialize();
+	return report.NumFailed > 0 ? 1 : 0;
+}